@@ -67,8 +67,63 @@ BENCHMARK(BM_Convolution)->Args({256, 128, 40, 40, 3, 3})->Unit(benchmark::kMill
 
 BENCHMARK(BM_Convolution)->Args({512, 256, 20, 20, 3, 3})->Unit(benchmark::kMillisecond);
 
+// 输出通道数不是8的整数倍，走微内核
+BENCHMARK(BM_Convolution)->Args({3, 16, 320, 320, 3, 3})->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_Convolution)->Args({37, 19, 160, 160, 3, 3})->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_Convolution)->Args({85, 64, 40, 40, 3, 3})->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_Convolution)->Args({12, 32, 80, 80, 3, 3})->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_Convolution)->Args({20, 32, 80, 80, 3, 3})->Unit(benchmark::kMillisecond);
+
 BENCHMARK(BM_Convolution)->Args({32, 3, 320, 320, 1, 1})->Unit(benchmark::kMillisecond);
 
+static void BM_ConvolutionSparse(benchmark::State& state) {
+  using namespace kuiper_infer;
+
+  uint32_t kernel_count = state.range(0);
+  uint32_t channels = state.range(1);
+  uint32_t rows = state.range(2);
+  uint32_t cols = state.range(3);
+  uint32_t kernel_size = state.range(4);
+  uint32_t zero_percent = state.range(5);
+  sftensor input = std::make_shared<ftensor>(channels, rows, cols);
+  input->Fill(1.f);
+
+  // 按1x8块剪枝，zero_percent为0时走稠密路径
+  std::vector<sftensor> weights(kernel_count);
+  for (uint32_t k = 0; k < kernel_count; ++k) {
+    sftensor weight = std::make_shared<ftensor>(channels, kernel_size, kernel_size);
+    weight->RandN();
+    float* values = weight->raw_ptr();
+    for (uint32_t i = 0; i < weight->size(); ++i) {
+      const uint32_t block = k * weight->size() / 8 + i / 8;
+      if (block * 37 % 100 < zero_percent) {
+        values[i] = 0.f;
+      }
+    }
+    weights.at(k) = weight;
+  }
+
+  std::vector<sftensor> outputs(1);
+  std::vector<sftensor> inputs = {input};
+  const uint32_t padding = kernel_size / 2;
+  ConvolutionLayer conv_layer(kernel_count, channels, kernel_size, kernel_size, padding, padding,
+                              1, 1, 1, false);
+  conv_layer.set_weights(weights);
+  for (auto _ : state) {
+    conv_layer.Forward(inputs, outputs);
+  }
+}
+
+BENCHMARK(BM_ConvolutionSparse)->Args({128, 128, 40, 40, 3, 0})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ConvolutionSparse)->Args({128, 128, 40, 40, 3, 75})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ConvolutionSparse)->Args({128, 128, 40, 40, 3, 90})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ConvolutionSparse)->Args({256, 128, 40, 40, 1, 0})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ConvolutionSparse)->Args({256, 128, 40, 40, 1, 90})->Unit(benchmark::kMillisecond);
+
 BENCHMARK(BM_Convolution)->Args({64, 32, 160, 160, 1, 1})->Unit(benchmark::kMillisecond);
 
 BENCHMARK(BM_Convolution)->Args({128, 64, 80, 80, 1, 1})->Unit(benchmark::kMillisecond);
@@ -77,6 +132,47 @@ BENCHMARK(BM_Convolution)->Args({256, 128, 40, 40, 1, 1})->Unit(benchmark::kMill
 
 BENCHMARK(BM_Convolution)->Args({512, 256, 20, 20, 1, 1})->Unit(benchmark::kMillisecond);
 
+// 大卷积核由代价模型选择FFT
+BENCHMARK(BM_Convolution)->Args({64, 64, 80, 80, 7, 7})->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_Convolution)->Args({128, 128, 40, 40, 9, 9})->Unit(benchmark::kMillisecond);
+
+static void BM_ConvolutionGroup(benchmark::State& state) {
+  using namespace kuiper_infer;
+
+  uint32_t kernel_count = state.range(0);
+  uint32_t channels = state.range(1);
+  uint32_t rows = state.range(2);
+  uint32_t cols = state.range(3);
+  uint32_t groups = state.range(4);
+
+  sftensor input = std::make_shared<ftensor>(channels, rows, cols);
+  input->Fill(1.f);
+
+  std::vector<sftensor> weights(kernel_count);
+  for (uint32_t k = 0; k < kernel_count; ++k) {
+    sftensor weight = std::make_shared<ftensor>(channels / groups, 3, 3);
+    weight->RandN();
+    weights.at(k) = weight;
+  }
+
+  std::vector<sftensor> outputs(1);
+  std::vector<sftensor> inputs;
+  inputs.push_back(input);
+  ConvolutionLayer conv_layer(kernel_count, channels, 3, 3, 1, 1, 1, 1, groups, false);
+  conv_layer.set_weights(weights);
+  for (auto _ : state) {
+    conv_layer.Forward(inputs, outputs);
+  }
+}
+
+// ResNeXt和RegNet风格的分组卷积
+BENCHMARK(BM_ConvolutionGroup)->Args({128, 128, 80, 80, 4})->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ConvolutionGroup)->Args({256, 256, 40, 40, 32})->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ConvolutionGroup)->Args({512, 512, 20, 20, 64})->Unit(benchmark::kMillisecond);
+
 static void BM_DeConvolutionk2x2s2x2(benchmark::State& state) {
   using namespace kuiper_infer;
 
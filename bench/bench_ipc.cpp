@@ -0,0 +1,65 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-13.
+#include <benchmark/benchmark.h>
+#include <thread>
+#include "runtime/runtime_ipc.hpp"
+
+static void BM_IpcResnet18_Batch8_224x224(benchmark::State& state) {
+  using namespace kuiper_infer;
+  const uint32_t batch_size = 8;
+  const uint32_t client_num = state.range(0);
+  const uint32_t request_num = 16;
+
+  auto graph = std::make_shared<RuntimeGraph>("tmp/resnet/resnet18_batch8.pnnx.param",
+                                              "tmp/resnet/resnet18_batch8.pnnx.bin");
+  graph->Build();
+  RuntimeIpcServer server("/kuiper_bench_ipc", graph, "pnnx_input_0", "pnnx_output_0",
+                          batch_size, {3, 224, 224}, {1, 1, 1000}, 2 * batch_size);
+  std::thread server_thread([&server]() { server.Run(); });
+
+  for (auto _ : state) {
+    std::vector<std::thread> client_threads;
+    for (uint32_t c = 0; c < client_num; ++c) {
+      client_threads.emplace_back([request_num]() {
+        RuntimeIpcClient client("/kuiper_bench_ipc");
+        for (uint32_t i = 0; i < request_num; ++i) {
+          const uint32_t slot = client.Acquire();
+          client.input(slot)->Fill(1.f);
+          client.Submit(slot);
+          benchmark::DoNotOptimize(client.output(slot)->raw_ptr());
+          client.Release(slot);
+        }
+      });
+    }
+    for (std::thread& client_thread : client_threads) {
+      client_thread.join();
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * client_num * request_num);
+  state.counters["batches"] = double(server.batch_count());
+
+  server.Stop();
+  server_thread.join();
+}
+
+BENCHMARK(BM_IpcResnet18_Batch8_224x224)->Arg(1)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond);
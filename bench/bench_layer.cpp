@@ -149,6 +149,76 @@ BENCHMARK(BM_Linear)->Args({128, 1000, 512})->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_Linear)->Args({128, 2048, 512})->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_Linear)->Args({512, 1024, 1000})->Unit(benchmark::kMillisecond);
 
+static void BM_LinearSparse(benchmark::State& state) {
+  using namespace kuiper_infer;
+  const int32_t in_features = (int32_t)state.range(0);
+  const int32_t out_features = (int32_t)state.range(1);
+  const int32_t in_dims = (int32_t)state.range(2);
+  const int32_t zero_percent = (int32_t)state.range(3);
+
+  // 按1x8块剪枝，zero_percent为0时走稠密路径
+  std::vector<float> weights(in_features * out_features, 1.f);
+  for (int32_t i = 0; i < in_features * out_features; ++i) {
+    const int32_t block = i / 8;
+    if (block * 37 % 100 < zero_percent) {
+      weights.at(i) = 0.f;
+    }
+  }
+  LinearLayer linear_layer(in_features, out_features, true);
+  linear_layer.set_weights(weights);
+  std::vector<float> bias(out_features, 3.f);
+  linear_layer.set_bias(bias);
+
+  std::shared_ptr<Tensor<float>> input = std::make_shared<Tensor<float>>(1, in_dims, in_features);
+  input->Fill(1.f);
+  std::vector<std::shared_ptr<Tensor<float>>> inputs = {input};
+  std::vector<std::shared_ptr<Tensor<float>>> outputs = {
+      std::make_shared<Tensor<float>>(1, in_dims, out_features)};
+
+  for (auto _ : state) {
+    linear_layer.Forward(inputs, outputs);
+  }
+  state.counters["sparse"] = linear_layer.is_sparse() ? 1 : 0;
+}
+
+BENCHMARK(BM_LinearSparse)->Args({512, 1024, 64, 0})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LinearSparse)->Args({512, 1024, 64, 50})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LinearSparse)->Args({512, 1024, 64, 75})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LinearSparse)->Args({512, 1024, 64, 90})->Unit(benchmark::kMillisecond);
+
+static void BM_LinearInt8(benchmark::State& state) {
+  using namespace kuiper_infer;
+  const int32_t in_features = (int32_t)state.range(0);
+  const int32_t out_features = (int32_t)state.range(1);
+  const int32_t in_dims = (int32_t)state.range(2);
+
+  LinearLayer linear_layer(in_features, out_features, true);
+  std::vector<float> weights(in_features * out_features);
+  for (int32_t i = 0; i < in_features * out_features; ++i) {
+    weights.at(i) = float(i % 17) * 0.1f;
+  }
+  linear_layer.set_weights(weights);
+  linear_layer.QuantizeWeights();
+
+  std::vector<float> bias(out_features, 3.f);
+  linear_layer.set_bias(bias);
+
+  std::shared_ptr<Tensor<float>> input = std::make_shared<Tensor<float>>(1, in_dims, in_features);
+  input->Fill(1.f);
+  std::vector<std::shared_ptr<Tensor<float>>> inputs = {input};
+  std::vector<std::shared_ptr<Tensor<float>>> outputs = {
+      std::make_shared<Tensor<float>>(1, in_dims, out_features)};
+
+  for (auto _ : state) {
+    linear_layer.Forward(inputs, outputs);
+  }
+}
+
+BENCHMARK(BM_LinearInt8)->Args({128, 1000, 512})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LinearInt8)->Args({128, 2048, 512})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LinearInt8)->Args({512, 1024, 1000})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LinearInt8)->Args({2048, 1000, 1})->Unit(benchmark::kMillisecond);
+
 static void BM_Expression(benchmark::State& state) {
   const int32_t channels = (int32_t)state.range(0);
   const int32_t rows = (int32_t)state.range(1);
@@ -260,6 +330,34 @@ BENCHMARK(BM_ReLU)->Args({32, 160, 160})->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_ReLU)->Args({64, 80, 80})->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_ReLU)->Args({128, 40, 40})->Unit(benchmark::kMillisecond);
 
+static void BM_ReLUViews(benchmark::State& state) {
+  using namespace kuiper_infer;
+
+  uint32_t channels = state.range(0);
+  uint32_t rows = state.range(1);
+  uint32_t cols = state.range(2);
+  uint32_t batch = state.range(3);
+
+  // 小张量上调用开销占主要部分，对比共享指针接口和视图接口
+  std::vector<sftensor> inputs;
+  std::vector<sftensor> outputs;
+  for (uint32_t i = 0; i < batch; ++i) {
+    inputs.push_back(std::make_shared<ftensor>(channels, rows, cols));
+    inputs.back()->Fill(1.f);
+    outputs.push_back(std::make_shared<ftensor>(channels, rows, cols));
+  }
+  const std::vector<TensorView> input_views = MakeTensorViews(inputs);
+  const std::vector<TensorView> output_views = MakeTensorViews(outputs);
+
+  ReluLayer relu_layer;
+  for (auto _ : state) {
+    relu_layer.ForwardViews(input_views, output_views);
+  }
+}
+
+BENCHMARK(BM_ReLUViews)->Args({128, 40, 40, 1})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReLUViews)->Args({16, 4, 4, 32})->Unit(benchmark::kMicrosecond);
+
 static void BM_MaxPooling_k3x3s1x1(benchmark::State& state) {
   using namespace kuiper_infer;
 
@@ -21,12 +21,14 @@
 
 // Created by fss on 22-11-22.
 #include <benchmark/benchmark.h>
+#include "bench_util.hpp"
 #include "runtime/runtime_ir.hpp"
 
 static void BM_MobilenetV3_Batch8_224x224(benchmark::State& state) {
   using namespace kuiper_infer;
   RuntimeGraph graph("tmp/mobilenet/mobile_batch8.pnnx.param", "tmp/mobilenet/mobile_batch8.bin");
 
+  graph.set_fast_path(state.range(0) != 0);
   graph.Build();
   std::vector<std::shared_ptr<Tensor<float>>> inputs;
 
@@ -40,6 +42,11 @@ static void BM_MobilenetV3_Batch8_224x224(benchmark::State& state) {
   for (auto _ : state) {
     graph.Forward(false);
   }
+  SetThroughputCounters(state, graph);
 }
 
-BENCHMARK(BM_MobilenetV3_Batch8_224x224)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MobilenetV3_Batch8_224x224)
+    ->ArgName("fast_path")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
@@ -21,6 +21,7 @@
 
 // Created by fss on 23-2-2.
 #include <benchmark/benchmark.h>
+#include "bench_util.hpp"
 #include "runtime/runtime_ir.hpp"
 
 const static int kIterationNum = 5;
@@ -30,6 +31,7 @@ static void BM_Resnet18_Batch8_224x224(benchmark::State& state) {
   RuntimeGraph graph("tmp/resnet/resnet18_batch8.pnnx.param",
                      "tmp/resnet/resnet18_batch8.pnnx.bin");
 
+  graph.set_fast_path(state.range(0) != 0);
   graph.Build();
   std::vector<std::shared_ptr<Tensor<float>>> inputs;
 
@@ -43,6 +45,7 @@ static void BM_Resnet18_Batch8_224x224(benchmark::State& state) {
   for (auto _ : state) {
     graph.Forward(false);
   }
+  SetThroughputCounters(state, graph);
 }
 
 static void BM_Resnet18_Batch16_224x224(benchmark::State& state) {
@@ -50,6 +53,7 @@ static void BM_Resnet18_Batch16_224x224(benchmark::State& state) {
   RuntimeGraph graph("tmp/resnet/resnet18_batch16.pnnx.param",
                      "tmp/resnet/resnet18_batch16.pnnx.bin");
 
+  graph.set_fast_path(state.range(0) != 0);
   graph.Build();
   std::vector<std::shared_ptr<Tensor<float>>> inputs;
   const uint32_t batch_size = 16;
@@ -62,7 +66,16 @@ static void BM_Resnet18_Batch16_224x224(benchmark::State& state) {
   for (auto _ : state) {
     graph.Forward(false);
   }
+  SetThroughputCounters(state, graph);
 }
 
-BENCHMARK(BM_Resnet18_Batch8_224x224)->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_Resnet18_Batch16_224x224)->Unit(benchmark::kMillisecond);
\ No newline at end of file
+BENCHMARK(BM_Resnet18_Batch8_224x224)
+    ->ArgName("fast_path")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Resnet18_Batch16_224x224)
+    ->ArgName("fast_path")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
\ No newline at end of file
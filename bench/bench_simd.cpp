@@ -109,4 +109,53 @@ static void BM_SiluSimd(benchmark::State& state) {
 
 BENCHMARK(BM_SiluSimd)->Args({255, 80, 80})->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_SiluSimd)->Args({255, 40, 40})->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_SiluSimd)->Args({255, 20, 20})->Unit(benchmark::kMillisecond);
\ No newline at end of file
+BENCHMARK(BM_SiluSimd)->Args({255, 20, 20})->Unit(benchmark::kMillisecond);
+static void BM_ReluMap(benchmark::State& state) {
+  using namespace kuiper_infer;
+  uint32_t input_c = state.range(0);
+  uint32_t input_h = state.range(1);
+  uint32_t input_w = state.range(2);
+  sftensor input = std::make_shared<ftensor>(input_c, input_h, input_w);
+  input->RandN();
+  for (auto _ : state) {
+    input->Map([](float value) { return value > 0.f ? value : 0.f; });
+  }
+}
+
+BENCHMARK(BM_ReluMap)->Args({255, 80, 80})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReluMap)->Args({255, 40, 40})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReluMap)->Args({255, 20, 20})->Unit(benchmark::kMillisecond);
+
+#ifdef __AVX2__
+static void BM_ReluMapSimd(benchmark::State& state) {
+  using namespace kuiper_infer;
+  uint32_t input_c = state.range(0);
+  uint32_t input_h = state.range(1);
+  uint32_t input_w = state.range(2);
+  sftensor input = std::make_shared<ftensor>(input_c, input_h, input_w);
+  input->RandN();
+  const __m256 zero = _mm256_setzero_ps();
+  for (auto _ : state) {
+    input->MapSimd([zero](__m256 value) { return _mm256_max_ps(value, zero); });
+  }
+}
+
+BENCHMARK(BM_ReluMapSimd)->Args({255, 80, 80})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReluMapSimd)->Args({255, 40, 40})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReluMapSimd)->Args({255, 20, 20})->Unit(benchmark::kMillisecond);
+#endif
+
+static void BM_TensorSum(benchmark::State& state) {
+  using namespace kuiper_infer;
+  uint32_t input_c = state.range(0);
+  uint32_t input_h = state.range(1);
+  uint32_t input_w = state.range(2);
+  sftensor input = std::make_shared<ftensor>(input_c, input_h, input_w);
+  input->RandN();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(input->Reduce(0.f, [](float x, float y) { return x + y; }));
+  }
+}
+
+BENCHMARK(BM_TensorSum)->Args({255, 80, 80})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TensorSum)->Args({255, 20, 20})->Unit(benchmark::kMillisecond);
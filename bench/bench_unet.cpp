@@ -21,6 +21,7 @@
 
 // Created by fss on 23-2-2.
 #include <benchmark/benchmark.h>
+#include "bench_util.hpp"
 #include "runtime/runtime_ir.hpp"
 
 const static int kIterationNum = 4;
@@ -28,6 +29,7 @@ const static int kIterationNum = 4;
 static void BM_Unet_Batch1_512x512(benchmark::State& state) {
   using namespace kuiper_infer;
   RuntimeGraph graph("tmp/unet/unet_demo.pnnx.param", "tmp/unet/unet_demo.pnnx.bin");
+  graph.set_fast_path(state.range(0) != 0);
   graph.Build();
   const uint32_t batch_size = 1;
   std::vector<std::shared_ptr<Tensor<float>>> inputs;
@@ -42,6 +44,12 @@ static void BM_Unet_Batch1_512x512(benchmark::State& state) {
   for (auto _ : state) {
     graph.Forward(false);
   }
+  SetThroughputCounters(state, graph);
 }
 
-BENCHMARK(BM_Unet_Batch1_512x512)->Unit(benchmark::kMillisecond)->Iterations(kIterationNum);
\ No newline at end of file
+BENCHMARK(BM_Unet_Batch1_512x512)
+    ->ArgName("fast_path")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(kIterationNum);
\ No newline at end of file
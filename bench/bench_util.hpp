@@ -0,0 +1,70 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-29.
+
+#ifndef KUIPER_INFER_BENCH_BENCH_UTIL_HPP_
+#define KUIPER_INFER_BENCH_BENCH_UTIL_HPP_
+#include <armadillo>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include "runtime/runtime_ir.hpp"
+
+/**
+ * @brief Measures the FLOP/s of a large single precision GEMM
+ *
+ * Used as the attainable peak of the machine, measured once per process.
+ */
+inline double MeasureGemmPeakFlops() {
+  static const double peak_flops = []() {
+    const arma::uword size = 1024;
+    const arma::fmat a(size, size, arma::fill::randu);
+    const arma::fmat b(size, size, arma::fill::randu);
+    arma::fmat c = a * b;
+    const int repeats = 4;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i) {
+      c = a * b;
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    benchmark::DoNotOptimize(c.memptr());
+    return 2. * size * size * size * repeats / elapsed.count();
+  }();
+  return peak_flops;
+}
+
+/**
+ * @brief Reports the achieved throughput of a graph benchmark
+ *
+ * Adds the FLOP/s of the graph, its activation bandwidth and its share of
+ * the measured GEMM peak as counters.
+ */
+inline void SetThroughputCounters(benchmark::State& state,
+                                  const kuiper_infer::RuntimeGraph& graph) {
+  const kuiper_infer::LayerCost cost = graph.TotalCost();
+  state.counters["FLOP/s"] =
+      benchmark::Counter(cost.flops, benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["bytes/s"] =
+      benchmark::Counter(cost.bytes(), benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["peak%"] = benchmark::Counter(100. * cost.flops / MeasureGemmPeakFlops(),
+                                               benchmark::Counter::kIsIterationInvariantRate);
+}
+#endif  // KUIPER_INFER_BENCH_BENCH_UTIL_HPP_
@@ -21,6 +21,7 @@
 
 // Created by fss on 23-2-2.
 #include <benchmark/benchmark.h>
+#include "bench_util.hpp"
 #include "runtime/runtime_ir.hpp"
 const static int kIterationNum = 5;
 
@@ -29,6 +30,7 @@ static void BM_Yolov5nano_Batch4_320x320(benchmark::State& state) {
   RuntimeGraph graph("tmp/yolo/demo/yolov5n_small.pnnx.param",
                      "tmp/yolo/demo/yolov5n_small.pnnx.bin");
 
+  graph.set_fast_path(state.range(0) != 0);
   graph.Build();
   const uint32_t batch_size = 4;
   std::vector<std::shared_ptr<Tensor<float>>> inputs;
@@ -43,6 +45,7 @@ static void BM_Yolov5nano_Batch4_320x320(benchmark::State& state) {
   for (auto _ : state) {
     graph.Forward(false);
   }
+  SetThroughputCounters(state, graph);
 }
 
 static void BM_Yolov5s_Batch4_640x640(benchmark::State& state) {
@@ -63,6 +66,7 @@ static void BM_Yolov5s_Batch4_640x640(benchmark::State& state) {
   for (auto _ : state) {
     graph.Forward(false);
   }
+  SetThroughputCounters(state, graph);
 }
 
 static void BM_Yolov5s_Batch8_640x640(benchmark::State& state) {
@@ -83,8 +87,14 @@ static void BM_Yolov5s_Batch8_640x640(benchmark::State& state) {
   for (auto _ : state) {
     graph.Forward(false);
   }
+  SetThroughputCounters(state, graph);
 }
 
-BENCHMARK(BM_Yolov5nano_Batch4_320x320)->Unit(benchmark::kMillisecond)->Iterations(5);
+BENCHMARK(BM_Yolov5nano_Batch4_320x320)
+    ->ArgName("fast_path")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(5);
 BENCHMARK(BM_Yolov5s_Batch4_640x640)->Unit(benchmark::kMillisecond)->Iterations(5);
 BENCHMARK(BM_Yolov5s_Batch8_640x640)->Unit(benchmark::kMillisecond)->Iterations(5);
\ No newline at end of file
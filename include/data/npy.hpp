@@ -0,0 +1,217 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-9.
+
+#ifndef KUIPER_INFER_INCLUDE_DATA_NPY_HPP_
+#define KUIPER_INFER_INCLUDE_DATA_NPY_HPP_
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "data/tensor.hpp"
+#include "data/tensor_view.hpp"
+#include "runtime/runtime_datatype.hpp"
+
+namespace kuiper_infer {
+class MappedFile;
+
+/**
+ * @brief Array of a NPY file mapped into memory
+ *
+ * The array keeps the mapping alive and never copies on its own. The file is
+ * mapped copy-on-write, so tensors wrapping the mapping may be written without
+ * changing the file. Supported element types are float32, int32 and uint8.
+ */
+class NpyArray {
+ public:
+  NpyArray() = default;
+
+  /**
+   * @brief Gets the shape as stored in the file
+   */
+  const std::vector<uint32_t>& shape() const { return shape_; }
+
+  RuntimeDataType dtype() const { return dtype_; }
+
+  /**
+   * @brief Whether the file stores the array in column-major order
+   */
+  bool fortran_order() const { return fortran_order_; }
+
+  /**
+   * @brief Gets the number of elements
+   */
+  size_t size() const;
+
+  bool empty() const { return data_ == nullptr; }
+
+  /**
+   * @brief Views the array as channels, rows and cols without copying
+   *
+   * The last two dimensions are the rows and cols, the leading dimensions are
+   * folded into the channels. A one dimensional array is a single row.
+   */
+  TensorView view() const;
+
+  /**
+   * @brief Whether ToTensor can wrap the mapped memory without copying
+   *
+   * True for float32 arrays whose layout matches Tensor, such as vectors,
+   * single rows or columns per channel, and column-major matrices.
+   */
+  bool is_tensor_layout() const;
+
+  /**
+   * @brief Gets the array as a float tensor
+   *
+   * Wraps the mapping if is_tensor_layout, otherwise converts the layout and
+   * the element type into a new tensor.
+   *
+   * @return Tensor shaped like view()
+   */
+  std::shared_ptr<Tensor<float>> ToTensor() const;
+
+  /**
+   * @brief Converts the array into an existing tensor shaped like view()
+   */
+  void CopyTo(Tensor<float>& tensor) const;
+
+  /**
+   * @brief Gets the number of samples along the first dimension
+   */
+  uint32_t samples() const { return shape_.empty() ? 0 : shape_.front(); }
+
+  /**
+   * @brief Gets one sample along the first dimension of a row-major array
+   *
+   * @param index Sample index
+   * @return Array sharing the mapping, without the first dimension
+   */
+  NpyArray Sample(uint32_t index) const;
+
+ private:
+  friend class NpyDataLoader;
+
+  size_t element_size() const;
+
+  std::shared_ptr<const MappedFile> file_;
+  const char* data_ = nullptr;
+  RuntimeDataType dtype_ = RuntimeDataType::kTypeUnknown;
+  bool fortran_order_ = false;
+  std::vector<uint32_t> shape_;
+};
+
+/**
+ * @brief NPY and NPZ data loader
+ *
+ * Reads NPY files and stored (uncompressed) NPZ archives through memory
+ * mappings, and writes float tensors in both formats.
+ */
+class NpyDataLoader {
+ public:
+  /**
+   * @brief Maps a NPY file
+   *
+   * @param file_path Path to the NPY file
+   * @return Mapped array, empty if the file can not be read
+   */
+  static NpyArray Load(const std::string& file_path);
+
+  /**
+   * @brief Maps all arrays of a stored NPZ archive
+   *
+   * Archives written by numpy.savez_compressed are not supported.
+   *
+   * @param file_path Path to the NPZ file
+   * @return Arrays by name without the .npy suffix, empty if the archive can not be read
+   */
+  static std::map<std::string, NpyArray> LoadArchive(const std::string& file_path);
+
+  /**
+   * @brief Writes a tensor as a row-major float32 NPY file
+   *
+   * The NPY shape is the raw shape of the tensor.
+   *
+   * @param file_path Path to the NPY file
+   * @param tensor Tensor to write
+   * @return True if the file was written
+   */
+  static bool Save(const std::string& file_path, const Tensor<float>& tensor);
+
+  /**
+   * @brief Writes tensors as a stored NPZ archive
+   *
+   * @param file_path Path to the NPZ file
+   * @param tensors Tensors by array name
+   * @return True if the archive was written
+   */
+  static bool SaveArchive(const std::string& file_path,
+                          const std::map<std::string, std::shared_ptr<Tensor<float>>>& tensors);
+
+ private:
+  static NpyArray Parse(const std::shared_ptr<const MappedFile>& file, size_t offset,
+                        size_t size);
+
+  static std::string Serialize(const Tensor<float>& tensor);
+};
+
+/**
+ * @brief Iterates over a dataset array in batches
+ *
+ * The first dimension of the array indexes the samples. Samples are wrapped
+ * without copying if their layout permits, otherwise they are converted into
+ * the tensors of the previous batch, so iterating does not allocate.
+ */
+class NpyBatchIterator {
+ public:
+  /**
+   * @param dataset Row-major array, one sample per entry of the first dimension
+   * @param batch_size Maximum number of samples per batch
+   */
+  NpyBatchIterator(NpyArray dataset, uint32_t batch_size);
+
+  /**
+   * @brief Gets the next batch
+   *
+   * @param batch Receives the samples, the last batch may be smaller
+   * @return False if all samples have been returned
+   */
+  bool Next(std::vector<std::shared_ptr<Tensor<float>>>& batch);
+
+  /**
+   * @brief Restarts from the first sample
+   */
+  void Reset() { next_sample_ = 0; }
+
+  uint32_t samples() const { return dataset_.samples(); }
+
+  uint32_t batch_size() const { return batch_size_; }
+
+ private:
+  NpyArray dataset_;
+  uint32_t batch_size_ = 0;
+  uint32_t next_sample_ = 0;
+};
+}  // namespace kuiper_infer
+
+#endif  // KUIPER_INFER_INCLUDE_DATA_NPY_HPP_
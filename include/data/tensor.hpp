@@ -24,10 +24,15 @@
 #ifndef KUIPER_INFER_DATA_BLOB_HPP_
 #define KUIPER_INFER_DATA_BLOB_HPP_
 #include <glog/logging.h>
+#include <algorithm>
 #include <armadillo>
 #include <memory>
 #include <numeric>
+#include <type_traits>
 #include <vector>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 namespace kuiper_infer {
 template <typename T>
@@ -69,6 +74,20 @@ class Tensor {
    */
   explicit Tensor(const std::vector<uint32_t>& shapes);
 
+  /**
+   * @brief Construct a 3D Tensor on external memory
+   *
+   * The tensor neither copies nor owns the memory, which must hold
+   * channels * rows * cols elements in column-major order per channel and
+   * outlive the tensor. The shape of the tensor can not change.
+   *
+   * @param raw_ptr Pointer to the external memory
+   * @param channels Number of channels
+   * @param rows Number of rows
+   * @param cols Number of columns
+   */
+  explicit Tensor(T* raw_ptr, uint32_t channels, uint32_t rows, uint32_t cols);
+
   /**
    * @brief Gets number of rows
    *
@@ -263,12 +282,74 @@ class Tensor {
    */
   void Flatten(bool row_major = false);
 
+  /**
+   * @brief Copies data from a tensor with the same size in row-major order
+   *
+   * Keeps the current shape and storage of this tensor, so nothing is allocated.
+   *
+   * @param tensor Source tensor
+   */
+  void CopyRowMajor(const Tensor<T>& tensor);
+
   /**
    * @brief Applies element-wise transform
    *
+   * Alias of Map.
+   *
    * @param filter Transform function
    */
-  void Transform(const std::function<T(T)>& filter);
+  template <typename Func>
+  void Transform(Func&& filter) {
+    this->Map(std::forward<Func>(filter));
+  }
+
+  /**
+   * @brief Replaces every element x with func(x)
+   *
+   * The callable is inlined into a vectorizable loop over the contiguous
+   * storage, large tensors are split between threads. func may be called
+   * concurrently and in any order.
+   *
+   * @param func Callable taking and returning T
+   */
+  template <typename Func>
+  void Map(Func&& func);
+
+  /**
+   * @brief Replaces every element x with func(x, y), y is the element of other at the same index
+   *
+   * @param other Tensor with the same shape
+   * @param func Callable taking two T and returning T
+   */
+  template <typename Func>
+  void Zip(const Tensor<T>& other, Func&& func);
+
+  /**
+   * @brief Folds all elements with a binary callable
+   *
+   * Partial results are computed per chunk of the storage and combined in a
+   * fixed order, so func must be associative and commutative, and identity
+   * must leave any value unchanged, e.g. 0 for a sum.
+   *
+   * @param identity Neutral element of func
+   * @param func Callable taking two T and returning T
+   * @return The folded value
+   */
+  template <typename Func>
+  T Reduce(T identity, Func&& func) const;
+
+#ifdef __AVX2__
+  /**
+   * @brief Replaces every eight floats x with func(x)
+   *
+   * SIMD variant of Map for float tensors. The last incomplete group is padded
+   * with zeros before func is applied, the padding is discarded afterwards.
+   *
+   * @param func Callable taking and returning __m256
+   */
+  template <typename Func>
+  void MapSimd(Func&& func);
+#endif
 
   /**
    * @brief Gets raw data pointer
@@ -324,6 +405,15 @@ class Tensor {
    */
   void Review(const std::vector<uint32_t>& shapes);
 
+  /// Elements from which the element-wise loops run in parallel
+  static constexpr size_t kParallelSize = size_t(1) << 15;
+
+  /// Elements folded by one task of Reduce
+  static constexpr size_t kReduceChunk = size_t(1) << 14;
+
+  /// Independent accumulators of Reduce within a chunk
+  static constexpr size_t kReduceLanes = 8;
+
   /// Raw tensor dimensions
   std::vector<uint32_t> raw_shapes_;
 
@@ -331,6 +421,96 @@ class Tensor {
   arma::Cube<T> data_;
 };
 
+template <typename T>
+template <typename Func>
+void Tensor<T>::Map(Func&& func) {
+  CHECK(!this->data_.empty()) << "The data area of the tensor is empty.";
+  T* data = this->data_.memptr();
+  const size_t size = this->data_.size();
+#pragma omp parallel for simd if (size >= kParallelSize)
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = func(data[i]);
+  }
+}
+
+template <typename T>
+template <typename Func>
+void Tensor<T>::Zip(const Tensor<T>& other, Func&& func) {
+  CHECK(!this->data_.empty()) << "The data area of the tensor is empty.";
+  CHECK(this->shapes() == other.shapes()) << "The shapes of the zipped tensors do not match.";
+  T* data = this->data_.memptr();
+  const T* other_data = other.data_.memptr();
+  const size_t size = this->data_.size();
+#pragma omp parallel for simd if (size >= kParallelSize)
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = func(data[i], other_data[i]);
+  }
+}
+
+template <typename T>
+template <typename Func>
+T Tensor<T>::Reduce(T identity, Func&& func) const {
+  CHECK(!this->data_.empty()) << "The data area of the tensor is empty.";
+  const T* data = this->data_.memptr();
+  const size_t size = this->data_.size();
+  const size_t chunks = (size + kReduceChunk - 1) / kReduceChunk;
+  std::vector<T> partials(chunks, identity);
+#pragma omp parallel for if (size >= kParallelSize)
+  for (size_t chunk = 0; chunk < chunks; ++chunk) {
+    const size_t begin = chunk * kReduceChunk;
+    const size_t end = std::min(begin + kReduceChunk, size);
+    // 多个独立的累加器打断依赖链，内层循环可以向量化
+    T lanes[kReduceLanes];
+    std::fill(lanes, lanes + kReduceLanes, identity);
+    size_t i = begin;
+    for (; i + kReduceLanes <= end; i += kReduceLanes) {
+      for (size_t lane = 0; lane < kReduceLanes; ++lane) {
+        lanes[lane] = func(lanes[lane], data[i + lane]);
+      }
+    }
+    T partial = identity;
+    for (size_t lane = 0; lane < kReduceLanes; ++lane) {
+      partial = func(partial, lanes[lane]);
+    }
+    for (; i < end; ++i) {
+      partial = func(partial, data[i]);
+    }
+    partials[chunk] = partial;
+  }
+  T result = identity;
+  for (const T& partial : partials) {
+    result = func(result, partial);
+  }
+  return result;
+}
+
+#ifdef __AVX2__
+template <typename T>
+template <typename Func>
+void Tensor<T>::MapSimd(Func&& func) {
+  static_assert(std::is_same_v<T, float>, "MapSimd only supports float tensors");
+  CHECK(!this->data_.empty()) << "The data area of the tensor is empty.";
+  constexpr size_t kPackSize = 8;
+  float* data = this->data_.memptr();
+  const size_t size = this->data_.size();
+  const size_t packs = size / kPackSize;
+#pragma omp parallel for if (size >= kParallelSize)
+  for (size_t pack = 0; pack < packs; ++pack) {
+    float* pack_data = data + pack * kPackSize;
+    _mm256_storeu_ps(pack_data, func(_mm256_loadu_ps(pack_data)));
+  }
+  // 不足8个的尾部补零后计算，只写回有效的部分
+  const size_t tail = size - packs * kPackSize;
+  if (tail != 0) {
+    float lanes[kPackSize] = {0.f};
+    float* tail_data = data + packs * kPackSize;
+    std::copy(tail_data, tail_data + tail, lanes);
+    _mm256_storeu_ps(lanes, func(_mm256_loadu_ps(lanes)));
+    std::copy(lanes, lanes + tail, tail_data);
+  }
+}
+#endif
+
 using ftensor = Tensor<float>;
 using sftensor = std::shared_ptr<Tensor<float>>;
 
@@ -62,6 +62,16 @@ template <typename T>
 bool TensorIsSame(const std::shared_ptr<Tensor<T>>& a, const std::shared_ptr<Tensor<T>>& b,
                   T threshold = 1e-5f);
 
+/**
+ * @brief Checks whether two tensors have the same shape without allocating
+ *
+ * @param a Tensor 1
+ * @param b Tensor 2
+ * @return True if channels, rows and cols are all equal
+ */
+template <typename T>
+bool TensorShapeIsSame(const std::shared_ptr<Tensor<T>>& a, const std::shared_ptr<Tensor<T>>& b);
+
 /**
  * @brief Element-wise tensor add
  *
@@ -168,20 +178,32 @@ bool TensorIsSame(const std::shared_ptr<Tensor<T>>& a, const std::shared_ptr<Ten
   return is_same;
 }
 
+template <typename T>
+bool TensorShapeIsSame(const std::shared_ptr<Tensor<T>>& a, const std::shared_ptr<Tensor<T>>& b) {
+  CHECK(a != nullptr && b != nullptr);
+  return a->channels() == b->channels() && a->rows() == b->rows() && a->cols() == b->cols();
+}
+
 template <typename T>
 void TensorElementAdd(const std::shared_ptr<Tensor<T>>& tensor1,
                       const std::shared_ptr<Tensor<T>>& tensor2,
                       const std::shared_ptr<Tensor<T>>& output_tensor) {
   CHECK(tensor1 != nullptr && tensor2 != nullptr && output_tensor != nullptr);
-  if (tensor1->shapes() == tensor2->shapes()) {
-    CHECK(tensor1->shapes() == output_tensor->shapes());
-    output_tensor->set_data(tensor1->data() + tensor2->data());
+  if (TensorShapeIsSame(tensor1, tensor2)) {
+    CHECK(TensorShapeIsSame(tensor1, output_tensor));
+    output_tensor->data() = tensor1->data() + tensor2->data();
   } else {
+    // 逐通道广播，不生成广播后的中间张量
     CHECK(tensor1->channels() == tensor2->channels()) << "Tensors shape are not adapting";
-    const auto& [input_tensor1, input_tensor2] = TensorBroadcast(tensor1, tensor2);
-    CHECK(output_tensor->shapes() == input_tensor1->shapes() &&
-          output_tensor->shapes() == input_tensor2->shapes());
-    output_tensor->set_data(input_tensor1->data() + input_tensor2->data());
+    const bool broadcast_tensor2 = tensor2->rows() == 1 && tensor2->cols() == 1;
+    CHECK(broadcast_tensor2 || (tensor1->rows() == 1 && tensor1->cols() == 1))
+        << "Broadcast shape is not adapting!";
+    const auto& full_tensor = broadcast_tensor2 ? tensor1 : tensor2;
+    const auto& channel_tensor = broadcast_tensor2 ? tensor2 : tensor1;
+    CHECK(TensorShapeIsSame(full_tensor, output_tensor));
+    for (uint32_t c = 0; c < output_tensor->channels(); ++c) {
+      output_tensor->slice(c) = full_tensor->slice(c) + channel_tensor->index(c);
+    }
   }
 }
 
@@ -190,15 +212,21 @@ void TensorElementMultiply(const std::shared_ptr<Tensor<T>>& tensor1,
                            const std::shared_ptr<Tensor<T>>& tensor2,
                            const std::shared_ptr<Tensor<T>>& output_tensor) {
   CHECK(tensor1 != nullptr && tensor2 != nullptr && output_tensor != nullptr);
-  if (tensor1->shapes() == tensor2->shapes()) {
-    CHECK(tensor1->shapes() == output_tensor->shapes());
-    output_tensor->set_data(tensor1->data() % tensor2->data());
+  if (TensorShapeIsSame(tensor1, tensor2)) {
+    CHECK(TensorShapeIsSame(tensor1, output_tensor));
+    output_tensor->data() = tensor1->data() % tensor2->data();
   } else {
+    // 逐通道广播，不生成广播后的中间张量
     CHECK(tensor1->channels() == tensor2->channels()) << "Tensors shape are not adapting";
-    const auto& [input_tensor1, input_tensor2] = TensorBroadcast(tensor1, tensor2);
-    CHECK(output_tensor->shapes() == input_tensor1->shapes() &&
-          output_tensor->shapes() == input_tensor2->shapes());
-    output_tensor->set_data(input_tensor1->data() % input_tensor2->data());
+    const bool broadcast_tensor2 = tensor2->rows() == 1 && tensor2->cols() == 1;
+    CHECK(broadcast_tensor2 || (tensor1->rows() == 1 && tensor1->cols() == 1))
+        << "Broadcast shape is not adapting!";
+    const auto& full_tensor = broadcast_tensor2 ? tensor1 : tensor2;
+    const auto& channel_tensor = broadcast_tensor2 ? tensor2 : tensor1;
+    CHECK(TensorShapeIsSame(full_tensor, output_tensor));
+    for (uint32_t c = 0; c < output_tensor->channels(); ++c) {
+      output_tensor->slice(c) = full_tensor->slice(c) * channel_tensor->index(c);
+    }
   }
 }
 
@@ -0,0 +1,235 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-8.
+
+#ifndef KUIPER_INFER_DATA_TENSOR_VIEW_HPP_
+#define KUIPER_INFER_DATA_TENSOR_VIEW_HPP_
+#include <glog/logging.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "data/tensor.hpp"
+#include "runtime/runtime_datatype.hpp"
+
+namespace kuiper_infer {
+/**
+ * @brief Non-owning view of a contiguous sequence
+ *
+ * Passed by value instead of a reference to a vector, so the callee neither
+ * owns nor copies the elements.
+ */
+template <typename T>
+class Span {
+ public:
+  Span() = default;
+
+  Span(T* data, size_t size) : data_(data), size_(size) {}
+
+  template <typename Container,
+            typename = std::enable_if_t<std::is_convertible_v<
+                decltype(std::declval<Container&>().data()), T*>>>
+  Span(Container& container) : data_(container.data()), size_(container.size()) {}
+
+  T* data() const { return data_; }
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  T& operator[](size_t index) const { return data_[index]; }
+
+  T* begin() const { return data_; }
+
+  T* end() const { return data_ + size_; }
+
+ private:
+  T* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+template <typename T>
+struct TensorDataType {};
+
+template <>
+struct TensorDataType<float> {
+  static constexpr RuntimeDataType value = RuntimeDataType::kTypeFloat32;
+};
+
+template <>
+struct TensorDataType<int32_t> {
+  static constexpr RuntimeDataType value = RuntimeDataType::kTypeInt32;
+};
+
+template <>
+struct TensorDataType<uint8_t> {
+  static constexpr RuntimeDataType value = RuntimeDataType::kTypeUInt8;
+};
+
+/**
+ * @brief Non-owning view of the data of a tensor
+ *
+ * Holds the data pointer, the shape (channels, rows, cols), the strides of
+ * the three dimensions in elements and the data type. Copying a view does
+ * not touch any reference count, the viewed memory must outlive the view.
+ */
+class TensorView {
+ public:
+  TensorView() = default;
+
+  /**
+   * @brief Views a dense buffer in the layout of Tensor, column-major per channel
+   */
+  template <typename T>
+  TensorView(T* data, uint32_t channels, uint32_t rows, uint32_t cols)
+      : TensorView(data, channels, rows, cols, size_t(rows) * cols, 1, rows) {}
+
+  /**
+   * @brief Views a strided buffer
+   *
+   * @param data First element
+   * @param channels Number of channels
+   * @param rows Number of rows
+   * @param cols Number of columns
+   * @param channel_stride Distance between two channels in elements
+   * @param row_stride Distance between two rows in elements
+   * @param col_stride Distance between two columns in elements
+   */
+  template <typename T>
+  TensorView(T* data, uint32_t channels, uint32_t rows, uint32_t cols, size_t channel_stride,
+             size_t row_stride, size_t col_stride)
+      : data_(const_cast<std::remove_const_t<T>*>(data)),
+        dtype_(TensorDataType<std::remove_const_t<T>>::value),
+        channels_(channels),
+        rows_(rows),
+        cols_(cols),
+        channel_stride_(channel_stride),
+        row_stride_(row_stride),
+        col_stride_(col_stride) {}
+
+  /**
+   * @brief Views all elements of a tensor
+   */
+  template <typename T>
+  explicit TensorView(Tensor<T>& tensor)
+      : TensorView(tensor.raw_ptr(), tensor.channels(), tensor.rows(), tensor.cols()) {}
+
+  /**
+   * @brief Gets the data pointer, the type must match the viewed data
+   */
+  template <typename T>
+  T* data() const {
+    DCHECK(dtype_ == TensorDataType<std::remove_const_t<T>>::value)
+        << "The data type of the tensor view does not match";
+    return static_cast<T*>(data_);
+  }
+
+  /**
+   * @brief Gets an element by channel, row and column
+   */
+  template <typename T>
+  T& at(uint32_t channel, uint32_t row, uint32_t col) const {
+    DCHECK(channel < channels_ && row < rows_ && col < cols_);
+    return data<T>()[channel * channel_stride_ + row * row_stride_ + col * col_stride_];
+  }
+
+  /**
+   * @brief Views a single channel
+   */
+  TensorView channel(uint32_t index) const {
+    DCHECK(index < channels_);
+    TensorView view = *this;
+    view.data_ = static_cast<char*>(data_) + index * channel_stride_ * element_size();
+    view.channels_ = 1;
+    return view;
+  }
+
+  RuntimeDataType dtype() const { return dtype_; }
+
+  uint32_t channels() const { return channels_; }
+
+  uint32_t rows() const { return rows_; }
+
+  uint32_t cols() const { return cols_; }
+
+  size_t channel_stride() const { return channel_stride_; }
+
+  size_t row_stride() const { return row_stride_; }
+
+  size_t col_stride() const { return col_stride_; }
+
+  size_t size() const { return size_t(channels_) * rows_ * cols_; }
+
+  bool empty() const { return data_ == nullptr || size() == 0; }
+
+  /**
+   * @brief Whether the elements are stored densely in the layout of Tensor
+   *
+   * Kernels may then run over size() elements from the data pointer.
+   */
+  bool is_contiguous() const {
+    return row_stride_ == 1 && col_stride_ == rows_ && channel_stride_ == size_t(rows_) * cols_;
+  }
+
+  /**
+   * @brief Whether two views have the same channels, rows and cols
+   */
+  bool same_shape(const TensorView& other) const {
+    return channels_ == other.channels_ && rows_ == other.rows_ && cols_ == other.cols_;
+  }
+
+ private:
+  size_t element_size() const {
+    switch (dtype_) {
+      case RuntimeDataType::kTypeFloat32:
+      case RuntimeDataType::kTypeInt32:
+        return 4;
+      default:
+        return 1;
+    }
+  }
+
+  void* data_ = nullptr;
+  RuntimeDataType dtype_ = RuntimeDataType::kTypeUnknown;
+  uint32_t channels_ = 0;
+  uint32_t rows_ = 0;
+  uint32_t cols_ = 0;
+  size_t channel_stride_ = 0;
+  size_t row_stride_ = 0;
+  size_t col_stride_ = 0;
+};
+
+/**
+ * @brief Views every tensor of a batch, empty tensors give empty views
+ */
+template <typename T>
+std::vector<TensorView> MakeTensorViews(const std::vector<std::shared_ptr<Tensor<T>>>& tensors) {
+  std::vector<TensorView> views;
+  views.reserve(tensors.size());
+  for (const auto& tensor : tensors) {
+    views.push_back(tensor != nullptr && !tensor->empty() ? TensorView(*tensor) : TensorView());
+  }
+  return views;
+}
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_DATA_TENSOR_VIEW_HPP_
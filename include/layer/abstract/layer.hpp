@@ -29,9 +29,27 @@
 #include <utility>
 #include <vector>
 #include "data/tensor.hpp"
+#include "data/tensor_view.hpp"
 #include "runtime/runtime_op.hpp"
 #include "status_code.hpp"
 
+/**
+ * @brief Checks a condition inside the forward loops of a layer
+ *
+ * CHECK_WHEN only checks while `enabled` is true, LAYER_CHECK while the
+ * layer's checks are on. The runtime graph turns them off after it has
+ * validated the layer shapes. Debug builds always check.
+ */
+#ifdef NDEBUG
+#define CHECK_WHEN(enabled, condition)                                         \
+  LOG_IF(FATAL, (enabled) && GOOGLE_PREDICT_BRANCH_NOT_TAKEN(!(condition))) \
+      << "Check failed: " #condition " "
+#else
+#define CHECK_WHEN(enabled, condition) CHECK(condition)
+#endif
+
+#define LAYER_CHECK(condition) CHECK_WHEN(this->checked_, condition)
+
 namespace kuiper_infer {
 template <typename T>
 class Layer;
@@ -39,6 +57,48 @@ class Layer;
 template <>
 class Layer<int8_t> {};
 
+/**
+ * @brief Analytic work of a layer for a whole batch
+ */
+struct LayerCost {
+  /// Floating point operations, a multiply-add counts as two
+  double flops = 0.;
+
+  /// Number of weight and bias values
+  double parameters = 0.;
+
+  /// Bytes of weights and biases read
+  double weight_bytes = 0.;
+
+  /// Bytes of input activations read
+  double input_bytes = 0.;
+
+  /// Bytes of output activations written
+  double output_bytes = 0.;
+
+  /**
+   * @brief Gets all bytes moved by the layer
+   */
+  double bytes() const { return weight_bytes + input_bytes + output_bytes; }
+
+  LayerCost& operator+=(const LayerCost& other);
+};
+
+/**
+ * @brief Split of the threads of a layer between and within the samples
+ *
+ * Chosen per operator by the cost model of the runtime graph. A zero keeps
+ * the default of the layer: one thread per sample for the batch loop and
+ * all OpenMP threads for the loops inside a sample.
+ */
+struct ParallelPlan {
+  /// Threads running the samples of the batch concurrently
+  uint32_t batch_threads = 0;
+
+  /// Threads splitting the channels or rows of one sample
+  uint32_t intra_threads = 0;
+};
+
 /**
  * @brief Base layer class
  *
@@ -83,6 +143,25 @@ class Layer<float> {
   virtual StatusCode Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                              std::vector<std::shared_ptr<Tensor<float>>>& outputs);
 
+  /**
+   * @brief Performs forward inference on non-owning tensor views
+   *
+   * Kernel interface of the layers that override supports_views. The runtime
+   * graph binds the views once and calls this method instead of the shared_ptr
+   * Forward, so no reference count or tensor vector is touched per call. The
+   * output views must already have their final shapes.
+   *
+   * @param inputs Views of the input tensors
+   * @param outputs Views of the output tensors
+   * @return Status code
+   */
+  virtual StatusCode ForwardViews(Span<const TensorView> inputs, Span<const TensorView> outputs);
+
+  /**
+   * @brief Whether the layer implements ForwardViews
+   */
+  virtual bool supports_views() const { return false; }
+
   /**
    * @brief Gets layer weights
    *
@@ -133,6 +212,28 @@ class Layer<float> {
    */
   virtual void set_bias(const std::vector<float>& bias);
 
+  /**
+   * @brief Fuses a following residual add into the layer output
+   *
+   * After the fusion the layer receives the residual tensors behind its
+   * regular inputs, adds them to its outputs and applies the activation
+   * before the outputs are written back.
+   *
+   * @param activation_type Operator type of the fused activation, empty if none
+   * @return True if the layer supports the fusion
+   */
+  virtual bool FuseResidualAdd(const std::string& activation_type);
+
+  /**
+   * @brief Switches the layer to int8 weights with dynamic activation quantization
+   *
+   * The weights are quantized once per output channel, the activations are
+   * quantized per row in every forward call, so no calibration is needed.
+   *
+   * @return True if the layer supports dynamic quantization
+   */
+  virtual bool QuantizeWeights();
+
   /**
    * @brief Gets layer name
    *
@@ -149,9 +250,85 @@ class Layer<float> {
    */
   void set_runtime_operator(const std::shared_ptr<RuntimeOperator>& runtime_operator);
 
+  /**
+   * @brief Enables or disables the checks inside the forward loops
+   *
+   * The runtime graph disables them after the shapes of the layer have been
+   * validated, see LAYER_CHECK.
+   *
+   * @param checked Whether the forward loops check their inputs
+   */
+  virtual void set_checked(bool checked);
+
+  /**
+   * @brief Whether the forward loops check their inputs
+   */
+  bool checked() const { return this->checked_; }
+
+  /**
+   * @brief Computes the analytic work of the layer
+   *
+   * Derived from the configured parameters of the layer and the operand
+   * shapes, which include the batch dimension. The default counts one
+   * operation per output element and no weights.
+   *
+   * @param input_shapes Shapes of the input operands
+   * @param output_shape Shape of the output operand
+   * @return Work of the layer for the whole batch
+   */
+  virtual LayerCost Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                         const std::vector<int32_t>& output_shape) const;
+
+  /**
+   * @brief Computes the per-thread scratch the kernels of the layer need
+   *
+   * The runtime graph reserves it in the LayerWorkspace at Build. The
+   * default is no scratch.
+   *
+   * @param input_shapes Shapes of the input operands
+   * @param output_shape Shape of the output operand
+   * @return Scratch of one thread in floats
+   */
+  virtual size_t WorkspaceSize(const std::vector<std::vector<int32_t>>& input_shapes,
+                               const std::vector<int32_t>& output_shape) const;
+
+  /**
+   * @brief Sets the thread split chosen by the runtime graph
+   *
+   * @param parallel_plan Threads across and within the samples
+   */
+  virtual void set_parallel_plan(const ParallelPlan& parallel_plan);
+
+  /**
+   * @brief Gets the thread split of the layer
+   */
+  const ParallelPlan& parallel_plan() const { return this->parallel_plan_; }
+
+  /**
+   * @brief Number of threads for the loop over the samples of a batch
+   *
+   * @param batch_size Number of samples
+   * @return Threads of the plan, one per sample without a plan
+   */
+  uint32_t batch_threads(uint32_t batch_size) const;
+
+  /**
+   * @brief Number of threads for the loops inside one sample
+   *
+   * @return Threads of the plan, the OpenMP default without a plan
+   */
+  uint32_t intra_threads() const;
+
  protected:
+  /**
+   * @brief Gets the number of elements of an operand shape
+   */
+  static double ShapeElements(const std::vector<int32_t>& shape);
+
   std::string layer_name_;
   std::weak_ptr<RuntimeOperator> runtime_operator_;
+  bool checked_ = true;
+  ParallelPlan parallel_plan_;
 };
 }  // namespace kuiper_infer
 #endif  // KUIPER_INFER_SOURCE_LAYER_LAYER_HPP_
@@ -0,0 +1,70 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-3.
+
+#ifndef KUIPER_INFER_SOURCE_LAYER_LAYER_WORKSPACE_HPP_
+#define KUIPER_INFER_SOURCE_LAYER_LAYER_WORKSPACE_HPP_
+#include <cstddef>
+#include <cstdint>
+
+namespace kuiper_infer {
+/**
+ * @brief Per-thread scratch memory shared by the kernels of all layers
+ *
+ * Layers declare their per-thread scratch requirement when the graph is
+ * built. Each thread owns one buffer of the largest declared size, which
+ * kernels split into slices. A kernel must not keep its slices across calls
+ * into other layers.
+ */
+class LayerWorkspace {
+ public:
+  /// Alignment of the buffer and its slices in floats
+  static constexpr size_t kAlignment = 16;
+
+  /**
+   * @brief Raises the per-thread requirement to at least size floats
+   */
+  static void Reserve(size_t size);
+
+  /**
+   * @brief Gets the largest requirement declared so far in floats
+   */
+  static size_t reserved_size();
+
+  /**
+   * @brief Gets the buffer of the calling thread
+   *
+   * Allocates only when the thread has no buffer of the reserved size yet,
+   * so kernels of a built graph never allocate.
+   *
+   * @param size Floats the caller needs
+   * @return Buffer of at least max(size, reserved_size()) floats
+   */
+  static float* Acquire(size_t size);
+
+  /**
+   * @brief Rounds a slice up so the next slice stays aligned
+   */
+  static size_t SliceSize(size_t size) { return (size + kAlignment - 1) / kAlignment * kAlignment; }
+};
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_SOURCE_LAYER_LAYER_WORKSPACE_HPP_
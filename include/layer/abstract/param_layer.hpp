@@ -122,6 +122,12 @@ class ParamLayer : public Layer<float> {
    */
   void set_bias(const std::vector<std::shared_ptr<Tensor<float>>>& bias) override;
 
+  /**
+   * @brief Adds the weights and biases to the cost of the layer
+   */
+  LayerCost Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                 const std::vector<int32_t>& output_shape) const override;
+
  protected:
   std::vector<std::shared_ptr<Tensor<float>>> weights_;
   std::vector<std::shared_ptr<Tensor<float>>> bias_;
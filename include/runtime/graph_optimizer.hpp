@@ -0,0 +1,161 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-27.
+
+#ifndef KUIPER_INFER_INCLUDE_RUNTIME_GRAPH_OPTIMIZER_HPP_
+#define KUIPER_INFER_INCLUDE_RUNTIME_GRAPH_OPTIMIZER_HPP_
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "runtime/pnnx/ir.h"
+
+namespace kuiper_infer {
+
+/**
+ * @brief Statistics of one optimization pass
+ */
+struct GraphPassStats {
+  /// Name of the pass
+  std::string pass_name;
+
+  /// Number of rewrites done by the pass
+  uint32_t rewrites = 0;
+
+  /// Operator count before and after the pass
+  uint32_t ops_before = 0;
+  uint32_t ops_after = 0;
+
+  /// Time spent in the pass in ms
+  double elapsed_time = 0.;
+};
+
+/**
+ * @brief Offline optimizer rewriting a PNNX graph in place
+ *
+ * The optimized graph is written back with pnnx::Graph::save and loaded by
+ * RuntimeGraph like any other model, so the optimization cost is paid once
+ * offline instead of at every startup.
+ */
+class GraphOptimizer {
+ public:
+  /**
+   * @brief Construct a new optimizer on a loaded graph
+   *
+   * @param graph The PNNX graph to rewrite
+   */
+  explicit GraphOptimizer(pnnx::Graph& graph);
+
+  /**
+   * @brief Runs every pass in order
+   *
+   * @return Statistics of the passes
+   */
+  std::vector<GraphPassStats> Optimize();
+
+  /**
+   * @brief Removes operators which forward their input unchanged
+   *
+   * Removes nn.Identity, dropout, clone and contiguous operators as well as
+   * views whose output shape equals the input shape.
+   *
+   * @return Number of removed operators
+   */
+  uint32_t EliminateIdentity();
+
+  /**
+   * @brief Folds nn.BatchNorm2d into the preceding nn.Conv2d
+   *
+   * The convolution weights are scaled by gamma / sqrt(var + eps) and the
+   * bias becomes (bias - mean) * gamma / sqrt(var + eps) + beta.
+   *
+   * @return Number of folded batch norms
+   */
+  uint32_t FoldBatchNorm();
+
+  /**
+   * @brief Fuses activations into the preceding convolution
+   *
+   * The activation type is recorded in the "activation" parameter of the
+   * convolution, which applies it in its output stage.
+   *
+   * @return Number of fused activations
+   */
+  uint32_t FuseActivation();
+
+  /**
+   * @brief Fuses a depthwise convolution into the following pointwise convolution
+   *
+   * A depthwise nn.Conv2d whose only consumer is a 1x1 nn.Conv2d becomes one
+   * kuiper.DepthwisePointwise operator, which computes both convolutions tile
+   * by tile without materializing the intermediate tensor. Activations fused
+   * into either convolution are kept.
+   *
+   * @return Number of fused convolution pairs
+   */
+  uint32_t FuseDepthwisePointwise();
+
+  /**
+   * @brief Folds chains of reshapes with static shapes
+   *
+   * A chain of Tensor.view and torch.flatten operators is replaced by one
+   * Tensor.view to the final shape, which is known at export time.
+   *
+   * @return Number of removed operators
+   */
+  uint32_t FoldConstantShape();
+
+  /**
+   * @brief Removes operators whose outputs are never used
+   *
+   * @return Number of removed operators
+   */
+  uint32_t EliminateDeadCode();
+
+ private:
+  /**
+   * @brief Lets the consumers of an operand read another operand
+   */
+  static void ReplaceOperandUses(pnnx::Operand* from, pnnx::Operand* to);
+
+  /**
+   * @brief Merges a single-input consumer into its producer
+   *
+   * The producer takes over the output operand of the consumer, the
+   * consumer and the intermediate operand are deleted.
+   */
+  void MergeIntoProducer(pnnx::Operator* producer, pnnx::Operator* consumer);
+
+  /**
+   * @brief Deletes an operator and its output operands
+   */
+  void RemoveOperator(pnnx::Operator* op);
+
+  /**
+   * @brief Deletes an operand which has neither producer nor consumers
+   */
+  void RemoveOperand(pnnx::Operand* operand);
+
+  pnnx::Graph& graph_;
+};
+
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_INCLUDE_RUNTIME_GRAPH_OPTIMIZER_HPP_
@@ -213,6 +213,8 @@ class Graph
 
   int python(const std::string& pypath, const std::string& binpath);
 
+  int cpp(const std::string& cpppath, const std::string& binpath);
+
   int parse(const std::string& param);
 
   Operator* new_operator(const std::string& type, const std::string& name);
@@ -31,6 +31,10 @@ class StoreZipReader {
 
   size_t get_file_size(const std::string& name);
 
+  size_t get_file_offset(const std::string& name);
+
+  std::vector<std::string> get_names() const;
+
   int read_file(const std::string& name, char* data);
 
   int close();
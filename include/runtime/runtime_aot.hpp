@@ -0,0 +1,162 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-31.
+
+#ifndef KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_AOT_HPP_
+#define KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_AOT_HPP_
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "layer/abstract/layer.hpp"
+#include "runtime/pnnx/store_zip.hpp"
+#include "runtime/runtime_op.hpp"
+
+namespace kuiper_infer {
+
+/**
+ * @brief Weight attribute of an operator in generated code
+ */
+struct AotAttribute {
+  /// Name of the attribute, such as weight
+  std::string name;
+
+  /// PNNX element type of the attribute, 1 is f32
+  int32_t type = 1;
+
+  /// Shape of the attribute
+  std::vector<int32_t> shape;
+};
+
+/**
+ * @brief Operator description emitted by pnnx::Graph::cpp()
+ *
+ * Carries everything the layer factory needs, so generated code does not
+ * read the param file.
+ */
+struct AotOperator {
+  /// Type of the operator, such as nn.Conv2d
+  std::string type;
+
+  /// Name of the operator, prefix of its weights in the bin file
+  std::string name;
+
+  /// Parameters encoded as in the param file
+  std::vector<std::pair<std::string, std::string>> params;
+
+  /// Weight attributes read from the bin file
+  std::vector<AotAttribute> attrs;
+
+  /// Shapes of the input operands including the batch dimension
+  std::vector<std::vector<int32_t>> input_shapes;
+
+  /// Shape of the output operand including the batch dimension
+  std::vector<int32_t> output_shape;
+};
+
+/**
+ * @brief One block of memory holding every activation of a generated model
+ *
+ * The generator plans the offsets of all operands from their lifetimes, so
+ * operands that are never alive at the same time share memory.
+ */
+class AotArena {
+ public:
+  /**
+   * @brief Allocates the arena
+   *
+   * @param size Number of floats in the arena
+   */
+  explicit AotArena(size_t size);
+
+  /**
+   * @brief Creates the tensors of an operand on the arena
+   *
+   * @param offset Offset of the operand in floats, aligned to 64 bytes
+   * @param shape Shape of the operand including the batch dimension
+   * @return One tensor per sample, sharing the memory of the arena
+   */
+  std::vector<sftensor> Tensors(size_t offset, const std::vector<int32_t>& shape);
+
+  /**
+   * @brief Gets the number of floats in the arena
+   */
+  size_t size() const { return size_; }
+
+  /**
+   * @brief Gets the first float of the arena, operand offsets are relative to it
+   */
+  float* data() { return data_.get(); }
+
+ private:
+  size_t size_ = 0;
+  std::unique_ptr<float, void (*)(void*)> data_;
+};
+
+/**
+ * @brief Loads the weights of generated code and creates its fallback layers
+ */
+class AotLoader {
+ public:
+  /**
+   * @brief Opens the PNNX bin file holding the weights
+   *
+   * @param bin_path Path of the bin file
+   */
+  explicit AotLoader(const std::string& bin_path);
+
+  ~AotLoader();
+
+  /**
+   * @brief Creates the layer of an operator through the layer factory
+   *
+   * Also chooses the thread split of the layer with the cost model of the
+   * runtime graph.
+   *
+   * @param aot_operator Description of the operator
+   * @return The created layer
+   */
+  std::shared_ptr<Layer<float>> CreateLayer(const AotOperator& aot_operator);
+
+  /**
+   * @brief Reads a f32 weight attribute for a specialized kernel
+   *
+   * @param op_name Name of the operator
+   * @param attr_name Name of the attribute, such as weight
+   * @param size Number of floats the attribute must hold
+   * @return Values of the attribute in the PNNX layout
+   */
+  std::vector<float> ReadAttribute(const std::string& op_name, const std::string& attr_name,
+                                   size_t size);
+
+ private:
+  pnnx::StoreZipReader reader_;
+  std::vector<std::shared_ptr<RuntimeOperator>> operators_;
+};
+
+/**
+ * @brief Concatenates the tensors of several operands into the inputs of a layer
+ */
+std::vector<sftensor> AotConcat(const std::vector<std::vector<sftensor>>& operands);
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_AOT_HPP_
@@ -0,0 +1,322 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-10.
+
+#ifndef KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_AOT_KERNELS_HPP_
+#define KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_AOT_KERNELS_HPP_
+#include <armadillo>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace kuiper_infer {
+namespace aot {
+/**
+ * Kernels called by the code pnnx::Graph::cpp() generates. Every shape and
+ * geometry is a template argument, so the loop bounds and the operand
+ * offsets are compile-time constants and the compiler unrolls the window
+ * loops. The tensors are raw pointers into the arena, each sample stores
+ * its channels one after another, every channel column-major as in Tensor.
+ */
+
+/**
+ * @brief Activation applied by a kernel to its output
+ */
+enum class Activation {
+  kNone,
+  kRelu,
+  kRelu6,
+  kSigmoid,
+  kSilu,
+  kHardSigmoid,
+  kHardSwish,
+};
+
+template <Activation A>
+inline float ActivateValue(float x) {
+  if constexpr (A == Activation::kRelu) {
+    return std::max(x, 0.f);
+  } else if constexpr (A == Activation::kRelu6) {
+    return std::min(std::max(x, 0.f), 6.f);
+  } else if constexpr (A == Activation::kSigmoid) {
+    return 1.f / (1.f + std::exp(-x));
+  } else if constexpr (A == Activation::kSilu) {
+    return x / (1.f + std::exp(-x));
+  } else if constexpr (A == Activation::kHardSigmoid) {
+    return std::min(std::max(x + 3.f, 0.f), 6.f) / 6.f;
+  } else if constexpr (A == Activation::kHardSwish) {
+    return x * std::min(std::max(x + 3.f, 0.f), 6.f) / 6.f;
+  } else {
+    return x;
+  }
+}
+
+/**
+ * @brief Applies an activation to size elements
+ */
+template <size_t Size, Activation A>
+inline void Activate(const float* input, float* output) {
+#pragma omp simd
+  for (size_t i = 0; i < Size; ++i) {
+    output[i] = ActivateValue<A>(input[i]);
+  }
+}
+
+/**
+ * @brief Adds two operands of the same shape
+ */
+template <size_t Size>
+inline void Add(const float* input1, const float* input2, float* output) {
+#pragma omp simd
+  for (size_t i = 0; i < Size; ++i) {
+    output[i] = input1[i] + input2[i];
+  }
+}
+
+/**
+ * @brief Multiplies two operands of the same shape
+ */
+template <size_t Size>
+inline void Mul(const float* input1, const float* input2, float* output) {
+#pragma omp simd
+  for (size_t i = 0; i < Size; ++i) {
+    output[i] = input1[i] * input2[i];
+  }
+}
+
+/**
+ * @brief Output size of a window along one dimension
+ */
+constexpr uint32_t WindowOutput(uint32_t input, uint32_t kernel, uint32_t stride,
+                                uint32_t padding, uint32_t dilation = 1) {
+  return (input + 2 * padding - dilation * (kernel - 1) - 1) / stride + 1;
+}
+
+/**
+ * @brief Im2col of C channels
+ *
+ * Writes a (C * KH * KW) x (OH * OW) column-major matrix. Column p holds the
+ * window of output position p, positions are ordered as the elements of an
+ * output channel, rows are ordered as the weights of an output channel.
+ */
+template <uint32_t C, uint32_t H, uint32_t W, uint32_t KH, uint32_t KW, uint32_t SH, uint32_t SW,
+          uint32_t PH, uint32_t PW, uint32_t DH, uint32_t DW>
+inline void Im2Col(const float* input, float* matrix) {
+  constexpr uint32_t OH = WindowOutput(H, KH, SH, PH, DH);
+  constexpr uint32_t OW = WindowOutput(W, KW, SW, PW, DW);
+  constexpr uint32_t KK = C * KH * KW;
+#pragma omp parallel for if (size_t(KK) * OH * OW >= (1 << 16))
+  for (uint32_t ow = 0; ow < OW; ++ow) {
+    for (uint32_t oh = 0; oh < OH; ++oh) {
+      float* column = matrix + (size_t(ow) * OH + oh) * KK;
+      for (uint32_t c = 0; c < C; ++c) {
+        const float* channel = input + size_t(c) * H * W;
+        for (uint32_t kw = 0; kw < KW; ++kw) {
+          const int32_t iw = int32_t(ow * SW + kw * DW) - int32_t(PW);
+          for (uint32_t kh = 0; kh < KH; ++kh) {
+            const int32_t ih = int32_t(oh * SH + kh * DH) - int32_t(PH);
+            const bool inside = ih >= 0 && ih < int32_t(H) && iw >= 0 && iw < int32_t(W);
+            column[(c * KH + kh) * KW + kw] = inside ? channel[iw * H + ih] : 0.f;
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Depthwise convolution of one channel, without bias
+ */
+template <uint32_t H, uint32_t W, uint32_t KH, uint32_t KW, uint32_t SH, uint32_t SW, uint32_t PH,
+          uint32_t PW, uint32_t DH, uint32_t DW>
+inline void DepthwiseChannel(const float* input, const float* weight, float* output) {
+  constexpr uint32_t OH = WindowOutput(H, KH, SH, PH, DH);
+  constexpr uint32_t OW = WindowOutput(W, KW, SW, PW, DW);
+  for (uint32_t ow = 0; ow < OW; ++ow) {
+    for (uint32_t oh = 0; oh < OH; ++oh) {
+      float sum = 0.f;
+      for (uint32_t kw = 0; kw < KW; ++kw) {
+        const int32_t iw = int32_t(ow * SW + kw * DW) - int32_t(PW);
+        for (uint32_t kh = 0; kh < KH; ++kh) {
+          const int32_t ih = int32_t(oh * SH + kh * DH) - int32_t(PH);
+          if (ih >= 0 && ih < int32_t(H) && iw >= 0 && iw < int32_t(W)) {
+            sum += weight[kh * KW + kw] * input[iw * H + ih];
+          }
+        }
+      }
+      output[ow * OH + oh] = sum;
+    }
+  }
+}
+
+/**
+ * @brief Convolution of N samples with a fused bias and activation
+ *
+ * The weights keep the PNNX layout (OC, C / G, KH, KW). Depthwise
+ * convolutions run directly on the windows and pointwise convolutions
+ * multiply the input directly. Other geometries go through Im2Col into the
+ * scratch memory, which holds (C / G) * KH * KW * OH * OW floats. bias may be
+ * nullptr.
+ */
+template <uint32_t N, uint32_t C, uint32_t H, uint32_t W, uint32_t OC, uint32_t KH, uint32_t KW,
+          uint32_t SH, uint32_t SW, uint32_t PH, uint32_t PW, uint32_t DH, uint32_t DW,
+          uint32_t G, Activation A>
+inline void Conv2d(const float* input, const float* weight, const float* bias, float* output,
+                   float* scratch) {
+  static_assert(C % G == 0 && OC % G == 0, "The channels are not divisible by the groups");
+  constexpr uint32_t OH = WindowOutput(H, KH, SH, PH, DH);
+  constexpr uint32_t OW = WindowOutput(W, KW, SW, PW, DW);
+  constexpr uint32_t P = OH * OW;
+  constexpr uint32_t CG = C / G;
+  constexpr uint32_t OCG = OC / G;
+  constexpr uint32_t KK = CG * KH * KW;
+  constexpr bool kPointwise = KH == 1 && KW == 1 && SH == 1 && SW == 1 && PH == 0 && PW == 0;
+
+  for (uint32_t n = 0; n < N; ++n) {
+    const float* sample_input = input + size_t(n) * C * H * W;
+    float* sample_output = output + size_t(n) * OC * P;
+    if constexpr (CG == 1 && OCG == 1) {
+#pragma omp parallel for if (size_t(C) * P * KK >= (1 << 16))
+      for (uint32_t c = 0; c < C; ++c) {
+        DepthwiseChannel<H, W, KH, KW, SH, SW, PH, PW, DH, DW>(sample_input + size_t(c) * H * W,
+                                                               weight + size_t(c) * KK,
+                                                               sample_output + size_t(c) * P);
+      }
+    } else {
+      for (uint32_t g = 0; g < G; ++g) {
+        const float* group_input = sample_input + size_t(g) * CG * H * W;
+        const arma::fmat weight_mat(const_cast<float*>(weight) + size_t(g) * OCG * KK, KK, OCG,
+                                    false, true);
+        arma::fmat output_mat(sample_output + size_t(g) * OCG * P, P, OCG, false, true);
+        if constexpr (kPointwise) {
+          // 输入的每个通道连续存放，本身就是P x C的列主序矩阵
+          const arma::fmat input_mat(const_cast<float*>(group_input), P, CG, false, true);
+          output_mat = input_mat * weight_mat;
+        } else {
+          Im2Col<CG, H, W, KH, KW, SH, SW, PH, PW, DH, DW>(group_input, scratch);
+          const arma::fmat matrix_mat(scratch, KK, P, false, true);
+          output_mat = matrix_mat.t() * weight_mat;
+        }
+      }
+    }
+
+#pragma omp parallel for if (size_t(OC) * P >= (1 << 16))
+    for (uint32_t oc = 0; oc < OC; ++oc) {
+      float* channel = sample_output + size_t(oc) * P;
+      const float channel_bias = bias != nullptr ? bias[oc] : 0.f;
+#pragma omp simd
+      for (uint32_t p = 0; p < P; ++p) {
+        channel[p] = ActivateValue<A>(channel[p] + channel_bias);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Max pooling of N samples with C channels
+ */
+template <uint32_t N, uint32_t C, uint32_t H, uint32_t W, uint32_t KH, uint32_t KW, uint32_t SH,
+          uint32_t SW, uint32_t PH, uint32_t PW>
+inline void MaxPool2d(const float* input, float* output) {
+  constexpr uint32_t OH = WindowOutput(H, KH, SH, PH);
+  constexpr uint32_t OW = WindowOutput(W, KW, SW, PW);
+#pragma omp parallel for if (size_t(N) * C * OH * OW * KH * KW >= (1 << 16))
+  for (uint32_t nc = 0; nc < N * C; ++nc) {
+    const float* channel = input + size_t(nc) * H * W;
+    float* output_channel = output + size_t(nc) * OH * OW;
+    for (uint32_t ow = 0; ow < OW; ++ow) {
+      for (uint32_t oh = 0; oh < OH; ++oh) {
+        float max_value = std::numeric_limits<float>::lowest();
+        for (uint32_t kw = 0; kw < KW; ++kw) {
+          const int32_t iw = int32_t(ow * SW + kw) - int32_t(PW);
+          for (uint32_t kh = 0; kh < KH; ++kh) {
+            const int32_t ih = int32_t(oh * SH + kh) - int32_t(PH);
+            if (ih >= 0 && ih < int32_t(H) && iw >= 0 && iw < int32_t(W)) {
+              max_value = std::max(max_value, channel[iw * H + ih]);
+            }
+          }
+        }
+        output_channel[ow * OH + oh] = max_value;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Adaptive average pooling to 1x1 of N samples with C channels
+ */
+template <uint32_t N, uint32_t C, uint32_t H, uint32_t W>
+inline void GlobalAvgPool2d(const float* input, float* output) {
+  for (uint32_t nc = 0; nc < N * C; ++nc) {
+    const float* channel = input + size_t(nc) * H * W;
+    float sum = 0.f;
+#pragma omp simd reduction(+ : sum)
+    for (uint32_t i = 0; i < H * W; ++i) {
+      sum += channel[i];
+    }
+    output[nc] = sum / float(H * W);
+  }
+}
+
+/**
+ * @brief Flattens (N, C, H, W) to (N, C * H * W) in row-major order
+ */
+template <uint32_t N, uint32_t C, uint32_t H, uint32_t W>
+inline void Flatten(const float* input, float* output) {
+  for (uint32_t nc = 0; nc < N * C; ++nc) {
+    const float* channel = input + size_t(nc) * H * W;
+    float* output_channel = output + size_t(nc) * H * W;
+    if constexpr (H == 1 || W == 1) {
+      std::copy(channel, channel + H * W, output_channel);
+    } else {
+      for (uint32_t h = 0; h < H; ++h) {
+        for (uint32_t w = 0; w < W; ++w) {
+          output_channel[h * W + w] = channel[w * H + h];
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Linear layer on (N, IN) inputs, the weights keep the layout (OUT, IN)
+ */
+template <uint32_t N, uint32_t IN, uint32_t OUT>
+inline void Linear(const float* input, const float* weight, const float* bias, float* output) {
+  const arma::fmat input_mat(const_cast<float*>(input), IN, N, false, true);
+  const arma::fmat weight_mat(const_cast<float*>(weight), IN, OUT, false, true);
+  arma::fmat output_mat(output, OUT, N, false, true);
+  output_mat = weight_mat.t() * input_mat;
+  if (bias != nullptr) {
+    for (uint32_t n = 0; n < N; ++n) {
+#pragma omp simd
+      for (uint32_t o = 0; o < OUT; ++o) {
+        output[n * OUT + o] += bias[o];
+      }
+    }
+  }
+}
+
+}  // namespace aot
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_AOT_KERNELS_HPP_
@@ -0,0 +1,143 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-30.
+
+#ifndef KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_BINDING_HPP_
+#define KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_BINDING_HPP_
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "data/tensor.hpp"
+
+namespace kuiper_infer {
+
+/**
+ * @brief Element type of a caller-owned buffer
+ */
+enum class BufferDataType {
+  kFloat32 = 0,
+  kUInt8 = 1,
+};
+
+/**
+ * @brief Caller-owned memory bound as a graph input or output
+ *
+ * The shape is the shape of the graph operand including the batch
+ * dimension, such as {N, C, H, W}. Strides are counted in elements and
+ * default to a dense row-major layout. Elements are converted as
+ * value * scale + offset on the way in and on the way out, uint8 outputs
+ * are rounded and saturated.
+ */
+struct ExternalBuffer {
+  /// Caller-owned memory, must outlive the binding
+  void* data = nullptr;
+
+  /// Element type of the memory
+  BufferDataType type = BufferDataType::kFloat32;
+
+  /// Shape of the operand including the batch dimension
+  std::vector<uint32_t> shape;
+
+  /// Element strides of every dimension, empty for dense row-major
+  std::vector<int64_t> strides;
+
+  /// Factor applied to every element
+  float scale = 1.f;
+
+  /// Offset added to every element after scaling
+  float offset = 0.f;
+
+  /**
+   * @brief Creates a dense row-major float buffer
+   */
+  static ExternalBuffer RowMajor(float* data, std::vector<uint32_t> shape);
+
+  /**
+   * @brief Creates a dense row-major uint8 buffer
+   */
+  static ExternalBuffer RowMajor(uint8_t* data, std::vector<uint32_t> shape, float scale = 1.f,
+                                 float offset = 0.f);
+
+  /**
+   * @brief Gets the strides, filling in the dense row-major default
+   */
+  std::vector<int64_t> element_strides() const;
+
+  /**
+   * @brief Whether the memory already has the layout of the engine tensors
+   *
+   * Such buffers are wrapped by tensors without any copy: float elements
+   * without conversion, every sample stored channel by channel and every
+   * channel column-major.
+   */
+  bool IsTensorLayout() const;
+};
+
+/**
+ * @brief Caller-owned buffer bound to the tensors of a graph operand
+ */
+struct BufferBinding {
+  /// Name of the graph input or output
+  std::string name;
+
+  /// The caller-owned memory
+  ExternalBuffer buffer;
+
+  /// Engine tensors read from or written to the buffer
+  std::vector<sftensor> tensors;
+};
+
+/**
+ * @brief Wraps every sample of a buffer in the tensor layout as a tensor
+ *
+ * @param buffer Buffer for which IsTensorLayout holds
+ * @return One tensor per sample, sharing the memory of the buffer
+ */
+std::vector<sftensor> WrapBuffer(const ExternalBuffer& buffer);
+
+/**
+ * @brief Creates engine tensors for every sample of a buffer
+ *
+ * @param buffer The buffer
+ * @return One tensor per sample with the shape of the sample
+ */
+std::vector<sftensor> CreateBufferTensors(const ExternalBuffer& buffer);
+
+/**
+ * @brief Converts a sample of a buffer into an engine tensor
+ *
+ * @param buffer The source buffer
+ * @param batch_index Index of the sample
+ * @param tensor Destination tensor with the shape of the sample
+ */
+void ReadBuffer(const ExternalBuffer& buffer, uint32_t batch_index, Tensor<float>& tensor);
+
+/**
+ * @brief Converts an engine tensor into a sample of a buffer
+ *
+ * @param tensor Source tensor with the shape of the sample
+ * @param batch_index Index of the sample
+ * @param buffer The destination buffer
+ */
+void WriteBuffer(const Tensor<float>& tensor, uint32_t batch_index, const ExternalBuffer& buffer);
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_BINDING_HPP_
@@ -0,0 +1,208 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-9.
+
+#ifndef KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_CACHE_HPP_
+#define KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_CACHE_HPP_
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "runtime/runtime_ir.hpp"
+
+namespace kuiper_infer {
+
+/**
+ * @brief Hit and miss counters of the result cache
+ */
+struct RuntimeCacheMetrics {
+  /// Lookups answered from the cache
+  uint64_t hits = 0;
+
+  /// Lookups that had to run the graph
+  uint64_t misses = 0;
+
+  /// Entries dropped by the LRU policy
+  uint64_t evictions = 0;
+
+  /**
+   * @brief Ratio of hits to lookups
+   *
+   * @return Hit rate in [0, 1], zero if nothing was looked up
+   */
+  double hit_rate() const {
+    const uint64_t lookups = hits + misses;
+    return lookups == 0 ? 0. : double(hits) / double(lookups);
+  }
+};
+
+/**
+ * @brief Key of a cached inference result
+ */
+struct RuntimeCacheKey {
+  /// Name of the model
+  std::string model_name;
+
+  /// Name of the graph input the tensors are bound to
+  std::string input_name;
+
+  /// Name of the requested graph output
+  std::string output_name;
+
+  /// Hash of the input tensors, see RuntimeResultCache::HashTensors
+  uint64_t input_hash = 0;
+
+  bool operator<(const RuntimeCacheKey& rhs) const {
+    return std::tie(model_name, input_name, output_name, input_hash) <
+           std::tie(rhs.model_name, rhs.input_name, rhs.output_name, rhs.input_hash);
+  }
+};
+
+/**
+ * @brief Content-addressed cache of inference results
+ *
+ * Sits in front of a RuntimeGraph and keys the graph outputs by the model,
+ * the input and output names and a 64 bit hash of the input tensors.
+ * Byte-identical inputs are answered from a bounded LRU without executing
+ * the graph. Forward keeps a copy of the inputs and compares it on a hit,
+ * so a hash collision only costs a graph execution. Thread safe, misses on
+ * the same graph execute it one at a time. Callers that run the graph
+ * outside the cache must serialize that with the cache themselves.
+ */
+class RuntimeResultCache {
+ public:
+  /**
+   * @brief Construct a new result cache
+   *
+   * @param capacity Maximum number of cached results
+   */
+  explicit RuntimeResultCache(uint32_t capacity);
+
+  /**
+   * @brief Hashes the shapes and values of tensors
+   *
+   * Uses a four lane xxHash64 style hash over the raw tensor memory.
+   *
+   * @param tensors Tensors to hash
+   * @return 64 bit hash of the tensors
+   */
+  static uint64_t HashTensors(const std::vector<sftensor>& tensors);
+
+  /**
+   * @brief Looks up the cached outputs by key only
+   *
+   * The inputs are not compared, two inputs whose 64 bit hashes collide
+   * return the same outputs. Use Forward when that is not acceptable.
+   *
+   * @param key Key of the result
+   * @param outputs Cached output tensors on a hit
+   * @return True on a hit
+   */
+  bool Lookup(const RuntimeCacheKey& key, std::vector<sftensor>& outputs);
+
+  /**
+   * @brief Inserts a copy of the outputs into the cache
+   *
+   * @param key Key of the result
+   * @param outputs Output tensors to cache
+   */
+  void Insert(const RuntimeCacheKey& key, const std::vector<sftensor>& outputs);
+
+  /**
+   * @brief Runs the graph unless the result is cached
+   *
+   * The returned tensors are shared with the cache and must be treated as
+   * read-only. Misses of concurrent calls on the same graph are serialized,
+   * hits do not wait for them.
+   *
+   * @param graph The built runtime graph
+   * @param model_name Name of the model
+   * @param input_name Name of the graph input
+   * @param inputs Input tensors
+   * @param output_name Name of the graph output
+   * @return Output tensors
+   */
+  std::vector<sftensor> Forward(RuntimeGraph& graph, const std::string& model_name,
+                                const std::string& input_name, const std::vector<sftensor>& inputs,
+                                const std::string& output_name);
+
+  /**
+   * @brief Removes all cached results
+   */
+  void Clear();
+
+  /**
+   * @brief Gets the number of cached results
+   */
+  uint32_t size() const;
+
+  /**
+   * @brief Gets the hit and miss counters
+   */
+  RuntimeCacheMetrics metrics() const;
+
+ private:
+  struct CacheEntry {
+    RuntimeCacheKey key;
+
+    /// Copies of the inputs, empty for entries inserted without them
+    std::vector<sftensor> inputs;
+
+    std::vector<sftensor> outputs;
+  };
+
+  /**
+   * @brief Looks up the outputs, compares the inputs if they are given
+   */
+  bool LookupEntry(const RuntimeCacheKey& key, const std::vector<sftensor>* inputs,
+                   std::vector<sftensor>& outputs);
+
+  /**
+   * @brief Inserts inputs and outputs already owned by the cache
+   */
+  void InsertCloned(const RuntimeCacheKey& key, std::vector<sftensor> cached_inputs,
+                    std::vector<sftensor> cached_outputs);
+
+  /**
+   * @brief Gets the mutex that serializes the executions of a graph
+   */
+  std::mutex& GraphMutex(const RuntimeGraph& graph);
+
+  uint32_t capacity_ = 0;
+  mutable std::mutex mutex_;
+
+  /// One mutex per graph executed on a miss, guarded by mutex_
+  std::map<const RuntimeGraph*, std::unique_ptr<std::mutex>> graph_mutexes_;
+  RuntimeCacheMetrics metrics_;
+
+  /// Most recently used entries at the front
+  std::list<CacheEntry> entries_;
+  std::map<RuntimeCacheKey, std::list<CacheEntry>::iterator> entries_map_;
+};
+
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_CACHE_HPP_
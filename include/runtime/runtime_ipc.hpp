@@ -0,0 +1,251 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-13.
+
+#ifndef KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_IPC_HPP_
+#define KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_IPC_HPP_
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "runtime/runtime_ir.hpp"
+#include "status_code.hpp"
+
+namespace kuiper_infer {
+
+/**
+ * @brief Header at the beginning of the shared memory segment
+ *
+ * The segment holds the header followed by slot_count request slots which
+ * form a ring. Every slot has room for the input and the output tensor of
+ * one sample.
+ */
+struct RuntimeIpcHeader {
+  uint32_t magic = 0;
+  uint32_t slot_count = 0;
+
+  /// Shapes of one input and one output sample, channels, rows and cols
+  uint32_t input_shapes[3] = {0, 0, 0};
+  uint32_t output_shapes[3] = {0, 0, 0};
+
+  /// Distance between two slots in bytes
+  uint64_t slot_stride = 0;
+
+  /// Process id of the server, clients poll it to detect a crashed server
+  int32_t server_pid = 0;
+
+  /// Futex word increased by every submission, the server sleeps on it
+  std::atomic<uint32_t> submitted{0};
+
+  /// Set when the server is stopping
+  std::atomic<uint32_t> stopped{0};
+};
+
+/**
+ * @brief Request slot in the shared memory segment
+ *
+ * The input and output tensors follow the slot at input_offset and
+ * output_offset, in the column-major layout of Tensor.
+ */
+struct alignas(64) RuntimeIpcSlot {
+  enum State : uint32_t {
+    kSlotFree = 0,
+    kSlotAcquired = 1,
+    kSlotSubmitted = 2,
+    kSlotProcessing = 3,
+    kSlotDone = 4,
+    /// The client gave up waiting, the server frees the slot when it is done
+    kSlotAbandoned = 5,
+  };
+
+  /// Futex word of the slot, the client sleeps on it
+  std::atomic<uint32_t> state{kSlotFree};
+
+  /// Status code of the finished request
+  int32_t status = 0;
+};
+
+/**
+ * @brief Inference daemon serving several processes through shared memory
+ *
+ * The server owns the graph and creates a POSIX shared memory segment of
+ * request slots. Clients write their input in place, submit the slot and
+ * sleep on a futex until the server has written the output in place. The
+ * server gathers the submitted slots into one batch, binds the slot memory
+ * as the graph inputs and outputs and runs the graph once per batch.
+ */
+class RuntimeIpcServer {
+ public:
+  /**
+   * @brief Creates the shared memory segment
+   *
+   * @param shm_name Name of the POSIX shared memory object, e.g. "/kuiper"
+   * @param graph The built runtime graph
+   * @param input_name Name of the graph input
+   * @param output_name Name of the graph output
+   * @param batch_size Batch size the graph was exported with
+   * @param input_shapes Shape of one input sample, channels, rows and cols
+   * @param output_shapes Shape of one output sample, channels, rows and cols
+   * @param slot_count Number of request slots
+   * @param reclaim Removes an existing segment of the same name first, only
+   * for restarting after a crashed server. Otherwise an existing segment is
+   * a fatal error, it may belong to a live server.
+   */
+  RuntimeIpcServer(std::string shm_name, std::shared_ptr<RuntimeGraph> graph,
+                   std::string input_name, std::string output_name, uint32_t batch_size,
+                   const std::vector<uint32_t>& input_shapes,
+                   const std::vector<uint32_t>& output_shapes, uint32_t slot_count,
+                   bool reclaim = false);
+
+  /**
+   * @brief Unmaps and removes the shared memory segment
+   */
+  ~RuntimeIpcServer();
+
+  RuntimeIpcServer(const RuntimeIpcServer&) = delete;
+
+  RuntimeIpcServer& operator=(const RuntimeIpcServer&) = delete;
+
+  /**
+   * @brief Serves requests until Stop is called
+   */
+  void Run();
+
+  /**
+   * @brief Stops the serving loop, can be called from any thread
+   */
+  void Stop();
+
+  /**
+   * @brief Gets the number of batches executed
+   */
+  uint64_t batch_count() const;
+
+ private:
+  /**
+   * @brief Gathers up to batch_size submitted slots in ring order
+   *
+   * @return Indices of the gathered slots
+   */
+  std::vector<uint32_t> GatherBatch();
+
+  std::string shm_name_;
+  std::shared_ptr<RuntimeGraph> graph_;
+  std::string input_name_;
+  std::string output_name_;
+  uint32_t batch_size_ = 0;
+
+  void* shm_ptr_ = nullptr;
+  size_t shm_size_ = 0;
+  RuntimeIpcHeader* header_ = nullptr;
+  uint32_t cursor_ = 0;
+  std::atomic<uint64_t> batch_count_{0};
+
+  /// Tensors on the input and output memory of every slot
+  std::vector<sftensor> slot_inputs_;
+  std::vector<sftensor> slot_outputs_;
+
+  /// Tensors padding a partial batch
+  std::vector<sftensor> padding_inputs_;
+  std::vector<sftensor> padding_outputs_;
+};
+
+/**
+ * @brief Client of a RuntimeIpcServer in the same or another process
+ *
+ * Usage: Acquire a slot, fill input(slot) in place, Submit it, read
+ * output(slot) in place and Release the slot. The tensors returned by
+ * input and output are only valid while the client exists.
+ */
+class RuntimeIpcClient {
+ public:
+  /**
+   * @brief Maps the shared memory segment of a running server
+   *
+   * @param shm_name Name of the POSIX shared memory object
+   */
+  explicit RuntimeIpcClient(const std::string& shm_name);
+
+  /**
+   * @brief Unmaps the shared memory segment
+   */
+  ~RuntimeIpcClient();
+
+  RuntimeIpcClient(const RuntimeIpcClient&) = delete;
+
+  RuntimeIpcClient& operator=(const RuntimeIpcClient&) = delete;
+
+  /**
+   * @brief Acquires a free slot, spins while all slots are in use
+   *
+   * @return Index of the acquired slot
+   */
+  uint32_t Acquire();
+
+  /**
+   * @brief Gets the tensor on the input memory of a slot
+   */
+  sftensor input(uint32_t slot_index) const;
+
+  /**
+   * @brief Gets the tensor on the output memory of a slot
+   */
+  sftensor output(uint32_t slot_index) const;
+
+  /**
+   * @brief Submits an acquired slot and waits for the result
+   *
+   * Returns kInferTimeout when the timeout passes and kInferServerUnavailable
+   * when the server stops or its process exits. A request that was not
+   * picked up yet is withdrawn, the slot stays acquired and can be submitted
+   * again. A request the server is executing is abandoned, the server
+   * returns that slot to the ring when it is done.
+   *
+   * @param slot_index Index of the acquired slot
+   * @param timeout Maximum time to wait for the result
+   * @return Status code of the request
+   */
+  StatusCode Submit(uint32_t slot_index,
+                    std::chrono::milliseconds timeout = std::chrono::milliseconds(30000));
+
+  /**
+   * @brief Returns a slot to the ring
+   *
+   * Slots abandoned by Submit are left to the server.
+   *
+   * @param slot_index Index of the acquired slot
+   */
+  void Release(uint32_t slot_index);
+
+ private:
+  void* shm_ptr_ = nullptr;
+  size_t shm_size_ = 0;
+  RuntimeIpcHeader* header_ = nullptr;
+  std::atomic<uint32_t> acquire_cursor_{0};
+  std::vector<sftensor> slot_inputs_;
+  std::vector<sftensor> slot_outputs_;
+};
+
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_IPC_HPP_
@@ -24,15 +24,60 @@
 #include <map>
 #include <memory>
 #include <queue>
+#include <set>
 #include <string>
 #include <vector>
 #include "layer/abstract/layer.hpp"
 #include "runtime/pnnx/ir.h"
+#include "runtime/runtime_binding.hpp"
 #include "runtime/runtime_operand.hpp"
+#include "runtime/runtime_parallel.hpp"
 #include "runtime_op.hpp"
 
 namespace kuiper_infer {
 
+/**
+ * @brief Precompiled step of the graph execution plan
+ *
+ * Each step binds a layer to its input and output tensors once at build
+ * time, so executing the step needs neither operand lookup nor output
+ * propagation.
+ */
+struct RuntimeExecutionStep {
+  /// Operator executed by this step
+  RuntimeOperator* op = nullptr;
+
+  /// Layer of the operator
+  Layer<float>* layer = nullptr;
+
+  /// Operators fused into this step, the last one owns the output tensors
+  std::vector<RuntimeOperator*> fused_ops;
+
+  /// Whether the step is skipped because no requested output needs it
+  bool skipped = false;
+
+  /// Operands the input tensors are gathered from
+  std::vector<std::shared_ptr<RuntimeOperand>> input_operands;
+
+  /// Input tensors aliased from the output tensors of the producers
+  std::vector<sftensor> inputs;
+
+  /// Output tensors of the operator
+  std::vector<sftensor>* outputs = nullptr;
+
+  /// Views of the inputs, bound only when the layer runs on views
+  std::vector<TensorView> input_views;
+
+  /// Views of the outputs, bound together with the input views
+  std::vector<TensorView> output_views;
+
+  /// Whether the step has run once with all layer checks on
+  bool validated = false;
+
+  /// Estimated work of the step including the fused operators
+  OperatorCost cost;
+};
+
 /**
  * @brief Runtime representation of a neural network graph
  *
@@ -64,15 +109,117 @@ class RuntimeGraph {
   void set_inputs(const std::string& input_name, const std::vector<sftensor>& inputs);
 
   /**
-   * @brief Gets output tensors from the graph
+   * @brief Binds caller-owned output tensors to a graph output
    *
-   * Returns the output tensors with the given name.
+   * The producer of the graph output writes directly into the given
+   * tensors in the following Forward calls, which must have the shapes of
+   * the tensors they replace.
    *
    * @param output_name Name of the graph output
+   * @param outputs Output tensors, one per batch
+   */
+  void set_outputs(const std::string& output_name, const std::vector<sftensor>& outputs);
+
+  /**
+   * @brief Binds caller-owned memory as a graph input
+   *
+   * A float buffer in the tensor layout is read in place by the first
+   * layers. Other buffers, such as row-major or uint8 images, are converted
+   * straight into the input tensors at the start of every Forward call, so
+   * the caller never builds tensors.
+   *
+   * @param input_name Name of the graph input
+   * @param buffer Caller-owned memory with the shape of the input
+   */
+  void bind_input(const std::string& input_name, const ExternalBuffer& buffer);
+
+  /**
+   * @brief Binds caller-owned memory as a graph output destination
+   *
+   * The producer of the output writes in place into a float buffer in the
+   * tensor layout. Other buffers are written from the output tensors at
+   * the end of every Forward call, so the caller never copies them out.
+   *
+   * @param output_name Name of the graph output
+   * @param buffer Caller-owned memory with the shape of the output
+   */
+  void bind_output(const std::string& output_name, const ExternalBuffer& buffer);
+
+  /**
+   * @brief Gets output tensors from the graph
+   *
+   * Returns the output tensors with the given name. Besides the graph
+   * outputs, the name can be any operator whose output operand is computed
+   * by the requested outputs and not fused away, see set_requested_outputs.
+   *
+   * @param output_name Name of the graph output or of the producing operator
    * @return Vector of output tensors
    */
   std::vector<sftensor> get_outputs(const std::string& output_name) const;
 
+  /**
+   * @brief Requests the operands to compute in Forward
+   *
+   * Only the transitive producers of the requested operands are executed,
+   * the other operators are marked as skipped. An empty list executes the
+   * whole graph. Intermediate operands folded away by operator fusion are
+   * kept when requested before Build.
+   *
+   * @param output_names Names of graph outputs or of the producing operators
+   */
+  void set_requested_outputs(const std::vector<std::string>& output_names);
+
+  /**
+   * @brief Enables the unchecked fast path of Forward
+   *
+   * Build validates the shapes of the execution plan once. After a step has
+   * run with all checks on, its layer skips the per-call checks in later
+   * Forward calls as long as the graph inputs keep the shapes declared by
+   * the model. Enabled by default, debug builds always check.
+   *
+   * @param fast_path Whether validated layers run unchecked
+   */
+  void set_fast_path(bool fast_path);
+
+  /**
+   * @brief Whether validated layers run unchecked
+   */
+  bool fast_path() const;
+
+  /**
+   * @brief Enables dynamic int8 quantization of the layers that support it
+   *
+   * Build quantizes the weights of those layers per output channel, their
+   * activations are quantized per row in every Forward call. No calibration
+   * data is needed. Disabled by default, must be set before Build.
+   *
+   * @param dynamic_quantization Whether supported layers run in int8
+   */
+  void set_dynamic_quantization(bool dynamic_quantization);
+
+  /**
+   * @brief Whether supported layers run in int8
+   */
+  bool dynamic_quantization() const;
+
+  /**
+   * @brief Describes the work of the built graph
+   *
+   * Prints a table with the FLOPs, parameters, weight bytes and activation
+   * bytes of every operator and the thread split the cost model chose for
+   * its step, followed by the totals of the graph as one line of JSON.
+   *
+   * @return The table and the JSON totals
+   */
+  std::string Summary() const;
+
+  /**
+   * @brief Sums the analytic cost of all operators that are executed
+   *
+   * @return Total work of one Forward call
+   */
+  LayerCost TotalCost() const;
+
   /**
    * @brief Checks if an op is an input op
    *
@@ -133,12 +280,39 @@ class RuntimeGraph {
   /**
    * @brief Executes the computation graph
    *
-   * Executes the graph operations in depth-first order.
+   * Runs the execution plan compiled by Build, the layers are executed in
+   * topological order with their pre-bound input and output tensors.
    *
    * @param debug Whether to print debugging information during execution
    */
   void Forward(bool debug = false);
 
+  /**
+   * @brief Executes one step of the execution plan
+   *
+   * Lets an external scheduler interleave the layers of several graphs.
+   * Running every step from zero to plan_size() - 1 is equivalent to
+   * Forward. Skipped steps return immediately.
+   *
+   * @param step_index Index of the step in the execution plan
+   * @return Status code returned by the layer
+   */
+  StatusCode ForwardStep(uint32_t step_index);
+
+  /**
+   * @brief Gets the number of steps in the execution plan
+   *
+   * @return Number of execution steps
+   */
+  uint32_t plan_size() const;
+
+  /**
+   * @brief Gets the steps of the execution plan
+   *
+   * @return Steps in execution order, valid after Build
+   */
+  const std::vector<RuntimeExecutionStep>& execution_plan() const;
+
  private:
   /**
    * @brief Initializes the graph
@@ -239,6 +413,88 @@ class RuntimeGraph {
       const std::shared_ptr<RuntimeOperator>& current_op,
       const std::vector<std::shared_ptr<Tensor<float>>>& layer_output_data);
 
+  /**
+   * @brief Compiles the execution plan
+   *
+   * Aliases the output tensors of every operator to the inputs of its
+   * successors and records one execution step per layer in topological
+   * order.
+   */
+  void BuildExecutionPlan();
+
+  /**
+   * @brief Fuses a residual add into the convolution before it
+   *
+   * Matches convolution -> pnnx.Expression add(@0,@1) -> optional activation
+   * and lets the convolution add the residual and apply the activation in
+   * its output stage.
+   *
+   * @param expression_op The expression operator of the residual add
+   * @param fused_ops Operators absorbed by the fusion
+   * @param step Execution step of the fused convolution
+   * @return True if the fusion succeeded
+   */
+  bool FuseResidualAdd(const std::shared_ptr<RuntimeOperator>& expression_op,
+                       std::set<RuntimeOperator*>& fused_ops, RuntimeExecutionStep& step);
+
+  /**
+   * @brief Marks the operators required by the requested outputs
+   *
+   * Walks the producers of the requested operands and marks every other
+   * operator and execution step as skipped.
+   */
+  void MarkRequiredOperators();
+
+  /**
+   * @brief Binds the input tensors of the execution steps
+   *
+   * Gathers the input tensors of every step from its input operands.
+   *
+   * @return True if all input tensors of the steps to execute are available
+   */
+  bool BindExecutionInputs();
+
+  /**
+   * @brief Binds the tensor views of a step whose layer runs on views
+   *
+   * Leaves the views empty, so the step uses the shared_ptr interface, if
+   * the layer does not support views or a tensor is not allocated yet.
+   *
+   * @param step Execution step with bound input tensors
+   */
+  static void BindExecutionViews(RuntimeExecutionStep& step);
+
+  /**
+   * @brief Validates the shapes of the execution plan
+   *
+   * Checks that the output tensors of every step match the shapes of their
+   * operands and that the input operands agree on the batch size. Resets
+   * the steps so that their next run is fully checked.
+   */
+  void ValidateExecutionPlan();
+
+  /**
+   * @brief Turns the layer checks back on for all steps
+   */
+  void ResetValidation();
+
+  /**
+   * @brief Chooses the thread split of every step
+   *
+   * Runs again whenever the OpenMP thread budget of the calling thread
+   * changes, for example when a scheduler worker executes the graph.
+   *
+   * @param thread_budget Threads available to the graph
+   */
+  void PlanExecutionParallelism(uint32_t thread_budget);
+
+  /**
+   * @brief Reserves the per-thread scratch of an operator's layer
+   *
+   * @param op Operator with its layer and operand shapes
+   */
+  static void ReserveWorkspace(const RuntimeOperator& op);
+
  private:
   /**
    * @brief Graph state enum
@@ -258,6 +514,8 @@ class RuntimeGraph {
   GraphState graph_state() const;
 
  private:
+  friend class AotLoader;
+
   std::string bin_path_;
   std::string param_path_;
   std::unique_ptr<pnnx::Graph> graph_;
@@ -266,6 +524,15 @@ class RuntimeGraph {
   std::vector<std::shared_ptr<RuntimeOperator>> input_ops_;
   std::vector<std::shared_ptr<RuntimeOperator>> output_ops_;
   std::vector<std::shared_ptr<RuntimeOperator>> operators_;
+
+  bool plan_inputs_bound_ = false;
+  bool fast_path_ = true;
+  bool dynamic_quantization_ = false;
+  uint32_t thread_budget_ = 0;
+  std::vector<BufferBinding> input_bindings_;
+  std::vector<BufferBinding> output_bindings_;
+  std::vector<std::string> requested_outputs_;
+  std::vector<RuntimeExecutionStep> execution_plan_;
 };
 
 }  // namespace kuiper_infer
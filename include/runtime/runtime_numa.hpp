@@ -0,0 +1,193 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-20.
+
+#ifndef KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_NUMA_HPP_
+#define KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_NUMA_HPP_
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "runtime/runtime_ir.hpp"
+
+namespace kuiper_infer {
+
+/**
+ * @brief NUMA node topology of the machine
+ *
+ * Lists the cpus of every NUMA node. The topology is detected from sysfs
+ * or constructed by hand, which allows testing multi-node layouts on a
+ * single-node machine.
+ */
+struct NumaTopology {
+  /// Kernel ids of the nodes
+  std::vector<uint32_t> node_ids;
+
+  /// Cpu ids of every node
+  std::vector<std::vector<uint32_t>> node_cpus;
+
+  /**
+   * @brief Gets the number of nodes
+   */
+  uint32_t node_count() const { return node_cpus.size(); }
+
+  /**
+   * @brief Detects the topology from sysfs
+   *
+   * Falls back to a single node holding every cpu when the node directory
+   * can not be read.
+   *
+   * @param node_root Directory containing the node<N>/cpulist files
+   * @return Detected topology
+   */
+  static NumaTopology Detect(const std::string& node_root = "/sys/devices/system/node");
+
+  /**
+   * @brief Creates a topology with one node holding every cpu
+   */
+  static NumaTopology SingleNode();
+
+  /**
+   * @brief Parses a cpulist such as "0-3,8,10-11"
+   *
+   * @param cpu_list The cpulist string
+   * @return Cpu ids in the list
+   */
+  static std::vector<uint32_t> ParseCpuList(const std::string& cpu_list);
+};
+
+/**
+ * @brief Runs graph replicas on the NUMA nodes of the machine
+ *
+ * One worker thread per node is pinned to the cpus of the node and builds
+ * its own replica of the graph there. With the memory policy of the worker
+ * preferring its node, the weights, the packed weights and the activation
+ * buffers of a replica are first touched and therefore allocated on the
+ * node which executes it. The OpenMP threads started by a worker inherit
+ * its cpu affinity, so no thread crosses the socket.
+ *
+ * On a single-node machine there is one replica and pinning is skipped.
+ */
+class RuntimeNumaGraph {
+ public:
+  /**
+   * @brief Construct a new NUMA graph and start the node workers
+   *
+   * @param param_path Path to the parameter file
+   * @param bin_path Path to the bin file
+   * @param topology Node topology, detected from sysfs by default
+   */
+  RuntimeNumaGraph(std::string param_path, std::string bin_path,
+                   NumaTopology topology = NumaTopology::Detect());
+
+  /**
+   * @brief Stops the node workers
+   */
+  ~RuntimeNumaGraph();
+
+  RuntimeNumaGraph(const RuntimeNumaGraph&) = delete;
+
+  RuntimeNumaGraph& operator=(const RuntimeNumaGraph&) = delete;
+
+  /**
+   * @brief Builds the replica of every node on the node itself
+   */
+  void Build();
+
+  /**
+   * @brief Executes the replica of a node on its worker
+   *
+   * @param node_index Index of the node
+   * @param input_name Name of the graph input
+   * @param inputs Input tensors
+   * @param output_name Name of the graph output
+   * @return Copies of the output tensors
+   */
+  std::vector<sftensor> Forward(uint32_t node_index, const std::string& input_name,
+                                const std::vector<sftensor>& inputs,
+                                const std::string& output_name);
+
+  /**
+   * @brief Executes the replica of the node with the fewest pending requests
+   */
+  std::vector<sftensor> Forward(const std::string& input_name, const std::vector<sftensor>& inputs,
+                                const std::string& output_name);
+
+  /**
+   * @brief Gets the node topology in use
+   */
+  const NumaTopology& topology() const;
+
+  /**
+   * @brief Gets the graph replica of a node
+   */
+  RuntimeGraph& replica(uint32_t node_index);
+
+ private:
+  struct NodeWorker {
+    std::shared_ptr<RuntimeGraph> graph;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::function<void()>> tasks;
+    std::atomic<uint32_t> pending{0};
+    bool stop = false;
+  };
+
+  /**
+   * @brief Runs a task on the worker of a node and waits for it
+   */
+  void RunOnNode(uint32_t node_index, std::function<void()> task);
+
+  /**
+   * @brief Main loop of a node worker
+   */
+  void WorkerLoop(uint32_t node_index);
+
+  std::string param_path_;
+  std::string bin_path_;
+  NumaTopology topology_;
+  std::vector<std::unique_ptr<NodeWorker>> workers_;
+};
+
+/**
+ * @brief Pins the calling thread to the cpus of a node
+ *
+ * @return False if the node has no cpus or the affinity can not be set
+ */
+bool PinThreadToNode(const NumaTopology& topology, uint32_t node_index);
+
+/**
+ * @brief Prefers the memory of a node for allocations of the calling thread
+ *
+ * @return False if the kernel has no NUMA support or the node is unknown
+ */
+bool PreferNodeMemory(const NumaTopology& topology, uint32_t node_index);
+
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_NUMA_HPP_
@@ -54,6 +54,9 @@ struct RuntimeOperatorBase {
   /// Whether this operator has run in current execution
   bool has_forward = false;
 
+  /// Whether this operator is skipped because no requested output needs it
+  bool is_skipped = false;
+
   /// Name of the operator
   std::string name;
 
@@ -0,0 +1,76 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-29.
+
+#ifndef KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_PARALLEL_HPP_
+#define KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_PARALLEL_HPP_
+#include <cstdint>
+#include <string>
+#include "layer/abstract/layer.hpp"
+#include "runtime/runtime_op.hpp"
+
+namespace kuiper_infer {
+
+/**
+ * @brief Work of one operator for a whole batch
+ */
+struct OperatorCost : public LayerCost {
+  /// Number of samples in the batch
+  uint32_t batch_size = 1;
+
+  /// Units one sample splits across its threads, the output channels or the
+  /// output features of a linear layer, 0 if the split is not bounded
+  uint32_t channels = 0;
+};
+
+/**
+ * @brief Computes the work of an operator from its operand shapes
+ *
+ * Asks the layer of the operator for its analytic cost. Operators without
+ * a layer are estimated from their weight shapes, or as one operation per
+ * element when they have no weights.
+ *
+ * @param op The runtime operator
+ * @return Estimated cost of the operator
+ */
+OperatorCost EstimateOperatorCost(const RuntimeOperator& op);
+
+/**
+ * @brief Splits a thread budget between and within the samples of a batch
+ *
+ * An operator gets only as many threads as its work can keep busy. These
+ * go to the samples of the batch first, so no thread is spent on forking
+ * inside a sample while other samples wait. The threads left over split
+ * the channels of every sample, at most one thread per channel.
+ *
+ * @param cost Estimated cost of the operator
+ * @param thread_budget Threads available to the graph
+ * @return Thread split of the operator
+ */
+ParallelPlan PlanParallelism(const OperatorCost& cost, uint32_t thread_budget);
+
+/**
+ * @brief Formats a thread split as "batch x intra"
+ */
+std::string ParallelPlanToString(const ParallelPlan& parallel_plan);
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_PARALLEL_HPP_
@@ -0,0 +1,224 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-6.
+
+#ifndef KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_SCHEDULER_HPP_
+#define KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_SCHEDULER_HPP_
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "runtime/runtime_ir.hpp"
+#include "status_code.hpp"
+
+namespace kuiper_infer {
+
+/**
+ * @brief Result of a scheduled inference request
+ */
+struct RuntimeRequestResult {
+  /// kSuccess, the failing layer's status or kInferDeadlineExceeded
+  StatusCode status = StatusCode::kUnknownCode;
+
+  /// Copies of the requested graph outputs
+  std::vector<sftensor> outputs;
+};
+
+/**
+ * @brief Queue metrics of a model registered in the scheduler
+ */
+struct RuntimeModelMetrics {
+  /// Requests waiting to start
+  uint64_t queued = 0;
+
+  /// Requests that ran to the end, successfully or not
+  uint64_t completed = 0;
+
+  /// Requests dropped because their deadline passed before they started
+  uint64_t expired = 0;
+
+  /// Average time between submission and the first layer in ms
+  double avg_queue_time = 0.;
+
+  /// Average time between submission and completion in ms
+  double avg_latency = 0.;
+};
+
+/**
+ * @brief Process-wide inference scheduler shared by several graphs
+ *
+ * The scheduler owns the worker threads and executes the registered graphs
+ * one layer at a time. After every layer the worker picks the request with
+ * the highest priority, then the earliest deadline, so latency critical
+ * requests preempt long running ones between layers. The requests of one
+ * model run one after another because they share the graph's tensors.
+ *
+ * Every worker limits the OpenMP parallel regions it starts to
+ * threads_per_worker threads, so the graphs no longer oversubscribe the
+ * cores. Regions sized by the batch size keep one thread per sample.
+ */
+class RuntimeScheduler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Called by a worker after every layer with the model name and the step index
+  using StepObserver = std::function<void(const std::string&, uint32_t)>;
+
+  /**
+   * @brief Construct a new scheduler and start its workers
+   *
+   * @param worker_count Number of worker threads
+   * @param threads_per_worker OpenMP threads used by each worker
+   */
+  explicit RuntimeScheduler(uint32_t worker_count, uint32_t threads_per_worker = 1);
+
+  /**
+   * @brief Stops the workers, pending requests are finished first
+   */
+  ~RuntimeScheduler();
+
+  RuntimeScheduler(const RuntimeScheduler&) = delete;
+
+  RuntimeScheduler& operator=(const RuntimeScheduler&) = delete;
+
+  /**
+   * @brief Registers a built graph under a model name
+   *
+   * The graph must not be executed outside the scheduler afterwards.
+   *
+   * @param model_name Name of the model
+   * @param graph The built runtime graph
+   */
+  void RegisterModel(const std::string& model_name, std::shared_ptr<RuntimeGraph> graph);
+
+  /**
+   * @brief Submits an inference request
+   *
+   * @param model_name Name of a registered model
+   * @param input_name Name of the graph input
+   * @param inputs Input tensors of the request
+   * @param output_name Name of the graph output to return
+   * @param priority Requests with a larger priority are scheduled first
+   * @param deadline Requests not started before the deadline are dropped
+   * @return Future of the request result
+   */
+  std::future<RuntimeRequestResult> Submit(const std::string& model_name,
+                                           const std::string& input_name,
+                                           std::vector<sftensor> inputs,
+                                           const std::string& output_name, int32_t priority = 0,
+                                           Clock::time_point deadline = Clock::time_point::max());
+
+  /**
+   * @brief Gets the queue metrics of a model
+   *
+   * @param model_name Name of a registered model
+   * @return Queue metrics of the model
+   */
+  RuntimeModelMetrics metrics(const std::string& model_name) const;
+
+  /**
+   * @brief Sets a callback invoked after every executed layer
+   *
+   * The callback runs on the worker thread before the worker picks the next
+   * layer, so requests it submits take part in that pick. Used for tracing.
+   *
+   * @param observer The callback, empty to remove it
+   */
+  void set_step_observer(StepObserver observer);
+
+ private:
+  struct Request {
+    std::string input_name;
+    std::string output_name;
+    std::vector<sftensor> inputs;
+    int32_t priority = 0;
+    uint64_t sequence = 0;
+    Clock::time_point deadline;
+    Clock::time_point submit_time;
+    Clock::time_point start_time;
+    std::promise<RuntimeRequestResult> promise;
+  };
+
+  struct Model {
+    std::string name;
+    std::shared_ptr<RuntimeGraph> graph;
+    std::deque<std::unique_ptr<Request>> pending;
+
+    /// Request in execution and the index of its next layer
+    std::unique_ptr<Request> current;
+    uint32_t next_step = 0;
+
+    /// Whether a worker is executing a layer of this model
+    bool busy = false;
+
+    RuntimeModelMetrics metrics;
+    double total_queue_time = 0.;
+    double total_latency = 0.;
+  };
+
+  /**
+   * @brief Compares two requests, true if the left one runs first
+   */
+  static bool HasPrecedence(const Request& lhs, const Request& rhs);
+
+  /**
+   * @brief Picks the model whose next request has the highest precedence
+   *
+   * @return The picked model, nullptr if no model can run
+   */
+  Model* PickModel();
+
+  /**
+   * @brief Main loop of a worker thread
+   */
+  void WorkerLoop();
+
+  /**
+   * @brief Executes the next layer of the picked model
+   */
+  void RunStep(Model* model, std::unique_lock<std::mutex>& lock);
+
+  /**
+   * @brief Completes the current request of a model
+   */
+  static void FinishRequest(Model* model, RuntimeRequestResult result);
+
+  uint32_t threads_per_worker_ = 1;
+  uint64_t sequence_ = 0;
+  bool stop_ = false;
+  std::shared_ptr<const StepObserver> step_observer_;
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::map<std::string, std::unique_ptr<Model>> models_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_INCLUDE_RUNTIME_RUNTIME_SCHEDULER_HPP_
@@ -50,6 +50,10 @@ enum class StatusCode {
   kParseWeightError = 6,
   kParseParameterError = 7,
   kParseOperatorNullParam = 8,
+
+  kInferDeadlineExceeded = 9,
+  kInferTimeout = 10,
+  kInferServerUnavailable = 11,
 };
 
 }  // namespace kuiper_infer
@@ -0,0 +1,533 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-9.
+#include "data/npy.hpp"
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+#include "runtime/pnnx/store_zip.hpp"
+
+namespace kuiper_infer {
+// 元素数超过该值时按通道并行转换布局
+constexpr size_t kParallelCopySize = size_t(1) << 16;
+
+/**
+ * @brief Read-only file mapped copy-on-write into memory
+ */
+class MappedFile {
+ public:
+  static std::shared_ptr<const MappedFile> Open(const std::string& file_path) {
+    const int fd = open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      LOG(ERROR) << "File open failed: " << file_path;
+      return nullptr;
+    }
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+      LOG(ERROR) << "The file is empty: " << file_path;
+      close(fd);
+      return nullptr;
+    }
+    // 私有映射，包装映射的张量被写入时不会修改文件
+    const size_t size = size_t(file_stat.st_size);
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+      LOG(ERROR) << "Can not map the file: " << file_path;
+      return nullptr;
+    }
+    return std::shared_ptr<const MappedFile>(new MappedFile(static_cast<char*>(data), size));
+  }
+
+  ~MappedFile() { munmap(data_, size_); }
+
+  MappedFile(const MappedFile&) = delete;
+
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  char* data() const { return data_; }
+
+  size_t size() const { return size_; }
+
+ private:
+  MappedFile(char* data, size_t size) : data_(data), size_(size) {}
+
+  char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+size_t NpyArray::size() const {
+  if (empty()) {
+    return 0;
+  }
+  size_t size = 1;
+  for (uint32_t dim : shape_) {
+    size *= dim;
+  }
+  return size;
+}
+
+size_t NpyArray::element_size() const { return dtype_ == RuntimeDataType::kTypeUInt8 ? 1 : 4; }
+
+TensorView NpyArray::view() const {
+  if (empty()) {
+    return TensorView();
+  }
+  const size_t dims = shape_.size();
+  const uint32_t cols = dims >= 1 ? shape_.at(dims - 1) : 1;
+  const uint32_t rows = dims >= 2 ? shape_.at(dims - 2) : 1;
+  uint32_t channels = 1;
+  for (size_t i = 0; i + 2 < dims; ++i) {
+    channels *= shape_.at(i);
+  }
+
+  size_t channel_stride = size_t(rows) * cols;
+  size_t row_stride = cols;
+  size_t col_stride = 1;
+  if (fortran_order_ && dims == 2) {
+    row_stride = 1;
+    col_stride = rows;
+  } else if (fortran_order_ && dims == 3) {
+    channel_stride = 1;
+    row_stride = channels;
+    col_stride = size_t(channels) * rows;
+  }
+  // 只有一行、一列或一个通道时对应的步长不参与寻址，按Tensor的布局归一化
+  if (rows == 1) {
+    row_stride = 1;
+  }
+  if (cols == 1) {
+    col_stride = rows;
+  }
+  if (channels == 1) {
+    channel_stride = size_t(rows) * cols;
+  }
+
+  switch (dtype_) {
+    case RuntimeDataType::kTypeFloat32:
+      return TensorView(reinterpret_cast<const float*>(data_), channels, rows, cols,
+                        channel_stride, row_stride, col_stride);
+    case RuntimeDataType::kTypeInt32:
+      return TensorView(reinterpret_cast<const int32_t*>(data_), channels, rows, cols,
+                        channel_stride, row_stride, col_stride);
+    default:
+      return TensorView(reinterpret_cast<const uint8_t*>(data_), channels, rows, cols,
+                        channel_stride, row_stride, col_stride);
+  }
+}
+
+bool NpyArray::is_tensor_layout() const {
+  return !empty() && dtype_ == RuntimeDataType::kTypeFloat32 &&
+         reinterpret_cast<uintptr_t>(data_) % alignof(float) == 0 && view().is_contiguous();
+}
+
+std::shared_ptr<Tensor<float>> NpyArray::ToTensor() const {
+  CHECK(!empty()) << "The npy array is empty";
+  const TensorView array_view = view();
+  if (is_tensor_layout()) {
+    // 张量持有映射，映射在最后一个张量释放后才解除
+    std::shared_ptr<const MappedFile> file = file_;
+    return std::shared_ptr<Tensor<float>>(
+        new Tensor<float>(array_view.data<float>(), array_view.channels(), array_view.rows(),
+                          array_view.cols()),
+        [file](Tensor<float>* tensor) { delete tensor; });
+  }
+  std::shared_ptr<Tensor<float>> tensor = std::make_shared<Tensor<float>>(
+      array_view.channels(), array_view.rows(), array_view.cols());
+  CopyTo(*tensor);
+  return tensor;
+}
+
+template <typename T>
+static void CopyStrided(const TensorView& view, Tensor<float>& tensor) {
+  const T* data = view.data<const T>();
+  const uint32_t rows = view.rows();
+  const uint32_t cols = view.cols();
+#pragma omp parallel for if (view.size() >= kParallelCopySize)
+  for (uint32_t c = 0; c < view.channels(); ++c) {
+    const T* channel_data = data + c * view.channel_stride();
+    // 行主序的浮点数据由armadillo分块转置
+    if (std::is_same_v<T, float> && view.col_stride() == 1 && view.row_stride() == cols) {
+      tensor.slice(c) =
+          arma::fmat(const_cast<float*>(reinterpret_cast<const float*>(channel_data)), cols, rows,
+                     false, true)
+              .t();
+      continue;
+    }
+    float* output = tensor.matrix_raw_ptr(c);
+    for (uint32_t col = 0; col < cols; ++col) {
+      for (uint32_t row = 0; row < rows; ++row) {
+        output[col * rows + row] =
+            float(channel_data[row * view.row_stride() + col * view.col_stride()]);
+      }
+    }
+  }
+}
+
+void NpyArray::CopyTo(Tensor<float>& tensor) const {
+  CHECK(!empty()) << "The npy array is empty";
+  const TensorView array_view = view();
+  CHECK(tensor.channels() == array_view.channels() && tensor.rows() == array_view.rows() &&
+        tensor.cols() == array_view.cols())
+      << "The shape of the tensor does not match the npy array";
+  if (static_cast<const void*>(tensor.raw_ptr()) == data_) {
+    return;
+  }
+  switch (dtype_) {
+    case RuntimeDataType::kTypeFloat32:
+      CopyStrided<float>(array_view, tensor);
+      break;
+    case RuntimeDataType::kTypeInt32:
+      CopyStrided<int32_t>(array_view, tensor);
+      break;
+    default:
+      CopyStrided<uint8_t>(array_view, tensor);
+      break;
+  }
+}
+
+NpyArray NpyArray::Sample(uint32_t index) const {
+  CHECK(!empty()) << "The npy array is empty";
+  CHECK(!fortran_order_ || shape_.size() == 1)
+      << "Samples of a column-major npy array are not contiguous";
+  CHECK_LT(index, samples());
+  NpyArray sample = *this;
+  sample.shape_.erase(sample.shape_.begin());
+  sample.data_ = data_ + index * sample.size() * element_size();
+  return sample;
+}
+
+// 解析头部字典中某个键的值，返回值起始位置
+static size_t FindValue(const std::string& header, const std::string& key) {
+  const size_t key_pos = header.find("'" + key + "'");
+  if (key_pos == std::string::npos) {
+    return std::string::npos;
+  }
+  const size_t colon_pos = header.find(':', key_pos);
+  if (colon_pos == std::string::npos) {
+    return std::string::npos;
+  }
+  return header.find_first_not_of(' ', colon_pos + 1);
+}
+
+// 解析形状中的一个维度，只接受十进制的非负整数
+static bool ParseDim(const std::string& dim, uint32_t& value) {
+  const size_t begin = dim.find_first_not_of(' ');
+  if (begin == std::string::npos || !std::isdigit(static_cast<unsigned char>(dim.at(begin)))) {
+    return false;
+  }
+  const char* dim_begin = dim.c_str() + begin;
+  char* dim_end = nullptr;
+  errno = 0;
+  const unsigned long long parsed = std::strtoull(dim_begin, &dim_end, 10);
+  if (errno == ERANGE || parsed > std::numeric_limits<uint32_t>::max() ||
+      dim.find_first_not_of(' ', dim_end - dim.c_str()) != std::string::npos) {
+    return false;
+  }
+  value = uint32_t(parsed);
+  return true;
+}
+
+static bool ParseHeader(const std::string& header, RuntimeDataType& dtype, bool& fortran_order,
+                        std::vector<uint32_t>& shape) {
+  const size_t descr_pos = FindValue(header, "descr");
+  if (descr_pos == std::string::npos || header.at(descr_pos) != '\'') {
+    return false;
+  }
+  const size_t descr_end = header.find('\'', descr_pos + 1);
+  if (descr_end == std::string::npos) {
+    return false;
+  }
+  const std::string descr = header.substr(descr_pos + 1, descr_end - descr_pos - 1);
+  if (descr == "<f4") {
+    dtype = RuntimeDataType::kTypeFloat32;
+  } else if (descr == "<i4") {
+    dtype = RuntimeDataType::kTypeInt32;
+  } else if (descr == "|u1") {
+    dtype = RuntimeDataType::kTypeUInt8;
+  } else {
+    LOG(ERROR) << "Unsupported npy data type: " << descr;
+    return false;
+  }
+
+  const size_t order_pos = FindValue(header, "fortran_order");
+  if (order_pos == std::string::npos) {
+    return false;
+  }
+  if (header.compare(order_pos, 4, "True") == 0) {
+    fortran_order = true;
+  } else if (header.compare(order_pos, 5, "False") == 0) {
+    fortran_order = false;
+  } else {
+    return false;
+  }
+
+  const size_t shape_pos = FindValue(header, "shape");
+  if (shape_pos == std::string::npos || header.at(shape_pos) != '(') {
+    return false;
+  }
+  const size_t shape_end = header.find(')', shape_pos);
+  if (shape_end == std::string::npos) {
+    return false;
+  }
+  std::stringstream shape_stream(header.substr(shape_pos + 1, shape_end - shape_pos - 1));
+  std::string dim;
+  shape.clear();
+  while (std::getline(shape_stream, dim, ',')) {
+    // 一维数组的形状以逗号结尾，最后一段为空
+    if (dim.find_first_not_of(' ') == std::string::npos && shape_stream.eof()) {
+      break;
+    }
+    uint32_t value = 0;
+    if (!ParseDim(dim, value)) {
+      return false;
+    }
+    shape.push_back(value);
+  }
+  return true;
+}
+
+// 计算数组的字节数，溢出size_t时返回false
+static bool ArrayBytes(const std::vector<uint32_t>& shape, size_t element_size, size_t& bytes) {
+  bytes = element_size;
+  for (uint32_t dim : shape) {
+    if (dim != 0 && bytes > std::numeric_limits<size_t>::max() / dim) {
+      return false;
+    }
+    bytes *= dim;
+  }
+  return true;
+}
+
+NpyArray NpyDataLoader::Parse(const std::shared_ptr<const MappedFile>& file, size_t offset,
+                              size_t size) {
+  CHECK(file != nullptr);
+  if (offset > file->size() || size > file->size() - offset) {
+    LOG(ERROR) << "The npy data is out of the file";
+    return NpyArray();
+  }
+  const char* begin = file->data() + offset;
+  if (size < 10 || std::memcmp(begin, "\x93NUMPY", 6) != 0) {
+    LOG(ERROR) << "The data is not in npy format";
+    return NpyArray();
+  }
+
+  // 1.0版本的头部长度占两个字节，2.0和3.0版本占四个字节
+  const uint8_t major_version = uint8_t(begin[6]);
+  size_t header_start = 0;
+  size_t header_size = 0;
+  if (major_version == 1) {
+    uint16_t header_size16 = 0;
+    std::memcpy(&header_size16, begin + 8, sizeof(header_size16));
+    header_start = 10;
+    header_size = header_size16;
+  } else if (major_version == 2 || major_version == 3) {
+    uint32_t header_size32 = 0;
+    std::memcpy(&header_size32, begin + 8, sizeof(header_size32));
+    header_start = 12;
+    header_size = header_size32;
+  } else {
+    LOG(ERROR) << "Unsupported npy version: " << int32_t(major_version);
+    return NpyArray();
+  }
+  if (header_start + header_size > size) {
+    LOG(ERROR) << "The npy header is truncated";
+    return NpyArray();
+  }
+
+  NpyArray array;
+  const std::string header(begin + header_start, header_size);
+  if (!ParseHeader(header, array.dtype_, array.fortran_order_, array.shape_)) {
+    LOG(ERROR) << "Can not parse the npy header: " << header;
+    return NpyArray();
+  }
+  if (array.fortran_order_ && array.shape_.size() > 3) {
+    LOG(ERROR) << "Column-major npy arrays with more than three dimensions are not supported";
+    return NpyArray();
+  }
+  size_t array_bytes = 0;
+  if (!ArrayBytes(array.shape_, array.element_size(), array_bytes)) {
+    LOG(ERROR) << "The npy array is too large";
+    return NpyArray();
+  }
+  if (array_bytes > size - header_start - header_size) {
+    LOG(ERROR) << "The npy data is truncated";
+    return NpyArray();
+  }
+  array.file_ = file;
+  array.data_ = begin + header_start + header_size;
+  return array;
+}
+
+NpyArray NpyDataLoader::Load(const std::string& file_path) {
+  const std::shared_ptr<const MappedFile> file = MappedFile::Open(file_path);
+  if (file == nullptr) {
+    return NpyArray();
+  }
+  return Parse(file, 0, file->size());
+}
+
+std::map<std::string, NpyArray> NpyDataLoader::LoadArchive(const std::string& file_path) {
+  pnnx::StoreZipReader reader;
+  if (reader.open(file_path) != 0) {
+    LOG(ERROR) << "Can not read the npz archive, only stored archives are supported: "
+               << file_path;
+    return {};
+  }
+  const std::shared_ptr<const MappedFile> file = MappedFile::Open(file_path);
+  if (file == nullptr) {
+    return {};
+  }
+
+  const std::string suffix = ".npy";
+  std::map<std::string, NpyArray> arrays;
+  for (const std::string& name : reader.get_names()) {
+    const NpyArray array =
+        Parse(file, reader.get_file_offset(name), reader.get_file_size(name));
+    if (array.empty()) {
+      LOG(ERROR) << "Can not read the array " << name << " of the npz archive: " << file_path;
+      return {};
+    }
+    std::string array_name = name;
+    if (array_name.size() > suffix.size() &&
+        array_name.compare(array_name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+      array_name.resize(array_name.size() - suffix.size());
+    }
+    arrays.emplace(array_name, array);
+  }
+  return arrays;
+}
+
+std::string NpyDataLoader::Serialize(const Tensor<float>& tensor) {
+  const std::vector<uint32_t>& raw_shapes = tensor.raw_shapes();
+  std::string shape = "(";
+  for (uint32_t i = 0; i < raw_shapes.size(); ++i) {
+    shape += std::to_string(raw_shapes.at(i));
+    if (raw_shapes.size() == 1) {
+      shape += ",";
+    } else if (i + 1 < raw_shapes.size()) {
+      shape += ", ";
+    }
+  }
+  shape += ")";
+
+  // 头部以换行结束并用空格补齐，数据从64字节对齐的位置开始
+  std::string header = "{'descr': '<f4', 'fortran_order': False, 'shape': " + shape + ", }";
+  const size_t header_start = 10;
+  const size_t unpadded_size = header_start + header.size() + 1;
+  header.append((64 - unpadded_size % 64) % 64, ' ');
+  header.push_back('\n');
+
+  std::string npy("\x93NUMPY\x01\x00", 8);
+  const uint16_t header_size = uint16_t(header.size());
+  npy.append(reinterpret_cast<const char*>(&header_size), sizeof(header_size));
+  npy += header;
+
+  // 每个通道转置为行主序后写出
+  const size_t data_start = npy.size();
+  const uint32_t rows = tensor.rows();
+  const uint32_t cols = tensor.cols();
+  const size_t planes = size_t(rows) * cols;
+  npy.resize(data_start + tensor.size() * sizeof(float));
+  for (uint32_t c = 0; c < tensor.channels(); ++c) {
+    const arma::fmat channel_t = tensor.slice(c).t();
+    std::memcpy(&npy[data_start + c * planes * sizeof(float)], channel_t.memptr(),
+                planes * sizeof(float));
+  }
+  return npy;
+}
+
+bool NpyDataLoader::Save(const std::string& file_path, const Tensor<float>& tensor) {
+  CHECK(!tensor.empty()) << "The tensor to save is empty";
+  const std::string npy = Serialize(tensor);
+  std::ofstream out(file_path, std::ios::binary);
+  if (!out.is_open()) {
+    LOG(ERROR) << "File open failed: " << file_path;
+    return false;
+  }
+  out.write(npy.data(), std::streamsize(npy.size()));
+  return out.good();
+}
+
+bool NpyDataLoader::SaveArchive(
+    const std::string& file_path,
+    const std::map<std::string, std::shared_ptr<Tensor<float>>>& tensors) {
+  pnnx::StoreZipWriter writer;
+  if (writer.open(file_path) != 0) {
+    LOG(ERROR) << "File open failed: " << file_path;
+    return false;
+  }
+  for (const auto& [name, tensor] : tensors) {
+    CHECK(tensor != nullptr && !tensor->empty()) << "The tensor " << name << " to save is empty";
+    const std::string npy = Serialize(*tensor);
+    if (writer.write_file(name + ".npy", npy.data(), npy.size()) != 0) {
+      LOG(ERROR) << "Can not write the array " << name << " to the npz archive: " << file_path;
+      return false;
+    }
+  }
+  return writer.close() == 0;
+}
+
+NpyBatchIterator::NpyBatchIterator(NpyArray dataset, uint32_t batch_size)
+    : dataset_(std::move(dataset)), batch_size_(batch_size) {
+  CHECK(!dataset_.empty()) << "The dataset array is empty";
+  CHECK_GT(batch_size_, 0);
+}
+
+bool NpyBatchIterator::Next(std::vector<std::shared_ptr<Tensor<float>>>& batch) {
+  if (next_sample_ >= samples()) {
+    return false;
+  }
+  const uint32_t count = std::min(batch_size_, samples() - next_sample_);
+  batch.resize(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    const NpyArray sample = dataset_.Sample(next_sample_ + i);
+    if (sample.is_tensor_layout()) {
+      batch.at(i) = sample.ToTensor();
+      continue;
+    }
+    // 布局不同的样本转换到上一批的张量中，形状一致时不再申请
+    const TensorView sample_view = sample.view();
+    std::shared_ptr<Tensor<float>>& tensor = batch.at(i);
+    if (tensor == nullptr || tensor->channels() != sample_view.channels() ||
+        tensor->rows() != sample_view.rows() || tensor->cols() != sample_view.cols()) {
+      tensor = std::make_shared<Tensor<float>>(sample_view.channels(), sample_view.rows(),
+                                               sample_view.cols());
+    }
+    sample.CopyTo(*tensor);
+  }
+  next_sample_ += count;
+  return true;
+}
+}  // namespace kuiper_infer
@@ -74,6 +74,19 @@ Tensor<T>::Tensor(const std::vector<uint32_t>& shapes) {
   }
 }
 
+template <typename T>
+Tensor<T>::Tensor(T* raw_ptr, uint32_t channels, uint32_t rows, uint32_t cols)
+    : data_(raw_ptr, rows, cols, channels, false, true) {
+  CHECK(raw_ptr != nullptr) << "The external memory of the tensor is empty.";
+  if (channels == 1 && rows == 1) {
+    this->raw_shapes_ = std::vector<uint32_t>{cols};
+  } else if (channels == 1) {
+    this->raw_shapes_ = std::vector<uint32_t>{rows, cols};
+  } else {
+    this->raw_shapes_ = std::vector<uint32_t>{channels, rows, cols};
+  }
+}
+
 template <typename T>
 uint32_t Tensor<T>::rows() const {
   CHECK(!this->data_.empty()) << "The data area of the tensor is empty.";
@@ -290,12 +303,6 @@ void Tensor<T>::Ones() {
   this->Fill(T{1});
 }
 
-template <typename T>
-void Tensor<T>::Transform(const std::function<T(T)>& filter) {
-  CHECK(!this->data_.empty()) << "The data area of the tensor is empty.";
-  this->data_.transform(filter);
-}
-
 template <typename T>
 const std::vector<uint32_t>& Tensor<T>::raw_shapes() const {
   CHECK(!this->raw_shapes_.empty());
@@ -404,35 +411,54 @@ const T* Tensor<T>::matrix_raw_ptr(uint32_t index) const {
   return mem_ptr;
 }
 
+/**
+ * 按行主序把src中的数据排列到dst中，两者的元素个数必须相同
+ */
 template <typename T>
-void Tensor<T>::Review(const std::vector<uint32_t>& shapes) {
-  CHECK(!this->data_.empty()) << "The data area of the tensor is empty.";
-  CHECK_EQ(shapes.size(), 3);
-  const uint32_t target_ch = shapes.at(0);
-  const uint32_t target_rows = shapes.at(1);
-  const uint32_t target_cols = shapes.at(2);
-
-  CHECK_EQ(this->data_.size(), target_ch * target_cols * target_rows);
-  arma::Cube<T> new_data(target_rows, target_cols, target_ch);
+static void RowMajorCopy(const arma::Cube<T>& src, arma::Cube<T>& dst) {
+  const uint32_t target_rows = dst.n_rows;
+  const uint32_t target_cols = dst.n_cols;
   const uint32_t plane_size = target_rows * target_cols;
 #pragma omp parallel for
-  for (uint32_t channel = 0; channel < this->data_.n_slices; ++channel) {
-    const uint32_t plane_start = channel * data_.n_rows * data_.n_cols;
-    for (uint32_t src_col = 0; src_col < this->data_.n_cols; ++src_col) {
-      const T* col_ptr = this->data_.slice_colptr(channel, src_col);
-      for (uint32_t src_row = 0; src_row < this->data_.n_rows; ++src_row) {
-        const uint32_t pos_idx = plane_start + src_row * data_.n_cols + src_col;
+  for (uint32_t channel = 0; channel < src.n_slices; ++channel) {
+    const uint32_t plane_start = channel * src.n_rows * src.n_cols;
+    for (uint32_t src_col = 0; src_col < src.n_cols; ++src_col) {
+      const T* col_ptr = src.slice_colptr(channel, src_col);
+      for (uint32_t src_row = 0; src_row < src.n_rows; ++src_row) {
+        const uint32_t pos_idx = plane_start + src_row * src.n_cols + src_col;
         const uint32_t dst_ch = pos_idx / plane_size;
         const uint32_t dst_ch_offset = pos_idx % plane_size;
         const uint32_t dst_row = dst_ch_offset / target_cols;
         const uint32_t dst_col = dst_ch_offset % target_cols;
-        new_data.at(dst_row, dst_col, dst_ch) = *(col_ptr + src_row);
+        dst.at(dst_row, dst_col, dst_ch) = *(col_ptr + src_row);
       }
     }
   }
+}
+
+template <typename T>
+void Tensor<T>::Review(const std::vector<uint32_t>& shapes) {
+  CHECK(!this->data_.empty()) << "The data area of the tensor is empty.";
+  CHECK_EQ(shapes.size(), 3);
+  const uint32_t target_ch = shapes.at(0);
+  const uint32_t target_rows = shapes.at(1);
+  const uint32_t target_cols = shapes.at(2);
+
+  CHECK_EQ(this->data_.size(), target_ch * target_cols * target_rows);
+  arma::Cube<T> new_data(target_rows, target_cols, target_ch);
+  RowMajorCopy(this->data_, new_data);
   this->data_ = std::move(new_data);
 }
 
+template <typename T>
+void Tensor<T>::CopyRowMajor(const Tensor<T>& tensor) {
+  CHECK(!this->data_.empty()) << "The data area of the tensor is empty.";
+  CHECK(!tensor.empty()) << "The data area of the source tensor is empty.";
+  CHECK_EQ(this->data_.size(), tensor.data_.size());
+  CHECK(&tensor != this);
+  RowMajorCopy(tensor.data_, this->data_);
+}
+
 template class Tensor<float>;
 template class Tensor<int32_t>;
 template class Tensor<uint8_t>;
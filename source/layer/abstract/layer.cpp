@@ -21,6 +21,10 @@
 
 // Created by fss on 22-11-15.
 #include "layer/abstract/layer.hpp"
+#include <omp.h>
+#include <algorithm>
+#include <functional>
+#include <numeric>
 namespace kuiper_infer {
 
 const std::vector<std::shared_ptr<Tensor<float>>>& Layer<float>::weights() const {
@@ -53,6 +57,12 @@ StatusCode Layer<float>::Forward(const std::vector<std::shared_ptr<Tensor<float>
   return StatusCode::kFunctionNotImplement;
 }
 
+StatusCode Layer<float>::ForwardViews(Span<const TensorView> inputs,
+                                      Span<const TensorView> outputs) {
+  LOG(FATAL) << this->layer_name_ << " layer not implement yet!";
+  return StatusCode::kFunctionNotImplement;
+}
+
 StatusCode Layer<float>::Forward() {
   LOG_IF(FATAL, this->runtime_operator_.expired()) << "Runtime operator is expired or nullptr";
   const auto& runtime_operator = this->runtime_operator_.lock();
@@ -88,9 +98,65 @@ StatusCode Layer<float>::Forward() {
   return status;
 }
 
+bool Layer<float>::FuseResidualAdd(const std::string& activation_type) { return false; }
+
+bool Layer<float>::QuantizeWeights() { return false; }
+
 void Layer<float>::set_runtime_operator(const std::shared_ptr<RuntimeOperator>& runtime_operator) {
   CHECK(runtime_operator != nullptr);
   this->runtime_operator_ = runtime_operator;
 }
 
+void Layer<float>::set_checked(bool checked) { this->checked_ = checked; }
+
+LayerCost& LayerCost::operator+=(const LayerCost& other) {
+  flops += other.flops;
+  parameters += other.parameters;
+  weight_bytes += other.weight_bytes;
+  input_bytes += other.input_bytes;
+  output_bytes += other.output_bytes;
+  return *this;
+}
+
+double Layer<float>::ShapeElements(const std::vector<int32_t>& shape) {
+  if (shape.empty()) {
+    return 0.;
+  }
+  return std::accumulate(shape.begin(), shape.end(), 1., std::multiplies<double>());
+}
+
+LayerCost Layer<float>::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                             const std::vector<int32_t>& output_shape) const {
+  LayerCost cost;
+  for (const std::vector<int32_t>& input_shape : input_shapes) {
+    cost.input_bytes += ShapeElements(input_shape) * sizeof(float);
+  }
+  cost.output_bytes = ShapeElements(output_shape) * sizeof(float);
+  cost.flops = ShapeElements(output_shape);
+  return cost;
+}
+
+size_t Layer<float>::WorkspaceSize(const std::vector<std::vector<int32_t>>& input_shapes,
+                                  const std::vector<int32_t>& output_shape) const {
+  return 0;
+}
+
+void Layer<float>::set_parallel_plan(const ParallelPlan& parallel_plan) {
+  this->parallel_plan_ = parallel_plan;
+}
+
+uint32_t Layer<float>::batch_threads(uint32_t batch_size) const {
+  if (parallel_plan_.batch_threads == 0) {
+    return std::max(batch_size, 1u);
+  }
+  return std::max(std::min(parallel_plan_.batch_threads, batch_size), 1u);
+}
+
+uint32_t Layer<float>::intra_threads() const {
+  if (parallel_plan_.intra_threads == 0) {
+    return uint32_t(omp_get_max_threads());
+  }
+  return parallel_plan_.intra_threads;
+}
+
 }  // namespace kuiper_infer
\ No newline at end of file
@@ -0,0 +1,59 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-3.
+
+#include "layer/abstract/layer_workspace.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+
+namespace kuiper_infer {
+static std::atomic<size_t> workspace_reserved_size{0};
+
+void LayerWorkspace::Reserve(size_t size) {
+  size_t reserved = workspace_reserved_size.load();
+  while (reserved < size && !workspace_reserved_size.compare_exchange_weak(reserved, size)) {
+  }
+}
+
+size_t LayerWorkspace::reserved_size() { return workspace_reserved_size.load(); }
+
+float* LayerWorkspace::Acquire(size_t size) {
+  struct ThreadBuffer {
+    std::unique_ptr<float, void (*)(void*)> data{nullptr, std::free};
+    size_t capacity = 0;
+  };
+  thread_local ThreadBuffer buffer;
+
+  const size_t required = SliceSize(std::max({size, reserved_size(), size_t(1)}));
+  if (buffer.capacity < required) {
+    // 按64字节对齐，相邻的线程不会共享缓存行
+    buffer.data.reset(static_cast<float*>(std::aligned_alloc(64, required * sizeof(float))));
+    CHECK(buffer.data != nullptr) << "Failed to allocate the workspace of " << required
+                                  << " floats";
+    buffer.capacity = required;
+  }
+  return buffer.data.get();
+}
+}  // namespace kuiper_infer
@@ -116,4 +116,17 @@ void ParamLayer::set_bias(const std::vector<float>& bias) {
   }
 }
 
+LayerCost ParamLayer::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                           const std::vector<int32_t>& output_shape) const {
+  LayerCost cost = Layer<float>::Cost(input_shapes, output_shape);
+  for (const auto& weight : this->weights_) {
+    cost.parameters += weight != nullptr ? weight->size() : 0;
+  }
+  for (const auto& bias : this->bias_) {
+    cost.parameters += bias != nullptr ? bias->size() : 0;
+  }
+  cost.weight_bytes = cost.parameters * sizeof(float);
+  return cost;
+}
+
 }  // namespace kuiper_infer
@@ -3,48 +3,63 @@
 //
 #include "activation.hpp"
 #include "activation_sse.hpp"
+#include "data/tensor_util.hpp"
 namespace kuiper_infer {
 namespace activation {
-StatusCode ActivationForward(ActivationType type,
-                             const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
-                             std::vector<std::shared_ptr<Tensor<float>>>& outputs) {
-  const std::string& activation_type = ActivationTypeToString(type);
+StatusCode ActivationForward(ActivationType type, Span<const TensorView> inputs,
+                             Span<const TensorView> outputs, const Layer<float>& layer) {
   if (inputs.empty()) {
-    LOG(ERROR) << "The input tensor array in the " + activation_type + " layer is empty";
+    LOG(ERROR) << "The input tensor array in the " << ActivationTypeToString(type)
+               << " layer is empty";
     return StatusCode::kInferInputsEmpty;
   }
 
   if (outputs.empty()) {
-    LOG(ERROR) << "The output tensor array in the " + activation_type + " layer is empty";
+    LOG(ERROR) << "The output tensor array in the " << ActivationTypeToString(type)
+               << " layer is empty";
     return StatusCode::kInferOutputsEmpty;
   }
 
   if (inputs.size() != outputs.size()) {
-    LOG(ERROR) << "The input and output tensor array size of the " + activation_type +
-                      " layer do not match";
+    LOG(ERROR) << "The input and output tensor array size of the " << ActivationTypeToString(type)
+               << " layer do not match";
     return StatusCode::kInferInOutShapeMismatch;
   }
 
   const uint32_t batch_size = inputs.size();
-  ActivationFunc activation_function = ApplySSEActivation(type);
-#pragma omp parallel for num_threads(batch_size)
+  ActivationRawFunc activation_function = ApplySSEActivationRaw(type);
+  const bool checked = layer.checked();
+#pragma omp parallel for num_threads(layer.batch_threads(batch_size))
   for (uint32_t i = 0; i < batch_size; ++i) {
-    const std::shared_ptr<Tensor<float>>& input = inputs.at(i);
-    CHECK(input != nullptr && !input->empty())
-        << "The input tensor array in the " + activation_type + " layer has an empty tensor " << i
-        << " th";
+    const TensorView& input = inputs[i];
+    const TensorView& output = outputs[i];
+    CHECK_WHEN(checked, !input.empty() && input.is_contiguous())
+        << "The input tensor array in the " << ActivationTypeToString(type)
+        << " layer has an empty tensor " << i << " th";
+    CHECK_WHEN(checked, output.same_shape(input) && output.is_contiguous())
+        << "The input and output tensor shapes of the " << ActivationTypeToString(type)
+        << " layer do not match " << i << " th";
+    activation_function(input.data<const float>(), output.data<float>(), int64_t(input.size()));
+  }
+  return StatusCode::kSuccess;
+}
 
-    std::shared_ptr<Tensor<float>> output = outputs.at(i);
-    if (output == nullptr || output->empty()) {
-      output = std::make_shared<Tensor<float>>(input->shapes());
-      outputs.at(i) = output;
+StatusCode ActivationForward(ActivationType type,
+                             const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
+                             std::vector<std::shared_ptr<Tensor<float>>>& outputs,
+                             const Layer<float>& layer) {
+  // 为空的输出按输入的形状申请，之后转为视图计算，数量等检查由视图接口完成
+  const size_t batch_size = std::min(inputs.size(), outputs.size());
+  for (size_t i = 0; i < batch_size; ++i) {
+    const std::shared_ptr<Tensor<float>>& input = inputs[i];
+    std::shared_ptr<Tensor<float>>& output = outputs[i];
+    if (input != nullptr && !input->empty() && (output == nullptr || output->empty())) {
+      output = std::make_shared<Tensor<float>>(input->channels(), input->rows(), input->cols());
     }
-    CHECK(output != nullptr && output->shapes() == input->shapes())
-        << "The input and output tensor shapes of the " + activation_type + " layer do not match "
-        << i << " th";
-    activation_function(input, output);
   }
-  return StatusCode::kSuccess;
+  const std::vector<TensorView> input_views = MakeTensorViews(inputs);
+  const std::vector<TensorView> output_views = MakeTensorViews(outputs);
+  return ActivationForward(type, input_views, output_views, layer);
 }
 
 std::string ActivationTypeToString(ActivationType type) {
@@ -82,5 +97,23 @@ std::string ActivationTypeToString(ActivationType type) {
   return activate_type;
 }
 
+ActivationType OpTypeToActivationType(const std::string& op_type) {
+  if (op_type == "nn.ReLU") {
+    return ActivationType::kActivationRelu;
+  } else if (op_type == "nn.ReLU6") {
+    return ActivationType::kActivationRelu6;
+  } else if (op_type == "nn.SiLU") {
+    return ActivationType::kActivationSilu;
+  } else if (op_type == "nn.Sigmoid") {
+    return ActivationType::kActivationSigmoid;
+  } else if (op_type == "nn.Hardswish") {
+    return ActivationType::kActivationHardSwish;
+  } else if (op_type == "nn.Hardsigmoid") {
+    return ActivationType::kActivationHardSigmoid;
+  } else {
+    return ActivationType::kActivatetionUnknown;
+  }
+}
+
 }  // namespace activation
 }  // namespace kuiper_infer
\ No newline at end of file
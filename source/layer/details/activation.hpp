@@ -5,11 +5,14 @@
 #ifndef KUIPER_INFER_SOURCE_LAYER_DETAILS_ACTIVATION_HPP
 #define KUIPER_INFER_SOURCE_LAYER_DETAILS_ACTIVATION_HPP
 #include "data/tensor.hpp"
+#include "layer/abstract/layer.hpp"
 #include "status_code.hpp"
 namespace kuiper_infer {
 namespace activation {
 using ActivationFunc = std::function<void(sftensor, sftensor)>;
 
+using ActivationRawFunc = void (*)(const float* in_ptr, float* out_ptr, int64_t size);
+
 enum class ActivationType {
   kActivatetionUnknown = -1,
   kActivationRelu = 0,
@@ -22,9 +25,42 @@ enum class ActivationType {
 
 std::string ActivationTypeToString(ActivationType type);
 
+/**
+ * @brief Maps a PNNX operator type to its activation type
+ *
+ * @param op_type Operator type, such as nn.ReLU
+ * @return Activation type, kActivatetionUnknown if the operator is not an activation
+ */
+ActivationType OpTypeToActivationType(const std::string& op_type);
+
+/**
+ * @brief Applies an activation to every tensor of the batch
+ *
+ * @param type Activation type
+ * @param inputs Views of the input tensors
+ * @param outputs Views of the output tensors, shaped like the inputs
+ * @param layer Layer providing the check state and the thread split
+ * @return Status code
+ */
+StatusCode ActivationForward(ActivationType type, Span<const TensorView> inputs,
+                             Span<const TensorView> outputs, const Layer<float>& layer);
+
+/**
+ * @brief Applies an activation to every tensor of the batch
+ *
+ * Adapter of the shared_ptr interface, allocates the empty outputs and runs
+ * the kernel on views of the tensors.
+ *
+ * @param type Activation type
+ * @param inputs Input tensors
+ * @param outputs Output tensors
+ * @param layer Layer providing the check state and the thread split
+ * @return Status code
+ */
 StatusCode ActivationForward(ActivationType type,
                              const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
-                             std::vector<std::shared_ptr<Tensor<float>>>& outputs);
+                             std::vector<std::shared_ptr<Tensor<float>>>& outputs,
+                             const Layer<float>& layer);
 }  // namespace activation
 }  // namespace kuiper_infer
 #endif  // KUIPER_INFER_SOURCE_LAYER_DETAILS_ACTIVATION_HPP
@@ -31,20 +31,15 @@ namespace kuiper_infer {
 
 namespace activation {
 
-static void SigmoidSSE(sftensor input, sftensor output) {
-  CHECK(input != nullptr && output != nullptr) << "The input or output tensor is empty.";
-  CHECK(!input->empty() && !output->empty()) << "The input or output tensor is empty.";
-  CHECK(input->size() == output->size()) << "The input and output sizes are not equal.";
+static void SigmoidSSE(const float* in_ptr, float* out_ptr, int64_t size) {
+  CHECK(in_ptr != nullptr && out_ptr != nullptr) << "The input or output tensor is empty.";
   int64_t index = 0;
   int64_t packet_size;
-  int64_t in_size = static_cast<int64_t>(input->size());
-  const float* in_ptr = input->raw_ptr();
-  float* out_ptr = output->raw_ptr();
 #ifdef __AVX2__
   packet_size = 8;
   __m256 one = _mm256_set1_ps(1.f);
   __m256 zero = _mm256_setzero_ps();
-  for (; index <= in_size - packet_size; index += packet_size) {
+  for (; index <= size - packet_size; index += packet_size) {
     __m256 p = _mm256_loadu_ps(in_ptr);
     p = _mm256_div_ps(one, _mm256_add_ps(one, fmath::exp_ps256(_mm256_sub_ps(zero, p))));
     _mm256_storeu_ps(out_ptr, p);
@@ -55,7 +50,7 @@ static void SigmoidSSE(sftensor input, sftensor output) {
   packet_size = 4;
   __m128 one128 = _mm_set1_ps(1.f);
   __m128 zero128 = _mm_setzero_ps();
-  for (; index <= in_size - packet_size; index += packet_size) {
+  for (; index <= size - packet_size; index += packet_size) {
     __m128 p = _mm_loadu_ps(in_ptr);
     p = _mm_div_ps(one128, _mm_add_ps(one128, fmath::exp_ps(_mm_sub_ps(zero128, p))));
     _mm_storeu_ps(out_ptr, p);
@@ -64,28 +59,23 @@ static void SigmoidSSE(sftensor input, sftensor output) {
   }
 #endif
 #endif
-  if (index < in_size) {
-    while (index < in_size) {
-      float value = input->index(index);
-      output->index(index) = 1 / (1.f + fmath::exp(-value));
+  if (index < size) {
+    while (index < size) {
+      float value = *(in_ptr++);
+      *(out_ptr++) = 1 / (1.f + fmath::exp(-value));
       index += 1;
     }
   }
 }
 
-static void ReluSSE(sftensor input, sftensor output) {
-  CHECK(input != nullptr && output != nullptr) << "The input or output tensor is empty.";
-  CHECK(!input->empty() && !output->empty()) << "The input or output tensor is empty.";
-  CHECK(input->size() == output->size()) << "The input and output sizes are not equal.";
-  int64_t index;
+static void ReluSSE(const float* in_ptr, float* out_ptr, int64_t size) {
+  CHECK(in_ptr != nullptr && out_ptr != nullptr) << "The input or output tensor is empty.";
+  int64_t index = 0;
   int64_t packet_size;
-  int64_t size = static_cast<int64_t>(input->size());
-  const float* in_ptr = input->raw_ptr();
-  float* out_ptr = output->raw_ptr();
 #ifdef __AVX2__
   packet_size = 8;
   __m256 zero = _mm256_setzero_ps();
-  for (index = 0; index <= size - packet_size; index += packet_size) {
+  for (; index <= size - packet_size; index += packet_size) {
     __m256 p = _mm256_loadu_ps(in_ptr);
     __m256 value = _mm256_max_ps(zero, p);
     _mm256_storeu_ps(out_ptr, value);
@@ -106,28 +96,23 @@ static void ReluSSE(sftensor input, sftensor output) {
 #endif
   if (index < size) {
     while (index < size) {
-      float value = input->index(index);
-      output->index(index) = std::max(value, 0.f);
+      float value = *(in_ptr++);
+      *(out_ptr++) = std::max(value, 0.f);
       index += 1;
     }
   }
 }
 
-static void Relu6SSE(sftensor input, sftensor output) {
-  CHECK(input != nullptr && output != nullptr) << "The input or output tensor is empty.";
-  CHECK(!input->empty() && !output->empty()) << "The input or output tensor is empty.";
-  CHECK(input->size() == output->size()) << "The input and output sizes are not equal.";
-  int64_t index;
+static void Relu6SSE(const float* in_ptr, float* out_ptr, int64_t size) {
+  CHECK(in_ptr != nullptr && out_ptr != nullptr) << "The input or output tensor is empty.";
+  int64_t index = 0;
   int64_t packet_size;
-  int64_t size = static_cast<int64_t>(input->size());
-  const float* in_ptr = input->raw_ptr();
-  float* out_ptr = output->raw_ptr();
 #ifdef __AVX2__
   packet_size = 8;
   __m256 zero = _mm256_setzero_ps();
   __m256 six = _mm256_set1_ps(6.f);
 
-  for (index = 0; index <= size - packet_size; index += packet_size) {
+  for (; index <= size - packet_size; index += packet_size) {
     __m256 p = _mm256_loadu_ps(in_ptr);
     __m256 value = _mm256_min_ps(_mm256_max_ps(zero, p), six);
     _mm256_storeu_ps(out_ptr, value);
@@ -149,28 +134,23 @@ static void Relu6SSE(sftensor input, sftensor output) {
 #endif
   if (index < size) {
     while (index < size) {
-      float value = input->index(index);
-      output->index(index) = std::min(std::max(value, 0.f), 6.f);
+      float value = *(in_ptr++);
+      *(out_ptr++) = std::min(std::max(value, 0.f), 6.f);
       index += 1;
     }
   }
 }
 
-static void SiluSSE(sftensor input, sftensor output) {
-  CHECK(input != nullptr && output != nullptr) << "The input or output tensor is empty.";
-  CHECK(!input->empty() && !output->empty()) << "The input or output tensor is empty.";
-  CHECK(input->size() == output->size()) << "The input and output sizes are not equal.";
-  int64_t index;
+static void SiluSSE(const float* in_ptr, float* out_ptr, int64_t size) {
+  CHECK(in_ptr != nullptr && out_ptr != nullptr) << "The input or output tensor is empty.";
+  int64_t index = 0;
   int64_t packet_size;
-  int64_t size = static_cast<int64_t>(input->size());
-  const float* in_ptr = input->raw_ptr();
-  float* out_ptr = output->raw_ptr();
 #ifdef __AVX2__
   packet_size = 8;
   __m256 one_256 = _mm256_set1_ps(1.f);
   __m256 zero_256 = _mm256_setzero_ps();
 
-  for (index = 0; index <= size - packet_size; index += packet_size) {
+  for (; index <= size - packet_size; index += packet_size) {
     __m256 p = _mm256_loadu_ps(in_ptr);
     p = _mm256_div_ps(p, _mm256_add_ps(one_256, fmath::exp_ps256(_mm256_sub_ps(zero_256, p))));
     _mm256_storeu_ps(out_ptr, p);
@@ -193,32 +173,26 @@ static void SiluSSE(sftensor input, sftensor output) {
 #endif
   if (index < size) {
     while (index < size) {
-      float value = input->index(index);
-      output->index(index) = value / (1.f + fmath::exp(-value));
+      float value = *(in_ptr++);
+      *(out_ptr++) = value / (1.f + fmath::exp(-value));
       index += 1;
     }
   }
 }
 
-static void HardSwishSSE(sftensor input, sftensor output) {
-  CHECK(input != nullptr && output != nullptr) << "The input or output tensor is empty.";
-  CHECK(!input->empty() && !output->empty()) << "The input or output tensor is empty.";
-  CHECK(input->size() == output->size()) << "The input and output sizes are not equal.";
-
-  int64_t index;
+static void HardSwishSSE(const float* in_ptr, float* out_ptr, int64_t size) {
+  CHECK(in_ptr != nullptr && out_ptr != nullptr) << "The input or output tensor is empty.";
+  int64_t index = 0;
   float threshold = 3.f;
   int64_t packet_size;
-  int64_t size = static_cast<int64_t>(input->size());
 
-  const float* in_ptr = input->raw_ptr();
-  float* out_ptr = output->raw_ptr();
 #ifdef __AVX2__
   packet_size = 8;
   __m256 zero = _mm256_set1_ps(0.f);
   __m256 three = _mm256_set1_ps(threshold);
   __m256 six = _mm256_set1_ps(6.f);
   __m256 minus_three = _mm256_set1_ps(-threshold);
-  for (index = 0; index <= size - packet_size; index += packet_size) {
+  for (; index <= size - packet_size; index += packet_size) {
     __m256 x = _mm256_loadu_ps(in_ptr);
 
     __m256 le_branch = _mm256_cmp_ps(x, minus_three, _CMP_LE_OS);  // <= -3
@@ -265,7 +239,7 @@ static void HardSwishSSE(sftensor input, sftensor output) {
 #endif
   if (index < size) {
     while (index < size) {
-      float value = input->index(index);
+      float value = *(in_ptr++);
       float result = 0.f;
       if (value <= -3.f) {
         result = 0.f;
@@ -274,24 +248,18 @@ static void HardSwishSSE(sftensor input, sftensor output) {
       } else {
         result = value * (value + threshold) / 6;
       }
-      output->index(index) = result;
+      *(out_ptr++) = result;
       index += 1;
     }
   }
 }
 
-static void HardSigmoidSSE(sftensor input, sftensor output) {
-  CHECK(input != nullptr && output != nullptr) << "The input or output tensor is empty.";
-  CHECK(!input->empty() && !output->empty()) << "The input or output tensor is empty.";
-  CHECK(input->size() == output->size()) << "The input and output sizes are not equal.";
-
-  int64_t index;
+static void HardSigmoidSSE(const float* in_ptr, float* out_ptr, int64_t size) {
+  CHECK(in_ptr != nullptr && out_ptr != nullptr) << "The input or output tensor is empty.";
+  int64_t index = 0;
   float threshold = 3.f;
   int64_t packet_size;
-  int64_t size = static_cast<int64_t>(input->size());
 
-  const float* in_ptr = input->raw_ptr();
-  float* out_ptr = output->raw_ptr();
 #ifdef __AVX2__
   packet_size = 8;
   __m256 zero = _mm256_set1_ps(0.f);
@@ -301,7 +269,7 @@ static void HardSigmoidSSE(sftensor input, sftensor output) {
   __m256 six = _mm256_set1_ps(6.f);
   __m256 point_five = _mm256_set1_ps(0.5f);
   __m256 minus_three = _mm256_set1_ps(-threshold);
-  for (index = 0; index <= size - packet_size; index += packet_size) {
+  for (; index <= size - packet_size; index += packet_size) {
     __m256 x = _mm256_loadu_ps(in_ptr);
     __m256 le_branch = _mm256_cmp_ps(x, minus_three, _CMP_LE_OS);  // <= -3
     __m256 ge_branch = _mm256_cmp_ps(x, three, _CMP_GE_OS);        // >= 3
@@ -348,7 +316,7 @@ static void HardSigmoidSSE(sftensor input, sftensor output) {
 #endif
   if (index < size) {
     while (index < size) {
-      float value = input->index(index);
+      float value = *(in_ptr++);
       float result = 0.f;
       if (value <= -3.f) {
         result = 0.f;
@@ -357,43 +325,48 @@ static void HardSigmoidSSE(sftensor input, sftensor output) {
       } else {
         result = value / 6.f + 0.5f;
       }
-      output->index(index) = result;
+      *(out_ptr++) = result;
       index += 1;
     }
   }
 }
 
-ActivationFunc ApplySSEActivation(ActivationType act_type) {
-  ActivationFunc function;
+ActivationRawFunc ApplySSEActivationRaw(ActivationType act_type) {
   switch (act_type) {
     case ActivationType::kActivationRelu: {
-      function = ReluSSE;
-      return function;
+      return ReluSSE;
     }
     case ActivationType::kActivationRelu6: {
-      function = Relu6SSE;
-      return function;
+      return Relu6SSE;
     }
     case ActivationType::kActivationSigmoid: {
-      function = SigmoidSSE;
-      return function;
+      return SigmoidSSE;
     }
     case ActivationType::kActivationSilu: {
-      function = SiluSSE;
-      return function;
+      return SiluSSE;
     }
     case ActivationType::kActivationHardSwish: {
-      function = HardSwishSSE;
-      return function;
+      return HardSwishSSE;
     }
     case ActivationType::kActivationHardSigmoid: {
-      function = HardSigmoidSSE;
-      return function;
+      return HardSigmoidSSE;
     }
     default: {
       LOG(FATAL) << "Unknown SSE activation type: " << int32_t(act_type);
+      return nullptr;
     }
   }
 }
+
+ActivationFunc ApplySSEActivation(ActivationType act_type) {
+  ActivationRawFunc raw_function = ApplySSEActivationRaw(act_type);
+  ActivationFunc function = [raw_function](sftensor input, sftensor output) {
+    CHECK(input != nullptr && output != nullptr) << "The input or output tensor is empty.";
+    CHECK(!input->empty() && !output->empty()) << "The input or output tensor is empty.";
+    CHECK(input->size() == output->size()) << "The input and output sizes are not equal.";
+    raw_function(input->raw_ptr(), output->raw_ptr(), static_cast<int64_t>(input->size()));
+  };
+  return function;
+}
 }  // namespace activation
 }  // namespace kuiper_infer
\ No newline at end of file
@@ -29,6 +29,14 @@ namespace kuiper_infer {
 namespace activation {
 ActivationFunc ApplySSEActivation(ActivationType act_type);
 
+/**
+ * @brief Gets the SSE activation kernel working on raw float buffers
+ *
+ * @param act_type Activation type
+ * @return Kernel computing the activation of size elements from in_ptr to out_ptr
+ */
+ActivationRawFunc ApplySSEActivationRaw(ActivationType act_type);
+
 }  // namespace activation
 }  // namespace kuiper_infer
 #endif  // KUIPER_INFER_INCLUDE_MATH_ARMA_SSE
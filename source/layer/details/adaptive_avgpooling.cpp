@@ -58,10 +58,10 @@ StatusCode AdaptiveAveragePoolingLayer::Forward(
   }
 
   const uint32_t batch = inputs.size();
-#pragma omp parallel for num_threads(batch)
+#pragma omp parallel for num_threads(this->batch_threads(batch))
   for (uint32_t i = 0; i < batch; ++i) {
     const std::shared_ptr<Tensor<float>>& input_data = inputs.at(i);
-    CHECK(input_data != nullptr && !input_data->empty())
+    LAYER_CHECK(input_data != nullptr && !input_data->empty())
         << "The input tensor array in the adaptive pooling layer has an empty "
            "tensor "
         << i << "th";
@@ -71,14 +71,14 @@ StatusCode AdaptiveAveragePoolingLayer::Forward(
     const uint32_t input_c = input_data->channels();
     const uint32_t stride_h = uint32_t(std::floor(input_h / output_h_));
     const uint32_t stride_w = uint32_t(std::floor(input_w / output_w_));
-    CHECK(stride_w > 0 && stride_h > 0)
+    LAYER_CHECK(stride_w > 0 && stride_h > 0)
         << "The stride parameter is set incorrectly. It must always be greater "
            "than 0";
 
     const uint32_t pooling_h = (int32_t)input_h - (int32_t(output_h_) - 1) * int32_t(stride_h);
     const uint32_t pooling_w = (int32_t)input_w - (int32_t(output_w_) - 1) * int32_t(stride_w);
 
-    CHECK(pooling_w > 0 && pooling_h > 0)
+    LAYER_CHECK(pooling_w > 0 && pooling_h > 0)
         << "The pooling parameter is set incorrectly. It must always be "
            "greater than 0";
 
@@ -88,13 +88,14 @@ StatusCode AdaptiveAveragePoolingLayer::Forward(
       outputs.at(i) = output_data;
     }
 
-    CHECK(output_data->rows() == output_h_ && output_data->cols() == output_w_ &&
-          output_data->channels() == input_c)
+    LAYER_CHECK(output_data->rows() == output_h_ && output_data->cols() == output_w_ &&
+                output_data->channels() == input_c)
         << "The output tensor array in the adaptive pooling layer has an "
            "incorrectly sized tensor "
         << i << "th";
 
     const uint32_t pooling_size = pooling_h * pooling_w;
+#pragma omp parallel for num_threads(this->intra_threads())
     for (uint32_t ic = 0; ic < input_c; ++ic) {
       const arma::fmat& input_channel = input_data->slice(ic);
       arma::fmat& output_channel = output_data->slice(ic);
@@ -119,6 +120,15 @@ StatusCode AdaptiveAveragePoolingLayer::Forward(
   return StatusCode::kSuccess;
 }
 
+LayerCost AdaptiveAveragePoolingLayer::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                                            const std::vector<int32_t>& output_shape) const {
+  LayerCost cost = Layer<float>::Cost(input_shapes, output_shape);
+  if (!input_shapes.empty()) {
+    cost.flops = ShapeElements(input_shapes.front()) + ShapeElements(output_shape);
+  }
+  return cost;
+}
+
 StatusCode AdaptiveAveragePoolingLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                                        std::shared_ptr<Layer<float>>& avg_layer) {
   if (!op) {
@@ -23,6 +23,7 @@
 // Created by fss on 23-10-11.
 //
 #include "base_convolution.hpp"
+#include "activation_sse.hpp"
 #include "convolution.hpp"
 #include "deconvolution.hpp"
 #include "status_code.hpp"
@@ -80,15 +81,41 @@ void BaseConvolutionLayer::InitIm2ColWeight() {}
 
 void BaseConvolutionLayer::AddBias(arma::fmat& output, uint32_t bias_index) const {
   if (!this->bias_.empty() && this->use_bias_) {
-    std::shared_ptr<Tensor<float>> bias;
-    bias = this->bias_.at(bias_index);
-    if (bias != nullptr && !bias->empty()) {
-      float bias_value = bias->index(0);
-      output += bias_value;
-    } else {
-      LOG(FATAL) << "Bias tensor is empty or nullptr";
+    const std::shared_ptr<Tensor<float>>& bias = this->bias_[bias_index];
+    LAYER_CHECK(bias != nullptr && !bias->empty()) << "Bias tensor is empty or nullptr";
+    output += bias->index(0);
+  }
+}
+
+void BaseConvolutionLayer::AddResidualActivation(arma::fmat& output, const sftensor& residual,
+                                                 uint32_t kernel_index) const {
+  if (residual != nullptr) {
+    const arma::fmat residual_channel(residual->matrix_raw_ptr(kernel_index), output.n_rows,
+                                      output.n_cols, false, true);
+    output += residual_channel;
+  }
+  if (fused_activation_ != nullptr) {
+    fused_activation_(output.memptr(), output.memptr(), static_cast<int64_t>(output.size()));
+  }
+}
+
+bool BaseConvolutionLayer::FuseResidualAdd(const std::string& activation_type) {
+  using namespace activation;
+  // 激活函数已经在残差相加之前被融合，不能再调整计算顺序
+  if (this->fused_activation_ != nullptr && !this->fused_residual_) {
+    return false;
+  }
+  ActivationRawFunc activation_function = nullptr;
+  if (!activation_type.empty()) {
+    const ActivationType type = OpTypeToActivationType(activation_type);
+    if (type == ActivationType::kActivatetionUnknown) {
+      return false;
     }
+    activation_function = ApplySSEActivationRaw(type);
   }
+  this->fused_residual_ = true;
+  this->fused_activation_ = activation_function;
+  return true;
 }
 
 StatusCode BaseConvolutionLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
@@ -103,7 +130,10 @@ StatusCode BaseConvolutionLayer::Forward(const std::vector<std::shared_ptr<Tenso
     return StatusCode::kInferOutputsEmpty;
   }
 
-  if (inputs.size() != outputs.size()) {
+  // 融合残差相加后，残差张量排列在常规输入之后
+  const uint32_t batch_size = outputs.size();
+  const uint32_t residual_size = fused_residual_ ? batch_size : 0;
+  if (inputs.size() != batch_size + residual_size) {
     LOG(ERROR) << "The input and output tensor array size of the convolution "
                   "layer do not match";
     return StatusCode::kInferInOutShapeMismatch;
@@ -154,23 +184,26 @@ StatusCode BaseConvolutionLayer::Forward(const std::vector<std::shared_ptr<Tenso
       << "The size of kernel matrix in the convolution layer should be greater "
          "than zero";
 
+  // 权重形状的逐个检查和其他形状检查一样，在校验通过后由LAYER_CHECK跳过
   for (uint32_t k = 0; k < kernel_count; ++k) {
     const std::shared_ptr<Tensor<float>>& kernel = this->weights_.at(k);
-    CHECK(kernel->rows() == kernel_h);
-    CHECK(kernel->cols() == kernel_w);
-    CHECK(kernel->channels() == kernel_channel);
+    LAYER_CHECK(kernel->rows() == kernel_h && kernel->cols() == kernel_w &&
+                kernel->channels() == kernel_channel)
+        << "The kernel matrices in the convolution layer have different shapes " << k << " th";
   }
+  LAYER_CHECK(kernel_count % groups_ == 0)
+      << "The kernel count in the convolution layer is not a multiple of the groups";
 
   if (this->kernel_matrix_arr_.empty()) {
     InitIm2ColWeight();
   }
-  const uint32_t batch_size = inputs.size();
   const uint32_t kernel_count_group = kernel_count / groups_;
 
-#pragma omp parallel for num_threads(batch_size)
+  // 以下循环中的检查在形状校验通过后由LAYER_CHECK跳过
+#pragma omp parallel for num_threads(this->batch_threads(batch_size))
   for (uint32_t i = 0; i < batch_size; ++i) {
-    const std::shared_ptr<Tensor<float>>& input = inputs.at(i);
-    CHECK(input != nullptr && !input->empty())
+    const std::shared_ptr<Tensor<float>>& input = inputs[i];
+    LAYER_CHECK(input != nullptr && !input->empty())
         << "The input tensor array in the convolution layer has an empty  "
            "tensor "
         << i << " th";
@@ -178,42 +211,72 @@ StatusCode BaseConvolutionLayer::Forward(const std::vector<std::shared_ptr<Tenso
     const uint32_t input_h = input->rows();
     const uint32_t input_w = input->cols();
     const uint32_t input_c = input->channels();
-    CHECK(input_h > 0 && input_w > 0 && input_c > 0);
+    LAYER_CHECK(input_h > 0 && input_w > 0 && input_c > 0);
 
     const auto& output_size = ComputeOutputSize(input_h, input_w, kernel_h, kernel_w);
     const uint32_t output_h = output_size.first;
     const uint32_t output_w = output_size.second;
-    CHECK(output_h > 0 && output_w > 0)
+    LAYER_CHECK(output_h > 0 && output_w > 0)
         << "The size of the output tensor should be greater than zero " << i << " th";
 
-    std::shared_ptr<Tensor<float>> output_tensor = outputs.at(i);
+    std::shared_ptr<Tensor<float>> output_tensor = outputs[i];
     if (output_tensor == nullptr || output_tensor->empty()) {
       output_tensor = std::make_shared<Tensor<float>>(kernel_count, output_h, output_w);
-      outputs.at(i) = output_tensor;
+      outputs[i] = output_tensor;
     }
 
-    CHECK(output_tensor->rows() == output_h && output_tensor->cols() == output_w &&
-          output_tensor->channels() == kernel_count)
+    LAYER_CHECK(output_tensor->rows() == output_h && output_tensor->cols() == output_w &&
+                output_tensor->channels() == kernel_count)
         << "The output tensor array in the convolution layer has an "
            "incorrectly sized tensor "
         << i << "th";
 
-#pragma omp parallel for if (groups_ > 1)
-    for (uint32_t group = 0; group < groups_; ++group) {
-      if (groups_ != 1) {
-        CHECK(kernel_count % groups_ == 0);
-        CHECK(input_c % groups_ == 0);
-      }
-      const uint32_t channels_per_group = input_c / groups_;
-      CHECK(channels_per_group == kernel_channel) << "The number of channel for the kernel "
-                                                     "matrix and input tensor do not match";
+    sftensor residual;
+    if (fused_residual_) {
+      residual = inputs[batch_size + i];
+      LAYER_CHECK(residual != nullptr && residual->rows() == output_h &&
+                  residual->cols() == output_w && residual->channels() == kernel_count)
+          << "The residual tensor array in the convolution layer has an incorrectly sized tensor "
+          << i << "th";
+    }
+
+    LAYER_CHECK(input_c % groups_ == 0);
+    const uint32_t channels_per_group = input_c / groups_;
+    LAYER_CHECK(channels_per_group == kernel_channel) << "The number of channel for the kernel "
+                                                         "matrix and input tensor do not match";
+    if (groups_ > 1) {
+      ComputeGroupedOutput(input, output_tensor, kernel_h, kernel_w, kernel_count_group, input_h,
+                           input_w, channels_per_group, output_h, output_w, residual);
+    } else {
       ComputeOutput(input, output_tensor, kernel_h, kernel_w, kernel_count_group, input_h, input_w,
-                    channels_per_group, output_h, output_w, group);
+                    channels_per_group, output_h, output_w, 0, residual);
     }
   }
   return StatusCode::kSuccess;
 }
 
+LayerCost BaseConvolutionLayer::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                                     const std::vector<int32_t>& output_shape) const {
+  LayerCost cost = ParamLayer::Cost(input_shapes, output_shape);
+  if (this->weights_.empty() || input_shapes.empty()) {
+    return cost;
+  }
+  const sftensor& kernel = this->weights_.front();
+  const double output_elements = ShapeElements(output_shape);
+  double multiply_adds = 0.;
+  if (conv_type_ == ConvType::kOpConv) {
+    // 每个输出元素与一个卷积核做乘加
+    multiply_adds = output_elements * kernel->size();
+  } else {
+    // 每个输入元素与同组的所有卷积核平面做乘加
+    const double kernel_count_group = double(this->weights_.size()) / groups_;
+    multiply_adds = ShapeElements(input_shapes.front()) * kernel_count_group * kernel->rows() *
+                    kernel->cols();
+  }
+  cost.flops = 2. * multiply_adds + (use_bias_ ? output_elements : 0.);
+  return cost;
+}
+
 StatusCode BaseConvolutionLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                                 std::shared_ptr<Layer<float>>& conv_layer) {
   if (!op) {
@@ -430,6 +493,22 @@ StatusCode BaseConvolutionLayer::CreateInstance(const std::shared_ptr<RuntimeOpe
 
   auto conv_layer_derived = std::dynamic_pointer_cast<BaseConvolutionLayer>(conv_layer);
   CHECK(conv_layer_derived != nullptr);
+
+  // 离线优化时融合进卷积的激活函数
+  if (params.find("activation") != params.end()) {
+    auto activation_type =
+        std::dynamic_pointer_cast<RuntimeParameterString>(params.at("activation"));
+    if (!activation_type) {
+      LOG(ERROR) << "Can not find the activation parameter";
+      return StatusCode::kParseParameterError;
+    }
+    const auto type = activation::OpTypeToActivationType(activation_type->value);
+    if (type == activation::ActivationType::kActivatetionUnknown) {
+      LOG(ERROR) << "Unsupported fused activation: " << activation_type->value;
+      return StatusCode::kParseParameterError;
+    }
+    conv_layer_derived->fused_activation_ = activation::ApplySSEActivationRaw(type);
+  }
   conv_layer_derived->InitIm2ColWeight();
 
   return StatusCode::kSuccess;
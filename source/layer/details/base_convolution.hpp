@@ -25,6 +25,7 @@
 
 #ifndef KUIPER_INFER_SOURCE_LAYER_DETAILS_BASE_CONVOLUTION_H
 #define KUIPER_INFER_SOURCE_LAYER_DETAILS_BASE_CONVOLUTION_H
+#include "activation.hpp"
 #include "layer/abstract/param_layer.hpp"
 namespace kuiper_infer {
 enum class ConvType {
@@ -48,11 +49,29 @@ class BaseConvolutionLayer : public ParamLayer {
   StatusCode Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                      std::vector<std::shared_ptr<Tensor<float>>>& outputs) override;
 
+  bool FuseResidualAdd(const std::string& activation_type) override;
+
+  LayerCost Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                 const std::vector<int32_t>& output_shape) const override;
+
  private:
   virtual void ComputeOutput(sftensor input, sftensor output_tensor, uint32_t kernel_h,
                              uint32_t kernel_w, uint32_t kernel_count_group, uint32_t input_h,
                              uint32_t input_w, uint32_t input_c_group, uint32_t output_h,
-                             uint32_t output_w, uint32_t group) const = 0;
+                             uint32_t output_w, uint32_t group,
+                             const sftensor& residual) const = 0;
+
+  /**
+   * @brief Computes all groups of one sample in a single parallel region
+   *
+   * The groups are split into a flat list of equally sized tasks, so the
+   * threads are not spread over nested per-group and per-kernel loops.
+   */
+  virtual void ComputeGroupedOutput(sftensor input, sftensor output_tensor, uint32_t kernel_h,
+                                    uint32_t kernel_w, uint32_t kernel_count_group,
+                                    uint32_t input_h, uint32_t input_w, uint32_t input_c_group,
+                                    uint32_t output_h, uint32_t output_w,
+                                    const sftensor& residual) const = 0;
 
   virtual std::pair<uint32_t, uint32_t> ComputeOutputSize(uint32_t input_h, uint32_t input_w,
                                                           uint32_t kernel_h,
@@ -63,6 +82,9 @@ class BaseConvolutionLayer : public ParamLayer {
  protected:
   void AddBias(arma::fmat& output, uint32_t bias_index) const;
 
+  void AddResidualActivation(arma::fmat& output, const sftensor& residual,
+                             uint32_t kernel_index) const;
+
  protected:
   uint32_t groups_ = 1;
   bool use_bias_ = false;
@@ -78,6 +100,9 @@ class BaseConvolutionLayer : public ParamLayer {
   uint32_t dilation_h_ = 1;
   uint32_t dilation_w_ = 1;
 
+  bool fused_residual_ = false;
+  activation::ActivationRawFunc fused_activation_ = nullptr;
+
   ConvType conv_type_ = ConvType::kOpConvUnknown;
   std::vector<arma::fmat> kernel_matrix_arr_;
 };
@@ -21,6 +21,7 @@
 
 // Created by fss on 22-11-17.
 #include "batchnorm2d.hpp"
+#include "data/tensor_util.hpp"
 #include "layer/abstract/layer_factory.hpp"
 #include "runtime/runtime_ir.hpp"
 
@@ -64,39 +65,49 @@ StatusCode BatchNorm2dLayer::Forward(const std::vector<std::shared_ptr<Tensor<fl
     return StatusCode::kInferParameterError;
   }
   const uint32_t batch_size = inputs.size();
-#pragma omp parallel for num_threads(batch_size)
+#pragma omp parallel for num_threads(this->batch_threads(batch_size))
   for (uint32_t b = 0; b < batch_size; ++b) {
-    const auto& input = inputs.at(b);
-    CHECK(input != nullptr && !input->empty())
+    const auto& input = inputs[b];
+    LAYER_CHECK(input != nullptr && !input->empty())
         << "The input tensor array in the batchnorm2d layer has an "
            "empty tensor "
         << b << " th";
 
-    std::shared_ptr<Tensor<float>> output = outputs.at(b);
+    std::shared_ptr<Tensor<float>> output = outputs[b];
     if (output == nullptr || output->empty()) {
-      output = std::make_shared<Tensor<float>>(input->shapes());
-      outputs.at(b) = output;
+      output = std::make_shared<Tensor<float>>(input->channels(), input->rows(), input->cols());
+      outputs[b] = output;
     }
 
-    CHECK(output->shapes() == input->shapes())
+    LAYER_CHECK(TensorShapeIsSame(output, input))
         << "The input and output tensor shapes of the batchnorm2d "
            "layer do not match "
         << b << " th";
+    LAYER_CHECK(input->channels() >= mean_value_size)
+        << "In the batchnorm2d layer, too few channels for input tensor " << b << " th";
 
+#pragma omp parallel for num_threads(this->intra_threads())
     for (uint32_t i = 0; i < mean_value_size; ++i) {
-      CHECK(weights_.at(i)->size() == 1 && bias_.at(i)->size() == 1);
-      const float mean_value = weights_.at(i)->index(0);
-      CHECK(input->channels() > i)
-          << "In the batchnorm2d layer, too few channels for input tensor " << b << " th";
-
-      const float var_value = std::sqrt(bias_.at(i)->index(0) + eps_);
+      LAYER_CHECK(weights_[i]->size() == 1 && bias_[i]->size() == 1);
+      const float mean_value = weights_[i]->index(0);
+      const float var_value = std::sqrt(bias_[i]->index(0) + eps_);
       output->slice(i) =
-          ((input->slice(i) - mean_value) / var_value) * affine_weight_.at(i) + affine_bias_.at(i);
+          ((input->slice(i) - mean_value) / var_value) * affine_weight_[i] + affine_bias_[i];
     }
   }
   return StatusCode::kSuccess;
 }
 
+LayerCost BatchNorm2dLayer::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                                 const std::vector<int32_t>& output_shape) const {
+  LayerCost cost = ParamLayer::Cost(input_shapes, output_shape);
+  cost.parameters += affine_weight_.size() + affine_bias_.size();
+  cost.weight_bytes = cost.parameters * sizeof(float);
+  // 减均值、除标准差、乘仿射权重和加仿射偏移
+  cost.flops = 4. * ShapeElements(output_shape);
+  return cost;
+}
+
 StatusCode BatchNorm2dLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                             std::shared_ptr<Layer<float>>& batch_layer) {
   if (!op) {
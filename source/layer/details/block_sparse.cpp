@@ -0,0 +1,121 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-6.
+
+#include "block_sparse.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+#include "row_multiply.hpp"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace kuiper_infer {
+namespace sparse {
+static bool IsZeroBlock(const float* row, uint32_t col, uint32_t cols) {
+  const uint32_t end = std::min(col + kBlockCols, cols);
+  for (uint32_t c = col; c < end; ++c) {
+    if (row[c] != 0.f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+float ZeroBlockRatio(const std::vector<const float*>& rows, uint32_t cols) {
+  if (rows.empty() || cols == 0) {
+    return 0.f;
+  }
+  size_t zero_blocks = 0;
+  size_t total_blocks = 0;
+  for (const float* row : rows) {
+    for (uint32_t col = 0; col < cols; col += kBlockCols) {
+      zero_blocks += IsZeroBlock(row, col, cols);
+      total_blocks += 1;
+    }
+  }
+  return float(zero_blocks) / float(total_blocks);
+}
+
+BlockSparseMatrix::BlockSparseMatrix(const std::vector<const float*>& rows, uint32_t cols)
+    : rows_(rows.size()), cols_(cols) {
+  CHECK(rows_ > 0 && cols_ > 0) << "The sparse matrix can not be empty";
+  row_offsets_.reserve(rows_ + 1);
+  row_offsets_.push_back(0);
+  for (const float* row : rows) {
+    CHECK(row != nullptr);
+    for (uint32_t col = 0; col < cols_; col += kBlockCols) {
+      if (IsZeroBlock(row, col, cols_)) {
+        continue;
+      }
+      // 最后一个不满的块补零，计算时按实际长度处理
+      block_cols_.push_back(col);
+      for (uint32_t c = col; c < col + kBlockCols; ++c) {
+        values_.push_back(c < cols_ ? row[c] : 0.f);
+      }
+    }
+    row_offsets_.push_back(block_cols_.size());
+  }
+}
+
+size_t BlockSparseMatrix::memory_bytes() const {
+  return values_.size() * sizeof(float) + block_cols_.size() * sizeof(uint32_t) +
+         row_offsets_.size() * sizeof(uint32_t);
+}
+
+float BlockSparseMatrix::RowDot(uint32_t row, const float* column) const {
+  uint32_t b = row_offsets_[row];
+  const uint32_t end = row_offsets_[row + 1];
+  float sum = 0.f;
+#ifdef __AVX2__
+  __m256 acc = _mm256_setzero_ps();
+  for (; b < end && block_cols_[b] + kBlockCols <= cols_; ++b) {
+    const __m256 w = _mm256_loadu_ps(values_.data() + size_t(b) * kBlockCols);
+    const __m256 x = _mm256_loadu_ps(column + block_cols_[b]);
+    acc = _mm256_add_ps(acc, _mm256_mul_ps(w, x));
+  }
+  float lanes[8];
+  _mm256_storeu_ps(lanes, acc);
+  for (float lane : lanes) {
+    sum += lane;
+  }
+#endif
+  for (; b < end; ++b) {
+    const float* w = values_.data() + size_t(b) * kBlockCols;
+    const uint32_t col = block_cols_[b];
+    const uint32_t length = std::min(kBlockCols, cols_ - col);
+    for (uint32_t c = 0; c < length; ++c) {
+      sum += w[c] * column[col + c];
+    }
+  }
+  return sum;
+}
+
+void BlockSparseMatrix::Multiply(const float* matrix, size_t col_stride, uint32_t positions,
+                                 float* output, size_t channel_stride, uint32_t threads) const {
+  CHECK(matrix != nullptr && output != nullptr);
+  CHECK_GE(col_stride, cols_);
+  MultiplyRows(rows_, positions, output, channel_stride, threads,
+               [&](uint32_t row, uint32_t n) { return RowDot(row, matrix + n * col_stride); });
+}
+}  // namespace sparse
+}  // namespace kuiper_infer
@@ -0,0 +1,101 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-6.
+
+#ifndef KUIPER_INFER_SOURCE_LAYER_DETAILS_BLOCK_SPARSE_HPP_
+#define KUIPER_INFER_SOURCE_LAYER_DETAILS_BLOCK_SPARSE_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+namespace kuiper_infer {
+namespace sparse {
+/// Weights of one output channel stored together, along the reduce dimension
+constexpr uint32_t kBlockCols = 8;
+
+/// Share of all-zero blocks from which the sparse kernels are used
+constexpr float kSparsityThreshold = 0.5f;
+
+/**
+ * @brief Gets the share of all-zero 1 x kBlockCols blocks of a weight matrix
+ *
+ * @param rows Weights of every output channel, cols floats each
+ */
+float ZeroBlockRatio(const std::vector<const float*>& rows, uint32_t cols);
+
+/**
+ * @brief Weight matrix in block compressed sparse row format
+ *
+ * Every row keeps only its nonzero 1 x kBlockCols blocks. A block spans
+ * contiguous reduce positions, which matches the columns of the im2col
+ * matrix, so a block is multiplied with one vector load per output.
+ */
+class BlockSparseMatrix {
+ public:
+  /**
+   * @brief Compresses a dense matrix at build time
+   *
+   * @param rows Weights of every output channel, cols floats each
+   */
+  BlockSparseMatrix(const std::vector<const float*>& rows, uint32_t cols);
+
+  /**
+   * @brief Multiplies the sparse weights with a dense matrix
+   *
+   * output[o * channel_stride + n] is the dot product of row o with the n-th
+   * column of the matrix.
+   *
+   * @param matrix Dense matrix, one column of cols() floats per output position
+   * @param col_stride Distance between two columns of the matrix
+   * @param positions Number of output positions
+   * @param output First output channel
+   * @param channel_stride Distance between two output channels
+   * @param threads Threads computing the output
+   */
+  void Multiply(const float* matrix, size_t col_stride, uint32_t positions, float* output,
+                size_t channel_stride, uint32_t threads) const;
+
+  uint32_t rows() const { return rows_; }
+
+  uint32_t cols() const { return cols_; }
+
+  /**
+   * @brief Gets the number of stored nonzero blocks
+   */
+  size_t blocks() const { return block_cols_.size(); }
+
+  /**
+   * @brief Gets the memory of the compressed weights in bytes
+   */
+  size_t memory_bytes() const;
+
+ private:
+  float RowDot(uint32_t row, const float* column) const;
+
+  uint32_t rows_ = 0;
+  uint32_t cols_ = 0;
+  std::vector<uint32_t> row_offsets_;
+  std::vector<uint32_t> block_cols_;
+  std::vector<float> values_;
+};
+}  // namespace sparse
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_SOURCE_LAYER_DETAILS_BLOCK_SPARSE_HPP_
@@ -49,19 +49,18 @@ StatusCode CatLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>>&
   }
 
   const uint32_t packet_size = inputs.size() / output_size;
-#pragma omp parallel for num_threads(outputs.size())
+#pragma omp parallel for num_threads(this->batch_threads(outputs.size()))
   for (uint32_t i = 0; i < outputs.size(); ++i) {
     uint32_t copy_channel_offset = 0;
     std::shared_ptr<Tensor<float>> output = outputs.at(i);
     for (uint32_t j = i; j < inputs.size(); j += output_size) {
       const std::shared_ptr<Tensor<float>>& input = inputs.at(j);
-      CHECK(input != nullptr && !input->empty()) << "The input tensor array in the cat layer has "
-                                                    "an empty tensor "
-                                                 << j << " th";
+      LAYER_CHECK(input != nullptr && !input->empty())
+          << "The input tensor array in the cat layer has an empty tensor " << j << " th";
       const uint32_t in_rows = input->rows();
       const uint32_t in_cols = input->cols();
       const uint32_t in_channels = input->channels();
-      CHECK(in_rows == input->rows() && in_cols == input->cols())
+      LAYER_CHECK(in_rows == input->rows() && in_cols == input->cols())
           << "The input tensor array in the cat layer "
              "has an incorrectly sized tensor "
           << j << " th";
@@ -70,8 +69,8 @@ StatusCode CatLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>>&
         output = std::make_shared<Tensor<float>>(in_channels * packet_size, in_rows, in_cols);
         outputs.at(i) = output;
       }
-      CHECK(output->channels() == in_channels * packet_size && output->rows() == in_rows &&
-            output->cols() == in_cols)
+      LAYER_CHECK(output->channels() == in_channels * packet_size && output->rows() == in_rows &&
+                  output->cols() == in_cols)
           << "The output tensor array in the cat layer "
              "has an incorrectly sized tensor "
           << i << " th";
@@ -84,6 +83,13 @@ StatusCode CatLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>>&
   return StatusCode::kSuccess;
 }
 
+LayerCost CatLayer::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                         const std::vector<int32_t>& output_shape) const {
+  LayerCost cost = Layer<float>::Cost(input_shapes, output_shape);
+  cost.flops = 0.;
+  return cost;
+}
+
 StatusCode CatLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                     std::shared_ptr<Layer<float>>& cat_layer) {
   if (!op) {
@@ -32,6 +32,9 @@ class CatLayer : public NonParamLayer {
   StatusCode Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                      std::vector<std::shared_ptr<Tensor<float>>>& outputs) override;
 
+  LayerCost Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                 const std::vector<int32_t>& output_shape) const override;
+
   static StatusCode CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                    std::shared_ptr<Layer<float>>& cat_layer);
 
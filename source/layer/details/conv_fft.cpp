@@ -0,0 +1,341 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-5.
+
+#include "conv_fft.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "layer/abstract/layer_workspace.hpp"
+
+namespace kuiper_infer {
+namespace fft {
+// 标量FFT和复数乘加相对im2col后GEMM的效率折算
+constexpr double kTransformPenalty = 4.;
+// 权重频谱占用内存的上限
+constexpr double kMaxSpectrumBytes = 128. * 1024 * 1024;
+
+uint32_t SelectTransformSize(uint32_t in_channels, uint32_t out_channels, uint32_t kernel_h,
+                             uint32_t kernel_w, uint32_t stride_h, uint32_t stride_w) {
+  const uint32_t kernel_size = std::max(kernel_h, kernel_w);
+  if (kernel_size < kMinKernelSize || in_channels == 0 || out_channels == 0) {
+    return 0;
+  }
+  // im2col每个输出与一个卷积核做乘加
+  const double direct_cost = 2. * out_channels * in_channels * kernel_h * kernel_w;
+  const double channel_pairs = double(out_channels) * in_channels;
+
+  uint32_t best_size = 0;
+  double best_cost = direct_cost;
+  for (const uint32_t size : {16u, 32u, 64u}) {
+    // 分块至少要覆盖一个卷积核大小的输出，否则重叠部分的变换都是浪费
+    if (size < 2 * kernel_size) {
+      continue;
+    }
+    const double spectrum_size = double(size / 2 + 1) * size;
+    if (channel_pairs * spectrum_size * 2 * sizeof(float) > kMaxSpectrumBytes) {
+      continue;
+    }
+    const double transform_cost = 2.5 * size * size * std::log2(double(size) * size);
+    const double tile_cost =
+        (in_channels + out_channels) * transform_cost + 8. * channel_pairs * spectrum_size;
+    const double tile_outputs = std::ceil(double(size - kernel_h + 1) / stride_h) *
+                                std::ceil(double(size - kernel_w + 1) / stride_w);
+    const double cost = kTransformPenalty * tile_cost / tile_outputs;
+    if (cost < best_cost) {
+      best_cost = cost;
+      best_size = size;
+    }
+  }
+  return best_size;
+}
+
+FFTConvolution::FFTConvolution(uint32_t size, uint32_t in_channels, uint32_t out_channels,
+                               uint32_t kernel_h, uint32_t kernel_w,
+                               const std::vector<const float*>& kernels)
+    : size_(size),
+      spectrum_size_((size / 2 + 1) * size),
+      in_channels_(in_channels),
+      out_channels_(out_channels),
+      kernel_h_(kernel_h),
+      kernel_w_(kernel_w) {
+  CHECK(size_ >= 2 && (size_ & (size_ - 1)) == 0) << "The transform size must be a power of two";
+  CHECK(kernel_h_ > 0 && kernel_h_ <= size_ && kernel_w_ > 0 && kernel_w_ <= size_)
+      << "The kernel does not fit into the transform size";
+  CHECK_EQ(kernels.size(), out_channels_);
+
+  uint32_t log_size = 0;
+  while ((1u << log_size) < size_) {
+    log_size += 1;
+  }
+  bit_reverse_.resize(size_);
+  for (uint32_t i = 0; i < size_; ++i) {
+    uint32_t reversed = 0;
+    for (uint32_t b = 0; b < log_size; ++b) {
+      reversed |= ((i >> b) & 1u) << (log_size - 1 - b);
+    }
+    bit_reverse_.at(i) = reversed;
+  }
+  cos_table_.resize(size_ / 2);
+  sin_table_.resize(size_ / 2);
+  for (uint32_t k = 0; k < size_ / 2; ++k) {
+    const double angle = 2. * M_PI * k / size_;
+    cos_table_.at(k) = float(std::cos(angle));
+    sin_table_.at(k) = float(std::sin(angle));
+  }
+
+  // 卷积实际是互相关，乘以共轭频谱；逆变换的1/(size*size)也并入权重
+  const float scale = 1.f / float(size_ * size_);
+  const size_t weight_size = size_t(out_channels_) * in_channels_ * spectrum_size_;
+  weight_real_.resize(weight_size);
+  weight_imag_.resize(weight_size);
+  std::vector<float> block(size_ * size_);
+  std::vector<float> scratch(2 * size_);
+  for (uint32_t o = 0; o < out_channels_; ++o) {
+    for (uint32_t c = 0; c < in_channels_; ++c) {
+      std::fill(block.begin(), block.end(), 0.f);
+      const float* kernel = kernels.at(o) + size_t(c) * kernel_h_ * kernel_w_;
+      for (uint32_t j = 0; j < kernel_w_; ++j) {
+        std::memcpy(block.data() + j * size_, kernel + j * kernel_h_, kernel_h_ * sizeof(float));
+      }
+      const size_t offset = (size_t(o) * in_channels_ + c) * spectrum_size_;
+      float* real = weight_real_.data() + offset;
+      float* imag = weight_imag_.data() + offset;
+      Transform(block.data(), real, imag, scratch.data());
+      for (uint32_t f = 0; f < spectrum_size_; ++f) {
+        real[f] *= scale;
+        imag[f] *= -scale;
+      }
+    }
+  }
+}
+
+size_t FFTConvolution::WorkspaceSize(uint32_t size, uint32_t in_channels) {
+  const size_t spectrum_size = size_t(size / 2 + 1) * size;
+  return 2 * LayerWorkspace::SliceSize(spectrum_size * in_channels) +
+         2 * LayerWorkspace::SliceSize(spectrum_size) +
+         LayerWorkspace::SliceSize(size_t(size) * size) + 2 * size;
+}
+
+void FFTConvolution::ComplexFFT(float* real, float* imag, bool inverse) const {
+  const uint32_t n = size_;
+  for (uint32_t i = 0; i < n; ++i) {
+    const uint32_t j = bit_reverse_[i];
+    if (i < j) {
+      std::swap(real[i], real[j]);
+      std::swap(imag[i], imag[j]);
+    }
+  }
+
+  // 基2蝶形运算，逆变换不做缩放
+  for (uint32_t length = 2; length <= n; length <<= 1) {
+    const uint32_t half = length / 2;
+    const uint32_t step = n / length;
+    for (uint32_t i = 0; i < n; i += length) {
+      for (uint32_t k = 0; k < half; ++k) {
+        const float wr = cos_table_[k * step];
+        const float wi = inverse ? sin_table_[k * step] : -sin_table_[k * step];
+        const uint32_t a = i + k;
+        const uint32_t b = a + half;
+        const float tr = real[b] * wr - imag[b] * wi;
+        const float ti = real[b] * wi + imag[b] * wr;
+        real[b] = real[a] - tr;
+        imag[b] = imag[a] - ti;
+        real[a] += tr;
+        imag[a] += ti;
+      }
+    }
+  }
+}
+
+void FFTConvolution::Transform(const float* block, float* real, float* imag,
+                               float* scratch) const {
+  const uint32_t n = size_;
+  const uint32_t half = n / 2 + 1;
+  float* scratch_real = scratch;
+  float* scratch_imag = scratch + n;
+
+  // 第一维：两列实数打包成一次复数FFT，再按对称性拆出两列各自的半频谱
+  for (uint32_t j = 0; j < n; j += 2) {
+    std::memcpy(scratch_real, block + j * n, n * sizeof(float));
+    std::memcpy(scratch_imag, block + (j + 1) * n, n * sizeof(float));
+    ComplexFFT(scratch_real, scratch_imag, false);
+    for (uint32_t u = 0; u < half; ++u) {
+      const uint32_t r = (n - u) % n;
+      const float zr = scratch_real[u];
+      const float zi = scratch_imag[u];
+      const float cr = scratch_real[r];
+      const float ci = -scratch_imag[r];
+      // A = (Z[u] + conj(Z[n - u])) / 2, B = (Z[u] - conj(Z[n - u])) / 2i
+      real[u + j * half] = 0.5f * (zr + cr);
+      imag[u + j * half] = 0.5f * (zi + ci);
+      real[u + (j + 1) * half] = 0.5f * (zi - ci);
+      imag[u + (j + 1) * half] = -0.5f * (zr - cr);
+    }
+  }
+
+  // 第二维：每个频率行做复数FFT
+  for (uint32_t u = 0; u < half; ++u) {
+    for (uint32_t v = 0; v < n; ++v) {
+      scratch_real[v] = real[u + v * half];
+      scratch_imag[v] = imag[u + v * half];
+    }
+    ComplexFFT(scratch_real, scratch_imag, false);
+    for (uint32_t v = 0; v < n; ++v) {
+      real[u + v * half] = scratch_real[v];
+      imag[u + v * half] = scratch_imag[v];
+    }
+  }
+}
+
+void FFTConvolution::InverseTransform(float* real, float* imag, float* block,
+                                      float* scratch) const {
+  const uint32_t n = size_;
+  const uint32_t half = n / 2 + 1;
+  float* scratch_real = scratch;
+  float* scratch_imag = scratch + n;
+
+  for (uint32_t u = 0; u < half; ++u) {
+    for (uint32_t v = 0; v < n; ++v) {
+      scratch_real[v] = real[u + v * half];
+      scratch_imag[v] = imag[u + v * half];
+    }
+    ComplexFFT(scratch_real, scratch_imag, true);
+    for (uint32_t v = 0; v < n; ++v) {
+      real[u + v * half] = scratch_real[v];
+      imag[u + v * half] = scratch_imag[v];
+    }
+  }
+
+  // 由共轭对称补全两列的频谱，合成A + iB后一次逆变换得到两列实数
+  for (uint32_t j = 0; j < n; j += 2) {
+    const float* a_real = real + j * half;
+    const float* a_imag = imag + j * half;
+    const float* b_real = real + (j + 1) * half;
+    const float* b_imag = imag + (j + 1) * half;
+    for (uint32_t u = 0; u < n; ++u) {
+      const bool mirrored = u >= half;
+      const uint32_t k = mirrored ? n - u : u;
+      const float ar = a_real[k];
+      const float ai = mirrored ? -a_imag[k] : a_imag[k];
+      const float br = b_real[k];
+      const float bi = mirrored ? -b_imag[k] : b_imag[k];
+      scratch_real[u] = ar - bi;
+      scratch_imag[u] = ai + br;
+    }
+    ComplexFFT(scratch_real, scratch_imag, true);
+    std::memcpy(block + j * n, scratch_real, n * sizeof(float));
+    std::memcpy(block + (j + 1) * n, scratch_imag, n * sizeof(float));
+  }
+}
+
+void FFTConvolution::Forward(const float* input, uint32_t input_h, uint32_t input_w,
+                             uint32_t padding_h, uint32_t padding_w, uint32_t stride_h,
+                             uint32_t stride_w, float* output, uint32_t output_h,
+                             uint32_t output_w, uint32_t threads) const {
+  CHECK(input != nullptr && output != nullptr);
+  CHECK(output_h > 0 && output_w > 0 && stride_h > 0 && stride_w > 0);
+  const uint32_t n = size_;
+  const uint32_t tile_h = n - kernel_h_ + 1;
+  const uint32_t tile_w = n - kernel_w_ + 1;
+  // 按步长为1计算，只取落在步长网格上的输出
+  const uint32_t full_h = (output_h - 1) * stride_h + 1;
+  const uint32_t full_w = (output_w - 1) * stride_w + 1;
+  const uint32_t tiles_h = (full_h + tile_h - 1) / tile_h;
+  const uint32_t tiles_w = (full_w + tile_w - 1) / tile_w;
+  const size_t input_plane = size_t(input_h) * input_w;
+  const size_t output_plane = size_t(output_h) * output_w;
+
+  const size_t spectrum_slice = LayerWorkspace::SliceSize(size_t(in_channels_) * spectrum_size_);
+  const size_t accum_slice = LayerWorkspace::SliceSize(spectrum_size_);
+  const size_t block_slice = LayerWorkspace::SliceSize(size_t(n) * n);
+
+#pragma omp parallel for num_threads(threads)
+  for (uint32_t t = 0; t < tiles_h * tiles_w; ++t) {
+    const uint32_t tile_y = t % tiles_h * tile_h;
+    const uint32_t tile_x = t / tiles_h * tile_w;
+    const uint32_t oy_begin = (tile_y + stride_h - 1) / stride_h;
+    const uint32_t oy_end = std::min(output_h, (tile_y + tile_h + stride_h - 1) / stride_h);
+    const uint32_t ox_begin = (tile_x + stride_w - 1) / stride_w;
+    const uint32_t ox_end = std::min(output_w, (tile_x + tile_w + stride_w - 1) / stride_w);
+    if (oy_begin >= oy_end || ox_begin >= ox_end) {
+      continue;
+    }
+
+    // 输入频谱、累加频谱、实数块和FFT缓冲区是当前线程工作区中的几段
+    float* input_real = LayerWorkspace::Acquire(WorkspaceSize(n, in_channels_));
+    float* input_imag = input_real + spectrum_slice;
+    float* accum_real = input_imag + spectrum_slice;
+    float* accum_imag = accum_real + accum_slice;
+    float* block = accum_imag + accum_slice;
+    float* scratch = block + block_slice;
+
+    for (uint32_t c = 0; c < in_channels_; ++c) {
+      const float* input_channel = input + c * input_plane;
+      for (uint32_t j = 0; j < n; ++j) {
+        float* block_col = block + j * n;
+        const int32_t x = int32_t(tile_x + j) - int32_t(padding_w);
+        if (x < 0 || x >= int32_t(input_w)) {
+          std::fill(block_col, block_col + n, 0.f);
+          continue;
+        }
+        const float* input_col = input_channel + size_t(x) * input_h;
+        for (uint32_t i = 0; i < n; ++i) {
+          const int32_t y = int32_t(tile_y + i) - int32_t(padding_h);
+          block_col[i] = (y >= 0 && y < int32_t(input_h)) ? input_col[y] : 0.f;
+        }
+      }
+      Transform(block, input_real + c * spectrum_size_, input_imag + c * spectrum_size_,
+                scratch);
+    }
+
+    for (uint32_t o = 0; o < out_channels_; ++o) {
+      std::fill(accum_real, accum_real + spectrum_size_, 0.f);
+      std::fill(accum_imag, accum_imag + spectrum_size_, 0.f);
+      for (uint32_t c = 0; c < in_channels_; ++c) {
+        const size_t offset = (size_t(o) * in_channels_ + c) * spectrum_size_;
+        const float* wr = weight_real_.data() + offset;
+        const float* wi = weight_imag_.data() + offset;
+        const float* xr = input_real + c * spectrum_size_;
+        const float* xi = input_imag + c * spectrum_size_;
+#pragma omp simd
+        for (uint32_t f = 0; f < spectrum_size_; ++f) {
+          accum_real[f] += xr[f] * wr[f] - xi[f] * wi[f];
+          accum_imag[f] += xr[f] * wi[f] + xi[f] * wr[f];
+        }
+      }
+      InverseTransform(accum_real, accum_imag, block, scratch);
+
+      float* output_channel = output + o * output_plane;
+      for (uint32_t ox = ox_begin; ox < ox_end; ++ox) {
+        const float* block_col = block + (ox * stride_w - tile_x) * n;
+        float* output_col = output_channel + size_t(ox) * output_h;
+        for (uint32_t oy = oy_begin; oy < oy_end; ++oy) {
+          output_col[oy] = block_col[oy * stride_h - tile_y];
+        }
+      }
+    }
+  }
+}
+}  // namespace fft
+}  // namespace kuiper_infer
@@ -0,0 +1,109 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-5.
+
+#ifndef KUIPER_INFER_SOURCE_LAYER_DETAILS_CONV_FFT_HPP_
+#define KUIPER_INFER_SOURCE_LAYER_DETAILS_CONV_FFT_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+namespace kuiper_infer {
+namespace fft {
+/// Smallest kernel size for which the FFT path is considered
+constexpr uint32_t kMinKernelSize = 7;
+
+/**
+ * @brief Picks the transform size of an FFT convolution from a cost model
+ *
+ * Compares the multiply-adds per output of im2col with the transforms and
+ * the complex products per output of every candidate size, weighting the
+ * FFT by its lower efficiency. Sizes whose weight spectra would take too
+ * much memory are skipped.
+ *
+ * @return Transform size, 0 when im2col is estimated to be faster
+ */
+uint32_t SelectTransformSize(uint32_t in_channels, uint32_t out_channels, uint32_t kernel_h,
+                             uint32_t kernel_w, uint32_t stride_h, uint32_t stride_w);
+
+/**
+ * @brief Convolution computed as products of 2D real FFTs over input tiles
+ *
+ * The input is split into tiles of (size - kernel + 1) stride-1 outputs.
+ * Each tile is transformed once per input channel, multiplied by the weight
+ * spectra transformed at build time, summed over the input channels and
+ * transformed back per output channel.
+ */
+class FFTConvolution {
+ public:
+  /**
+   * @brief Transforms the weights at build time
+   *
+   * @param size Transform size, a power of two not smaller than the kernel
+   * @param kernels Weights of every output channel, in_channels column-major
+   * kernel_h x kernel_w planes each
+   */
+  FFTConvolution(uint32_t size, uint32_t in_channels, uint32_t out_channels, uint32_t kernel_h,
+                 uint32_t kernel_w, const std::vector<const float*>& kernels);
+
+  /**
+   * @brief Computes the convolution without bias
+   *
+   * @param input in_channels column-major input_h x input_w planes
+   * @param output out_channels column-major output_h x output_w planes
+   * @param threads Threads computing the tiles
+   */
+  void Forward(const float* input, uint32_t input_h, uint32_t input_w, uint32_t padding_h,
+               uint32_t padding_w, uint32_t stride_h, uint32_t stride_w, float* output,
+               uint32_t output_h, uint32_t output_w, uint32_t threads) const;
+
+  /**
+   * @brief Gets the per-thread workspace of the tiles in floats
+   */
+  static size_t WorkspaceSize(uint32_t size, uint32_t in_channels);
+
+  uint32_t size() const { return size_; }
+
+ private:
+  void ComplexFFT(float* real, float* imag, bool inverse) const;
+
+  void Transform(const float* block, float* real, float* imag, float* scratch) const;
+
+  void InverseTransform(float* real, float* imag, float* block, float* scratch) const;
+
+  uint32_t size_ = 0;
+  uint32_t spectrum_size_ = 0;
+  uint32_t in_channels_ = 0;
+  uint32_t out_channels_ = 0;
+  uint32_t kernel_h_ = 0;
+  uint32_t kernel_w_ = 0;
+
+  std::vector<uint32_t> bit_reverse_;
+  std::vector<float> cos_table_;
+  std::vector<float> sin_table_;
+
+  // 共轭后的权重频谱，按(out_channels, in_channels, spectrum_size)排列
+  std::vector<float> weight_real_;
+  std::vector<float> weight_imag_;
+};
+}  // namespace fft
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_SOURCE_LAYER_DETAILS_CONV_FFT_HPP_
@@ -0,0 +1,177 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-2.
+
+#include "conv_micro_kernel.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+
+namespace kuiper_infer {
+namespace micro_kernel {
+// MR个输出通道乘NR个输出位置的寄存器分块，偏置、残差和激活在写回时完成
+template <uint32_t MR, uint32_t NR, bool kBias>
+static inline void ComputeTile(const float* weights, const float* bias, uint32_t reduce_size,
+                               const float* matrix, size_t col_stride, const float* residual,
+                               EpilogueFunc activation, float* output, size_t channel_stride) {
+  float acc[NR][MR];
+  for (uint32_t n = 0; n < NR; ++n) {
+    for (uint32_t m = 0; m < MR; ++m) {
+      acc[n][m] = kBias ? bias[m] : 0.f;
+    }
+  }
+
+  for (uint32_t p = 0; p < reduce_size; ++p) {
+    const float* w = weights + p * MR;
+    for (uint32_t n = 0; n < NR; ++n) {
+      const float x = matrix[n * col_stride + p];
+#pragma omp simd
+      for (uint32_t m = 0; m < MR; ++m) {
+        acc[n][m] += w[m] * x;
+      }
+    }
+  }
+
+  for (uint32_t m = 0; m < MR; ++m) {
+    float* output_ptr = output + m * channel_stride;
+    for (uint32_t n = 0; n < NR; ++n) {
+      output_ptr[n] = acc[n][m];
+    }
+    if (residual != nullptr) {
+      const float* residual_ptr = residual + m * channel_stride;
+      for (uint32_t n = 0; n < NR; ++n) {
+        output_ptr[n] += residual_ptr[n];
+      }
+    }
+    // 激活在分块的一行写回后立即完成，数据仍在L1缓存中
+    if (activation != nullptr) {
+      activation(output_ptr, output_ptr, NR);
+    }
+  }
+}
+
+template <uint32_t MR, bool kBias>
+static void ComputePanel(const float* weights, const float* bias, uint32_t reduce_size,
+                         const float* matrix, size_t col_stride, uint32_t cols,
+                         const float* residual, EpilogueFunc activation, float* output,
+                         size_t channel_stride) {
+  uint32_t col = 0;
+  for (; col + kPanelCols <= cols; col += kPanelCols) {
+    ComputeTile<MR, kPanelCols, kBias>(weights, bias, reduce_size, matrix + col * col_stride,
+                                       col_stride, residual != nullptr ? residual + col : nullptr,
+                                       activation, output + col, channel_stride);
+  }
+  for (; col + 4 <= cols; col += 4) {
+    ComputeTile<MR, 4, kBias>(weights, bias, reduce_size, matrix + col * col_stride, col_stride,
+                              residual != nullptr ? residual + col : nullptr, activation,
+                              output + col, channel_stride);
+  }
+  for (; col < cols; ++col) {
+    ComputeTile<MR, 1, kBias>(weights, bias, reduce_size, matrix + col * col_stride, col_stride,
+                              residual != nullptr ? residual + col : nullptr, activation,
+                              output + col, channel_stride);
+  }
+}
+
+// 第一维是否有偏置，第二维是一个分块的输出通道数
+static const PanelFunc kPanelFuncs[2][kPanelRows + 1] = {
+    {nullptr, ComputePanel<1, false>, ComputePanel<2, false>, ComputePanel<3, false>,
+     ComputePanel<4, false>, ComputePanel<5, false>, ComputePanel<6, false>,
+     ComputePanel<7, false>, ComputePanel<8, false>},
+    {nullptr, ComputePanel<1, true>, ComputePanel<2, true>, ComputePanel<3, true>,
+     ComputePanel<4, true>, ComputePanel<5, true>, ComputePanel<6, true>, ComputePanel<7, true>,
+     ComputePanel<8, true>},
+};
+
+ConvKernelCode SelectConvKernelCode(const ConvKernelSignature& signature) {
+  CHECK_GT(signature.output_channels, 0);
+  CHECK_GT(signature.reduce_size, 0);
+  ConvKernelCode code;
+  code.signature = signature;
+  code.full_panels = signature.output_channels / kPanelRows;
+  code.tail_rows = signature.output_channels % kPanelRows;
+  code.panel_func = kPanelFuncs[signature.use_bias][kPanelRows];
+  code.tail_func = kPanelFuncs[signature.use_bias][code.tail_rows];
+  return code;
+}
+
+bool UseConvMicroKernel(uint32_t output_channels, uint32_t reduce_size) {
+  return output_channels % kPanelRows != 0 && reduce_size > 0;
+}
+
+ConvMicroKernel::ConvMicroKernel(uint32_t reduce_size, const std::vector<const float*>& kernels,
+                                 const std::vector<float>& bias) {
+  ConvKernelSignature signature;
+  signature.output_channels = kernels.size();
+  signature.reduce_size = reduce_size;
+  signature.use_bias = !bias.empty();
+  CHECK(bias.empty() || bias.size() == kernels.size())
+      << "The bias size does not match the output channels";
+  code_ = SelectConvKernelCode(signature);
+
+  // 每个分块内同一个规约下标的MR个权重连续存放
+  const uint32_t output_channels = signature.output_channels;
+  packed_weights_.resize(size_t(output_channels) * reduce_size);
+  for (uint32_t panel_start = 0; panel_start < output_channels; panel_start += kPanelRows) {
+    const uint32_t rows = std::min(kPanelRows, output_channels - panel_start);
+    float* panel = packed_weights_.data() + size_t(panel_start) * reduce_size;
+    for (uint32_t p = 0; p < reduce_size; ++p) {
+      for (uint32_t m = 0; m < rows; ++m) {
+        panel[p * rows + m] = kernels.at(panel_start + m)[p];
+      }
+    }
+  }
+  packed_bias_ = bias;
+}
+
+void ConvMicroKernel::Run(const float* matrix, size_t col_stride, uint32_t cols,
+                          const float* residual, EpilogueFunc activation, float* output,
+                          uint32_t threads) const {
+  const ConvKernelCode& code = code_;
+  const uint32_t reduce_size = code.signature.reduce_size;
+  const uint32_t panels = code.full_panels + (code.tail_rows ? 1 : 0);
+  const size_t channel_stride = cols;
+
+  // 通道分块少于线程数时再按输出位置切分，每段是寄存器分块列数的整数倍
+  const uint32_t col_tiles = (cols + kPanelCols - 1) / kPanelCols;
+  const uint32_t col_chunks =
+      std::max(1u, std::min(col_tiles, (std::max(threads, 1u) + panels - 1) / panels));
+  const uint32_t chunk_cols = (col_tiles + col_chunks - 1) / col_chunks * kPanelCols;
+#pragma omp parallel for num_threads(threads)
+  for (uint32_t task = 0; task < panels * col_chunks; ++task) {
+    const uint32_t panel = task / col_chunks;
+    const uint32_t col_start = task % col_chunks * chunk_cols;
+    if (col_start >= cols) {
+      continue;
+    }
+    const uint32_t chunk_end = std::min(cols, col_start + chunk_cols);
+    const uint32_t panel_start = panel * kPanelRows;
+    const size_t offset = panel_start * channel_stride + col_start;
+    const PanelFunc func = panel < code.full_panels ? code.panel_func : code.tail_func;
+    func(packed_weights_.data() + size_t(panel_start) * reduce_size,
+         packed_bias_.empty() ? nullptr : packed_bias_.data() + panel_start, reduce_size,
+         matrix + col_start * col_stride, col_stride, chunk_end - col_start,
+         residual != nullptr ? residual + offset : nullptr, activation, output + offset,
+         channel_stride);
+  }
+}
+}  // namespace micro_kernel
+}  // namespace kuiper_infer
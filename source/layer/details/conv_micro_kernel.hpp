@@ -0,0 +1,134 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-2.
+
+#ifndef KUIPER_INFER_SOURCE_LAYER_DETAILS_CONV_MICRO_KERNEL_HPP_
+#define KUIPER_INFER_SOURCE_LAYER_DETAILS_CONV_MICRO_KERNEL_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+namespace kuiper_infer {
+namespace micro_kernel {
+/// Output channels computed together by one register tile
+constexpr uint32_t kPanelRows = 8;
+
+/// Output positions computed together by one register tile
+constexpr uint32_t kPanelCols = 12;
+
+/**
+ * @brief Layer properties the micro-kernel instantiation is selected by
+ */
+struct ConvKernelSignature {
+  /// Output channels of one group
+  uint32_t output_channels = 0;
+
+  /// Input channels of one group times the kernel size
+  uint32_t reduce_size = 0;
+
+  /// Whether the bias is added in the epilogue, selects the instantiation with the bias load
+  bool use_bias = false;
+};
+
+/**
+ * @brief Activation applied to the output of a tile in the write-back, in place
+ */
+using EpilogueFunc = void (*)(const float* in_ptr, float* out_ptr, int64_t size);
+
+/**
+ * @brief Computes a panel of output channels from the im2col matrix
+ */
+using PanelFunc = void (*)(const float* weights, const float* bias, uint32_t reduce_size,
+                           const float* matrix, size_t col_stride, uint32_t cols,
+                           const float* residual, EpilogueFunc activation, float* output,
+                           size_t channel_stride);
+
+/**
+ * @brief Kernels selected for one layer signature
+ *
+ * Full panels run the kPanelRows kernel, the remaining output channels run
+ * a kernel instantiated for exactly that many channels. Both are the
+ * instantiations with or without the bias, the reduce size stays a runtime
+ * loop bound.
+ */
+struct ConvKernelCode {
+  ConvKernelSignature signature;
+  PanelFunc panel_func = nullptr;
+  PanelFunc tail_func = nullptr;
+  uint32_t full_panels = 0;
+  uint32_t tail_rows = 0;
+};
+
+/**
+ * @brief Selects the panel and tail kernels of a signature from the instantiations
+ */
+ConvKernelCode SelectConvKernelCode(const ConvKernelSignature& signature);
+
+/**
+ * @brief Whether a convolution group should run the micro-kernel instead of GEMM
+ *
+ * Channel counts that are not a multiple of the panel rows leave vector
+ * lanes idle in the generic GEMM edge handling.
+ */
+bool UseConvMicroKernel(uint32_t output_channels, uint32_t reduce_size);
+
+/**
+ * @brief Micro-kernel of one convolution group with its packed weights
+ */
+class ConvMicroKernel {
+ public:
+  /**
+   * @brief Selects the kernels and packs the weights at build time
+   *
+   * @param kernels Weights of every output channel, reduce_size floats each
+   * @param bias Bias of every output channel, empty if the layer has none
+   */
+  ConvMicroKernel(uint32_t reduce_size, const std::vector<const float*>& kernels,
+                  const std::vector<float>& bias);
+
+  /**
+   * @brief Computes the output channels of the group with bias, residual and activation
+   *
+   * The activation runs on every tile right after its write-back, while the
+   * tile is still in the cache, instead of as a separate pass over the output.
+   *
+   * @param matrix Im2col matrix, one column of reduce_size floats per output position
+   * @param col_stride Distance between two columns of the im2col matrix
+   * @param cols Number of output positions
+   * @param residual First residual channel of the group, nullptr if none
+   * @param activation Activation applied after the residual add, nullptr if none
+   * @param output First output channel of the group
+   * @param threads Threads computing the panels, the output positions are
+   * split as well when there are fewer panels than threads
+   */
+  void Run(const float* matrix, size_t col_stride, uint32_t cols, const float* residual,
+           EpilogueFunc activation, float* output, uint32_t threads) const;
+
+  const ConvKernelCode& code() const { return code_; }
+
+ private:
+  ConvKernelCode code_;
+  std::vector<float> packed_weights_;
+  std::vector<float> packed_bias_;
+};
+}  // namespace micro_kernel
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_SOURCE_LAYER_DETAILS_CONV_MICRO_KERNEL_HPP_
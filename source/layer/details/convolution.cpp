@@ -23,7 +23,9 @@
 
 #include "convolution.hpp"
 #include <glog/logging.h>
+#include <algorithm>
 #include "layer/abstract/layer_factory.hpp"
+#include "layer/abstract/layer_workspace.hpp"
 #include "runtime/runtime_ir.hpp"
 #include "tick.hpp"
 #include "utils/math/fmath.hpp"
@@ -40,6 +42,15 @@ bool ConvolutionLayer::Is1x1KernelNoPadding(uint32_t kernel_h, uint32_t kernel_w
   return false;
 }
 
+uint32_t ConvolutionLayer::FFTTransformSize() const {
+  if (this->weights_.empty() || groups_ != 1 || dilation_h_ != 1 || dilation_w_ != 1) {
+    return 0;
+  }
+  const sftensor& kernel = this->weights_.front();
+  return fft::SelectTransformSize(kernel->channels(), this->weights_.size(), kernel->rows(),
+                                  kernel->cols(), stride_h_, stride_w_);
+}
+
 void ConvolutionLayer::InitIm2ColWeight() {
   const uint32_t kernel_count = this->weights_.size();
   CHECK(kernel_count > 0) << "kernel count must greater than zero";
@@ -84,76 +95,272 @@ void ConvolutionLayer::InitIm2ColWeight() {
   }
 
   this->kernel_matrix_arr_ = std::move(kernel_matrix_arr);
+  // 常见的卷积核和步长使用编译期特化的im2col，其余的走通用实现
+  this->im2col_func_ = window::SelectIm2Col(kernel_h, kernel_w, stride_h_, stride_w_,
+                                            dilation_h_, dilation_w_);
+
+  // 大卷积核在代价模型估计更快时走FFT，权重频谱在Build时变换
+  this->fft_conv_.reset();
+  this->sparse_weight_.reset();
+  this->micro_kernels_.clear();
+  this->group_kernel_matrices_.clear();
+  const uint32_t fft_size = FFTTransformSize();
+  if (fft_size != 0) {
+    std::vector<const float*> kernels;
+    for (uint32_t k = 0; k < kernel_count; ++k) {
+      kernels.push_back(this->weights_.at(k)->raw_ptr());
+    }
+    this->fft_conv_ = std::make_shared<fft::FFTConvolution>(fft_size, kernel_c, kernel_count,
+                                                            kernel_h, kernel_w, kernels);
+    return;
+  }
+
+  // 剪枝后零块足够多的权重压缩成块稀疏格式，跳过零块的乘加
+  const uint32_t reduce_size = row_len * kernel_c;
+  if (groups_ == 1) {
+    std::vector<const float*> kernels;
+    for (uint32_t k = 0; k < kernel_count; ++k) {
+      kernels.push_back(this->kernel_matrix_arr_.at(k).memptr());
+    }
+    if (sparse::ZeroBlockRatio(kernels, reduce_size) >= sparse::kSparsityThreshold) {
+      this->sparse_weight_ = std::make_shared<sparse::BlockSparseMatrix>(kernels, reduce_size);
+      return;
+    }
+  }
+
+  // 输出通道数不是分块大小整数倍的层在Build时按通道尾数和偏置选择微内核的实例并打包权重
+  const uint32_t kernel_count_group = kernel_count / groups_;
+  if (groups_ == 1) {
+    if (!Is1x1KernelNoPadding(kernel_h, kernel_w) &&
+        micro_kernel::UseConvMicroKernel(kernel_count_group, reduce_size)) {
+      std::vector<const float*> kernels;
+      std::vector<float> bias;
+      for (uint32_t k = 0; k < kernel_count; ++k) {
+        kernels.push_back(this->kernel_matrix_arr_.at(k).memptr());
+        if (use_bias_ && !this->bias_.empty()) {
+          bias.push_back(this->bias_.at(k)->index(0));
+        }
+      }
+      this->micro_kernels_.emplace_back(reduce_size, kernels, bias);
+    }
+    return;
+  }
+
+  // 分组卷积把同组的卷积核拼成一个矩阵，每组的输出由一次矩阵乘法得到
+  for (uint32_t g = 0; g < groups_; ++g) {
+    arma::fmat group_kernel_matrix(reduce_size, kernel_count_group);
+    for (uint32_t k = 0; k < kernel_count_group; ++k) {
+      const arma::fmat& kernel_matrix = this->kernel_matrix_arr_.at(g * kernel_count_group + k);
+      memcpy(group_kernel_matrix.colptr(k), kernel_matrix.memptr(), reduce_size * sizeof(float));
+    }
+    this->group_kernel_matrices_.push_back(std::move(group_kernel_matrix));
+  }
 }
 
 void ConvolutionLayer::ComputeOutput(sftensor input, sftensor output_tensor, uint32_t kernel_h,
                                      uint32_t kernel_w, uint32_t kernel_count_group,
                                      uint32_t input_h, uint32_t input_w,
                                      uint32_t channels_per_group, uint32_t output_h,
-                                     uint32_t output_w, uint32_t group) const {
-  bool is_1x1conv = Is1x1KernelNoPadding(kernel_h, kernel_w);
-  const arma::fmat& input_matrix =
-      ConvIm2Col(input, kernel_h, kernel_w, input_h, input_w, channels_per_group, output_h,
-                 output_w, group, kernel_h * kernel_w, output_h * output_w);
-#pragma omp parallel for
-  for (uint32_t k = 0; k < kernel_count_group; ++k) {
-    ConvGEMMBias(input_matrix, output_tensor, group, k, kernel_count_group, output_h, output_w,
-                 is_1x1conv);
+                                     uint32_t output_w, uint32_t group,
+                                     const sftensor& residual) const {
+  if (fft_conv_ != nullptr) {
+    fft_conv_->Forward(input->raw_ptr(), input_h, input_w, padding_h_, padding_w_, stride_h_,
+                       stride_w_, output_tensor->raw_ptr(), output_h, output_w,
+                       this->intra_threads());
+    ApplyOutputStage(output_tensor, kernel_count_group, output_h, output_w, residual);
+    return;
+  }
+
+  // 稀疏权重需要im2col矩阵的列连续，1x1卷积也展开
+  const bool is_1x1conv = Is1x1KernelNoPadding(kernel_h, kernel_w) && sparse_weight_ == nullptr;
+  auto conv_gemm = [&](const arma::fmat& input_matrix) {
+#pragma omp parallel for num_threads(this->intra_threads())
+    for (uint32_t k = 0; k < kernel_count_group; ++k) {
+      ConvGEMMBias(input_matrix, output_tensor, group, k, kernel_count_group, output_h, output_w,
+                   is_1x1conv, residual);
+    }
+  };
+
+  if (is_1x1conv) {
+    // 1x1卷积直接把输入当作im2col矩阵使用，不需要额外的内存
+    const arma::fmat input_matrix(input->matrix_raw_ptr(group * channels_per_group),
+                                  output_h * output_w, channels_per_group, false, true);
+    conv_gemm(input_matrix);
+  } else {
+    // im2col矩阵放在当前线程的工作区中，Build时已经预留，Forward不再申请内存
+    const uint32_t row_len = kernel_h * kernel_w;
+    const uint32_t col_len = output_h * output_w;
+    arma::fmat im2col_workspace(
+        LayerWorkspace::Acquire(size_t(channels_per_group) * row_len * col_len),
+        channels_per_group * row_len, col_len, false, true);
+    ConvIm2Col(input, kernel_h, kernel_w, input_h, input_w, channels_per_group, output_h,
+               output_w, group, row_len, col_len, im2col_workspace);
+    if (sparse_weight_ != nullptr) {
+      sparse_weight_->Multiply(im2col_workspace.memptr(), im2col_workspace.n_rows, col_len,
+                               output_tensor->matrix_raw_ptr(0), col_len, this->intra_threads());
+      ApplyOutputStage(output_tensor, kernel_count_group, output_h, output_w, residual);
+      return;
+    }
+    if (!micro_kernels_.empty()) {
+      const uint32_t kernel_index = group * kernel_count_group;
+      float* output_ptr = output_tensor->matrix_raw_ptr(kernel_index);
+      micro_kernels_.at(group).Run(
+          im2col_workspace.memptr(), im2col_workspace.n_rows, output_h * output_w,
+          residual != nullptr ? residual->matrix_raw_ptr(kernel_index) : nullptr,
+          fused_activation_, output_ptr, this->intra_threads());
+      return;
+    }
+    conv_gemm(im2col_workspace);
   }
 }
 
-arma::fmat ConvolutionLayer::ConvIm2Col(sftensor input, uint32_t kernel_h, uint32_t kernel_w,
-                                        uint32_t input_h, uint32_t input_w,
-                                        uint32_t channels_per_group, uint32_t output_h,
-                                        uint32_t output_w, uint32_t group, uint32_t row_len,
-                                        uint32_t col_len) const {
-  CHECK(input && !input->empty()) << "The input tensor of the im2col function cannot be empty.";
-  const float padding_value = 0.f;
-  if (Is1x1KernelNoPadding(kernel_h, kernel_w)) {
-    arma::fmat input_matrix(input->raw_ptr(), col_len, channels_per_group * row_len, false, true);
-    return input_matrix;
+void ConvolutionLayer::ComputeGroupedOutput(sftensor input, sftensor output_tensor,
+                                            uint32_t kernel_h, uint32_t kernel_w,
+                                            uint32_t kernel_count_group, uint32_t input_h,
+                                            uint32_t input_w, uint32_t channels_per_group,
+                                            uint32_t output_h, uint32_t output_w,
+                                            const sftensor& residual) const {
+  LAYER_CHECK(group_kernel_matrices_.size() == groups_)
+      << "The kernel matrices of the grouped convolution are not initialized";
+  const bool is_1x1conv = Is1x1KernelNoPadding(kernel_h, kernel_w);
+  const uint32_t row_len = kernel_h * kernel_w;
+  const uint32_t col_len = output_h * output_w;
+  const uint32_t reduce_size = channels_per_group * row_len;
+  const size_t group_matrix_size = size_t(reduce_size) * col_len;
+
+  // 所有分组的im2col矩阵依次放在调用线程的工作区中，由并行区域内的线程共享
+  float* im2col_workspace = nullptr;
+  if (!is_1x1conv) {
+    im2col_workspace = LayerWorkspace::Acquire(groups_ * group_matrix_size);
   }
 
+  // 每组的输出通道切成相同大小的块，任务数不少于线程数
+  const uint32_t threads = this->intra_threads();
+  const uint32_t blocks_per_group =
+      std::min(kernel_count_group, (threads + groups_ - 1) / groups_);
+  const uint32_t block_size = (kernel_count_group + blocks_per_group - 1) / blocks_per_group;
+  const uint32_t task_count = groups_ * blocks_per_group;
+
+#pragma omp parallel num_threads(threads)
+  {
+    if (!is_1x1conv) {
+#pragma omp for
+      for (uint32_t ic = 0; ic < groups_ * channels_per_group; ++ic) {
+        float* group_matrix = im2col_workspace + ic / channels_per_group * group_matrix_size;
+        Im2ColChannel(input->matrix_raw_ptr(ic), kernel_h, kernel_w, input_h, input_w, output_h,
+                      output_w, reduce_size, group_matrix + ic % channels_per_group * row_len);
+      }
+    }
+
+#pragma omp for
+    for (uint32_t task = 0; task < task_count; ++task) {
+      const uint32_t group = task / blocks_per_group;
+      const uint32_t block_start = task % blocks_per_group * block_size;
+      if (block_start >= kernel_count_group) {
+        continue;
+      }
+      const uint32_t block_end = std::min(block_start + block_size, kernel_count_group);
+      const uint32_t kernel_index = group * kernel_count_group + block_start;
+      const arma::fmat& group_kernel_matrix = group_kernel_matrices_.at(group);
+      const arma::fmat block_kernel(const_cast<float*>(group_kernel_matrix.colptr(block_start)),
+                                    reduce_size, block_end - block_start, false, true);
+
+      // 同一块的输出通道在内存中相邻，输出是一个(col_len, block)的列主序矩阵
+      arma::fmat output(output_tensor->matrix_raw_ptr(kernel_index), col_len,
+                        block_end - block_start, false, true);
+      if (is_1x1conv) {
+        const arma::fmat input_matrix(input->matrix_raw_ptr(group * channels_per_group),
+                                      col_len, channels_per_group, false, true);
+        output = input_matrix * block_kernel;
+      } else {
+        const arma::fmat im2col_matrix(im2col_workspace + group * group_matrix_size,
+                                       reduce_size, col_len, false, true);
+        output = im2col_matrix.t() * block_kernel;
+      }
+
+      for (uint32_t k = kernel_index; k < kernel_index + block_end - block_start; ++k) {
+        arma::fmat output_channel(output_tensor->matrix_raw_ptr(k), output_h, output_w, false,
+                                  true);
+        AddBias(output_channel, k);
+        AddResidualActivation(output_channel, residual, k);
+      }
+    }
+  }
+}
+
+void ConvolutionLayer::ConvIm2Col(sftensor input, uint32_t kernel_h, uint32_t kernel_w,
+                                  uint32_t input_h, uint32_t input_w, uint32_t channels_per_group,
+                                  uint32_t output_h, uint32_t output_w, uint32_t group,
+                                  uint32_t row_len, uint32_t col_len,
+                                  arma::fmat& input_matrix) const {
+  LAYER_CHECK(input && !input->empty())
+      << "The input tensor of the im2col function cannot be empty.";
   const uint32_t channels_offset = group * channels_per_group;
-  arma::fmat input_matrix(channels_per_group * row_len, col_len);
-#pragma omp parallel for
+  LAYER_CHECK(input_matrix.n_rows == channels_per_group * row_len && input_matrix.n_cols == col_len)
+      << "The im2col matrix does not match the convolution geometry.";
+#pragma omp parallel for num_threads(this->intra_threads())
   for (uint32_t ic = 0; ic < channels_per_group; ++ic) {
-    float* input_channel_ptr = input->matrix_raw_ptr(ic + channels_offset);
-    uint32_t current_col = 0;
-    uint32_t channel_row = ic * row_len;
-    for (uint32_t w = 0, iw = 0; w < output_w; ++w, iw += stride_w_) {
-      for (uint32_t r = 0, ih = 0; r < output_h; ++r, ih += stride_h_) {
-        float* input_matrix_ptr = input_matrix.colptr(current_col) + channel_row;
-        for (uint32_t kw = 0; kw < kernel_w * dilation_w_; kw += dilation_w_) {
-          const uint32_t region_w = input_h * (iw + kw - padding_w_);
-          for (uint32_t kh = 0; kh < kernel_h * dilation_h_; kh += dilation_h_) {
-            if ((kh + ih >= padding_h_ && kw + iw >= padding_w_) &&
-                (kh + ih < input_h + padding_h_ && kw + iw < input_w + padding_w_)) {
-              float* region_ptr = input_channel_ptr + region_w + (ih + kh - padding_h_);
-              *input_matrix_ptr = *region_ptr;
-            } else {
-              *input_matrix_ptr = padding_value;  // only support zero mode
-            }
-            input_matrix_ptr++;
+    Im2ColChannel(input->matrix_raw_ptr(ic + channels_offset), kernel_h, kernel_w, input_h,
+                  input_w, output_h, output_w, input_matrix.n_rows,
+                  input_matrix.memptr() + ic * row_len);
+  }
+}
+
+void ConvolutionLayer::Im2ColChannel(const float* input_channel, uint32_t kernel_h,
+                                     uint32_t kernel_w, uint32_t input_h, uint32_t input_w,
+                                     uint32_t output_h, uint32_t output_w, uint32_t col_stride,
+                                     float* matrix) const {
+  if (im2col_func_ != nullptr) {
+    im2col_func_(input_channel, input_h, input_w, padding_h_, padding_w_, output_h, output_w,
+                 col_stride, matrix);
+    return;
+  }
+
+  const float padding_value = 0.f;
+  uint32_t current_col = 0;
+  for (uint32_t w = 0, iw = 0; w < output_w; ++w, iw += stride_w_) {
+    for (uint32_t r = 0, ih = 0; r < output_h; ++r, ih += stride_h_) {
+      float* input_matrix_ptr = matrix + size_t(current_col) * col_stride;
+      for (uint32_t kw = 0; kw < kernel_w * dilation_w_; kw += dilation_w_) {
+        const uint32_t region_w = input_h * (iw + kw - padding_w_);
+        for (uint32_t kh = 0; kh < kernel_h * dilation_h_; kh += dilation_h_) {
+          if ((kh + ih >= padding_h_ && kw + iw >= padding_w_) &&
+              (kh + ih < input_h + padding_h_ && kw + iw < input_w + padding_w_)) {
+            const float* region_ptr = input_channel + region_w + (ih + kh - padding_h_);
+            *input_matrix_ptr = *region_ptr;
+          } else {
+            *input_matrix_ptr = padding_value;  // only support zero mode
           }
+          input_matrix_ptr++;
         }
-        current_col += 1;
       }
+      current_col += 1;
     }
   }
-  return input_matrix;
+}
+
+void ConvolutionLayer::ApplyOutputStage(const sftensor& output_tensor, uint32_t kernel_count,
+                                        uint32_t output_h, uint32_t output_w,
+                                        const sftensor& residual) const {
+#pragma omp parallel for num_threads(this->intra_threads())
+  for (uint32_t k = 0; k < kernel_count; ++k) {
+    arma::fmat output(output_tensor->matrix_raw_ptr(k), output_h, output_w, false, true);
+    AddBias(output, k);
+    AddResidualActivation(output, residual, k);
+  }
 }
 
 void ConvolutionLayer::ConvGEMMBias(const arma::fmat& input_matrix, sftensor output_tensor,
                                     uint32_t group, uint32_t kernel_index,
                                     uint32_t kernel_count_group, uint32_t output_h,
-                                    uint32_t output_w, bool is_1x1conv_nopadding) const {
-  CHECK(!input_matrix.empty()) << "The input tensor of the gemm function cannot be empty.";
-  CHECK(output_tensor && !output_tensor->empty())
+                                    uint32_t output_w, bool is_1x1conv_nopadding,
+                                    const sftensor& residual) const {
+  LAYER_CHECK(!input_matrix.empty()) << "The input tensor of the gemm function cannot be empty.";
+  LAYER_CHECK(output_tensor && !output_tensor->empty())
       << "The output tensor of the gemm function cannot be empty.";
 
   kernel_index = kernel_index + group * kernel_count_group;
-  const arma::fmat& kernel = this->kernel_matrix_arr_.at(kernel_index);
+  const arma::fmat& kernel = this->kernel_matrix_arr_[kernel_index];
 
   arma::fmat output(output_tensor->matrix_raw_ptr(kernel_index), output_h, output_w, false, true);
   if (is_1x1conv_nopadding) {
@@ -161,7 +368,25 @@ void ConvolutionLayer::ConvGEMMBias(const arma::fmat& input_matrix, sftensor out
   } else {
     output = kernel * input_matrix;
   }
-  return AddBias(output, kernel_index);
+  AddBias(output, kernel_index);
+  AddResidualActivation(output, residual, kernel_index);
+}
+
+size_t ConvolutionLayer::WorkspaceSize(const std::vector<std::vector<int32_t>>& input_shapes,
+                                       const std::vector<int32_t>& output_shape) const {
+  if (this->weights_.empty() || output_shape.size() != 4) {
+    return 0;
+  }
+  const sftensor& kernel = this->weights_.front();
+  const uint32_t fft_size = FFTTransformSize();
+  if (fft_size != 0) {
+    return fft::FFTConvolution::WorkspaceSize(fft_size, kernel->channels());
+  }
+  if (Is1x1KernelNoPadding(kernel->rows(), kernel->cols()) && sparse_weight_ == nullptr) {
+    return 0;
+  }
+  // 普通卷积需要一个分组的im2col矩阵，分组卷积需要所有分组的
+  return kernel->size() * groups_ * size_t(output_shape.at(2)) * output_shape.at(3);
 }
 
 std::pair<uint32_t, uint32_t> ConvolutionLayer::ComputeOutputSize(const uint32_t input_h,
@@ -171,8 +396,8 @@ std::pair<uint32_t, uint32_t> ConvolutionLayer::ComputeOutputSize(const uint32_t
   uint32_t output_h = 0;
   uint32_t output_w = 0;
 
-  CHECK_GT(kernel_h, 0);
-  CHECK_GT(kernel_w, 0);
+  LAYER_CHECK(kernel_h > 0);
+  LAYER_CHECK(kernel_w > 0);
 
   output_h = (input_h + 2 * padding_h_ - dilation_h_ * (kernel_h - 1) - 1) / stride_h_ + 1;
   output_w = (input_w + 2 * padding_w_ - dilation_w_ * (kernel_w - 1) - 1) / stride_w_ + 1;
@@ -24,7 +24,11 @@
 #ifndef KUIPER_INFER_SOURCE_LAYER_CONVOLUTION_HPP_
 #define KUIPER_INFER_SOURCE_LAYER_CONVOLUTION_HPP_
 #include "base_convolution.hpp"
+#include "block_sparse.hpp"
+#include "conv_fft.hpp"
+#include "conv_micro_kernel.hpp"
 #include "layer/abstract/param_layer.hpp"
+#include "window_kernel.hpp"
 
 namespace kuiper_infer {
 
@@ -40,28 +44,59 @@ class ConvolutionLayer : public BaseConvolutionLayer {
                              padding_h, padding_w, stride_h, stride_w, groups, use_bias,
                              output_padding_h, output_padding_w, dilation_h, dilation_w) {}
 
+  size_t WorkspaceSize(const std::vector<std::vector<int32_t>>& input_shapes,
+                       const std::vector<int32_t>& output_shape) const override;
+
  private:
   bool Is1x1KernelNoPadding(uint32_t kernel_h, uint32_t kernel_w) const;
 
+  /**
+   * @brief Gets the transform size of the FFT path, 0 if the layer uses im2col
+   */
+  uint32_t FFTTransformSize() const;
+
   void InitIm2ColWeight() override;
 
   void ComputeOutput(sftensor input, sftensor output_tensor, uint32_t kernel_h, uint32_t kernel_w,
                      uint32_t kernel_count_group, uint32_t input_h, uint32_t input_w,
                      uint32_t channels_per_group, uint32_t output_h, uint32_t output_w,
-                     uint32_t group) const override;
+                     uint32_t group, const sftensor& residual) const override;
+
+  void ComputeGroupedOutput(sftensor input, sftensor output_tensor, uint32_t kernel_h,
+                            uint32_t kernel_w, uint32_t kernel_count_group, uint32_t input_h,
+                            uint32_t input_w, uint32_t channels_per_group, uint32_t output_h,
+                            uint32_t output_w, const sftensor& residual) const override;
 
   std::pair<uint32_t, uint32_t> ComputeOutputSize(uint32_t input_h, uint32_t input_w,
                                                   uint32_t kernel_h,
                                                   uint32_t kernel_w) const override;
 
+  /**
+   * @brief Adds the bias, the residual and the activation to output planes computed at once
+   */
+  void ApplyOutputStage(const sftensor& output_tensor, uint32_t kernel_count, uint32_t output_h,
+                        uint32_t output_w, const sftensor& residual) const;
+
   void ConvGEMMBias(const arma::fmat& input_matrix, sftensor output_tensor, uint32_t group,
                     uint32_t kernel_index, uint32_t kernel_count_group, uint32_t output_h,
-                    uint32_t output_w, bool is_1x1conv_nopadding) const;
+                    uint32_t output_w, bool is_1x1conv_nopadding,
+                    const sftensor& residual) const;
+
+  void ConvIm2Col(sftensor input, uint32_t kernel_h, uint32_t kernel_w, uint32_t input_h,
+                  uint32_t input_w, uint32_t channels_per_group, uint32_t output_h,
+                  uint32_t output_w, uint32_t group, uint32_t row_len, uint32_t col_len,
+                  arma::fmat& input_matrix) const;
+
+  void Im2ColChannel(const float* input_channel, uint32_t kernel_h, uint32_t kernel_w,
+                     uint32_t input_h, uint32_t input_w, uint32_t output_h, uint32_t output_w,
+                     uint32_t col_stride, float* matrix) const;
 
-  arma::fmat ConvIm2Col(sftensor input, uint32_t kernel_h, uint32_t kernel_w, uint32_t input_h,
-                        uint32_t input_w, uint32_t channels_per_group, uint32_t output_h,
-                        uint32_t output_w, uint32_t group, uint32_t row_len,
-                        uint32_t col_len) const;
+  window::Im2ColFunc im2col_func_ = nullptr;
+  std::vector<micro_kernel::ConvMicroKernel> micro_kernels_;
+  std::shared_ptr<const fft::FFTConvolution> fft_conv_;
+  std::shared_ptr<const sparse::BlockSparseMatrix> sparse_weight_;
+  // 分组卷积每组一个(reduce_size, kernel_count_group)的权重矩阵，每列是一个卷积核
+  std::vector<arma::fmat> group_kernel_matrices_;
 };
 
 }  // namespace kuiper_infer
@@ -24,6 +24,7 @@
 //
 #include "deconvolution.hpp"
 #include "layer/abstract/layer_factory.hpp"
+#include "layer/abstract/layer_workspace.hpp"
 namespace kuiper_infer {
 
 void DeconvolutionLayer::set_weights(const std::vector<std::shared_ptr<Tensor<float>>>& weights) {
@@ -87,16 +88,68 @@ void DeconvolutionLayer::ComputeOutput(sftensor input, sftensor output_tensor, u
                                        uint32_t kernel_w, uint32_t kernel_count_group,
                                        uint32_t input_h, uint32_t input_w,
                                        uint32_t channels_per_group, uint32_t output_h,
-                                       uint32_t output_w, uint32_t group) const {
-#pragma omp parallel for
+                                       uint32_t output_w, uint32_t group,
+                                       const sftensor& residual) const {
+#pragma omp parallel for num_threads(this->intra_threads())
   for (uint32_t k = 0; k < kernel_count_group; ++k) {
-    const arma::fmat& gemm_result =
-        DeconvGEMM(input, input_h, input_w, channels_per_group, group, k, kernel_count_group);
-    DeconvCol2ImBias(gemm_result, output_tensor, input_h, input_w, group, k, kernel_count_group,
-                     kernel_h, kernel_w, output_h, output_w);
+    ComputeKernelOutput(input, output_tensor, kernel_h, kernel_w, kernel_count_group, input_h,
+                        input_w, channels_per_group, output_h, output_w, group, k, residual);
   }
 }
 
+void DeconvolutionLayer::ComputeGroupedOutput(sftensor input, sftensor output_tensor,
+                                              uint32_t kernel_h, uint32_t kernel_w,
+                                              uint32_t kernel_count_group, uint32_t input_h,
+                                              uint32_t input_w, uint32_t channels_per_group,
+                                              uint32_t output_h, uint32_t output_w,
+                                              const sftensor& residual) const {
+  // 每个卷积核的计算量相同，所有分组的卷积核展开成一个任务列表均匀划分给线程
+  const uint32_t task_count = groups_ * kernel_count_group;
+#pragma omp parallel for num_threads(this->intra_threads())
+  for (uint32_t task = 0; task < task_count; ++task) {
+    ComputeKernelOutput(input, output_tensor, kernel_h, kernel_w, kernel_count_group, input_h,
+                        input_w, channels_per_group, output_h, output_w,
+                        task / kernel_count_group, task % kernel_count_group, residual);
+  }
+}
+
+void DeconvolutionLayer::ComputeKernelOutput(const sftensor& input, const sftensor& output_tensor,
+                                             uint32_t kernel_h, uint32_t kernel_w,
+                                             uint32_t kernel_count_group, uint32_t input_h,
+                                             uint32_t input_w, uint32_t channels_per_group,
+                                             uint32_t output_h, uint32_t output_w,
+                                             uint32_t group, uint32_t kernel_index,
+                                             const sftensor& residual) const {
+  // gemm结果和col2im缓冲区是当前线程工作区中的两段，Build时已经预留
+  const uint32_t kernel_hw = kernel_h * kernel_w;
+  const uint32_t padding_h = output_h + 2 * padding_h_;
+  const uint32_t padding_w = output_w + 2 * padding_w_;
+  const size_t gemm_size = LayerWorkspace::SliceSize(size_t(kernel_hw) * input_h * input_w);
+  float* workspace = LayerWorkspace::Acquire(gemm_size + size_t(padding_h) * padding_w);
+  arma::fmat gemm_result(workspace, kernel_hw, input_h * input_w, false, true);
+  arma::fmat output_padding(workspace + gemm_size, padding_h, padding_w, false, true);
+  DeconvGEMM(input, input_h, input_w, channels_per_group, group, kernel_index, kernel_count_group,
+             gemm_result);
+  DeconvCol2ImBias(gemm_result, output_tensor, input_h, input_w, group, kernel_index,
+                   kernel_count_group, kernel_h, kernel_w, output_h, output_w, residual,
+                   output_padding);
+}
+
+size_t DeconvolutionLayer::WorkspaceSize(const std::vector<std::vector<int32_t>>& input_shapes,
+                                         const std::vector<int32_t>& output_shape) const {
+  if (this->weights_.empty() || input_shapes.empty() || input_shapes.front().size() != 4 ||
+      output_shape.size() != 4) {
+    return 0;
+  }
+  const sftensor& kernel = this->weights_.front();
+  const std::vector<int32_t>& input_shape = input_shapes.front();
+  const size_t gemm_size = size_t(kernel->rows()) * kernel->cols() * input_shape.at(2) *
+                           input_shape.at(3);
+  const size_t padding_size =
+      size_t(output_shape.at(2) + 2 * padding_h_) * (output_shape.at(3) + 2 * padding_w_);
+  return LayerWorkspace::SliceSize(gemm_size) + padding_size;
+}
+
 std::pair<uint32_t, uint32_t> DeconvolutionLayer::ComputeOutputSize(const uint32_t input_h,
                                                                     const uint32_t input_w,
                                                                     const uint32_t kernel_h,
@@ -106,23 +159,23 @@ std::pair<uint32_t, uint32_t> DeconvolutionLayer::ComputeOutputSize(const uint32
 
   output_h = (input_h - 1) * stride_h_ + kernel_h + output_padding_h_;
   output_w = (input_w - 1) * stride_w_ + kernel_w + output_padding_w_;
-  CHECK(output_h > 2 * padding_h_ && output_w > 2 * padding_w_);
+  LAYER_CHECK(output_h > 2 * padding_h_ && output_w > 2 * padding_w_);
   output_h -= 2 * padding_h_;
   output_w -= 2 * padding_w_;
   return {output_h, output_w};
 }
 
-arma::fmat DeconvolutionLayer::DeconvGEMM(const sftensor& input, uint32_t input_h, uint32_t input_w,
-                                          uint32_t channels_per_group, uint32_t group,
-                                          uint32_t kernel_index,
-                                          uint32_t kernel_count_group) const {
-  CHECK(input != nullptr && !input->empty());
+void DeconvolutionLayer::DeconvGEMM(const sftensor& input, uint32_t input_h, uint32_t input_w,
+                                    uint32_t channels_per_group, uint32_t group,
+                                    uint32_t kernel_index, uint32_t kernel_count_group,
+                                    arma::fmat& gemm_result) const {
+  LAYER_CHECK(input != nullptr && !input->empty());
 
   kernel_index = kernel_index + group * kernel_count_group;
-  CHECK(kernel_index < this->weights_.size());
+  LAYER_CHECK(kernel_index < this->weights_.size());
 
-  sftensor group_kernel = this->weights_.at(kernel_index);
-  CHECK(group_kernel != nullptr && !group_kernel->empty());
+  const sftensor& group_kernel = this->weights_[kernel_index];
+  LAYER_CHECK(group_kernel != nullptr && !group_kernel->empty());
 
   uint32_t input_hw = input_h * input_w;
   uint32_t kernel_hw = group_kernel->rows() * group_kernel->cols();
@@ -132,19 +185,21 @@ arma::fmat DeconvolutionLayer::DeconvGEMM(const sftensor& input, uint32_t input_
 
   arma::fmat multi_kernel_channel(group_kernel->raw_ptr(), kernel_hw, channels_per_group, false,
                                   true);
-  return multi_kernel_channel * (multi_input_channel.t());
+  // 结果矩阵的形状不变时，乘法直接写入已有的内存
+  gemm_result = multi_kernel_channel * (multi_input_channel.t());
 }
 
 void DeconvolutionLayer::DeconvCol2ImBias(const arma::fmat& gemm_result, sftensor output_tensor,
                                           uint32_t input_h, uint32_t input_w, uint32_t group,
                                           uint32_t kernel_index, uint32_t kernel_count_group,
                                           uint32_t kernel_h, uint32_t kernel_w, uint32_t output_h,
-                                          uint32_t output_w) const {
-  CHECK(!gemm_result.empty());
-  CHECK(input_h > 0 && input_w > 0);
-  CHECK(output_tensor != nullptr && !output_tensor->empty());
+                                          uint32_t output_w, const sftensor& residual,
+                                          arma::fmat& output_padding) const {
+  LAYER_CHECK(!gemm_result.empty());
+  LAYER_CHECK(input_h > 0 && input_w > 0);
+  LAYER_CHECK(output_tensor != nullptr && !output_tensor->empty());
 
-  arma::fmat output_padding(output_h + 2 * padding_h_, output_w + 2 * padding_w_);
+  output_padding.zeros(output_h + 2 * padding_h_, output_w + 2 * padding_w_);
 
   uint32_t slide_w = input_w;
   uint32_t slide_h = input_h;
@@ -175,7 +230,8 @@ void DeconvolutionLayer::DeconvCol2ImBias(const arma::fmat& gemm_result, sftenso
   output = output_padding.submat(padding_h_, padding_w_, output_h + padding_h_ - 1,
                                  output_w + padding_w_ - 1);
 
-  return AddBias(output, kernel_index);
+  AddBias(output, kernel_index);
+  AddResidualActivation(output, residual, kernel_index);
 }
 
 LayerRegistererWrapper kDeConvCreateInstance(BaseConvolutionLayer::CreateInstance,
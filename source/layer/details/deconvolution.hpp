@@ -44,24 +44,39 @@ class DeconvolutionLayer : public BaseConvolutionLayer {
 
   void set_weights(const std::vector<std::shared_ptr<Tensor<float>>>& weights) override;
 
+  size_t WorkspaceSize(const std::vector<std::vector<int32_t>>& input_shapes,
+                       const std::vector<int32_t>& output_shape) const override;
+
  private:
   void ComputeOutput(sftensor input, sftensor output_tensor, uint32_t kernel_h, uint32_t kernel_w,
                      uint32_t kernel_count_group, uint32_t input_h, uint32_t input_w,
                      uint32_t channels_per_group, uint32_t output_h, uint32_t output_w,
-                     uint32_t group) const override;
+                     uint32_t group, const sftensor& residual) const override;
+
+  void ComputeGroupedOutput(sftensor input, sftensor output_tensor, uint32_t kernel_h,
+                            uint32_t kernel_w, uint32_t kernel_count_group, uint32_t input_h,
+                            uint32_t input_w, uint32_t channels_per_group, uint32_t output_h,
+                            uint32_t output_w, const sftensor& residual) const override;
 
   std::pair<uint32_t, uint32_t> ComputeOutputSize(uint32_t input_h, uint32_t input_w,
                                                   uint32_t kernel_h,
                                                   uint32_t kernel_w) const override;
 
+  void ComputeKernelOutput(const sftensor& input, const sftensor& output_tensor, uint32_t kernel_h,
+                           uint32_t kernel_w, uint32_t kernel_count_group, uint32_t input_h,
+                           uint32_t input_w, uint32_t channels_per_group, uint32_t output_h,
+                           uint32_t output_w, uint32_t group, uint32_t kernel_index,
+                           const sftensor& residual) const;
+
   void DeconvCol2ImBias(const arma::fmat& gemm_result, sftensor output_tensor, uint32_t input_h,
                         uint32_t input_w, uint32_t group, uint32_t kernel_index,
                         uint32_t kernel_count_group, uint32_t kernel_h, uint32_t kernel_w,
-                        uint32_t output_h, uint32_t output_w) const;
+                        uint32_t output_h, uint32_t output_w, const sftensor& residual,
+                        arma::fmat& output_padding) const;
 
-  arma::fmat DeconvGEMM(const sftensor& input, uint32_t input_h, uint32_t input_w,
-                        uint32_t channels_per_group, uint32_t group, uint32_t kernel_index,
-                        uint32_t kernel_count_group) const;
+  void DeconvGEMM(const sftensor& input, uint32_t input_h, uint32_t input_w,
+                  uint32_t channels_per_group, uint32_t group, uint32_t kernel_index,
+                  uint32_t kernel_count_group, arma::fmat& gemm_result) const;
 };
 }  // namespace kuiper_infer
 #endif  // KUIPER_INFER_SOURCE_LAYER_DETAILS_DECONVOLUTION_H
@@ -0,0 +1,378 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-4.
+
+#include "depthwise_pointwise.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+#include "activation_sse.hpp"
+#include "layer/abstract/layer_factory.hpp"
+#include "layer/abstract/layer_workspace.hpp"
+#include "runtime/runtime_ir.hpp"
+
+namespace kuiper_infer {
+// 一个分块内所有通道的深度卷积结果和逐点卷积结果合计约128KB，留在L2中
+constexpr uint32_t kTileFloats = 32 * 1024;
+constexpr uint32_t kMinTileSize = 16;
+
+DepthwisePointwiseLayer::DepthwisePointwiseLayer(uint32_t channels, uint32_t out_channels,
+                                                 uint32_t kernel_h, uint32_t kernel_w,
+                                                 uint32_t padding_h, uint32_t padding_w,
+                                                 uint32_t stride_h, uint32_t stride_w)
+    : Layer("DepthwisePointwise"),
+      channels_(channels),
+      out_channels_(out_channels),
+      kernel_h_(kernel_h),
+      kernel_w_(kernel_w),
+      padding_h_(padding_h),
+      padding_w_(padding_w),
+      stride_h_(stride_h),
+      stride_w_(stride_w) {
+  CHECK_GT(channels_, 0);
+  CHECK_GT(out_channels_, 0);
+  CHECK_GT(kernel_h_, 0);
+  CHECK_GT(kernel_w_, 0);
+  CHECK_GT(stride_h_, 0);
+  CHECK_GT(stride_w_, 0);
+}
+
+void DepthwisePointwiseLayer::set_depthwise(const std::vector<float>& weight,
+                                            const std::vector<float>& bias) {
+  CHECK_EQ(weight.size(), size_t(channels_) * kernel_h_ * kernel_w_)
+      << "The depthwise weight size does not match the channels";
+  CHECK(bias.empty() || bias.size() == channels_)
+      << "The depthwise bias size does not match the channels";
+  depthwise_weight_ = weight;
+  depthwise_bias_ = bias.empty() ? std::vector<float>(channels_, 0.f) : bias;
+}
+
+void DepthwisePointwiseLayer::set_pointwise(const std::vector<float>& weight,
+                                            const std::vector<float>& bias) {
+  CHECK_EQ(weight.size(), size_t(out_channels_) * channels_)
+      << "The pointwise weight size does not match the channels";
+  CHECK(bias.empty() || bias.size() == out_channels_)
+      << "The pointwise bias size does not match the output channels";
+  // (out_channels, channels)的行主序权重就是(channels, out_channels)的列主序矩阵
+  pointwise_weight_ = arma::fmat(weight.data(), channels_, out_channels_);
+  pointwise_bias_ = bias.empty() ? std::vector<float>(out_channels_, 0.f) : bias;
+}
+
+void DepthwisePointwiseLayer::set_activations(activation::ActivationRawFunc depthwise_activation,
+                                              activation::ActivationRawFunc activation) {
+  depthwise_activation_ = depthwise_activation;
+  activation_ = activation;
+}
+
+bool DepthwisePointwiseLayer::FuseResidualAdd(const std::string& activation_type) {
+  using namespace activation;
+  // 输出的激活函数已经在残差相加之前被融合，不能再调整计算顺序
+  if (activation_ != nullptr && !fused_residual_) {
+    return false;
+  }
+  ActivationRawFunc activation_function = nullptr;
+  if (!activation_type.empty()) {
+    const ActivationType type = OpTypeToActivationType(activation_type);
+    if (type == ActivationType::kActivatetionUnknown) {
+      return false;
+    }
+    activation_function = ApplySSEActivationRaw(type);
+  }
+  fused_residual_ = true;
+  activation_ = activation_function;
+  return true;
+}
+
+uint32_t DepthwisePointwiseLayer::TileSize(uint32_t output_size) const {
+  const uint32_t tile_size = std::max(kTileFloats / (channels_ + out_channels_), kMinTileSize);
+  return std::min(tile_size, output_size);
+}
+
+void DepthwisePointwiseLayer::ComputeDepthwiseTile(const sftensor& input, uint32_t output_h,
+                                                   uint32_t tile_start, uint32_t tile_size,
+                                                   float* tile) const {
+  const int32_t input_h = int32_t(input->rows());
+  const int32_t input_w = int32_t(input->cols());
+  const uint32_t kernel_size = kernel_h_ * kernel_w_;
+  for (uint32_t c = 0; c < channels_; ++c) {
+    const float* input_channel = input->matrix_raw_ptr(c);
+    const float* kernel = depthwise_weight_.data() + c * kernel_size;
+    float* tile_channel = tile + size_t(c) * tile_size;
+    for (uint32_t j = 0; j < tile_size; ++j) {
+      const uint32_t position = tile_start + j;
+      const int32_t ih = int32_t(position % output_h * stride_h_) - int32_t(padding_h_);
+      const int32_t iw = int32_t(position / output_h * stride_w_) - int32_t(padding_w_);
+      float sum = depthwise_bias_[c];
+      for (uint32_t kw = 0; kw < kernel_w_; ++kw) {
+        const int32_t x = iw + int32_t(kw);
+        if (x < 0 || x >= input_w) {
+          continue;
+        }
+        const float* input_col = input_channel + x * input_h;
+        for (uint32_t kh = 0; kh < kernel_h_; ++kh) {
+          const int32_t y = ih + int32_t(kh);
+          if (y >= 0 && y < input_h) {
+            // 权重按PyTorch的(kh, kw)行主序存放
+            sum += input_col[y] * kernel[kh * kernel_w_ + kw];
+          }
+        }
+      }
+      tile_channel[j] = sum;
+    }
+  }
+}
+
+StatusCode DepthwisePointwiseLayer::Forward(
+    const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
+    std::vector<std::shared_ptr<Tensor<float>>>& outputs) {
+  if (inputs.empty()) {
+    LOG(ERROR) << "The input tensor array in the depthwise pointwise layer is empty";
+    return StatusCode::kInferInputsEmpty;
+  }
+
+  if (outputs.empty()) {
+    LOG(ERROR) << "The output tensor array in the depthwise pointwise layer is empty";
+    return StatusCode::kInferOutputsEmpty;
+  }
+
+  // 融合残差相加后，残差张量排列在常规输入之后
+  const uint32_t batch_size = outputs.size();
+  const uint32_t residual_size = fused_residual_ ? batch_size : 0;
+  if (inputs.size() != batch_size + residual_size) {
+    LOG(ERROR) << "The input and output tensor array size of the depthwise pointwise layer do "
+                  "not match";
+    return StatusCode::kInferInOutShapeMismatch;
+  }
+
+  if (depthwise_weight_.empty() || pointwise_weight_.empty()) {
+    LOG(ERROR) << "The weights of the depthwise pointwise layer are empty";
+    return StatusCode::kInferParameterError;
+  }
+
+#pragma omp parallel for num_threads(this->batch_threads(batch_size))
+  for (uint32_t i = 0; i < batch_size; ++i) {
+    const std::shared_ptr<Tensor<float>>& input = inputs[i];
+    LAYER_CHECK(input != nullptr && !input->empty() && input->channels() == channels_)
+        << "The input tensor array in the depthwise pointwise layer has an incorrectly sized "
+           "tensor "
+        << i << "th";
+
+    const uint32_t input_h = input->rows();
+    const uint32_t input_w = input->cols();
+    LAYER_CHECK(input_h + 2 * padding_h_ >= kernel_h_ && input_w + 2 * padding_w_ >= kernel_w_);
+    const uint32_t output_h = (input_h + 2 * padding_h_ - kernel_h_) / stride_h_ + 1;
+    const uint32_t output_w = (input_w + 2 * padding_w_ - kernel_w_) / stride_w_ + 1;
+
+    std::shared_ptr<Tensor<float>> output = outputs[i];
+    if (output == nullptr || output->empty()) {
+      output = std::make_shared<Tensor<float>>(out_channels_, output_h, output_w);
+      outputs[i] = output;
+    }
+    LAYER_CHECK(output->rows() == output_h && output->cols() == output_w &&
+                output->channels() == out_channels_)
+        << "The output tensor array in the depthwise pointwise layer has an incorrectly sized "
+           "tensor "
+        << i << "th";
+
+    sftensor residual;
+    if (fused_residual_) {
+      residual = inputs[batch_size + i];
+      LAYER_CHECK(residual != nullptr && residual->rows() == output_h &&
+                  residual->cols() == output_w && residual->channels() == out_channels_)
+          << "The residual tensor array in the depthwise pointwise layer has an incorrectly "
+             "sized tensor "
+          << i << "th";
+    }
+
+    const uint32_t output_size = output_h * output_w;
+    const uint32_t tile_size = TileSize(output_size);
+    const uint32_t tile_count = (output_size + tile_size - 1) / tile_size;
+#pragma omp parallel for num_threads(this->intra_threads())
+    for (uint32_t t = 0; t < tile_count; ++t) {
+      const uint32_t tile_start = t * tile_size;
+      const uint32_t current_size = std::min(tile_size, output_size - tile_start);
+
+      // 深度卷积和逐点卷积的分块结果是当前线程工作区中的两段
+      const size_t depthwise_size = LayerWorkspace::SliceSize(size_t(tile_size) * channels_);
+      float* workspace =
+          LayerWorkspace::Acquire(depthwise_size + size_t(tile_size) * out_channels_);
+      ComputeDepthwiseTile(input, output_h, tile_start, current_size, workspace);
+      if (depthwise_activation_ != nullptr) {
+        depthwise_activation_(workspace, workspace, int64_t(current_size) * channels_);
+      }
+
+      const arma::fmat depthwise_tile(workspace, current_size, channels_, false, true);
+      arma::fmat pointwise_tile(workspace + depthwise_size, current_size, out_channels_, false,
+                                true);
+      pointwise_tile = depthwise_tile * pointwise_weight_;
+
+      for (uint32_t o = 0; o < out_channels_; ++o) {
+        const float* tile_ptr = pointwise_tile.colptr(o);
+        float* output_ptr = output->matrix_raw_ptr(o) + tile_start;
+        const float bias = pointwise_bias_[o];
+        if (residual != nullptr) {
+          const float* residual_ptr = residual->matrix_raw_ptr(o) + tile_start;
+          for (uint32_t j = 0; j < current_size; ++j) {
+            output_ptr[j] = tile_ptr[j] + bias + residual_ptr[j];
+          }
+        } else {
+          for (uint32_t j = 0; j < current_size; ++j) {
+            output_ptr[j] = tile_ptr[j] + bias;
+          }
+        }
+        if (activation_ != nullptr) {
+          activation_(output_ptr, output_ptr, current_size);
+        }
+      }
+    }
+  }
+  return StatusCode::kSuccess;
+}
+
+LayerCost DepthwisePointwiseLayer::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                                        const std::vector<int32_t>& output_shape) const {
+  LayerCost cost = Layer<float>::Cost(input_shapes, output_shape);
+  const double positions = ShapeElements(output_shape) / out_channels_;
+  const double kernel_size = double(kernel_h_) * kernel_w_;
+  // 深度卷积每个通道做kernel_size次乘加，逐点卷积每个输出通道做channels次乘加，另加偏置
+  cost.flops = positions * channels_ * (2. * kernel_size + 1.) +
+               positions * out_channels_ * (2. * channels_ + 1.);
+  cost.parameters = channels_ * (kernel_size + 1.) + out_channels_ * (channels_ + 1.);
+  cost.weight_bytes = cost.parameters * sizeof(float);
+  return cost;
+}
+
+size_t DepthwisePointwiseLayer::WorkspaceSize(
+    const std::vector<std::vector<int32_t>>& input_shapes,
+    const std::vector<int32_t>& output_shape) const {
+  if (output_shape.size() != 4) {
+    return 0;
+  }
+  const uint32_t tile_size = TileSize(uint32_t(output_shape.at(2) * output_shape.at(3)));
+  return LayerWorkspace::SliceSize(size_t(tile_size) * channels_) +
+         size_t(tile_size) * out_channels_;
+}
+
+static bool GetIntArrayParam(const std::map<std::string, std::shared_ptr<RuntimeParameter>>& params,
+                             const std::string& name, std::vector<int32_t>& values) {
+  const auto iter = params.find(name);
+  if (iter == params.end()) {
+    return false;
+  }
+  auto param = std::dynamic_pointer_cast<RuntimeParameterIntArray>(iter->second);
+  if (param == nullptr || param->value.size() != 2) {
+    return false;
+  }
+  values = param->value;
+  return true;
+}
+
+static bool GetIntParam(const std::map<std::string, std::shared_ptr<RuntimeParameter>>& params,
+                        const std::string& name, int32_t& value) {
+  const auto iter = params.find(name);
+  if (iter == params.end()) {
+    return false;
+  }
+  auto param = std::dynamic_pointer_cast<RuntimeParameterInt>(iter->second);
+  if (param == nullptr || param->value <= 0) {
+    return false;
+  }
+  value = param->value;
+  return true;
+}
+
+// 可选的激活函数参数，不存在时为空
+static bool GetActivationParam(
+    const std::map<std::string, std::shared_ptr<RuntimeParameter>>& params,
+    const std::string& name, activation::ActivationRawFunc& activation_function) {
+  using namespace activation;
+  activation_function = nullptr;
+  const auto iter = params.find(name);
+  if (iter == params.end()) {
+    return true;
+  }
+  auto param = std::dynamic_pointer_cast<RuntimeParameterString>(iter->second);
+  if (param == nullptr) {
+    return false;
+  }
+  const ActivationType type = OpTypeToActivationType(param->value);
+  if (type == ActivationType::kActivatetionUnknown) {
+    return false;
+  }
+  activation_function = ApplySSEActivationRaw(type);
+  return true;
+}
+
+StatusCode DepthwisePointwiseLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
+                                                   std::shared_ptr<Layer<float>>& dw_pw_layer) {
+  if (!op) {
+    LOG(ERROR) << "The depthwise pointwise operator parameter in the layer is null pointer.";
+    return StatusCode::kParseOperatorNullParam;
+  }
+
+  const auto& params = op->params;
+  int32_t channels = 0;
+  int32_t out_channels = 0;
+  if (!GetIntParam(params, "channels", channels) ||
+      !GetIntParam(params, "out_channels", out_channels)) {
+    LOG(ERROR) << "Can not find the channel parameters";
+    return StatusCode::kParseParameterError;
+  }
+
+  std::vector<int32_t> kernel_size;
+  std::vector<int32_t> padding;
+  std::vector<int32_t> stride;
+  if (!GetIntArrayParam(params, "kernel_size", kernel_size) ||
+      !GetIntArrayParam(params, "padding", padding) ||
+      !GetIntArrayParam(params, "stride", stride)) {
+    LOG(ERROR) << "Can not find the kernel size, padding or stride parameter";
+    return StatusCode::kParseParameterError;
+  }
+
+  activation::ActivationRawFunc depthwise_activation = nullptr;
+  activation::ActivationRawFunc activation = nullptr;
+  if (!GetActivationParam(params, "dw_activation", depthwise_activation) ||
+      !GetActivationParam(params, "activation", activation)) {
+    LOG(ERROR) << "Unsupported fused activation in the depthwise pointwise layer";
+    return StatusCode::kParseParameterError;
+  }
+
+  const auto& attrs = op->attribute;
+  for (const std::string& attr_name : {"dw_weight", "dw_bias", "weight", "bias"}) {
+    if (attrs.find(attr_name) == attrs.end() || attrs.at(attr_name) == nullptr) {
+      LOG(ERROR) << "Can not find the " << attr_name << " attribute";
+      return StatusCode::kParseWeightError;
+    }
+  }
+
+  auto layer = std::make_shared<DepthwisePointwiseLayer>(
+      channels, out_channels, kernel_size.at(0), kernel_size.at(1), padding.at(0), padding.at(1),
+      stride.at(0), stride.at(1));
+  layer->set_depthwise(attrs.at("dw_weight")->get<float>(), attrs.at("dw_bias")->get<float>());
+  layer->set_pointwise(attrs.at("weight")->get<float>(), attrs.at("bias")->get<float>());
+  layer->set_activations(depthwise_activation, activation);
+  dw_pw_layer = layer;
+  return StatusCode::kSuccess;
+}
+
+LayerRegistererWrapper kDepthwisePointwiseCreateInstance(DepthwisePointwiseLayer::CreateInstance,
+                                                         "kuiper.DepthwisePointwise");
+}  // namespace kuiper_infer
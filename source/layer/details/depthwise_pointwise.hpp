@@ -0,0 +1,104 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-4.
+
+#ifndef KUIPER_INFER_SOURCE_LAYER_DETAILS_DEPTHWISE_POINTWISE_HPP_
+#define KUIPER_INFER_SOURCE_LAYER_DETAILS_DEPTHWISE_POINTWISE_HPP_
+#include "activation.hpp"
+#include "layer/abstract/layer.hpp"
+namespace kuiper_infer {
+/**
+ * @brief Depthwise convolution followed by a pointwise convolution
+ *
+ * Created by the fuse_depthwise_pointwise pass of the graph optimizer. The
+ * depthwise output of a tile of output positions is computed for all
+ * channels in the workspace and multiplied by the pointwise weights right
+ * away, so the expanded intermediate tensor is never written to memory.
+ */
+class DepthwisePointwiseLayer : public Layer<float> {
+ public:
+  explicit DepthwisePointwiseLayer(uint32_t channels, uint32_t out_channels, uint32_t kernel_h,
+                                   uint32_t kernel_w, uint32_t padding_h, uint32_t padding_w,
+                                   uint32_t stride_h, uint32_t stride_w);
+
+  StatusCode Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
+                     std::vector<std::shared_ptr<Tensor<float>>>& outputs) override;
+
+  bool FuseResidualAdd(const std::string& activation_type) override;
+
+  LayerCost Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                 const std::vector<int32_t>& output_shape) const override;
+
+  size_t WorkspaceSize(const std::vector<std::vector<int32_t>>& input_shapes,
+                       const std::vector<int32_t>& output_shape) const override;
+
+  /**
+   * @brief Sets the depthwise weights in PyTorch order (channels, 1, kh, kw) and bias
+   */
+  void set_depthwise(const std::vector<float>& weight, const std::vector<float>& bias);
+
+  /**
+   * @brief Sets the pointwise weights in PyTorch order (out_channels, channels, 1, 1) and bias
+   */
+  void set_pointwise(const std::vector<float>& weight, const std::vector<float>& bias);
+
+  /**
+   * @brief Sets the activations after the depthwise and the pointwise convolution
+   *
+   * @param depthwise_activation Activation of the depthwise output, nullptr if none
+   * @param activation Activation of the layer output, nullptr if none
+   */
+  void set_activations(activation::ActivationRawFunc depthwise_activation,
+                       activation::ActivationRawFunc activation);
+
+  static StatusCode CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
+                                   std::shared_ptr<Layer<float>>& dw_pw_layer);
+
+ private:
+  /**
+   * @brief Output positions computed together, the tile of all channels stays in L2
+   */
+  uint32_t TileSize(uint32_t output_size) const;
+
+  void ComputeDepthwiseTile(const sftensor& input, uint32_t output_h, uint32_t tile_start,
+                            uint32_t tile_size, float* tile) const;
+
+  uint32_t channels_ = 0;
+  uint32_t out_channels_ = 0;
+  uint32_t kernel_h_ = 0;
+  uint32_t kernel_w_ = 0;
+  uint32_t padding_h_ = 0;
+  uint32_t padding_w_ = 0;
+  uint32_t stride_h_ = 1;
+  uint32_t stride_w_ = 1;
+
+  std::vector<float> depthwise_weight_;
+  std::vector<float> depthwise_bias_;
+  arma::fmat pointwise_weight_;
+  std::vector<float> pointwise_bias_;
+
+  bool fused_residual_ = false;
+  activation::ActivationRawFunc depthwise_activation_ = nullptr;
+  activation::ActivationRawFunc activation_ = nullptr;
+};
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_SOURCE_LAYER_DETAILS_DEPTHWISE_POINTWISE_HPP_
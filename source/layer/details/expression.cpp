@@ -22,7 +22,7 @@
 // Created by fss on 22-11-18.
 
 #include "expression.hpp"
-#include <stack>
+#include <algorithm>
 #include "data/tensor_util.hpp"
 #include "layer/abstract/layer_factory.hpp"
 
@@ -49,76 +49,125 @@ StatusCode ExpressionLayer::Forward(const std::vector<std::shared_ptr<Tensor<flo
   }
 
   CHECK(this->parser_ != nullptr) << "The parser in the expression layer is null!";
-  this->parser_->Tokenizer(false);
+  if (token_branches_.empty()) {
+    // 只在第一次推理时解析输入分支编号，之后的推理不再处理字符串
+    this->parser_->Tokenizer(false);
+    const auto& tokens = this->parser_->tokens();
+    const auto& token_str_array = this->parser_->token_str_array();
+    CHECK(!tokens.empty() && tokens.size() == token_str_array.size())
+        << "The expression parser failed to parse " << statement_;
+    operator_count_ = 0;
+    token_branches_.resize(tokens.size(), -1);
+    for (uint32_t t = 0; t < tokens.size(); ++t) {
+      if (tokens.at(t).token_type == TokenType::TokenInputNumber) {
+        const std::string& str_number = token_str_array.at(t);
+        token_branches_.at(t) = std::stoi(str_number.substr(1));
+        CHECK(token_branches_.at(t) >= 0) << "Input branch must be >= 0";
+      } else if (TokenIsOperator(tokens.at(t))) {
+        operator_count_ += 1;
+      }
+    }
+    operand_stack_.reserve(tokens.size());
+    temp_nodes_.resize(operator_count_);
+  }
   const auto& tokens = this->parser_->tokens();
-  const auto& token_str_array = this->parser_->token_str_array();
-  CHECK(!tokens.empty() && !token_str_array.empty())
-      << "The expression parser failed to parse " << statement_;
 
+  // 操作数编号大于等于0时表示输入分支，小于0时表示第(-id - 1)个运算的结果
   const uint32_t batch_size = outputs.size();
-  std::stack<std::vector<std::shared_ptr<Tensor<float>>>> op_stack;
+  auto operand_tensor = [&](int32_t operand, uint32_t i) -> const sftensor& {
+    if (operand >= 0) {
+      return inputs.at(operand * batch_size + i);
+    }
+    return temp_nodes_.at(-operand - 1).at(i);
+  };
+
+  operand_stack_.clear();
+  uint32_t operator_index = 0;
   for (auto iter = tokens.rbegin(); iter != tokens.rend(); ++iter) {
     const auto& current_token = *iter;
     // 如果是数据类型，就将对应分支的input插入到栈中
     if (current_token.token_type == TokenType::TokenInputNumber) {
-      std::string str_number = *(token_str_array.rbegin() + std::distance(tokens.rbegin(), iter));
-      str_number.erase(str_number.begin());
-
-      int32_t input_branch = std::stoi(str_number);
-      CHECK(input_branch >= 0) << "Input branch must be >= 0";
-      uint32_t input_start_pos = input_branch * batch_size;
-      std::vector<std::shared_ptr<Tensor<float>>> input_token_nodes;
-      for (uint32_t i = 0; i < batch_size; ++i) {
-        CHECK(i + input_start_pos < inputs.size())
-            << "The " << i << "th operand doesn't have appropriate number of tensors";
-        input_token_nodes.push_back(inputs.at(i + input_start_pos));
-      }
-      op_stack.push(input_token_nodes);
+      const int32_t input_branch =
+          token_branches_.at(tokens.size() - 1 - std::distance(tokens.rbegin(), iter));
+      CHECK((input_branch + 1) * batch_size <= inputs.size())
+          << "The " << input_branch << "th operand doesn't have appropriate number of tensors";
+      operand_stack_.push_back(input_branch);
     } else if (TokenIsOperator(current_token)) {
       // process operation
-      CHECK(op_stack.size() >= 2) << "The number of operand is less than two";
-      std::shared_ptr<Tensor<float>> (*function)(const std::shared_ptr<Tensor<float>>& tensor1,
-                                                 const std::shared_ptr<Tensor<float>>& tensor2);
-      std::vector<std::shared_ptr<Tensor<float>>> input_node1(std::move(op_stack.top()));
-      CHECK(input_node1.size() == batch_size)
-          << "The first operand doesn't have appropriate number of tensors, "
-             "which need "
-          << batch_size;
-      op_stack.pop();
-      std::vector<std::shared_ptr<Tensor<float>>> input_node2(std::move(op_stack.top()));
-      CHECK(input_node2.size() == batch_size)
-          << "The second operand doesn't have appropriate number of tensors, "
-             "which need "
-          << batch_size;
-      op_stack.pop();
-
-      std::vector<std::shared_ptr<Tensor<float>>> output_token_nodes(batch_size);
+      CHECK(operand_stack_.size() >= 2) << "The number of operand is less than two";
+      const int32_t operand1 = operand_stack_.back();
+      operand_stack_.pop_back();
+      const int32_t operand2 = operand_stack_.back();
+      operand_stack_.pop_back();
+
+      void (*inplace_function)(const std::shared_ptr<Tensor<float>>& tensor1,
+                               const std::shared_ptr<Tensor<float>>& tensor2,
+                               const std::shared_ptr<Tensor<float>>& output_tensor);
       if (current_token.token_type == TokenType::TokenAdd) {
-        function = TensorElementAdd;
+        inplace_function = TensorElementAdd;
       } else if (current_token.token_type == TokenType::TokenMul) {
-        function = TensorElementMultiply;
+        inplace_function = TensorElementMultiply;
       } else {
         LOG(FATAL) << "Unsupported operator type in the expression layer: "
                    << int(current_token.token_type);
       }
-#pragma omp parallel for num_threads(batch_size)
+
+      // 中间结果写入复用的临时张量，最后一个运算直接写入已有的输出空间
+      const bool is_last_operator = std::next(iter) == tokens.rend();
+      std::vector<sftensor>& output_token_nodes = temp_nodes_.at(operator_index);
+      output_token_nodes.resize(batch_size);
+#pragma omp parallel for num_threads(this->batch_threads(batch_size))
       for (uint32_t i = 0; i < batch_size; ++i) {
-        output_token_nodes.at(i) = function(input_node1.at(i), input_node2.at(i));
+        const sftensor& input1 = operand_tensor(operand1, i);
+        const sftensor& input2 = operand_tensor(operand2, i);
+        LAYER_CHECK(input1 != nullptr && input2 != nullptr)
+            << "The " << i << "th operand of the expression layer is empty";
+        const std::shared_ptr<Tensor<float>>& output = outputs.at(i);
+        if (is_last_operator && output != nullptr && !output->empty()) {
+          output_token_nodes.at(i) = output;
+        } else {
+          const bool broadcast_input1 = !TensorShapeIsSame(input1, input2) &&
+                                        input1->rows() == 1 && input1->cols() == 1;
+          const sftensor& shape_tensor = broadcast_input1 ? input2 : input1;
+          sftensor& temp_node = output_token_nodes.at(i);
+          if (temp_node == nullptr || !TensorShapeIsSame(temp_node, shape_tensor) ||
+              temp_node == output) {
+            temp_node = std::make_shared<Tensor<float>>(
+                shape_tensor->channels(), shape_tensor->rows(), shape_tensor->cols());
+          }
+        }
+        inplace_function(input1, input2, output_token_nodes.at(i));
       }
-      op_stack.push(output_token_nodes);
+      operand_stack_.push_back(-int32_t(operator_index) - 1);
+      operator_index += 1;
     }
   }
-  CHECK(op_stack.size() == 1) << "The expression has more than one output operand!";
-  std::vector<sftensor> output_node = op_stack.top();
+  CHECK(operand_stack_.size() == 1) << "The expression has more than one output operand!";
+  const int32_t output_operand = operand_stack_.back();
   for (uint32_t i = 0; i < batch_size; ++i) {
+    const sftensor& output_node = operand_tensor(output_operand, i);
+    if (outputs.at(i) == output_node) {
+      continue;
+    }
     if (outputs.at(i) != nullptr && !outputs.at(i)->empty()) {
-      CHECK(outputs.at(i)->shapes() == output_node.at(i)->shapes());
+      LAYER_CHECK(TensorShapeIsSame(outputs.at(i), output_node));
+      outputs.at(i)->data() = output_node->data();
+    } else {
+      outputs.at(i) = output_node;
     }
-    outputs.at(i) = output_node.at(i);
   }
   return StatusCode::kSuccess;
 }
 
+LayerCost ExpressionLayer::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                                const std::vector<int32_t>& output_shape) const {
+  LayerCost cost = Layer<float>::Cost(input_shapes, output_shape);
+  // 表达式中的每个运算形如add(@0,@1)，对每个输出元素计算一次
+  const auto operator_count = std::count(statement_.begin(), statement_.end(), '(');
+  cost.flops = double(operator_count) * ShapeElements(output_shape);
+  return cost;
+}
+
 StatusCode ExpressionLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                            std::shared_ptr<Layer<float>>& expression_layer) {
   if (!op) {
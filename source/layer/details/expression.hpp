@@ -34,6 +34,9 @@ class ExpressionLayer : public NonParamLayer {
   StatusCode Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                      std::vector<std::shared_ptr<Tensor<float>>>& outputs) override;
 
+  LayerCost Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                 const std::vector<int32_t>& output_shape) const override;
+
   bool TokenIsOperator(Token token) const;
 
   static StatusCode CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
@@ -42,6 +45,15 @@ class ExpressionLayer : public NonParamLayer {
  private:
   std::string statement_;
   std::unique_ptr<ExpressionParser> parser_;
+
+  /// 每个token对应的输入分支编号，非输入token为-1
+  std::vector<int32_t> token_branches_;
+  /// 表达式中运算符的数量
+  uint32_t operator_count_ = 0;
+  /// 后缀求值时使用的操作数栈，容量在第一次推理时预留
+  std::vector<int32_t> operand_stack_;
+  /// 每个运算的中间结果，在多次推理之间复用
+  std::vector<std::vector<sftensor>> temp_nodes_;
 };
 }  // namespace kuiper_infer
 #endif  // KUIPER_INFER_SOURCE_LAYER_MONOCULAR_EXPRESSION_HPP_
@@ -21,6 +21,8 @@
 
 // Created by fss on 22-12-9.
 #include "flatten.hpp"
+#include <algorithm>
+#include <array>
 #include <numeric>
 #include "data/tensor_util.hpp"
 #include "layer/abstract/layer_factory.hpp"
@@ -72,34 +74,64 @@ StatusCode FlattenLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>
       return StatusCode::kInferInputsEmpty;
     }
 
-    std::vector<uint32_t> shapes = input->shapes();
-    shapes.insert(shapes.begin(), batch_size);
+    const std::array<uint32_t, 4> shapes{batch_size, input->channels(), input->rows(),
+                                         input->cols()};
     uint32_t elements_size = std::accumulate(shapes.begin() + start_dim,
                                              shapes.begin() + end_dim + 1, 1, std::multiplies());
 
-    std::shared_ptr<Tensor<float>> output = outputs.at(i);
-    output = TensorClone(input);
-    CHECK(input->size() == output->size()) << "The output and input shapes of the flatten layer do "
-                                              "not match "
-                                           << i << " th";
-    outputs.at(i) = output;
-
+    std::array<uint32_t, 2> output_shapes{};
+    uint32_t output_dims = 0;
     if (start_dim == 1 && end_dim == 3) {
-      output->Reshape({elements_size}, true);
+      output_shapes = {elements_size};
+      output_dims = 1;
     } else if (start_dim == 2 && end_dim == 3) {
-      uint32_t channels = input->channels();
-      output->Reshape({channels, elements_size}, true);
+      output_shapes = {input->channels(), elements_size};
+      output_dims = 2;
     } else if (start_dim == 1 && end_dim == 2) {
-      uint32_t cols = input->cols();
-      output->Reshape({elements_size, cols}, true);
+      output_shapes = {elements_size, input->cols()};
+      output_dims = 2;
     } else {
       LOG(FATAL) << "Wrong flatten dim: "
                  << "start dim: " << start_dim << " end dim: " << end_dim;
     }
+
+    // 输出空间已经存在且形状一致时原地写入，保证后继算子绑定的输出张量不变并且不申请内存
+    std::shared_ptr<Tensor<float>> output = outputs.at(i);
+    if (output != nullptr && !output->empty() && output != input) {
+      CHECK(input->size() == output->size()) << "The output and input shapes of the flatten layer "
+                                                "do not match "
+                                             << i << " th";
+      const std::vector<uint32_t>& raw_shapes = output->raw_shapes();
+      if (std::equal(output_shapes.begin(), output_shapes.begin() + output_dims,
+                     raw_shapes.begin(), raw_shapes.end())) {
+        output->CopyRowMajor(*input);
+        continue;
+      }
+    }
+
+    if (output == nullptr || output->empty()) {
+      output = TensorClone(input);
+      outputs.at(i) = output;
+    } else if (output != input) {
+      output->data() = input->data();
+    }
+    CHECK(input->size() == output->size()) << "The output and input shapes of the flatten layer do "
+                                              "not match "
+                                           << i << " th";
+    output->Reshape(std::vector<uint32_t>(output_shapes.begin(),
+                                          output_shapes.begin() + output_dims),
+                    true);
   }
   return StatusCode::kSuccess;
 }
 
+LayerCost FlattenLayer::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                             const std::vector<int32_t>& output_shape) const {
+  LayerCost cost = Layer<float>::Cost(input_shapes, output_shape);
+  cost.flops = 0.;
+  return cost;
+}
+
 StatusCode FlattenLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                         std::shared_ptr<Layer<float>>& flatten_layer) {
   if (!op) {
@@ -30,7 +30,13 @@ HardSigmoid::HardSigmoid() : NonParamLayer("HardSigmoid") {}
 StatusCode HardSigmoid::Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                                 std::vector<std::shared_ptr<Tensor<float>>>& outputs) {
   using namespace activation;
-  return ActivationForward(ActivationType::kActivationHardSigmoid, inputs, outputs);
+  return ActivationForward(ActivationType::kActivationHardSigmoid, inputs, outputs, *this);
+}
+
+StatusCode HardSigmoid::ForwardViews(Span<const TensorView> inputs,
+                                     Span<const TensorView> outputs) {
+  using namespace activation;
+  return ActivationForward(ActivationType::kActivationHardSigmoid, inputs, outputs, *this);
 }
 
 StatusCode HardSigmoid::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
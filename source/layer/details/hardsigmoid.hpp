@@ -32,6 +32,10 @@ class HardSigmoid : public NonParamLayer {
   StatusCode Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                      std::vector<std::shared_ptr<Tensor<float>>>& outputs) override;
 
+  StatusCode ForwardViews(Span<const TensorView> inputs, Span<const TensorView> outputs) override;
+
+  bool supports_views() const override { return true; }
+
   static StatusCode CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                    std::shared_ptr<Layer<float>>& hardsigmoid_layer);
 };
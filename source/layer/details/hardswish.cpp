@@ -30,7 +30,13 @@ HardSwishLayer::HardSwishLayer() : NonParamLayer("HardSwish") {}
 StatusCode HardSwishLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                                    std::vector<std::shared_ptr<Tensor<float>>>& outputs) {
   using namespace activation;
-  return ActivationForward(ActivationType::kActivationHardSwish, inputs, outputs);
+  return ActivationForward(ActivationType::kActivationHardSwish, inputs, outputs, *this);
+}
+
+StatusCode HardSwishLayer::ForwardViews(Span<const TensorView> inputs,
+                                        Span<const TensorView> outputs) {
+  using namespace activation;
+  return ActivationForward(ActivationType::kActivationHardSwish, inputs, outputs, *this);
 }
 
 StatusCode HardSwishLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
@@ -24,6 +24,7 @@
 #include "linear.hpp"
 #include <glog/logging.h>
 #include "layer/abstract/layer_factory.hpp"
+#include "layer/abstract/layer_workspace.hpp"
 
 namespace kuiper_infer {
 
@@ -40,6 +41,48 @@ LinearLayer::LinearLayer(int32_t in_features, int32_t out_features, bool use_bia
   }
 }
 
+// int8输入所占的工作区大小，以float计
+static size_t QuantizedInputSize(size_t rows, size_t padded_cols) {
+  return LayerWorkspace::SliceSize((rows * padded_cols + sizeof(float) - 1) / sizeof(float));
+}
+
+void LinearLayer::set_weights(const std::vector<float>& weights) {
+  ParamLayer::set_weights(weights);
+  InitPackedWeight();
+}
+
+void LinearLayer::set_weights(const std::vector<std::shared_ptr<Tensor<float>>>& weights) {
+  ParamLayer::set_weights(weights);
+  InitPackedWeight();
+}
+
+void LinearLayer::InitPackedWeight() {
+  sparse_weight_.reset();
+  quantized_weight_.reset();
+  if (this->weights_.size() != 1 || this->weights_.front() == nullptr) {
+    return;
+  }
+  // 权重按列主序存放，先转成每个输出特征一行
+  const arma::fmat weight_data(this->weights_.front()->raw_ptr(), out_features_, in_features_,
+                               false, true);
+  const arma::fmat weight_rows = weight_data.t();
+  std::vector<const float*> rows;
+  for (int32_t o = 0; o < out_features_; ++o) {
+    rows.push_back(weight_rows.colptr(o));
+  }
+  if (dynamic_quantization_) {
+    quantized_weight_ = std::make_shared<quant::QuantizedMatrix>(rows, in_features_);
+  } else if (sparse::ZeroBlockRatio(rows, in_features_) >= sparse::kSparsityThreshold) {
+    sparse_weight_ = std::make_shared<sparse::BlockSparseMatrix>(rows, in_features_);
+  }
+}
+
+bool LinearLayer::QuantizeWeights() {
+  dynamic_quantization_ = true;
+  InitPackedWeight();
+  return true;
+}
+
 StatusCode LinearLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                                 std::vector<std::shared_ptr<Tensor<float>>>& outputs) {
   if (inputs.empty()) {
@@ -81,20 +124,17 @@ StatusCode LinearLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>
   uint32_t batch = inputs.size();
   const std::shared_ptr<Tensor<float>>& weight = weights_.front();
   arma::fmat weight_data(weight->raw_ptr(), out_features_, in_features_, false, true);
-  const arma::fmat& weight_data_t = weight_data.t();
 
-#pragma omp parallel for num_threads(batch)
+#pragma omp parallel for num_threads(this->batch_threads(batch))
   for (uint32_t i = 0; i < batch; ++i) {
     const std::shared_ptr<Tensor<float>>& input = inputs.at(i);
-    CHECK(input != nullptr && !input->empty())
+    LAYER_CHECK(input != nullptr && !input->empty())
         << "The input tensor array in the linear layer has an empty tensor " << i << " th";
-    const std::vector<uint32_t>& input_shapes = input->shapes();
-
-    const uint32_t feature_dims = input_shapes.at(1);
-    const uint32_t in_features = input_shapes.at(2);
-    CHECK(weight_data.n_rows == out_features_)
+    const uint32_t feature_dims = input->rows();
+    const uint32_t in_features = input->cols();
+    LAYER_CHECK(weight_data.n_rows == out_features_)
         << "The row of weight tensor should be same to output features.";
-    CHECK(weight_data.n_cols == in_features && in_features == in_features_)
+    LAYER_CHECK(weight_data.n_cols == in_features && in_features == in_features_)
         << "The col of weight tensor should be same to input features.";
 
     arma::fmat input_vec(input->raw_ptr(), feature_dims, in_features_, false, true);
@@ -106,24 +146,54 @@ StatusCode LinearLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>
 
     const auto& output_raw_shapes = output->raw_shapes();
     if (output_raw_shapes.size() == 2) {
-      CHECK(output_raw_shapes.at(0) == feature_dims && output_raw_shapes.at(1) == out_features_)
+      LAYER_CHECK(output_raw_shapes.at(0) == feature_dims &&
+                  output_raw_shapes.at(1) == out_features_)
           << "The row of output tensor should be same to feature dims and the "
              "col of output tensor should be same to output features.";
     } else if (output_raw_shapes.size() == 1) {
-      CHECK(output_raw_shapes.at(0) == out_features_)
+      LAYER_CHECK(output_raw_shapes.at(0) == out_features_)
           << "The row of output tensor should be same to feature dims.";
     } else {
       LOG(FATAL) << "The shape of output tensor need be equal to one or two";
     }
 
     arma::fmat& result = output->slice(0);
-    result = input_vec * weight_data_t;
+    if (quantized_weight_ != nullptr) {
+      LAYER_CHECK(result.n_rows == feature_dims && result.n_cols == out_features_)
+          << "The output tensor of the quantized linear layer has an incorrect size";
+      // 每一行输入单独量化，量化后的行连续存放在工作区中
+      const size_t scales_size = LayerWorkspace::SliceSize(feature_dims);
+      float* workspace = LayerWorkspace::Acquire(
+          scales_size + QuantizedInputSize(feature_dims, quant::PaddedCols(in_features_)));
+      int8_t* input_quantized = reinterpret_cast<int8_t*>(workspace + scales_size);
+      quant::QuantizeRows(input->raw_ptr(), 1, feature_dims, feature_dims, in_features_,
+                          input_quantized, workspace, this->intra_threads());
+      quantized_weight_->Multiply(input_quantized, workspace, feature_dims, result.memptr(),
+                                  feature_dims, this->intra_threads());
+    } else if (sparse_weight_ != nullptr) {
+      LAYER_CHECK(result.n_rows == feature_dims && result.n_cols == out_features_)
+          << "The output tensor of the sparse linear layer has an incorrect size";
+      // 稀疏内核要求每个位置的输入特征连续，多行输入先转置到工作区
+      const float* input_matrix = input->raw_ptr();
+      if (feature_dims > 1) {
+        arma::fmat input_transposed(LayerWorkspace::Acquire(size_t(in_features_) * feature_dims),
+                                    in_features_, feature_dims, false, true);
+        input_transposed = input_vec.t();
+        input_matrix = input_transposed.memptr();
+      }
+      sparse_weight_->Multiply(input_matrix, in_features_, feature_dims, result.memptr(),
+                               feature_dims, this->intra_threads());
+    } else {
+      // 转置在GEMM中完成，不生成转置后的权重矩阵
+      result = input_vec * weight_data.t();
+    }
     if (use_bias_) {
-      CHECK(!this->bias_.empty() && this->bias_.size() == 1)
+      LAYER_CHECK(!this->bias_.empty() && this->bias_.size() == 1)
           << "The bias tensor is empty, but \"use bias\" is true";
 
       const auto& bias_data = bias_.front()->data();
-      CHECK(!bias_data.empty() && bias_data.n_slices == 1 && bias_data.n_cols == out_features_)
+      LAYER_CHECK(!bias_data.empty() && bias_data.n_slices == 1 &&
+                  bias_data.n_cols == out_features_)
           << "The col of bias tensor is not same to output features";
       result.each_row() += bias_data.slice(0);
     }
@@ -131,6 +201,36 @@ StatusCode LinearLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>
   return StatusCode::kSuccess;
 }
 
+LayerCost LinearLayer::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                            const std::vector<int32_t>& output_shape) const {
+  LayerCost cost = ParamLayer::Cost(input_shapes, output_shape);
+  const double output_elements = ShapeElements(output_shape);
+  cost.flops = 2. * output_elements * in_features_ + (use_bias_ ? output_elements : 0.);
+  if (quantized_weight_ != nullptr) {
+    cost.weight_bytes -= double(weights_.front()->size()) * sizeof(float);
+    cost.weight_bytes += double(quantized_weight_->memory_bytes());
+  }
+  return cost;
+}
+
+size_t LinearLayer::WorkspaceSize(const std::vector<std::vector<int32_t>>& input_shapes,
+                                  const std::vector<int32_t>& output_shape) const {
+  if (output_shape.size() < 2) {
+    return 0;
+  }
+  const size_t feature_dims = ShapeElements(output_shape) / output_shape.front() / out_features_;
+  if (quantized_weight_ != nullptr) {
+    // 每行输入的缩放系数和量化后的输入
+    return LayerWorkspace::SliceSize(feature_dims) +
+           QuantizedInputSize(feature_dims, quant::PaddedCols(in_features_));
+  }
+  if (sparse_weight_ == nullptr) {
+    return 0;
+  }
+  // 多行输入转置后的矩阵
+  return feature_dims > 1 ? feature_dims * in_features_ : 0;
+}
+
 StatusCode LinearLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                        std::shared_ptr<Layer<float>>& linear_layer) {
   if (!op) {
@@ -23,6 +23,8 @@
 
 #ifndef KUIPER_INFER_SOURCE_LAYER_LINEAR_HPP_
 #define KUIPER_INFER_SOURCE_LAYER_LINEAR_HPP_
+#include "block_sparse.hpp"
+#include "quantize.hpp"
 #include "layer/abstract/layer.hpp"
 #include "layer/abstract/param_layer.hpp"
 
@@ -36,13 +38,40 @@ class LinearLayer : public ParamLayer {
   StatusCode Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                      std::vector<std::shared_ptr<Tensor<float>>>& outputs) override;
 
+  LayerCost Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                 const std::vector<int32_t>& output_shape) const override;
+
+  size_t WorkspaceSize(const std::vector<std::vector<int32_t>>& input_shapes,
+                       const std::vector<int32_t>& output_shape) const override;
+
+  void set_weights(const std::vector<float>& weights) override;
+
+  void set_weights(const std::vector<std::shared_ptr<Tensor<float>>>& weights) override;
+
+  /**
+   * @brief Whether the weights are pruned enough to run the block-sparse kernel
+   */
+  bool is_sparse() const { return sparse_weight_ != nullptr; }
+
+  bool QuantizeWeights() override;
+
+  /**
+   * @brief Whether the layer runs the int8 kernel with dynamic activation quantization
+   */
+  bool is_quantized() const { return quantized_weight_ != nullptr; }
+
   static StatusCode CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                    std::shared_ptr<Layer<float>>& linear_layer);
 
  private:
+  void InitPackedWeight();
+
   int32_t in_features_ = 0;
   int32_t out_features_ = 0;
   bool use_bias_ = false;
+  bool dynamic_quantization_ = false;
+  std::shared_ptr<const sparse::BlockSparseMatrix> sparse_weight_;
+  std::shared_ptr<const quant::QuantizedMatrix> quantized_weight_;
 };
 }  // namespace kuiper_infer
 
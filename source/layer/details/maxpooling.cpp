@@ -40,6 +40,8 @@ MaxPoolingLayer::MaxPoolingLayer(uint32_t padding_h, uint32_t padding_w, uint32_
   CHECK_GT(stride_w_, 0);
   CHECK_GT(pooling_size_h_, 0);
   CHECK_GT(pooling_size_w_, 0);
+  // 常见的池化窗口和步长使用编译期特化的实现，其余的走通用实现
+  pooling_func_ = window::SelectMaxPooling(pooling_size_h_, pooling_size_w_, stride_h_, stride_w_);
 }
 
 StatusCode MaxPoolingLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
@@ -76,10 +78,10 @@ StatusCode MaxPoolingLayer::Forward(const std::vector<std::shared_ptr<Tensor<flo
   const uint32_t pooling_h = pooling_size_h_;
   const uint32_t pooling_w = pooling_size_w_;
 
-#pragma omp parallel for num_threads(batch)
+#pragma omp parallel for num_threads(this->batch_threads(batch))
   for (uint32_t i = 0; i < batch; ++i) {
     const std::shared_ptr<Tensor<float>>& input_data = inputs.at(i);
-    CHECK(input_data != nullptr && !input_data->empty())
+    LAYER_CHECK(input_data != nullptr && !input_data->empty())
         << "The input tensor array in the max pooling layer has an "
            "empty tensor "
         << i << "th";
@@ -102,12 +104,22 @@ StatusCode MaxPoolingLayer::Forward(const std::vector<std::shared_ptr<Tensor<flo
       outputs.at(i) = output_data;
     }
 
-    CHECK(output_data->rows() == output_h && output_data->cols() == output_w &&
-          output_data->channels() == input_c)
+    LAYER_CHECK(output_data->rows() == output_h && output_data->cols() == output_w &&
+                output_data->channels() == input_c)
         << "The output tensor array in the max pooling layer "
            "has an incorrectly sized tensor "
         << i << "th";
 
+    if (pooling_func_ != nullptr) {
+#pragma omp parallel for num_threads(this->intra_threads())
+      for (uint32_t ic = 0; ic < input_c; ++ic) {
+        pooling_func_(input_data->matrix_raw_ptr(ic), input_h, input_w, padding_h_, padding_w_,
+                      output_h, output_w, output_data->matrix_raw_ptr(ic));
+      }
+      continue;
+    }
+
+#pragma omp parallel for num_threads(this->intra_threads())
     for (uint32_t ic = 0; ic < input_c; ++ic) {
       const arma::fmat& input_channel = input_data->slice(ic);
       arma::fmat& output_channel = output_data->slice(ic);
@@ -138,6 +150,13 @@ StatusCode MaxPoolingLayer::Forward(const std::vector<std::shared_ptr<Tensor<flo
   return StatusCode::kSuccess;
 }
 
+LayerCost MaxPoolingLayer::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                                const std::vector<int32_t>& output_shape) const {
+  LayerCost cost = Layer<float>::Cost(input_shapes, output_shape);
+  cost.flops = ShapeElements(output_shape) * pooling_size_h_ * pooling_size_w_;
+  return cost;
+}
+
 StatusCode MaxPoolingLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                            std::shared_ptr<Layer<float>>& max_layer) {
   if (!op) {
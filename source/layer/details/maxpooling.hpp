@@ -24,6 +24,7 @@
 #ifndef KUIPER_INFER_SOURCE_LAYER_MAX_POOLING_
 #define KUIPER_INFER_SOURCE_LAYER_MAX_POOLING_
 #include "layer/abstract/non_param_layer.hpp"
+#include "window_kernel.hpp"
 namespace kuiper_infer {
 class MaxPoolingLayer : public NonParamLayer {
  public:
@@ -33,6 +34,9 @@ class MaxPoolingLayer : public NonParamLayer {
   StatusCode Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                      std::vector<std::shared_ptr<Tensor<float>>>& outputs) override;
 
+  LayerCost Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                 const std::vector<int32_t>& output_shape) const override;
+
   static StatusCode CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                    std::shared_ptr<Layer<float>>& max_layer);
 
@@ -43,6 +47,7 @@ class MaxPoolingLayer : public NonParamLayer {
   uint32_t pooling_size_w_ = 0;
   uint32_t stride_h_ = 1;
   uint32_t stride_w_ = 1;
+  window::MaxPoolingFunc pooling_func_ = nullptr;
 };
 }  // namespace kuiper_infer
 #endif  // KUIPER_INFER_SOURCE_LAYER_MAX_POOLING_
@@ -0,0 +1,119 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-7.
+
+#include "quantize.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+#include "row_multiply.hpp"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace kuiper_infer {
+namespace quant {
+static float QuantizeRow(const float* row, size_t col_stride, uint32_t cols, int8_t* quantized) {
+  float max_value = 0.f;
+  for (uint32_t c = 0; c < cols; ++c) {
+    max_value = std::max(max_value, std::abs(row[c * col_stride]));
+  }
+  const size_t padded_cols = PaddedCols(cols);
+  if (max_value == 0.f) {
+    std::fill(quantized, quantized + padded_cols, int8_t(0));
+    return 0.f;
+  }
+  const float scale = max_value / float(kInt8Max);
+  const float inv_scale = 1.f / scale;
+  for (uint32_t c = 0; c < cols; ++c) {
+    const int32_t value = int32_t(std::lround(row[c * col_stride] * inv_scale));
+    quantized[c] = int8_t(std::clamp(value, -kInt8Max, kInt8Max));
+  }
+  std::fill(quantized + cols, quantized + padded_cols, int8_t(0));
+  return scale;
+}
+
+void QuantizeRows(const float* values, size_t row_stride, size_t col_stride, uint32_t rows,
+                  uint32_t cols, int8_t* quantized, float* scales, uint32_t threads) {
+  CHECK(values != nullptr && quantized != nullptr && scales != nullptr);
+  const size_t padded_cols = PaddedCols(cols);
+#pragma omp parallel for num_threads(threads) if (rows > 1)
+  for (uint32_t r = 0; r < rows; ++r) {
+    scales[r] = QuantizeRow(values + r * row_stride, col_stride, cols, quantized + r * padded_cols);
+  }
+}
+
+// 两行量化值的点积，长度是kRowAlignment的整数倍，累加在int32中
+static int32_t RowDot(const int8_t* weights, const int8_t* input, size_t padded_cols) {
+#ifdef __AVX2__
+  // 权重取绝对值后作为无符号数，符号转移到输入上，乘加的结果不超过int16的范围
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i acc = _mm256_setzero_si256();
+  for (size_t c = 0; c < padded_cols; c += kRowAlignment) {
+    const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + c));
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + c));
+    const __m256i products = _mm256_maddubs_epi16(_mm256_sign_epi8(w, w), _mm256_sign_epi8(x, w));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(products, ones));
+  }
+  const __m128i sum4 =
+      _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  const __m128i sum2 = _mm_add_epi32(sum4, _mm_unpackhi_epi64(sum4, sum4));
+  const __m128i sum1 = _mm_add_epi32(sum2, _mm_shuffle_epi32(sum2, 0x1));
+  return _mm_cvtsi128_si32(sum1);
+#else
+  int32_t sum = 0;
+  for (size_t c = 0; c < padded_cols; ++c) {
+    sum += int32_t(weights[c]) * int32_t(input[c]);
+  }
+  return sum;
+#endif
+}
+
+QuantizedMatrix::QuantizedMatrix(const std::vector<const float*>& rows, uint32_t cols)
+    : rows_(rows.size()), cols_(cols) {
+  CHECK(rows_ > 0 && cols_ > 0) << "The quantized matrix can not be empty";
+  const size_t padded_cols = PaddedCols(cols_);
+  values_.resize(rows_ * padded_cols);
+  scales_.resize(rows_);
+  for (uint32_t r = 0; r < rows_; ++r) {
+    CHECK(rows.at(r) != nullptr);
+    scales_[r] = QuantizeRow(rows.at(r), 1, cols_, values_.data() + r * padded_cols);
+  }
+}
+
+size_t QuantizedMatrix::memory_bytes() const {
+  return values_.size() * sizeof(int8_t) + scales_.size() * sizeof(float);
+}
+
+void QuantizedMatrix::Multiply(const int8_t* input, const float* input_scales, uint32_t positions,
+                               float* output, size_t channel_stride, uint32_t threads) const {
+  CHECK(input != nullptr && input_scales != nullptr && output != nullptr);
+  const size_t padded_cols = PaddedCols(cols_);
+  // 每个激活行是一个输出位置，量化的整数点积再乘上两边的缩放系数
+  MultiplyRows(rows_, positions, output, channel_stride, threads, [&](uint32_t row, uint32_t n) {
+    const int32_t sum =
+        RowDot(values_.data() + row * padded_cols, input + n * padded_cols, padded_cols);
+    return float(sum) * (scales_[row] * input_scales[n]);
+  });
+}
+}  // namespace quant
+}  // namespace kuiper_infer
@@ -0,0 +1,112 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-7.
+
+#ifndef KUIPER_INFER_SOURCE_LAYER_DETAILS_QUANTIZE_HPP_
+#define KUIPER_INFER_SOURCE_LAYER_DETAILS_QUANTIZE_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+namespace kuiper_infer {
+namespace quant {
+/// Largest magnitude of a quantized value, -128 is never used
+constexpr int32_t kInt8Max = 127;
+
+/// Quantized rows are zero padded to a multiple of this many values
+constexpr uint32_t kRowAlignment = 32;
+
+/**
+ * @brief Rounds a row length up to the padded length of a quantized row
+ */
+inline size_t PaddedCols(uint32_t cols) {
+  return (size_t(cols) + kRowAlignment - 1) / kRowAlignment * kRowAlignment;
+}
+
+/**
+ * @brief Quantizes every row of a float matrix symmetrically to int8
+ *
+ * Each row gets its own scale, max(|row|) / 127, so that
+ * row[c] ~= quantized[c] * scale. Values behind cols are set to zero.
+ *
+ * @param values First element of the matrix
+ * @param row_stride Distance between two rows of the matrix
+ * @param col_stride Distance between two elements of a row
+ * @param rows Number of rows
+ * @param cols Number of elements per row
+ * @param quantized Output rows, PaddedCols(cols) values each
+ * @param scales Output scales, one per row
+ * @param threads Threads quantizing the rows
+ */
+void QuantizeRows(const float* values, size_t row_stride, size_t col_stride, uint32_t rows,
+                  uint32_t cols, int8_t* quantized, float* scales, uint32_t threads);
+
+/**
+ * @brief Weight matrix quantized to int8 with one scale per output channel
+ *
+ * The matrix is multiplied with activations that are quantized per row on
+ * the fly. Products are accumulated in int32 and rescaled to float once per
+ * output, so the weights are read with a quarter of the fp32 traffic and
+ * no calibration data is needed.
+ */
+class QuantizedMatrix {
+ public:
+  /**
+   * @brief Quantizes a dense matrix at build time
+   *
+   * @param rows Weights of every output channel, cols floats each
+   */
+  QuantizedMatrix(const std::vector<const float*>& rows, uint32_t cols);
+
+  /**
+   * @brief Multiplies the weights with quantized activations
+   *
+   * output[o * channel_stride + n] is the dot product of weight row o with
+   * activation row n, rescaled by both row scales.
+   *
+   * @param input Activations from QuantizeRows, PaddedCols(cols()) values per row
+   * @param input_scales Scales of the activation rows
+   * @param positions Number of activation rows
+   * @param output First output channel
+   * @param channel_stride Distance between two output channels
+   * @param threads Threads computing the output
+   */
+  void Multiply(const int8_t* input, const float* input_scales, uint32_t positions, float* output,
+                size_t channel_stride, uint32_t threads) const;
+
+  uint32_t rows() const { return rows_; }
+
+  uint32_t cols() const { return cols_; }
+
+  /**
+   * @brief Gets the memory of the quantized weights and scales in bytes
+   */
+  size_t memory_bytes() const;
+
+ private:
+  uint32_t rows_ = 0;
+  uint32_t cols_ = 0;
+  std::vector<int8_t> values_;
+  std::vector<float> scales_;
+};
+}  // namespace quant
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_SOURCE_LAYER_DETAILS_QUANTIZE_HPP_
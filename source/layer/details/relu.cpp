@@ -28,7 +28,13 @@ namespace kuiper_infer {
 StatusCode ReluLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                               std::vector<std::shared_ptr<Tensor<float>>>& outputs) {
   using namespace activation;
-  return ActivationForward(ActivationType::kActivationRelu, inputs, outputs);
+  return ActivationForward(ActivationType::kActivationRelu, inputs, outputs, *this);
+}
+
+StatusCode ReluLayer::ForwardViews(Span<const TensorView> inputs,
+                                   Span<const TensorView> outputs) {
+  using namespace activation;
+  return ActivationForward(ActivationType::kActivationRelu, inputs, outputs, *this);
 }
 
 StatusCode ReluLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
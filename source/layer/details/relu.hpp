@@ -31,6 +31,10 @@ class ReluLayer : public NonParamLayer {
   StatusCode Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                      std::vector<std::shared_ptr<Tensor<float>>>& outputs) override;
 
+  StatusCode ForwardViews(Span<const TensorView> inputs, Span<const TensorView> outputs) override;
+
+  bool supports_views() const override { return true; }
+
   static StatusCode CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                    std::shared_ptr<Layer<float>>& relu_layer);
 };
@@ -28,8 +28,15 @@ namespace kuiper_infer {
 StatusCode Relu6Layer::Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                                std::vector<std::shared_ptr<Tensor<float>>>& outputs) {
   using namespace activation;
-  return ActivationForward(ActivationType::kActivationRelu6, inputs, outputs);
+  return ActivationForward(ActivationType::kActivationRelu6, inputs, outputs, *this);
 }
+
+StatusCode Relu6Layer::ForwardViews(Span<const TensorView> inputs,
+                                    Span<const TensorView> outputs) {
+  using namespace activation;
+  return ActivationForward(ActivationType::kActivationRelu6, inputs, outputs, *this);
+}
+
 StatusCode Relu6Layer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                       std::shared_ptr<Layer<float>>& relu_layer) {
   if (!op) {
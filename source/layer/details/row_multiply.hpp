@@ -0,0 +1,71 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-7.
+
+#ifndef KUIPER_INFER_SOURCE_LAYER_DETAILS_ROW_MULTIPLY_HPP_
+#define KUIPER_INFER_SOURCE_LAYER_DETAILS_ROW_MULTIPLY_HPP_
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+namespace kuiper_infer {
+/// Output positions one task computes in a row, their input columns stay in L2
+constexpr uint32_t kRowMultiplyPositionTile = 64;
+
+/**
+ * @brief Computes a rows x positions output from a per-element dot product
+ *
+ * The positions are tiled first and the rows are split afterwards, so there
+ * are at least as many tasks as threads. Shared by the block-sparse and the
+ * int8 weight matrices.
+ *
+ * @param rows Number of output channels
+ * @param positions Number of output positions
+ * @param output First output channel
+ * @param channel_stride Distance between two output channels
+ * @param threads Threads computing the output
+ * @param dot Returns the output of a row at a position, dot(row, position)
+ */
+template <typename Dot>
+void MultiplyRows(uint32_t rows, uint32_t positions, float* output, size_t channel_stride,
+                  uint32_t threads, const Dot& dot) {
+  const uint32_t position_tiles =
+      (positions + kRowMultiplyPositionTile - 1) / kRowMultiplyPositionTile;
+  const uint32_t row_chunks =
+      std::max(1u, std::min(rows, (threads + position_tiles - 1) / std::max(position_tiles, 1u)));
+  const uint32_t chunk_rows = (rows + row_chunks - 1) / row_chunks;
+
+#pragma omp parallel for num_threads(threads)
+  for (uint32_t task = 0; task < position_tiles * row_chunks; ++task) {
+    const uint32_t position_begin = task / row_chunks * kRowMultiplyPositionTile;
+    const uint32_t position_end = std::min(position_begin + kRowMultiplyPositionTile, positions);
+    const uint32_t row_begin = task % row_chunks * chunk_rows;
+    const uint32_t row_end = std::min(row_begin + chunk_rows, rows);
+    for (uint32_t row = row_begin; row < row_end; ++row) {
+      float* output_channel = output + row * channel_stride;
+      for (uint32_t n = position_begin; n < position_end; ++n) {
+        output_channel[n] = dot(row, n);
+      }
+    }
+  }
+}
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_SOURCE_LAYER_DETAILS_ROW_MULTIPLY_HPP_
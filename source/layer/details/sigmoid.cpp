@@ -31,7 +31,13 @@ namespace kuiper_infer {
 StatusCode SigmoidLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                                  std::vector<std::shared_ptr<Tensor<float>>>& outputs) {
   using namespace activation;
-  return ActivationForward(ActivationType::kActivationSigmoid, inputs, outputs);
+  return ActivationForward(ActivationType::kActivationSigmoid, inputs, outputs, *this);
+}
+
+StatusCode SigmoidLayer::ForwardViews(Span<const TensorView> inputs,
+                                      Span<const TensorView> outputs) {
+  using namespace activation;
+  return ActivationForward(ActivationType::kActivationSigmoid, inputs, outputs, *this);
 }
 
 StatusCode SigmoidLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
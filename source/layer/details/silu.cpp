@@ -33,7 +33,13 @@ SiLULayer::SiLULayer() : NonParamLayer("SiLU") {}
 StatusCode SiLULayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                               std::vector<std::shared_ptr<Tensor<float>>>& outputs) {
   using namespace activation;
-  return ActivationForward(ActivationType::kActivationSilu, inputs, outputs);
+  return ActivationForward(ActivationType::kActivationSilu, inputs, outputs, *this);
+}
+
+StatusCode SiLULayer::ForwardViews(Span<const TensorView> inputs,
+                                   Span<const TensorView> outputs) {
+  using namespace activation;
+  return ActivationForward(ActivationType::kActivationSilu, inputs, outputs, *this);
 }
 
 StatusCode SiLULayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
@@ -23,6 +23,8 @@
 
 #include "softmax.hpp"
 #include <glog/logging.h>
+#include <algorithm>
+#include <array>
 #include <numeric>
 #include "data/tensor_util.hpp"
 #include "layer/abstract/layer_factory.hpp"
@@ -50,37 +52,35 @@ StatusCode SoftmaxLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>
   }
 
   const uint32_t batch_size = inputs.size();
-#pragma omp parallel for num_threads(batch_size)
+#pragma omp parallel for num_threads(this->batch_threads(batch_size))
   for (uint32_t i = 0; i < batch_size; ++i) {
     const std::shared_ptr<Tensor<float>>& input = inputs.at(i);
-    CHECK(input != nullptr && !input->empty())
+    LAYER_CHECK(input != nullptr && !input->empty())
         << "The input tensor array in the softmax layer has an empty tensor " << i << " th";
 
     std::shared_ptr<Tensor<float>> output = outputs.at(i);
     if (output == nullptr || output->empty()) {
-      output = std::make_shared<Tensor<float>>(input->shapes());
+      output = std::make_shared<Tensor<float>>(input->channels(), input->rows(), input->cols());
       outputs.at(i) = output;
     }
-    CHECK(input->shapes() == output->shapes())
+    LAYER_CHECK(TensorShapeIsSame(input, output))
         << "The input and output tensor shapes of the softmax layer do not "
            "match "
         << i << " th";
     int32_t dim = this->softmax_dim_;
-    std::vector<uint32_t> raw_shapes = input->raw_shapes();
+    const std::vector<uint32_t>& input_raw_shapes = input->raw_shapes();
 
     if (dim < 0) {
-      dim += int32_t(raw_shapes.size());
+      dim += int32_t(input_raw_shapes.size());
     }
 
-    if (dim < 0 || dim >= 3 || dim > raw_shapes.size()) {
+    if (dim < 0 || dim >= 3 || dim > input_raw_shapes.size()) {
       LOG(FATAL) << "Error softmax dimension, which need between 0 and 2, "
                     "but dimension is "
                  << dim;
     }
-    const uint32_t padding_size_num = 3 - raw_shapes.size();
-    for (uint32_t j = 0; j < padding_size_num; ++j) {
-      raw_shapes.push_back(1);
-    }
+    std::array<uint32_t, 3> raw_shapes{1, 1, 1};
+    std::copy(input_raw_shapes.begin(), input_raw_shapes.end(), raw_shapes.begin());
 
     /**
      * [...(inner size) dim ...(outer_size)
@@ -95,20 +95,31 @@ StatusCode SoftmaxLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>
 
     // dim轴数据的数量
     int32_t axis_sizes = static_cast<int32_t>(raw_shapes.at(dim));
-    CHECK_EQ(axis_sizes * outer_sizes * inner_sizes, input->size());
-
-    std::vector<float> output_values = input->values(true);
-#pragma omp parallel for collapse(2)
+    LAYER_CHECK(axis_sizes * outer_sizes * inner_sizes == input->size());
+
+    // 按行主序的下标直接访问输入和输出张量的存储，不再拷贝出中间数组
+    const uint32_t rows = input->rows();
+    const uint32_t cols = input->cols();
+    const uint32_t planes = rows * cols;
+    auto storage_index = [rows, cols, planes](uint32_t index) {
+      const uint32_t plane_offset = index % planes;
+      return index - plane_offset + (plane_offset % cols) * rows + plane_offset / cols;
+    };
+    const float* input_values = input->raw_ptr();
+    float* output_values = output->raw_ptr();
+#pragma omp parallel for collapse(2) num_threads(this->intra_threads())
     for (uint32_t outer_size = 0; outer_size < outer_sizes; ++outer_size) {
       for (uint32_t inner_size = 0; inner_size < inner_sizes; ++inner_size) {
         // 迭代当前dim中的数据，并找到其中的最大值
         float max_value = std::numeric_limits<float>::lowest();
         uint32_t base_index = outer_size * axis_sizes * inner_sizes + inner_size;
 
-        std::vector<float> tmp_storage(axis_sizes);
+        // 每个线程复用自己的缓冲区，容量足够时resize不会申请内存
+        thread_local std::vector<float> tmp_storage;
+        tmp_storage.resize(axis_sizes);
         for (uint32_t axis_size = 0; axis_size < axis_sizes; ++axis_size) {
           uint32_t index = base_index + axis_size * inner_sizes;
-          float cur_value = output_values.at(index);
+          float cur_value = input_values[storage_index(index)];
           if (cur_value > max_value) {
             max_value = cur_value;
           }
@@ -160,14 +171,21 @@ StatusCode SoftmaxLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>
         for (axis_size = 0; axis_size < axis_sizes; ++axis_size) {
           uint32_t index = base_index + axis_size * inner_sizes;
           float div_value = tmp_storage.at(axis_size);
-          output_values.at(index) = div_value;
+          output_values[storage_index(index)] = div_value;
         }
       }
     }
-    output->Fill(output_values, true);
   }
   return StatusCode::kSuccess;
 }
+LayerCost SoftmaxLayer::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                             const std::vector<int32_t>& output_shape) const {
+  LayerCost cost = Layer<float>::Cost(input_shapes, output_shape);
+  // 求最大值、减最大值后取指数、求和以及相除
+  cost.flops = 4. * ShapeElements(output_shape);
+  return cost;
+}
+
 StatusCode SoftmaxLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                         std::shared_ptr<Layer<float>>& softmax_layer) {
   if (!op) {
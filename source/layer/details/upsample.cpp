@@ -78,7 +78,7 @@ StatusCode UpSampleLayer::Forward(const std::vector<std::shared_ptr<Tensor<float
   }
 
   const uint32_t batch_size = inputs.size();
-#pragma omp parallel for num_threads(batch_size)
+#pragma omp parallel for num_threads(this->batch_threads(batch_size))
   for (uint32_t i = 0; i < batch_size; ++i) {
     const arma::fcube& input_data = inputs.at(i)->data();
     LOG_IF(FATAL, input_data.empty())
@@ -91,16 +91,16 @@ StatusCode UpSampleLayer::Forward(const std::vector<std::shared_ptr<Tensor<float
       outputs.at(i) = output;
     }
     auto& output_data = output->data();
-    CHECK(output_data.n_rows == std::floor(input_data.n_rows * scale_h_))
+    LAYER_CHECK(output_data.n_rows == std::floor(input_data.n_rows * scale_h_))
         << "The input and output tensor height of the upsample layer do not "
            "match "
         << i << "th";
-    CHECK(output_data.n_cols == std::floor(input_data.n_cols * scale_w_))
+    LAYER_CHECK(output_data.n_cols == std::floor(input_data.n_cols * scale_w_))
         << "The input and output tensor width of the upsample layer do not "
            "match "
         << i << "th";
 
-    CHECK(input_data.n_slices == output_data.n_slices)
+    LAYER_CHECK(input_data.n_slices == output_data.n_slices)
         << "The input and output tensor channel of the upsample layer do not "
            "match "
         << i << "th";
@@ -108,7 +108,7 @@ StatusCode UpSampleLayer::Forward(const std::vector<std::shared_ptr<Tensor<float
     const uint32_t channels = input_data.n_slices;
     switch (mode_) {
       case UpSampleMode::kModeNearest: {
-#pragma omp parallel for
+#pragma omp parallel for num_threads(this->intra_threads())
         for (uint32_t c = 0; c < channels; ++c) {
           const arma::fmat& input_channel = input_data.slice(c);
           arma::fmat& output_channel = output_data.slice(c);
@@ -141,7 +141,7 @@ StatusCode UpSampleLayer::Forward(const std::vector<std::shared_ptr<Tensor<float
         break;
       }
       case UpSampleMode::kModeBilinear: {
-#pragma omp parallel for
+#pragma omp parallel for num_threads(this->intra_threads())
         for (uint32_t c = 0; c < channels; ++c) {
           const arma::fmat& input_channel = input_data.slice(c);
           arma::fmat& output_channel = output_data.slice(c);
@@ -156,8 +156,8 @@ StatusCode UpSampleLayer::Forward(const std::vector<std::shared_ptr<Tensor<float
             div_scale_h = 1.f / scale_h_;
             div_scale_w = 1.f / scale_w_;
           } else {
-            CHECK(input_h > 0 && input_w > 0);
-            CHECK(output_h > 0 && output_w > 0);
+            LAYER_CHECK(input_h > 0 && input_w > 0);
+            LAYER_CHECK(output_h > 0 && output_w > 0);
 
             div_scale_h = static_cast<float>(input_h - 1) / static_cast<float>(output_h - 1);
             div_scale_w = static_cast<float>(input_w - 1) / static_cast<float>(output_w - 1);
@@ -200,6 +200,14 @@ StatusCode UpSampleLayer::Forward(const std::vector<std::shared_ptr<Tensor<float
   return StatusCode::kSuccess;
 }
 
+LayerCost UpSampleLayer::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                              const std::vector<int32_t>& output_shape) const {
+  LayerCost cost = Layer<float>::Cost(input_shapes, output_shape);
+  // 最近邻插值只复制数据，双线性插值每个输出元素做四次乘加
+  cost.flops = mode_ == UpSampleMode::kModeBilinear ? 8. * ShapeElements(output_shape) : 0.;
+  return cost;
+}
+
 StatusCode UpSampleLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                          std::shared_ptr<Layer<float>>& upsample_layer) {
   if (!op) {
@@ -22,6 +22,8 @@
 // Created by fss on 22-11-12.
 #include "view.hpp"
 #include <glog/logging.h>
+#include <algorithm>
+#include <array>
 #include "data/tensor_util.hpp"
 #include "layer/abstract/layer_factory.hpp"
 #include "runtime/runtime_ir.hpp"
@@ -60,8 +62,10 @@ StatusCode ViewLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>>&
     // 检查形状中-1的数量，最多只可以存在一个
     size_t current_size = 1;
     int32_t dynamic_index = -1;
-    std::vector<uint32_t> shapes;
+    std::array<uint32_t, 3> shapes{};
+    uint32_t shape_dims = 0;
     const size_t total_size = input_data->size();
+    CHECK_LE(shapes_.size() - 1, shapes.size());
     for (uint32_t j = 1; j < shapes_.size(); ++j) {
       CHECK(shapes_.at(j) == -1 || shapes_.at(j) > 0);
       if (shapes_.at(j) == -1) {
@@ -70,7 +74,7 @@ StatusCode ViewLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>>&
         dynamic_index = static_cast<int32_t>(j);
       } else {
         current_size *= shapes_.at(j);
-        shapes.push_back(shapes_.at(j));
+        shapes.at(shape_dims++) = shapes_.at(j);
       }
     }
 
@@ -79,19 +83,41 @@ StatusCode ViewLayer::Forward(const std::vector<std::shared_ptr<Tensor<float>>>&
            "dimension";
     if (dynamic_index != -1) {
       CHECK(total_size >= current_size);
-      shapes.push_back(uint32_t(total_size / current_size));
+      shapes.at(shape_dims++) = uint32_t(total_size / current_size);
     }
 
+    // 输出空间已经存在且形状一致时原地写入，保证后继算子绑定的输出张量不变并且不申请内存
     std::shared_ptr<Tensor<float>> output_data = outputs.at(i);
-    output_data = TensorClone(input_data);
+    if (output_data != nullptr && !output_data->empty() && output_data != input_data) {
+      const std::vector<uint32_t>& raw_shapes = output_data->raw_shapes();
+      if (std::equal(shapes.begin(), shapes.begin() + shape_dims, raw_shapes.begin(),
+                     raw_shapes.end())) {
+        output_data->CopyRowMajor(*input_data);
+        continue;
+      }
+    }
+
+    if (output_data == nullptr || output_data->empty()) {
+      output_data = TensorClone(input_data);
+      outputs.at(i) = output_data;
+    } else if (output_data != input_data) {
+      CHECK(input_data->size() == output_data->size());
+      output_data->data() = input_data->data();
+    }
     CHECK(input_data->size() == output_data->size());
-    outputs.at(i) = output_data;
 
-    output_data->Reshape(shapes, true);
+    output_data->Reshape(std::vector<uint32_t>(shapes.begin(), shapes.begin() + shape_dims), true);
   }
   return StatusCode::kSuccess;
 }
 
+LayerCost ViewLayer::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                          const std::vector<int32_t>& output_shape) const {
+  LayerCost cost = Layer<float>::Cost(input_shapes, output_shape);
+  cost.flops = 0.;
+  return cost;
+}
+
 StatusCode ViewLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                      std::shared_ptr<Layer<float>>& view_layer) {
   if (!op) {
@@ -0,0 +1,204 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-1.
+
+#include "window_kernel.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace kuiper_infer {
+namespace window {
+struct InnerRange {
+  uint32_t begin = 0;
+  uint32_t end = 0;
+};
+
+// 窗口完全落在输入内部、不需要补边的输出下标范围[begin, end)
+static InnerRange ComputeInnerRange(uint32_t input_size, uint32_t padding, uint32_t output_size,
+                                    uint32_t kernel, uint32_t stride) {
+  InnerRange range;
+  range.begin = std::min((padding + stride - 1) / stride, output_size);
+  if (input_size + padding >= kernel) {
+    range.end = std::min((input_size + padding - kernel) / stride + 1, output_size);
+  }
+  range.end = std::max(range.begin, range.end);
+  return range;
+}
+
+// 边界上的窗口逐个元素判断是否落在补边区域，补边区域填充pad_value
+template <uint32_t KH, uint32_t KW, uint32_t SH, uint32_t SW, typename Visit>
+static inline void VisitBorderWindow(const float* input, uint32_t input_h, uint32_t input_w,
+                                     uint32_t padding_h, uint32_t padding_w, uint32_t r,
+                                     uint32_t w, float pad_value, Visit visit) {
+  const int32_t ih = int32_t(r * SH) - int32_t(padding_h);
+  const int32_t iw = int32_t(w * SW) - int32_t(padding_w);
+  for (int32_t kw = 0; kw < int32_t(KW); ++kw) {
+    const int32_t x = iw + kw;
+    for (int32_t kh = 0; kh < int32_t(KH); ++kh) {
+      const int32_t y = ih + kh;
+      if (x >= 0 && x < int32_t(input_w) && y >= 0 && y < int32_t(input_h)) {
+        visit(kw * KH + kh, input[x * input_h + y]);
+      } else {
+        visit(kw * KH + kh, pad_value);
+      }
+    }
+  }
+}
+
+template <uint32_t KH, uint32_t KW, uint32_t SH, uint32_t SW>
+static void Im2ColChannel(const float* input, uint32_t input_h, uint32_t input_w,
+                          uint32_t padding_h, uint32_t padding_w, uint32_t output_h,
+                          uint32_t output_w, size_t col_stride, float* matrix) {
+  const InnerRange rows = ComputeInnerRange(input_h, padding_h, output_h, KH, SH);
+  const InnerRange cols = ComputeInnerRange(input_w, padding_w, output_w, KW, SW);
+  auto border = [&](uint32_t r, uint32_t w, float* matrix_ptr) {
+    VisitBorderWindow<KH, KW, SH, SW>(input, input_h, input_w, padding_h, padding_w, r, w, 0.f,
+                                      [matrix_ptr](uint32_t i, float v) { matrix_ptr[i] = v; });
+  };
+
+  for (uint32_t w = 0; w < output_w; ++w) {
+    float* col_ptr = matrix + size_t(w) * output_h * col_stride;
+    if (w < cols.begin || w >= cols.end) {
+      for (uint32_t r = 0; r < output_h; ++r) {
+        border(r, w, col_ptr + r * col_stride);
+      }
+      continue;
+    }
+
+    for (uint32_t r = 0; r < rows.begin; ++r) {
+      border(r, w, col_ptr + r * col_stride);
+    }
+    // 内部区域没有补边判断，窗口大小是编译期常量，内层循环可以完全展开
+    const float* input_col = input + size_t(w * SW - padding_w) * input_h;
+    for (uint32_t r = rows.begin; r < rows.end; ++r) {
+      const float* region_ptr = input_col + (r * SH - padding_h);
+      float* matrix_ptr = col_ptr + r * col_stride;
+      for (uint32_t kw = 0; kw < KW; ++kw) {
+        for (uint32_t kh = 0; kh < KH; ++kh) {
+          matrix_ptr[kw * KH + kh] = region_ptr[kw * input_h + kh];
+        }
+      }
+    }
+    for (uint32_t r = rows.end; r < output_h; ++r) {
+      border(r, w, col_ptr + r * col_stride);
+    }
+  }
+}
+
+template <uint32_t KH, uint32_t KW, uint32_t SH, uint32_t SW>
+static void MaxPoolingChannel(const float* input, uint32_t input_h, uint32_t input_w,
+                              uint32_t padding_h, uint32_t padding_w, uint32_t output_h,
+                              uint32_t output_w, float* output) {
+  const InnerRange rows = ComputeInnerRange(input_h, padding_h, output_h, KH, SH);
+  const InnerRange cols = ComputeInnerRange(input_w, padding_w, output_w, KW, SW);
+  auto border = [&](uint32_t r, uint32_t w) {
+    float max_value = std::numeric_limits<float>::lowest();
+    VisitBorderWindow<KH, KW, SH, SW>(
+        input, input_h, input_w, padding_h, padding_w, r, w, std::numeric_limits<float>::lowest(),
+        [&max_value](uint32_t, float v) { max_value = std::max(max_value, v); });
+    return max_value;
+  };
+
+  for (uint32_t w = 0; w < output_w; ++w) {
+    float* output_col = output + size_t(w) * output_h;
+    if (w < cols.begin || w >= cols.end) {
+      for (uint32_t r = 0; r < output_h; ++r) {
+        output_col[r] = border(r, w);
+      }
+      continue;
+    }
+
+    for (uint32_t r = 0; r < rows.begin; ++r) {
+      output_col[r] = border(r, w);
+    }
+    const float* input_col = input + size_t(w * SW - padding_w) * input_h;
+    for (uint32_t r = rows.begin; r < rows.end; ++r) {
+      const float* region_ptr = input_col + (r * SH - padding_h);
+      float max_value = region_ptr[0];
+      for (uint32_t kw = 0; kw < KW; ++kw) {
+        for (uint32_t kh = 0; kh < KH; ++kh) {
+          max_value = std::max(max_value, region_ptr[kw * input_h + kh]);
+        }
+      }
+      output_col[r] = max_value;
+    }
+    for (uint32_t r = rows.end; r < output_h; ++r) {
+      output_col[r] = border(r, w);
+    }
+  }
+}
+
+struct Im2ColEntry {
+  uint32_t kernel_h;
+  uint32_t kernel_w;
+  uint32_t stride_h;
+  uint32_t stride_w;
+  Im2ColFunc func;
+};
+
+// 模型中常见的卷积几何形状，1x1步长1不补边的卷积不需要im2col
+static const Im2ColEntry kIm2ColTable[] = {
+    {1, 1, 2, 2, Im2ColChannel<1, 1, 2, 2>}, {3, 3, 1, 1, Im2ColChannel<3, 3, 1, 1>},
+    {3, 3, 2, 2, Im2ColChannel<3, 3, 2, 2>}, {5, 5, 1, 1, Im2ColChannel<5, 5, 1, 1>},
+    {5, 5, 2, 2, Im2ColChannel<5, 5, 2, 2>}, {7, 7, 2, 2, Im2ColChannel<7, 7, 2, 2>},
+};
+
+struct MaxPoolingEntry {
+  uint32_t pooling_h;
+  uint32_t pooling_w;
+  uint32_t stride_h;
+  uint32_t stride_w;
+  MaxPoolingFunc func;
+};
+
+static const MaxPoolingEntry kMaxPoolingTable[] = {
+    {2, 2, 2, 2, MaxPoolingChannel<2, 2, 2, 2>}, {3, 3, 1, 1, MaxPoolingChannel<3, 3, 1, 1>},
+    {3, 3, 2, 2, MaxPoolingChannel<3, 3, 2, 2>}, {5, 5, 1, 1, MaxPoolingChannel<5, 5, 1, 1>},
+};
+
+Im2ColFunc SelectIm2Col(uint32_t kernel_h, uint32_t kernel_w, uint32_t stride_h,
+                        uint32_t stride_w, uint32_t dilation_h, uint32_t dilation_w) {
+  if (dilation_h != 1 || dilation_w != 1) {
+    return nullptr;
+  }
+  for (const Im2ColEntry& entry : kIm2ColTable) {
+    if (entry.kernel_h == kernel_h && entry.kernel_w == kernel_w && entry.stride_h == stride_h &&
+        entry.stride_w == stride_w) {
+      return entry.func;
+    }
+  }
+  return nullptr;
+}
+
+MaxPoolingFunc SelectMaxPooling(uint32_t pooling_h, uint32_t pooling_w, uint32_t stride_h,
+                                uint32_t stride_w) {
+  for (const MaxPoolingEntry& entry : kMaxPoolingTable) {
+    if (entry.pooling_h == pooling_h && entry.pooling_w == pooling_w &&
+        entry.stride_h == stride_h && entry.stride_w == stride_w) {
+      return entry.func;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace window
+}  // namespace kuiper_infer
@@ -0,0 +1,67 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-1.
+
+#ifndef KUIPER_INFER_SOURCE_LAYER_DETAILS_WINDOW_KERNEL_HPP_
+#define KUIPER_INFER_SOURCE_LAYER_DETAILS_WINDOW_KERNEL_HPP_
+#include <cstddef>
+#include <cstdint>
+namespace kuiper_infer {
+namespace window {
+/**
+ * @brief Im2col kernel of one channel
+ *
+ * Writes the kh * kw window of every output position to one column of the
+ * im2col matrix, columns are ordered by output column and then output row.
+ */
+using Im2ColFunc = void (*)(const float* input, uint32_t input_h, uint32_t input_w,
+                            uint32_t padding_h, uint32_t padding_w, uint32_t output_h,
+                            uint32_t output_w, size_t col_stride, float* matrix);
+
+/**
+ * @brief Max pooling kernel of one channel
+ */
+using MaxPoolingFunc = void (*)(const float* input, uint32_t input_h, uint32_t input_w,
+                                uint32_t padding_h, uint32_t padding_w, uint32_t output_h,
+                                uint32_t output_w, float* output);
+
+/**
+ * @brief Gets the im2col kernel specialized for a window geometry
+ *
+ * @return The specialized kernel, nullptr if the geometry has none and the
+ * generic path should be used
+ */
+Im2ColFunc SelectIm2Col(uint32_t kernel_h, uint32_t kernel_w, uint32_t stride_h,
+                        uint32_t stride_w, uint32_t dilation_h, uint32_t dilation_w);
+
+/**
+ * @brief Gets the max pooling kernel specialized for a window geometry
+ *
+ * @return The specialized kernel, nullptr if the geometry has none and the
+ * generic path should be used
+ */
+MaxPoolingFunc SelectMaxPooling(uint32_t pooling_h, uint32_t pooling_w, uint32_t stride_h,
+                                uint32_t stride_w);
+
+}  // namespace window
+}  // namespace kuiper_infer
+#endif  // KUIPER_INFER_SOURCE_LAYER_DETAILS_WINDOW_KERNEL_HPP_
@@ -67,7 +67,14 @@ StatusCode YoloDetectLayer::Forward(const std::vector<std::shared_ptr<Tensor<flo
       << "The yolo detect layer do not have appropriate number of convolution "
          "operations";
 
-  std::vector<std::vector<std::shared_ptr<Tensor<float>>>> batches(stages);
+  // 各阶段的输入、卷积输出和中间结果都保存在层内，多次推理之间复用
+  stage_inputs_.resize(stages);
+  stage_outputs_.resize(stages);
+  stage_reshaped_.resize(stages);
+  stage_tensors_.resize(stages);
+  for (uint32_t stage = 0; stage < stages; ++stage) {
+    stage_inputs_.at(stage).clear();
+  }
   for (uint32_t i = 0; i < input_size; ++i) {
     const uint32_t index = i / batch_size;
     const auto& input_data = inputs.at(i);
@@ -77,19 +84,19 @@ StatusCode YoloDetectLayer::Forward(const std::vector<std::shared_ptr<Tensor<flo
                  << i << "th";
       return StatusCode::kInferInputsEmpty;
     }
-    CHECK(index <= batches.size());
-    batches.at(index).push_back(input_data);
+    CHECK(index <= stage_inputs_.size());
+    stage_inputs_.at(index).push_back(input_data);
   }
 
-  std::vector<std::vector<sftensor>> stage_outputs(stages);
   for (uint32_t stage = 0; stage < stages; ++stage) {
-    const std::vector<std::shared_ptr<Tensor<float>>>& stage_input = batches.at(stage);
+    const std::vector<std::shared_ptr<Tensor<float>>>& stage_input = stage_inputs_.at(stage);
 
     CHECK(stage_input.size() == batch_size)
         << "The number of stage input in the yolo detect layer should be equal "
            "to batch size";
 
-    std::vector<std::shared_ptr<Tensor<float>>> stage_output(batch_size);
+    std::vector<std::shared_ptr<Tensor<float>>>& stage_output = stage_outputs_.at(stage);
+    stage_output.resize(batch_size);
     const auto status = this->conv_layers_.at(stage)->Forward(stage_input, stage_output);
 
     CHECK(status == StatusCode::kSuccess)
@@ -99,35 +106,43 @@ StatusCode YoloDetectLayer::Forward(const std::vector<std::shared_ptr<Tensor<flo
     CHECK(stage_output.size() == batch_size)
         << "The number of stage output in the yolo detect layer should be "
            "equal to batch size";
-    stage_outputs.at(stage) = stage_output;
   }
 
-  std::vector<sftensor> stage_tensors;
   uint32_t concat_rows = 0;
   for (uint32_t stage = 0; stage < stages; ++stage) {
-    const std::vector<sftensor> stage_output = stage_outputs.at(stage);
+    const std::vector<sftensor>& stage_output = stage_outputs_.at(stage);
     const uint32_t nx = stage_output.front()->rows();
     const uint32_t ny = stage_output.front()->cols();
     for (uint32_t i = 0; i < stage_output.size(); ++i) {
-      CHECK(stage_output.at(i)->rows() == nx && stage_output.at(i)->cols() == ny);
+      LAYER_CHECK(stage_output[i]->rows() == nx && stage_output[i]->cols() == ny);
     }
 
-    std::shared_ptr<Tensor<float>> stages_tensor =
-        TensorCreate<float>(batch_size, stages * nx * ny, uint32_t(num_classes_ + 5));
-    stage_tensors.push_back(stages_tensor);
+    std::shared_ptr<Tensor<float>>& stages_tensor = stage_tensors_.at(stage);
+    if (stages_tensor == nullptr || stages_tensor->channels() != batch_size ||
+        stages_tensor->rows() != stages * nx * ny || stages_tensor->cols() != classes_info) {
+      stages_tensor = TensorCreate<float>(batch_size, stages * nx * ny, classes_info);
+    }
 
-#pragma omp parallel for num_threads(batch_size)
+    std::vector<sftensor>& stage_reshaped = stage_reshaped_.at(stage);
+    stage_reshaped.resize(batch_size);
+#pragma omp parallel for num_threads(this->batch_threads(batch_size))
     for (uint32_t b = 0; b < batch_size; ++b) {
-      const std::shared_ptr<Tensor<float>>& input = stage_output.at(b);
-      CHECK(input != nullptr && !input->empty());
-      CHECK_EQ(input->rows(), nx);
-      CHECK_EQ(input->cols(), ny);
-      input->Reshape({stages, uint32_t(classes_info), ny * nx}, true);
-
-      CHECK_EQ(stages_tensor->channels(), batch_size);
-      CHECK_EQ(stages_tensor->rows(), stages_ * nx * ny);
-      CHECK_EQ(stages_tensor->cols(), classes_info);
+      const std::shared_ptr<Tensor<float>>& stage_input = stage_output[b];
+      LAYER_CHECK(stage_input != nullptr && !stage_input->empty());
+      LAYER_CHECK(stage_input->rows() == nx);
+      LAYER_CHECK(stage_input->cols() == ny);
+
+      // 按行主序重排到预先申请好的张量中，不修改卷积层的输出空间
+      std::shared_ptr<Tensor<float>>& input = stage_reshaped[b];
+      if (input == nullptr || input->channels() != stages || input->rows() != classes_info ||
+          input->cols() != ny * nx) {
+        input = TensorCreate<float>(stages, classes_info, ny * nx);
+      }
+      input->CopyRowMajor(*stage_input);
 
+      LAYER_CHECK(stages_tensor->channels() == batch_size);
+      LAYER_CHECK(stages_tensor->rows() == stages_ * nx * ny);
+      LAYER_CHECK(stages_tensor->cols() == classes_info);
       using namespace kuiper_infer::activation;
       ApplySSEActivation(ActivationType::kActivationSigmoid)(input, input);
       const arma::fcube& input_data = input->data();
@@ -138,10 +153,22 @@ StatusCode YoloDetectLayer::Forward(const std::vector<std::shared_ptr<Tensor<flo
             input_data.slice(na).t();
       }
 
-      auto xy = x_stages.submat(0, 0, x_stages.n_rows - 1, 1);
-      auto wh = x_stages.submat(0, 2, x_stages.n_rows - 1, 3);
-      xy = (xy * 2 + grids_[stage]) * strides_[stage];
-      wh = arma::pow((wh * 2), 2) % anchor_grids_[stage];
+      // xy = (xy * 2 + grid) * stride, wh = (wh * 2)^2 * anchor_grid，逐元素原地计算
+      const arma::fmat& grid = grids_[stage];
+      const arma::fmat& anchor_grid = anchor_grids_[stage];
+      LAYER_CHECK(grid.n_rows == x_stages.n_rows && anchor_grid.n_rows == x_stages.n_rows);
+      const float stride = strides_[stage];
+      for (uint32_t col = 0; col < 2; ++col) {
+        float* xy_ptr = x_stages.colptr(col);
+        float* wh_ptr = x_stages.colptr(col + 2);
+        const float* grid_ptr = grid.colptr(col);
+        const float* anchor_grid_ptr = anchor_grid.colptr(col);
+        for (uint32_t row = 0; row < x_stages.n_rows; ++row) {
+          xy_ptr[row] = (xy_ptr[row] * 2.f + grid_ptr[row]) * stride;
+          const float wh_value = wh_ptr[row] * 2.f;
+          wh_ptr[row] = wh_value * wh_value * anchor_grid_ptr[row];
+        }
+      }
     }
     concat_rows += stages_tensor->rows();
   }
@@ -153,7 +180,7 @@ StatusCode YoloDetectLayer::Forward(const std::vector<std::shared_ptr<Tensor<flo
       outputs.at(i) = output;
     }
     uint32_t current_rows = 0;
-    for (std::shared_ptr<ftensor> stages_tensor : stage_tensors) {
+    for (const std::shared_ptr<ftensor>& stages_tensor : stage_tensors_) {
       arma::fcube& output_data = output->data();
       output_data.subcube(current_rows, 0, 0, current_rows + stages_tensor->rows() - 1,
                           classes_info - 1, 0) = stages_tensor->slice(i);
@@ -163,6 +190,39 @@ StatusCode YoloDetectLayer::Forward(const std::vector<std::shared_ptr<Tensor<flo
   return StatusCode::kSuccess;
 }
 
+void YoloDetectLayer::set_checked(bool checked) {
+  Layer<float>::set_checked(checked);
+  for (const auto& conv_layer : conv_layers_) {
+    conv_layer->set_checked(checked);
+  }
+}
+
+void YoloDetectLayer::set_parallel_plan(const ParallelPlan& parallel_plan) {
+  Layer<float>::set_parallel_plan(parallel_plan);
+  for (const auto& conv_layer : conv_layers_) {
+    conv_layer->set_parallel_plan(parallel_plan);
+  }
+}
+
+LayerCost YoloDetectLayer::Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                                const std::vector<int32_t>& output_shape) const {
+  LayerCost cost = Layer<float>::Cost(input_shapes, output_shape);
+  // 检测头中每个阶段的1x1卷积，输出与输入的空间尺寸相同
+  for (uint32_t stage = 0; stage < conv_layers_.size() && stage < input_shapes.size(); ++stage) {
+    std::vector<int32_t> stage_shape = input_shapes.at(stage);
+    if (stage_shape.size() != 4) {
+      continue;
+    }
+    stage_shape.at(1) = int32_t(conv_layers_.at(stage)->weights().size());
+    const LayerCost stage_cost =
+        conv_layers_.at(stage)->Cost({input_shapes.at(stage)}, stage_shape);
+    cost.flops += stage_cost.flops;
+    cost.parameters += stage_cost.parameters;
+    cost.weight_bytes += stage_cost.weight_bytes;
+  }
+  return cost;
+}
+
 StatusCode YoloDetectLayer::CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                            std::shared_ptr<Layer<float>>& yolo_detect_layer) {
   if (!op) {
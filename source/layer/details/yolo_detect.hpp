@@ -37,6 +37,13 @@ class YoloDetectLayer : public Layer<float> {
   StatusCode Forward(const std::vector<std::shared_ptr<Tensor<float>>>& inputs,
                      std::vector<std::shared_ptr<Tensor<float>>>& outputs) override;
 
+  LayerCost Cost(const std::vector<std::vector<int32_t>>& input_shapes,
+                 const std::vector<int32_t>& output_shape) const override;
+
+  void set_checked(bool checked) override;
+
+  void set_parallel_plan(const ParallelPlan& parallel_plan) override;
+
   static StatusCode CreateInstance(const std::shared_ptr<RuntimeOperator>& op,
                                    std::shared_ptr<Layer<float>>& yolo_detect_layer);
 
@@ -48,6 +55,12 @@ class YoloDetectLayer : public Layer<float> {
   std::vector<arma::fmat> anchor_grids_;
   std::vector<arma::fmat> grids_;
   std::vector<std::shared_ptr<ConvolutionLayer>> conv_layers_;
+
+  /// 以下张量在多次推理之间复用，稳态推理时不再申请内存
+  std::vector<std::vector<sftensor>> stage_inputs_;
+  std::vector<std::vector<sftensor>> stage_outputs_;
+  std::vector<std::vector<sftensor>> stage_reshaped_;
+  std::vector<sftensor> stage_tensors_;
 };
 }  // namespace kuiper_infer
 #endif  // KUIPER_INFER_SOURCE_LAYER_DETAILS_YOLO_DETECT_HPP_
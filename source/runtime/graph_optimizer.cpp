@@ -0,0 +1,428 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-27.
+
+#include "runtime/graph_optimizer.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <set>
+#include "../layer/details/activation.hpp"
+
+namespace kuiper_infer {
+
+namespace {
+const std::set<std::string> kIdentityTypes = {"nn.Identity", "nn.Dropout",  "nn.Dropout2d",
+                                              "F.dropout",   "torch.clone", "Tensor.contiguous"};
+
+const std::set<std::string> kReshapeTypes = {"Tensor.view", "Tensor.reshape", "torch.flatten"};
+
+std::vector<float> AttributeToFloat(const pnnx::Attribute& attr) {
+  CHECK_EQ(attr.type, 1) << "Only the float32 attribute is supported";
+  std::vector<float> values(attr.data.size() / sizeof(float));
+  std::memcpy(values.data(), attr.data.data(), values.size() * sizeof(float));
+  return values;
+}
+
+pnnx::Attribute FloatToAttribute(const std::vector<int>& shape, const std::vector<float>& values) {
+  pnnx::Attribute attr;
+  attr.type = 1;
+  attr.shape = shape;
+  attr.data.resize(values.size() * sizeof(float));
+  std::memcpy(attr.data.data(), values.data(), attr.data.size());
+  return attr;
+}
+
+bool IsStaticShape(const std::vector<int>& shape) {
+  return !shape.empty() &&
+         std::all_of(shape.begin(), shape.end(), [](int dim) { return dim > 0; });
+}
+
+// 算子唯一的输出只被一个算子使用时返回该使用者
+pnnx::Operator* SingleConsumer(const pnnx::Operator* op) {
+  if (op->outputs.size() != 1 || op->outputs.front()->consumers.size() != 1) {
+    return nullptr;
+  }
+  return op->outputs.front()->consumers.front();
+}
+
+int IntParam(const pnnx::Operator* op, const std::string& name) {
+  const auto iter = op->params.find(name);
+  return iter != op->params.end() && iter->second.type == 2 ? iter->second.i : -1;
+}
+
+std::vector<int> IntArrayParam(const pnnx::Operator* op, const std::string& name) {
+  const auto iter = op->params.find(name);
+  if (iter == op->params.end() || iter->second.type != 5) {
+    return {};
+  }
+  return iter->second.ai;
+}
+
+// 卷积的偏置，不存在时为全零
+std::vector<float> ConvBias(const pnnx::Operator* conv, int out_channels) {
+  const auto bias_param = conv->params.find("bias");
+  if (bias_param != conv->params.end() && bias_param->second.b && conv->attrs.count("bias")) {
+    return AttributeToFloat(conv->attrs.at("bias"));
+  }
+  return std::vector<float>(out_channels, 0.f);
+}
+
+bool IsZeroPaddingConv(const pnnx::Operator* conv) {
+  const auto padding_mode = conv->params.find("padding_mode");
+  return conv->type == "nn.Conv2d" && conv->attrs.count("weight") &&
+         conv->attrs.at("weight").type == 1 &&
+         (padding_mode == conv->params.end() || padding_mode->second.s == "zeros");
+}
+}  // namespace
+
+GraphOptimizer::GraphOptimizer(pnnx::Graph& graph) : graph_(graph) {}
+
+std::vector<GraphPassStats> GraphOptimizer::Optimize() {
+  using Pass = std::pair<std::string, std::function<uint32_t()>>;
+  const std::vector<Pass> passes = {
+      {"eliminate_identity", [this]() { return EliminateIdentity(); }},
+      {"fold_constant_shape", [this]() { return FoldConstantShape(); }},
+      {"fold_batch_norm", [this]() { return FoldBatchNorm(); }},
+      {"fuse_activation", [this]() { return FuseActivation(); }},
+      {"fuse_depthwise_pointwise", [this]() { return FuseDepthwisePointwise(); }},
+      {"eliminate_dead_code", [this]() { return EliminateDeadCode(); }},
+  };
+
+  std::vector<GraphPassStats> pass_stats;
+  for (const auto& [pass_name, pass] : passes) {
+    GraphPassStats stats;
+    stats.pass_name = pass_name;
+    stats.ops_before = graph_.ops.size();
+    const auto start_time = std::chrono::steady_clock::now();
+    stats.rewrites = pass();
+    const auto end_time = std::chrono::steady_clock::now();
+    stats.elapsed_time =
+        std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    stats.ops_after = graph_.ops.size();
+    pass_stats.push_back(stats);
+  }
+  return pass_stats;
+}
+
+uint32_t GraphOptimizer::EliminateIdentity() {
+  uint32_t rewrites = 0;
+  const std::vector<pnnx::Operator*> ops = graph_.ops;
+  for (pnnx::Operator* op : ops) {
+    if (op->inputs.empty() || op->outputs.size() != 1) {
+      continue;
+    }
+    pnnx::Operand* input = op->inputs.front();
+    pnnx::Operand* output = op->outputs.front();
+    bool is_identity = kIdentityTypes.count(op->type) != 0;
+    if (kReshapeTypes.count(op->type) && op->inputs.size() == 1) {
+      is_identity = IsStaticShape(input->shape) && input->shape == output->shape;
+    }
+    if (!is_identity) {
+      continue;
+    }
+    ReplaceOperandUses(output, input);
+    RemoveOperator(op);
+    rewrites += 1;
+  }
+  return rewrites;
+}
+
+uint32_t GraphOptimizer::FoldBatchNorm() {
+  uint32_t rewrites = 0;
+  const std::vector<pnnx::Operator*> ops = graph_.ops;
+  std::set<pnnx::Operator*> removed_ops;
+  for (pnnx::Operator* conv : ops) {
+    if (removed_ops.count(conv) || conv->type != "nn.Conv2d" || conv->params.count("activation")) {
+      continue;
+    }
+    pnnx::Operator* bn = SingleConsumer(conv);
+    if (bn == nullptr || bn->type != "nn.BatchNorm2d" || bn->inputs.size() != 1 ||
+        bn->outputs.size() != 1 || !bn->attrs.count("running_mean") ||
+        !bn->attrs.count("running_var") || !conv->attrs.count("weight")) {
+      continue;
+    }
+
+    const pnnx::Attribute& weight_attr = conv->attrs.at("weight");
+    if (weight_attr.type != 1 || weight_attr.shape.empty()) {
+      continue;
+    }
+    const int out_channels = weight_attr.shape.front();
+    std::vector<float> weight = AttributeToFloat(weight_attr);
+    const std::vector<float> mean = AttributeToFloat(bn->attrs.at("running_mean"));
+    const std::vector<float> var = AttributeToFloat(bn->attrs.at("running_var"));
+    std::vector<float> gamma(out_channels, 1.f);
+    std::vector<float> beta(out_channels, 0.f);
+    if (bn->attrs.count("weight") && bn->attrs.count("bias")) {
+      gamma = AttributeToFloat(bn->attrs.at("weight"));
+      beta = AttributeToFloat(bn->attrs.at("bias"));
+    }
+    std::vector<float> bias(out_channels, 0.f);
+    const auto bias_param = conv->params.find("bias");
+    if (bias_param != conv->params.end() && bias_param->second.b && conv->attrs.count("bias")) {
+      bias = AttributeToFloat(conv->attrs.at("bias"));
+    }
+    const size_t channels = out_channels;
+    if (mean.size() != channels || var.size() != channels || gamma.size() != channels ||
+        beta.size() != channels || bias.size() != channels || weight.size() % channels != 0) {
+      LOG(WARNING) << "Skip folding " << bn->name << " for the mismatched channels";
+      continue;
+    }
+
+    float eps = 1e-5f;
+    const auto eps_param = bn->params.find("eps");
+    if (eps_param != bn->params.end()) {
+      eps = eps_param->second.f;
+    }
+
+    // 折叠后 w' = w * gamma / sqrt(var + eps), b' = (b - mean) * gamma / sqrt(var + eps) + beta
+    const size_t kernel_size = weight.size() / out_channels;
+    for (int k = 0; k < out_channels; ++k) {
+      const float scale = gamma.at(k) / std::sqrt(var.at(k) + eps);
+      float* kernel_ptr = weight.data() + k * kernel_size;
+      for (size_t i = 0; i < kernel_size; ++i) {
+        kernel_ptr[i] *= scale;
+      }
+      bias.at(k) = (bias.at(k) - mean.at(k)) * scale + beta.at(k);
+    }
+    conv->attrs["weight"] = FloatToAttribute(weight_attr.shape, weight);
+    conv->attrs["bias"] = FloatToAttribute({out_channels}, bias);
+    conv->params["bias"] = pnnx::Parameter(true);
+
+    MergeIntoProducer(conv, bn);
+    removed_ops.insert(bn);
+    rewrites += 1;
+  }
+  return rewrites;
+}
+
+uint32_t GraphOptimizer::FuseActivation() {
+  uint32_t rewrites = 0;
+  const std::vector<pnnx::Operator*> ops = graph_.ops;
+  std::set<pnnx::Operator*> removed_ops;
+  for (pnnx::Operator* conv : ops) {
+    if (removed_ops.count(conv) ||
+        (conv->type != "nn.Conv2d" && conv->type != "nn.ConvTranspose2d") ||
+        conv->params.count("activation")) {
+      continue;
+    }
+    pnnx::Operator* activation_op = SingleConsumer(conv);
+    if (activation_op == nullptr || activation_op->inputs.size() != 1 ||
+        activation_op->outputs.size() != 1 ||
+        activation::OpTypeToActivationType(activation_op->type) ==
+            activation::ActivationType::kActivatetionUnknown) {
+      continue;
+    }
+
+    conv->params["activation"] = pnnx::Parameter(activation_op->type);
+    MergeIntoProducer(conv, activation_op);
+    removed_ops.insert(activation_op);
+    rewrites += 1;
+  }
+  return rewrites;
+}
+
+uint32_t GraphOptimizer::FuseDepthwisePointwise() {
+  uint32_t rewrites = 0;
+  const std::vector<pnnx::Operator*> ops = graph_.ops;
+  std::set<pnnx::Operator*> removed_ops;
+  for (pnnx::Operator* depthwise : ops) {
+    if (removed_ops.count(depthwise) || !IsZeroPaddingConv(depthwise) ||
+        depthwise->inputs.size() != 1) {
+      continue;
+    }
+    const int channels = IntParam(depthwise, "in_channels");
+    const std::vector<int> kernel_size = IntArrayParam(depthwise, "kernel_size");
+    const std::vector<int> padding = IntArrayParam(depthwise, "padding");
+    const std::vector<int> stride = IntArrayParam(depthwise, "stride");
+    const std::vector<int> dilation = IntArrayParam(depthwise, "dilation");
+    if (channels <= 0 || IntParam(depthwise, "groups") != channels ||
+        IntParam(depthwise, "out_channels") != channels || kernel_size.size() != 2 ||
+        padding.size() != 2 || stride.size() != 2 || dilation != std::vector<int>{1, 1}) {
+      continue;
+    }
+
+    pnnx::Operator* pointwise = SingleConsumer(depthwise);
+    if (pointwise == nullptr || !IsZeroPaddingConv(pointwise) || pointwise->inputs.size() != 1 ||
+        pointwise->outputs.size() != 1 || IntParam(pointwise, "in_channels") != channels ||
+        IntParam(pointwise, "groups") != 1 ||
+        IntArrayParam(pointwise, "kernel_size") != std::vector<int>{1, 1} ||
+        IntArrayParam(pointwise, "stride") != std::vector<int>{1, 1} ||
+        IntArrayParam(pointwise, "padding") != std::vector<int>{0, 0}) {
+      continue;
+    }
+    const int out_channels = IntParam(pointwise, "out_channels");
+    const std::vector<float> depthwise_weight = AttributeToFloat(depthwise->attrs.at("weight"));
+    const std::vector<float> depthwise_bias = ConvBias(depthwise, channels);
+    const std::vector<float> pointwise_weight = AttributeToFloat(pointwise->attrs.at("weight"));
+    const std::vector<float> pointwise_bias = ConvBias(pointwise, out_channels);
+    if (out_channels <= 0 ||
+        depthwise_weight.size() != size_t(channels) * kernel_size[0] * kernel_size[1] ||
+        depthwise_bias.size() != size_t(channels) ||
+        pointwise_weight.size() != size_t(out_channels) * channels ||
+        pointwise_bias.size() != size_t(out_channels)) {
+      LOG(WARNING) << "Skip fusing " << depthwise->name << " for the mismatched weights";
+      continue;
+    }
+
+    // 深度卷积算子改写为融合算子，两个卷积的激活函数分别保留
+    std::map<std::string, pnnx::Parameter> params;
+    params["channels"] = pnnx::Parameter(channels);
+    params["out_channels"] = pnnx::Parameter(out_channels);
+    params["kernel_size"] = pnnx::Parameter(kernel_size);
+    params["padding"] = pnnx::Parameter(padding);
+    params["stride"] = pnnx::Parameter(stride);
+    if (depthwise->params.count("activation")) {
+      params["dw_activation"] = depthwise->params.at("activation");
+    }
+    if (pointwise->params.count("activation")) {
+      params["activation"] = pointwise->params.at("activation");
+    }
+
+    std::map<std::string, pnnx::Attribute> attrs;
+    attrs["dw_weight"] = FloatToAttribute({channels, 1, kernel_size[0], kernel_size[1]},
+                                          depthwise_weight);
+    attrs["dw_bias"] = FloatToAttribute({channels}, depthwise_bias);
+    attrs["weight"] = FloatToAttribute({out_channels, channels, 1, 1}, pointwise_weight);
+    attrs["bias"] = FloatToAttribute({out_channels}, pointwise_bias);
+
+    depthwise->type = "kuiper.DepthwisePointwise";
+    depthwise->params = std::move(params);
+    depthwise->attrs = std::move(attrs);
+    MergeIntoProducer(depthwise, pointwise);
+    removed_ops.insert(pointwise);
+    rewrites += 1;
+  }
+  return rewrites;
+}
+
+uint32_t GraphOptimizer::FoldConstantShape() {
+  uint32_t rewrites = 0;
+  const std::vector<pnnx::Operator*> ops = graph_.ops;
+  std::set<pnnx::Operator*> removed_ops;
+  for (pnnx::Operator* op : ops) {
+    if (removed_ops.count(op) || !kReshapeTypes.count(op->type) || op->inputs.size() != 1 ||
+        op->outputs.size() != 1 || !IsStaticShape(op->outputs.front()->shape)) {
+      continue;
+    }
+    pnnx::Operand* input = op->inputs.front();
+    pnnx::Operator* producer = input->producer;
+    if (producer == nullptr || !kReshapeTypes.count(producer->type) ||
+        producer->inputs.size() != 1 || SingleConsumer(producer) != op) {
+      continue;
+    }
+
+    // 连续的形状变换只保留最后一个，形状在导出时已经确定
+    pnnx::Operand* producer_input = producer->inputs.front();
+    input->remove_consumer(op);
+    producer_input->consumers.push_back(op);
+    op->inputs.front() = producer_input;
+    op->type = "Tensor.view";
+    op->params.clear();
+    op->params["shape"] = pnnx::Parameter(op->outputs.front()->shape);
+
+    RemoveOperator(producer);
+    removed_ops.insert(producer);
+    rewrites += 1;
+  }
+  return rewrites;
+}
+
+uint32_t GraphOptimizer::EliminateDeadCode() {
+  uint32_t rewrites = 0;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    const std::vector<pnnx::Operator*> ops = graph_.ops;
+    for (pnnx::Operator* op : ops) {
+      if (op->type == "pnnx.Input" || op->type == "pnnx.Output" || op->outputs.empty()) {
+        continue;
+      }
+      const bool is_dead =
+          std::all_of(op->outputs.begin(), op->outputs.end(),
+                      [](const pnnx::Operand* output) { return output->consumers.empty(); });
+      if (is_dead) {
+        RemoveOperator(op);
+        rewrites += 1;
+        changed = true;
+      }
+    }
+  }
+  return rewrites;
+}
+
+void GraphOptimizer::ReplaceOperandUses(pnnx::Operand* from, pnnx::Operand* to) {
+  for (pnnx::Operator* consumer : from->consumers) {
+    for (pnnx::Operand*& input : consumer->inputs) {
+      if (input == from) {
+        input = to;
+      }
+    }
+    to->consumers.push_back(consumer);
+  }
+  from->consumers.clear();
+}
+
+void GraphOptimizer::MergeIntoProducer(pnnx::Operator* producer, pnnx::Operator* consumer) {
+  CHECK_EQ(producer->outputs.size(), 1);
+  CHECK_EQ(consumer->outputs.size(), 1);
+  pnnx::Operand* middle = producer->outputs.front();
+  pnnx::Operand* output = consumer->outputs.front();
+  middle->remove_consumer(consumer);
+  CHECK(middle->consumers.empty());
+
+  producer->outputs.front() = output;
+  output->producer = producer;
+  middle->producer = nullptr;
+  consumer->inputs.clear();
+  consumer->outputs.clear();
+
+  RemoveOperand(middle);
+  graph_.ops.erase(std::find(graph_.ops.begin(), graph_.ops.end(), consumer));
+  delete consumer;
+}
+
+void GraphOptimizer::RemoveOperator(pnnx::Operator* op) {
+  for (pnnx::Operand* input : op->inputs) {
+    auto& consumers = input->consumers;
+    consumers.erase(std::remove(consumers.begin(), consumers.end(), op), consumers.end());
+  }
+  for (pnnx::Operand* output : op->outputs) {
+    CHECK(output->consumers.empty()) << "The output of " << op->name << " is still in use";
+    output->producer = nullptr;
+    RemoveOperand(output);
+  }
+  graph_.ops.erase(std::find(graph_.ops.begin(), graph_.ops.end(), op));
+  delete op;
+}
+
+void GraphOptimizer::RemoveOperand(pnnx::Operand* operand) {
+  CHECK(operand->producer == nullptr && operand->consumers.empty());
+  graph_.operands.erase(std::find(graph_.operands.begin(), graph_.operands.end(), operand));
+  delete operand;
+}
+
+}  // namespace kuiper_infer
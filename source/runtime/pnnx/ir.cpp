@@ -13,11 +13,13 @@
 // specific language governing permissions and limitations under the License.
 
 #include "runtime/pnnx/ir.h"
+#include <ctype.h>
 #include <limits.h>
 #include <stdint.h>
 #include <string.h>
 #include <algorithm>
 #include <fstream>
+#include <map>
 #include <sstream>
 #include <stack>
 #include <string>
@@ -1858,6 +1860,597 @@ int Graph::python(const std::string& pypath, const std::string& pnnxbinpath) {
   return 0;
 }
 
+static std::string cpp_identifier(const std::string& s) {
+  std::string ss = s;
+  for (size_t i = 0; i < ss.size(); i++) {
+    if (!isalnum((unsigned char)ss[i])) ss[i] = '_';
+  }
+
+  return ss;
+}
+
+static std::string cpp_string_literal(const std::string& s) {
+  std::string ss = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') ss += '\\';
+    ss += c;
+  }
+  ss += "\"";
+
+  return ss;
+}
+
+static std::string cpp_shape(const std::vector<int>& shape) {
+  std::string ss = "{";
+  for (size_t i = 0; i < shape.size(); i++) {
+    ss += std::to_string(shape[i]);
+    if (i + 1 != shape.size()) ss += ", ";
+  }
+  ss += "}";
+
+  return ss;
+}
+
+// same encoding as the param file, decoded by Parameter::parse_from_string
+static std::string parameter_to_string(const Parameter& param) {
+  char buf[64];
+  std::string ss;
+  if (param.type == 0) {
+    ss = "None";
+  }
+  if (param.type == 1) {
+    ss = param.b ? "True" : "False";
+  }
+  if (param.type == 2) {
+    ss = std::to_string(param.i);
+  }
+  if (param.type == 3) {
+    snprintf(buf, sizeof(buf), "%e", param.f);
+    ss = buf;
+  }
+  if (param.type == 4) {
+    ss = param.s;
+  }
+  if (param.type == 5) {
+    ss = "(";
+    for (size_t i = 0; i < param.ai.size(); i++) {
+      ss += std::to_string(param.ai[i]);
+      if (i + 1 != param.ai.size()) ss += ",";
+    }
+    ss += ")";
+  }
+  if (param.type == 6) {
+    ss = "(";
+    for (size_t i = 0; i < param.af.size(); i++) {
+      snprintf(buf, sizeof(buf), "%e", param.af[i]);
+      ss += buf;
+      if (i + 1 != param.af.size()) ss += ",";
+    }
+    ss += ")";
+  }
+  if (param.type == 7) {
+    ss = "(";
+    for (size_t i = 0; i < param.as.size(); i++) {
+      ss += param.as[i];
+      if (i + 1 != param.as.size()) ss += ",";
+    }
+    ss += ")";
+  }
+
+  return ss;
+}
+
+// specialized kernel of an operator, with every shape as a template argument
+struct CppKernel {
+  std::string call;
+  std::vector<std::pair<std::string, size_t> > attrs;
+  size_t scratch_size = 0;
+};
+
+static bool cpp_param_ints(const Operator* op, const std::string& key, std::vector<int>& values) {
+  if (op->params.find(key) == op->params.end()) return false;
+
+  const Parameter& param = op->params.at(key);
+  if (param.type != 5 || param.ai.size() != values.size()) return false;
+
+  values = param.ai;
+  return true;
+}
+
+static bool cpp_param_is(const Operator* op, const std::string& key, const Parameter& value) {
+  if (op->params.find(key) == op->params.end()) return true;
+
+  return parameter_to_string(op->params.at(key)) == parameter_to_string(value);
+}
+
+static const char* cpp_activation(const std::string& type) {
+  if (type == "nn.ReLU") return "aot::Activation::kRelu";
+  if (type == "nn.ReLU6") return "aot::Activation::kRelu6";
+  if (type == "nn.Sigmoid") return "aot::Activation::kSigmoid";
+  if (type == "nn.SiLU") return "aot::Activation::kSilu";
+  if (type == "nn.Hardsigmoid") return "aot::Activation::kHardSigmoid";
+  if (type == "nn.Hardswish") return "aot::Activation::kHardSwish";
+
+  return 0;
+}
+
+static size_t cpp_elements(const std::vector<int>& shape) {
+  size_t size = 1;
+  for (int dim : shape) size *= dim;
+
+  return size;
+}
+
+static std::string cpp_template_args(const std::vector<int>& args) {
+  std::string ss;
+  for (size_t i = 0; i < args.size(); i++) {
+    ss += std::to_string(args[i]);
+    if (i + 1 != args.size()) ss += ", ";
+  }
+
+  return ss;
+}
+
+// weights of a kernel must be f32 and hold exactly size floats
+static bool cpp_kernel_attr(const Operator* op, const std::string& name, size_t size,
+                            CppKernel& kernel) {
+  if (op->attrs.find(name) == op->attrs.end()) return false;
+
+  const Attribute& attr = op->attrs.at(name);
+  if (attr.type != 1 || cpp_elements(attr.shape) != size) return false;
+
+  kernel.attrs.push_back(std::make_pair(name, size));
+  return true;
+}
+
+static std::string cpp_kernel_weight(const Operator* op, const std::string& name) {
+  return cpp_identifier(op->name) + "_" + name + "_.data()";
+}
+
+// emits the call of a kernel specialized on the constant shapes of the operator, false if the
+// operator goes through the layer factory instead
+static bool cpp_kernel(const Operator* op, const std::map<const Operand*, size_t>& offsets,
+                       CppKernel& kernel) {
+  const std::vector<int>& out_shape = op->outputs[0]->shape;
+  std::vector<std::string> args;
+  for (const Operand* r : op->inputs) {
+    args.push_back("arena + " + std::to_string(offsets.at(r)));
+  }
+  const std::string output = "arena + " + std::to_string(offsets.at(op->outputs[0]));
+
+  if (op->type == "nn.Conv2d" && op->inputs.size() == 1 && out_shape.size() == 4) {
+    const std::vector<int>& in_shape = op->inputs[0]->shape;
+    std::vector<int> kernel_size(2), stride(2), padding(2), dilation(2, 1);
+    if (in_shape.size() != 4 || !cpp_param_ints(op, "kernel_size", kernel_size) ||
+        !cpp_param_ints(op, "stride", stride) || !cpp_param_ints(op, "padding", padding))
+      return false;
+    if (op->params.find("dilation") != op->params.end() &&
+        !cpp_param_ints(op, "dilation", dilation))
+      return false;
+    if (!cpp_param_is(op, "padding_mode", Parameter("zeros"))) return false;
+    if (op->params.find("groups") == op->params.end() || op->params.at("groups").type != 2)
+      return false;
+
+    const int groups = op->params.at("groups").i;
+    const int channels = in_shape[1];
+    const int out_channels = out_shape[1];
+    if (groups <= 0 || channels % groups != 0 || out_channels % groups != 0) return false;
+
+    const char* activation = "aot::Activation::kNone";
+    if (op->params.find("activation") != op->params.end()) {
+      activation = cpp_activation(op->params.at("activation").s);
+      if (!activation) return false;
+    }
+
+    const int out_h =
+        (in_shape[2] + 2 * padding[0] - dilation[0] * (kernel_size[0] - 1) - 1) / stride[0] + 1;
+    const int out_w =
+        (in_shape[3] + 2 * padding[1] - dilation[1] * (kernel_size[1] - 1) - 1) / stride[1] + 1;
+    if (out_h != out_shape[2] || out_w != out_shape[3]) return false;
+
+    const size_t kernel_elements = (size_t)channels / groups * kernel_size[0] * kernel_size[1];
+    if (!cpp_kernel_attr(op, "weight", kernel_elements * out_channels, kernel)) return false;
+
+    const bool has_bias = op->attrs.find("bias") != op->attrs.end();
+    if (has_bias && !cpp_kernel_attr(op, "bias", out_channels, kernel)) return false;
+
+    const bool depthwise = channels == groups && out_channels == groups;
+    const bool pointwise = kernel_size[0] == 1 && kernel_size[1] == 1 && stride[0] == 1 &&
+                           stride[1] == 1 && padding[0] == 0 && padding[1] == 0;
+    if (!depthwise && !pointwise) kernel.scratch_size = kernel_elements * out_h * out_w;
+
+    kernel.call = "aot::Conv2d<" +
+                  cpp_template_args({in_shape[0], channels, in_shape[2], in_shape[3],
+                                     out_channels, kernel_size[0], kernel_size[1], stride[0],
+                                     stride[1], padding[0], padding[1], dilation[0], dilation[1],
+                                     groups}) +
+                  ", " + activation + ">(" + args[0] + ", " + cpp_kernel_weight(op, "weight") +
+                  ", " + (has_bias ? cpp_kernel_weight(op, "bias") : std::string("nullptr")) +
+                  ", " + output + ", scratch_.data())";
+    return true;
+  }
+
+  if (op->type == "nn.MaxPool2d" && op->inputs.size() == 1 && out_shape.size() == 4) {
+    const std::vector<int>& in_shape = op->inputs[0]->shape;
+    std::vector<int> kernel_size(2), stride(2), padding(2);
+    if (in_shape.size() != 4 || !cpp_param_ints(op, "kernel_size", kernel_size) ||
+        !cpp_param_ints(op, "stride", stride) || !cpp_param_ints(op, "padding", padding))
+      return false;
+    if (!cpp_param_is(op, "dilation", Parameter{1, 1}) ||
+        !cpp_param_is(op, "ceil_mode", Parameter(false)) ||
+        !cpp_param_is(op, "return_indices", Parameter(false)))
+      return false;
+
+    const int out_h = (in_shape[2] + 2 * padding[0] - kernel_size[0]) / stride[0] + 1;
+    const int out_w = (in_shape[3] + 2 * padding[1] - kernel_size[1]) / stride[1] + 1;
+    if (out_h != out_shape[2] || out_w != out_shape[3]) return false;
+
+    kernel.call = "aot::MaxPool2d<" +
+                  cpp_template_args({in_shape[0], in_shape[1], in_shape[2], in_shape[3],
+                                     kernel_size[0], kernel_size[1], stride[0], stride[1],
+                                     padding[0], padding[1]}) +
+                  ">(" + args[0] + ", " + output + ")";
+    return true;
+  }
+
+  if (op->type == "nn.AdaptiveAvgPool2d" && op->inputs.size() == 1 && out_shape.size() == 4) {
+    const std::vector<int>& in_shape = op->inputs[0]->shape;
+    std::vector<int> output_size(2);
+    if (in_shape.size() != 4 || !cpp_param_ints(op, "output_size", output_size)) return false;
+    if (output_size[0] != 1 || output_size[1] != 1 || out_shape[2] != 1 || out_shape[3] != 1)
+      return false;
+
+    kernel.call = "aot::GlobalAvgPool2d<" +
+                  cpp_template_args({in_shape[0], in_shape[1], in_shape[2], in_shape[3]}) +
+                  ">(" + args[0] + ", " + output + ")";
+    return true;
+  }
+
+  if (op->type == "torch.flatten" && op->inputs.size() == 1 && out_shape.size() == 2) {
+    const std::vector<int>& in_shape = op->inputs[0]->shape;
+    if (in_shape.size() != 4 || !cpp_param_is(op, "start_dim", Parameter(1))) return false;
+    if (!cpp_param_is(op, "end_dim", Parameter(-1)) && !cpp_param_is(op, "end_dim", Parameter(3)))
+      return false;
+
+    kernel.call = "aot::Flatten<" +
+                  cpp_template_args({in_shape[0], in_shape[1], in_shape[2], in_shape[3]}) +
+                  ">(" + args[0] + ", " + output + ")";
+    return true;
+  }
+
+  if (op->type == "nn.Linear" && op->inputs.size() == 1 && out_shape.size() == 2) {
+    const std::vector<int>& in_shape = op->inputs[0]->shape;
+    if (in_shape.size() != 2 || in_shape[0] != out_shape[0]) return false;
+    if (!cpp_kernel_attr(op, "weight", (size_t)in_shape[1] * out_shape[1], kernel)) return false;
+
+    const bool has_bias = op->attrs.find("bias") != op->attrs.end();
+    if (has_bias && !cpp_kernel_attr(op, "bias", out_shape[1], kernel)) return false;
+
+    kernel.call = "aot::Linear<" + cpp_template_args({in_shape[0], in_shape[1], out_shape[1]}) +
+                  ">(" + args[0] + ", " + cpp_kernel_weight(op, "weight") + ", " +
+                  (has_bias ? cpp_kernel_weight(op, "bias") : std::string("nullptr")) + ", " +
+                  output + ")";
+    return true;
+  }
+
+  if (cpp_activation(op->type) && op->inputs.size() == 1 && op->inputs[0]->shape == out_shape) {
+    kernel.call = "aot::Activate<" + std::to_string(cpp_elements(out_shape)) + ", " +
+                  cpp_activation(op->type) + ">(" + args[0] + ", " + output + ")";
+    return true;
+  }
+
+  if (op->type == "pnnx.Expression" && op->params.find("expr") != op->params.end() &&
+      op->inputs.size() == 2 && op->inputs[0]->shape == out_shape &&
+      op->inputs[1]->shape == out_shape) {
+    const std::string& expr = op->params.at("expr").s;
+    std::string function;
+    if (expr == "add(@0,@1)") function = "aot::Add<";
+    if (expr == "mul(@0,@1)") function = "aot::Mul<";
+    if (function.empty()) return false;
+
+    kernel.call = function + std::to_string(cpp_elements(out_shape)) + ">(" + args[0] + ", " +
+                  args[1] + ", " + output + ")";
+    return true;
+  }
+
+  return false;
+}
+
+int Graph::cpp(const std::string& cpppath, const std::string& binpath) {
+  // every operand needs a static shape to get a fixed place in the arena
+  for (const Operand* r : operands) {
+    if (r->shape.size() < 2 || r->shape.size() > 4) {
+      fprintf(stderr, "operand %s has unsupported rank %d\n", r->name.c_str(),
+              (int)r->shape.size());
+      return -1;
+    }
+    for (int dim : r->shape) {
+      if (dim <= 0) {
+        fprintf(stderr, "operand %s has a dynamic shape\n", r->name.c_str());
+        return -1;
+      }
+    }
+  }
+
+  std::vector<const Operator*> layer_ops;
+  std::vector<const Operand*> input_operands;
+  std::vector<const Operand*> output_operands;
+  for (const Operator* op : ops) {
+    if (op->type == "pnnx.Input") {
+      input_operands.insert(input_operands.end(), op->outputs.begin(), op->outputs.end());
+    } else if (op->type == "pnnx.Output") {
+      output_operands.insert(output_operands.end(), op->inputs.begin(), op->inputs.end());
+    } else {
+      if (op->outputs.size() != 1) {
+        fprintf(stderr, "operator %s has %d outputs\n", op->name.c_str(),
+                (int)op->outputs.size());
+        return -1;
+      }
+      layer_ops.push_back(op);
+    }
+  }
+
+  // lifetime of an operand: from its producer to its last consumer, graph outputs live to the end
+  const int op_count = (int)ops.size();
+  std::map<const Operand*, int> first_use;
+  std::map<const Operand*, int> last_use;
+  for (int i = 0; i < op_count; i++) {
+    for (const Operand* r : ops[i]->outputs) {
+      first_use[r] = i;
+      last_use[r] = i;
+    }
+  }
+  for (int i = 0; i < op_count; i++) {
+    for (const Operand* r : ops[i]->inputs) {
+      last_use[r] = ops[i]->type == "pnnx.Output" ? op_count : std::max(last_use[r], i);
+    }
+  }
+
+  // first fit placement, offsets and sizes aligned to 16 floats
+  struct Block {
+    size_t offset;
+    size_t size;
+    int last_use;
+  };
+  std::vector<Block> live_blocks;
+  std::map<const Operand*, size_t> offsets;
+  size_t arena_size = 0;
+  for (int i = 0; i < op_count; i++) {
+    for (const Operand* r : ops[i]->outputs) {
+      live_blocks.erase(std::remove_if(live_blocks.begin(), live_blocks.end(),
+                                       [i](const Block& block) { return block.last_use < i; }),
+                        live_blocks.end());
+      std::sort(live_blocks.begin(), live_blocks.end(),
+                [](const Block& a, const Block& b) { return a.offset < b.offset; });
+
+      size_t size = 1;
+      for (int dim : r->shape) size *= dim;
+      size = (size + 15) / 16 * 16;
+
+      size_t offset = 0;
+      for (const Block& block : live_blocks) {
+        if (offset + size <= block.offset) break;
+        offset = std::max(offset, block.offset + block.size);
+      }
+
+      offsets[r] = offset;
+      live_blocks.push_back({offset, size, last_use[r]});
+      arena_size = std::max(arena_size, offset + size);
+    }
+  }
+
+  // operators with a specialized kernel read the arena directly, the rest use the layer factory
+  std::map<const Operator*, CppKernel> kernels;
+  size_t scratch_size = 0;
+  for (const Operator* op : layer_ops) {
+    CppKernel kernel;
+    if (!cpp_kernel(op, offsets, kernel)) continue;
+
+    scratch_size = std::max(scratch_size, kernel.scratch_size);
+    kernels[op] = kernel;
+  }
+
+  FILE* cppfp = fopen(cpppath.c_str(), "wb");
+  if (!cppfp) {
+    fprintf(stderr, "fopen %s failed\n", cpppath.c_str());
+    return -1;
+  }
+
+  fprintf(cppfp, "// generated by kuiper_aot, do not edit\n");
+  fprintf(cppfp, "#include <glog/logging.h>\n");
+  fprintf(cppfp, "#include <algorithm>\n");
+  fprintf(cppfp, "#include <chrono>\n");
+  fprintf(cppfp, "#include <cstdio>\n");
+  fprintf(cppfp, "#include <cstdlib>\n");
+  fprintf(cppfp, "#include \"data/npy.hpp\"\n");
+  fprintf(cppfp, "#include \"runtime/runtime_aot.hpp\"\n");
+  fprintf(cppfp, "#include \"runtime/runtime_aot_kernels.hpp\"\n");
+  fprintf(cppfp, "\n");
+  fprintf(cppfp, "namespace kuiper_aot {\n");
+  fprintf(cppfp, "using namespace kuiper_infer;\n");
+  fprintf(cppfp, "\n");
+  fprintf(cppfp, "class Model {\n");
+  fprintf(cppfp, " public:\n");
+  fprintf(cppfp, "  static constexpr size_t kArenaSize = %zu;\n", arena_size);
+  fprintf(cppfp, "  static constexpr size_t kScratchSize = %zu;\n", scratch_size);
+  fprintf(cppfp, "  static constexpr size_t kInputCount = %d;\n", (int)input_operands.size());
+  fprintf(cppfp, "  static constexpr size_t kOutputCount = %d;\n", (int)output_operands.size());
+  fprintf(cppfp, "\n");
+  fprintf(cppfp, "  static constexpr const char* kBinPath = %s;\n",
+          cpp_string_literal(binpath).c_str());
+  fprintf(cppfp, "\n");
+  fprintf(cppfp, "  explicit Model(const std::string& bin_path = kBinPath)\n");
+  fprintf(cppfp, "      : arena_(kArenaSize), scratch_(kScratchSize) {\n");
+  fprintf(cppfp, "    AotLoader loader(bin_path);\n");
+
+  // weights of the specialized kernels and layers of the other operators
+  for (const Operator* op : layer_ops) {
+    if (kernels.find(op) != kernels.end()) {
+      for (const auto& attr : kernels[op].attrs) {
+        fprintf(cppfp, "    %s_%s_ = loader.ReadAttribute(%s, %s, %zu);\n",
+                cpp_identifier(op->name).c_str(), attr.first.c_str(),
+                cpp_string_literal(op->name).c_str(), cpp_string_literal(attr.first).c_str(),
+                attr.second);
+      }
+      continue;
+    }
+
+    fprintf(cppfp, "    {\n");
+    fprintf(cppfp, "      AotOperator op;\n");
+    fprintf(cppfp, "      op.type = %s;\n", cpp_string_literal(op->type).c_str());
+    fprintf(cppfp, "      op.name = %s;\n", cpp_string_literal(op->name).c_str());
+    for (const auto& it : op->params) {
+      fprintf(cppfp, "      op.params.emplace_back(%s, %s);\n",
+              cpp_string_literal(it.first).c_str(),
+              cpp_string_literal(parameter_to_string(it.second)).c_str());
+    }
+    for (const auto& it : op->attrs) {
+      fprintf(cppfp, "      op.attrs.push_back({%s, %d, %s});\n",
+              cpp_string_literal(it.first).c_str(), it.second.type,
+              cpp_shape(it.second.shape).c_str());
+    }
+    for (const Operand* r : op->inputs) {
+      fprintf(cppfp, "      op.input_shapes.push_back(%s);\n", cpp_shape(r->shape).c_str());
+    }
+    fprintf(cppfp, "      op.output_shape = %s;\n", cpp_shape(op->outputs[0]->shape).c_str());
+    fprintf(cppfp, "      layer_%s_ = loader.CreateLayer(op);\n",
+            cpp_identifier(op->name).c_str());
+    fprintf(cppfp, "    }\n");
+  }
+
+  fprintf(cppfp, "\n");
+
+  // operands
+  for (const Operand* r : operands) {
+    if (offsets.find(r) == offsets.end()) continue;
+
+    fprintf(cppfp, "    operand_%s_ = arena_.Tensors(%zu, %s);\n",
+            cpp_identifier(r->name).c_str(), offsets[r], cpp_shape(r->shape).c_str());
+  }
+
+  // layer inputs
+  for (const Operator* op : layer_ops) {
+    if (kernels.find(op) != kernels.end()) continue;
+
+    fprintf(cppfp, "    inputs_%s_ = AotConcat({", cpp_identifier(op->name).c_str());
+    for (size_t i = 0; i < op->inputs.size(); i++) {
+      fprintf(cppfp, "operand_%s_", cpp_identifier(op->inputs[i]->name).c_str());
+      if (i + 1 != op->inputs.size()) fprintf(cppfp, ", ");
+    }
+    fprintf(cppfp, "});\n");
+  }
+
+  fprintf(cppfp, "  }\n");
+  fprintf(cppfp, "\n");
+
+  // forward
+  fprintf(cppfp, "  void Forward() {\n");
+  if (!kernels.empty()) fprintf(cppfp, "    float* arena = arena_.data();\n");
+  for (const Operator* op : layer_ops) {
+    if (kernels.find(op) != kernels.end()) {
+      fprintf(cppfp, "    %s;\n", kernels[op].call.c_str());
+      continue;
+    }
+
+    const std::string name = cpp_identifier(op->name);
+    fprintf(cppfp, "    CHECK(layer_%s_->Forward(inputs_%s_, operand_%s_) == StatusCode::kSuccess)\n",
+            name.c_str(), name.c_str(), cpp_identifier(op->outputs[0]->name).c_str());
+    fprintf(cppfp, "        << %s;\n", cpp_string_literal(op->name).c_str());
+  }
+  fprintf(cppfp, "  }\n");
+  fprintf(cppfp, "\n");
+
+  fprintf(cppfp, "  std::vector<sftensor>& input(size_t index) {\n");
+  fprintf(cppfp, "    CHECK_LT(index, kInputCount) << \"Input index out of range\";\n");
+  fprintf(cppfp, "    std::vector<sftensor>* operands[] = {");
+  for (size_t i = 0; i < input_operands.size(); i++) {
+    fprintf(cppfp, "&operand_%s_", cpp_identifier(input_operands[i]->name).c_str());
+    if (i + 1 != input_operands.size()) fprintf(cppfp, ", ");
+  }
+  fprintf(cppfp, "};\n");
+  fprintf(cppfp, "    return *operands[index];\n");
+  fprintf(cppfp, "  }\n");
+  fprintf(cppfp, "\n");
+
+  fprintf(cppfp, "  std::vector<sftensor>& output(size_t index) {\n");
+  fprintf(cppfp, "    CHECK_LT(index, kOutputCount) << \"Output index out of range\";\n");
+  fprintf(cppfp, "    std::vector<sftensor>* operands[] = {");
+  for (size_t i = 0; i < output_operands.size(); i++) {
+    fprintf(cppfp, "&operand_%s_", cpp_identifier(output_operands[i]->name).c_str());
+    if (i + 1 != output_operands.size()) fprintf(cppfp, ", ");
+  }
+  fprintf(cppfp, "};\n");
+  fprintf(cppfp, "    return *operands[index];\n");
+  fprintf(cppfp, "  }\n");
+  fprintf(cppfp, "\n");
+
+  fprintf(cppfp, " private:\n");
+  fprintf(cppfp, "  AotArena arena_;\n");
+  fprintf(cppfp, "  std::vector<float> scratch_;\n");
+  for (const Operator* op : layer_ops) {
+    if (kernels.find(op) == kernels.end()) continue;
+
+    for (const auto& attr : kernels[op].attrs) {
+      fprintf(cppfp, "  std::vector<float> %s_%s_;\n", cpp_identifier(op->name).c_str(),
+              attr.first.c_str());
+    }
+  }
+  for (const Operator* op : layer_ops) {
+    if (kernels.find(op) != kernels.end()) continue;
+
+    fprintf(cppfp, "  std::shared_ptr<Layer<float>> layer_%s_;\n", cpp_identifier(op->name).c_str());
+  }
+  for (const Operator* op : layer_ops) {
+    if (kernels.find(op) != kernels.end()) continue;
+
+    fprintf(cppfp, "  std::vector<sftensor> inputs_%s_;\n", cpp_identifier(op->name).c_str());
+  }
+  for (const Operand* r : operands) {
+    if (offsets.find(r) == offsets.end()) continue;
+
+    fprintf(cppfp, "  std::vector<sftensor> operand_%s_;\n", cpp_identifier(r->name).c_str());
+  }
+  fprintf(cppfp, "};\n");
+  fprintf(cppfp, "}  // namespace kuiper_aot\n");
+  fprintf(cppfp, "\n");
+
+  // standalone executable timing the forward pass
+  fprintf(cppfp, "#ifdef KUIPER_AOT_MAIN\n");
+  fprintf(cppfp, "int main(int argc, char** argv) {\n");
+  fprintf(cppfp, "  kuiper_aot::Model model(argc > 1 ? argv[1] : kuiper_aot::Model::kBinPath);\n");
+  fprintf(cppfp, "  if (argc > 4) {\n");
+  fprintf(cppfp, "    // argv[3] holds one sample of the first input, copied into every sample\n");
+  fprintf(cppfp, "    using kuiper_infer::NpyDataLoader;\n");
+  fprintf(cppfp, "    const kuiper_infer::NpyArray input = NpyDataLoader::Load(argv[3]);\n");
+  fprintf(cppfp, "    CHECK(!input.empty()) << \"Can not read the input \" << argv[3];\n");
+  fprintf(cppfp, "    for (const kuiper_infer::sftensor& sample : model.input(0)) {\n");
+  fprintf(cppfp, "      input.CopyTo(*sample);\n");
+  fprintf(cppfp, "    }\n");
+  fprintf(cppfp, "    model.Forward();\n");
+  fprintf(cppfp, "    // argv[4] receives the first sample of the first output\n");
+  fprintf(cppfp, "    return NpyDataLoader::Save(argv[4], *model.output(0).front()) ? 0 : 1;\n");
+  fprintf(cppfp, "  }\n");
+  fprintf(cppfp, "\n");
+  fprintf(cppfp, "  const int iterations = argc > 2 ? atoi(argv[2]) : 10;\n");
+  fprintf(cppfp, "  model.Forward();\n");
+  fprintf(cppfp, "  const auto start = std::chrono::steady_clock::now();\n");
+  fprintf(cppfp, "  for (int i = 0; i < iterations; ++i) {\n");
+  fprintf(cppfp, "    model.Forward();\n");
+  fprintf(cppfp, "  }\n");
+  fprintf(cppfp, "  const std::chrono::duration<double, std::milli> elapsed =\n");
+  fprintf(cppfp, "      std::chrono::steady_clock::now() - start;\n");
+  fprintf(cppfp, "  printf(\"arena %%zu bytes, %%.3f ms per forward\\n\",\n");
+  fprintf(cppfp, "         kuiper_aot::Model::kArenaSize * sizeof(float),\n");
+  fprintf(cppfp, "         elapsed.count() / std::max(iterations, 1));\n");
+  fprintf(cppfp, "  return 0;\n");
+  fprintf(cppfp, "}\n");
+  fprintf(cppfp, "#endif  // KUIPER_AOT_MAIN\n");
+
+  fclose(cppfp);
+
+  return 0;
+}
+
 int Graph::parse(const std::string& param) {
   std::istringstream is(param);
   if (!is.good()) {
@@ -15,6 +15,7 @@
 #include "runtime/pnnx/store_zip.hpp"
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <map>
 #include <string>
 #include <vector>
@@ -125,28 +126,49 @@ int StoreZipReader::open(const std::string& path) {
         return -1;
       }
 
-      if (lfh.compression != 0 || lfh.compressed_size != lfh.uncompressed_size) {
-        fprintf(stderr, "not stored zip file %d %d\n", lfh.compressed_size, lfh.uncompressed_size);
-        return -1;
-      }
-
       // file name
       std::string name;
       name.resize(lfh.file_name_length);
       fread((char*)name.data(), name.size(), 1, fp);
 
-      // skip extra field
-      fseek(fp, lfh.extra_field_length, SEEK_CUR);
+      // extra field, numpy writes the sizes into the zip64 record
+      uint64_t compressed_size = lfh.compressed_size;
+      uint64_t uncompressed_size = lfh.uncompressed_size;
+      std::vector<char> extra(lfh.extra_field_length);
+      fread(extra.data(), extra.size(), 1, fp);
+      for (size_t i = 0; i + 4 <= extra.size();) {
+        uint16_t header_id = 0;
+        uint16_t data_size = 0;
+        memcpy(&header_id, extra.data() + i, 2);
+        memcpy(&data_size, extra.data() + i + 2, 2);
+        if (header_id == 0x0001 && i + 4 + data_size <= extra.size()) {
+          size_t field = i + 4;
+          if (lfh.uncompressed_size == 0xffffffff && field + 8 <= i + 4 + data_size) {
+            memcpy(&uncompressed_size, extra.data() + field, 8);
+            field += 8;
+          }
+          if (lfh.compressed_size == 0xffffffff && field + 8 <= i + 4 + data_size) {
+            memcpy(&compressed_size, extra.data() + field, 8);
+          }
+        }
+        i += 4 + data_size;
+      }
+
+      if (lfh.compression != 0 || compressed_size != uncompressed_size) {
+        fprintf(stderr, "not stored zip file %lu %lu\n", (unsigned long)compressed_size,
+                (unsigned long)uncompressed_size);
+        return -1;
+      }
 
       StoreZipMeta fm;
       fm.offset = ftell(fp);
-      fm.size = lfh.compressed_size;
+      fm.size = compressed_size;
 
       filemetas[name] = fm;
 
       //             fprintf(stderr, "%s = %d  %d\n", name.c_str(), fm.offset, fm.size);
 
-      fseek(fp, lfh.compressed_size, SEEK_CUR);
+      fseek(fp, compressed_size, SEEK_CUR);
     } else if (signature == 0x02014b50) {
       central_directory_file_header cdfh;
       fread((char*)&cdfh, sizeof(cdfh), 1, fp);
@@ -183,6 +205,24 @@ size_t StoreZipReader::get_file_size(const std::string& name) {
   return filemetas[name].size;
 }
 
+size_t StoreZipReader::get_file_offset(const std::string& name) {
+  if (filemetas.find(name) == filemetas.end()) {
+    fprintf(stderr, "no such file %s\n", name.c_str());
+    return 0;
+  }
+
+  return filemetas[name].offset;
+}
+
+std::vector<std::string> StoreZipReader::get_names() const {
+  std::vector<std::string> names;
+  for (const auto& filemeta : filemetas) {
+    names.push_back(filemeta.first);
+  }
+
+  return names;
+}
+
 int StoreZipReader::read_file(const std::string& name, char* data) {
   if (filemetas.find(name) == filemetas.end()) {
     fprintf(stderr, "no such file %s\n", name.c_str());
@@ -0,0 +1,134 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-31.
+
+#include "runtime/runtime_aot.hpp"
+#include <glog/logging.h>
+#include <omp.h>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include "runtime/runtime_ir.hpp"
+#include "runtime/runtime_parallel.hpp"
+
+namespace kuiper_infer {
+
+static float* AllocateArena(size_t size) {
+  // 按64字节对齐，大小向上取整到对齐的倍数
+  const size_t bytes = std::max<size_t>((size * sizeof(float) + 63) / 64 * 64, 64);
+  float* data = static_cast<float*>(std::aligned_alloc(64, bytes));
+  CHECK(data != nullptr) << "Failed to allocate the arena of " << bytes << " bytes";
+  std::memset(data, 0, bytes);
+  return data;
+}
+
+AotArena::AotArena(size_t size) : size_(size), data_(AllocateArena(size), std::free) {}
+
+std::vector<sftensor> AotArena::Tensors(size_t offset, const std::vector<int32_t>& shape) {
+  CHECK(shape.size() >= 2 && shape.size() <= 4) << "Unsupported operand dimension: "
+                                                 << shape.size();
+  CHECK_EQ(offset % 16, 0) << "The operand offset is not aligned to 64 bytes";
+  std::array<uint32_t, 3> dims{1, 1, 1};
+  std::copy(shape.begin() + 1, shape.end(), dims.end() - (shape.size() - 1));
+  const auto [channels, rows, cols] = dims;
+  const size_t sample_size = size_t(channels) * rows * cols;
+  const uint32_t batch_size = shape.front();
+  CHECK_LE(offset + batch_size * sample_size, size_) << "The operand exceeds the arena";
+
+  std::vector<sftensor> tensors;
+  for (uint32_t b = 0; b < batch_size; ++b) {
+    float* sample = data_.get() + offset + b * sample_size;
+    tensors.push_back(std::make_shared<Tensor<float>>(sample, channels, rows, cols));
+  }
+  return tensors;
+}
+
+AotLoader::AotLoader(const std::string& bin_path) {
+  CHECK_EQ(reader_.open(bin_path), 0) << "Can not open the bin file: " << bin_path;
+}
+
+AotLoader::~AotLoader() { reader_.close(); }
+
+std::shared_ptr<Layer<float>> AotLoader::CreateLayer(const AotOperator& aot_operator) {
+  auto op = std::make_shared<RuntimeOperator>();
+  op->name = aot_operator.name;
+  op->type = aot_operator.type;
+  for (uint32_t i = 0; i < aot_operator.input_shapes.size(); ++i) {
+    op->input_operands_seq.push_back(std::make_shared<RuntimeOperand>(
+        op->name + ".input" + std::to_string(i), aot_operator.input_shapes.at(i),
+        std::vector<sftensor>{}, RuntimeDataType::kTypeFloat32));
+  }
+  op->output_operands = std::make_shared<RuntimeOperand>(
+      op->name, aot_operator.output_shape, std::vector<sftensor>{}, RuntimeDataType::kTypeFloat32);
+
+  std::map<std::string, pnnx::Parameter> params;
+  for (const auto& [name, value] : aot_operator.params) {
+    params.insert({name, pnnx::Parameter::parse_from_string(value)});
+  }
+
+  std::map<std::string, pnnx::Attribute> attrs;
+  for (const AotAttribute& aot_attribute : aot_operator.attrs) {
+    CHECK_EQ(aot_attribute.type, 1) << "Only f32 weights are supported: " << op->name;
+    pnnx::Attribute attr;
+    attr.type = aot_attribute.type;
+    attr.shape.assign(aot_attribute.shape.begin(), aot_attribute.shape.end());
+    size_t size = 1;
+    for (int32_t dim : attr.shape) {
+      size *= dim;
+    }
+    const std::vector<float> values = ReadAttribute(op->name, aot_attribute.name, size);
+    attr.data.resize(size * sizeof(float));
+    std::memcpy(attr.data.data(), values.data(), attr.data.size());
+    attrs.insert({aot_attribute.name, std::move(attr)});
+  }
+
+  RuntimeGraph::InitGraphAttrs(attrs, op);
+  RuntimeGraph::InitGraphParams(params, op);
+  op->layer = RuntimeGraph::CreateLayer(op);
+  op->layer->set_runtime_operator(op);
+  op->layer->set_parallel_plan(
+      PlanParallelism(EstimateOperatorCost(*op), uint32_t(omp_get_max_threads())));
+  RuntimeGraph::ReserveWorkspace(*op);
+  operators_.push_back(op);
+  return op->layer;
+}
+
+std::vector<float> AotLoader::ReadAttribute(const std::string& op_name,
+                                            const std::string& attr_name, size_t size) {
+  const std::string file_name = op_name + "." + attr_name;
+  CHECK_EQ(reader_.get_file_size(file_name), size * sizeof(float))
+      << "The weight " << file_name << " does not match its shape";
+  std::vector<float> values(size);
+  reader_.read_file(file_name, reinterpret_cast<char*>(values.data()));
+  return values;
+}
+
+std::vector<sftensor> AotConcat(const std::vector<std::vector<sftensor>>& operands) {
+  std::vector<sftensor> tensors;
+  for (const std::vector<sftensor>& operand : operands) {
+    tensors.insert(tensors.end(), operand.begin(), operand.end());
+  }
+  return tensors;
+}
+}  // namespace kuiper_infer
@@ -0,0 +1,205 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-30.
+
+#include "runtime/runtime_binding.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <type_traits>
+
+namespace kuiper_infer {
+
+namespace {
+/// 单个样本在缓冲区中的布局，维度右对齐为通道、行和列
+struct SampleLayout {
+  std::array<uint32_t, 3> dims{1, 1, 1};
+  std::array<int64_t, 3> strides{0, 0, 0};
+  int64_t batch_stride = 0;
+};
+
+SampleLayout GetSampleLayout(const ExternalBuffer& buffer) {
+  CHECK(buffer.data != nullptr) << "The memory of the external buffer is empty";
+  const std::vector<uint32_t>& shape = buffer.shape;
+  CHECK(shape.size() >= 2 && shape.size() <= 4)
+      << "Unsupported dimension of the external buffer: " << shape.size();
+  CHECK(buffer.strides.empty() || buffer.strides.size() == shape.size())
+      << "The strides of the external buffer are mismatched";
+  // 推理时逐样本调用，稠密步长在栈上计算，不申请内存
+  std::array<int64_t, 4> strides{};
+  std::copy(buffer.strides.begin(), buffer.strides.end(), strides.begin());
+  if (buffer.strides.empty()) {
+    strides.at(shape.size() - 1) = 1;
+    for (size_t i = shape.size() - 1; i > 0; --i) {
+      strides.at(i - 1) = strides.at(i) * shape.at(i);
+    }
+  }
+
+  SampleLayout layout;
+  layout.batch_stride = strides.front();
+  const size_t dim_offset = 3 - (shape.size() - 1);
+  for (size_t i = 1; i < shape.size(); ++i) {
+    layout.dims.at(dim_offset + i - 1) = shape.at(i);
+    layout.strides.at(dim_offset + i - 1) = strides.at(i);
+  }
+  return layout;
+}
+
+template <typename T>
+void ReadSample(const T* sample, const SampleLayout& layout, float scale, float offset,
+                Tensor<float>& tensor) {
+  const auto [channels, rows, cols] = layout.dims;
+  const auto [channel_stride, row_stride, col_stride] = layout.strides;
+  for (uint32_t c = 0; c < channels; ++c) {
+    float* channel_ptr = tensor.matrix_raw_ptr(c);
+    for (uint32_t col = 0; col < cols; ++col) {
+      const T* col_ptr = sample + c * channel_stride + col * col_stride;
+      for (uint32_t row = 0; row < rows; ++row) {
+        channel_ptr[col * rows + row] = float(col_ptr[row * row_stride]) * scale + offset;
+      }
+    }
+  }
+}
+
+template <typename T>
+void WriteSample(const Tensor<float>& tensor, const SampleLayout& layout, float scale,
+                 float offset, T* sample) {
+  const auto [channels, rows, cols] = layout.dims;
+  const auto [channel_stride, row_stride, col_stride] = layout.strides;
+  for (uint32_t c = 0; c < channels; ++c) {
+    const float* channel_ptr = tensor.matrix_raw_ptr(c);
+    for (uint32_t col = 0; col < cols; ++col) {
+      T* col_ptr = sample + c * channel_stride + col * col_stride;
+      for (uint32_t row = 0; row < rows; ++row) {
+        const float value = channel_ptr[col * rows + row] * scale + offset;
+        if constexpr (std::is_same_v<T, uint8_t>) {
+          col_ptr[row * row_stride] = uint8_t(std::clamp(std::nearbyint(value), 0.f, 255.f));
+        } else {
+          col_ptr[row * row_stride] = value;
+        }
+      }
+    }
+  }
+}
+
+void CheckSampleTensor(const SampleLayout& layout, const Tensor<float>& tensor) {
+  CHECK(!tensor.empty() && tensor.channels() == layout.dims.at(0) &&
+        tensor.rows() == layout.dims.at(1) && tensor.cols() == layout.dims.at(2))
+      << "The tensor does not match the shape of the external buffer";
+}
+}  // namespace
+
+ExternalBuffer ExternalBuffer::RowMajor(float* data, std::vector<uint32_t> shape) {
+  ExternalBuffer buffer;
+  buffer.data = data;
+  buffer.type = BufferDataType::kFloat32;
+  buffer.shape = std::move(shape);
+  return buffer;
+}
+
+ExternalBuffer ExternalBuffer::RowMajor(uint8_t* data, std::vector<uint32_t> shape, float scale,
+                                        float offset) {
+  ExternalBuffer buffer;
+  buffer.data = data;
+  buffer.type = BufferDataType::kUInt8;
+  buffer.shape = std::move(shape);
+  buffer.scale = scale;
+  buffer.offset = offset;
+  return buffer;
+}
+
+std::vector<int64_t> ExternalBuffer::element_strides() const {
+  if (!strides.empty()) {
+    return strides;
+  }
+  std::vector<int64_t> dense_strides(shape.size(), 1);
+  for (size_t i = shape.size(); i > 1; --i) {
+    dense_strides.at(i - 2) = dense_strides.at(i - 1) * shape.at(i - 1);
+  }
+  return dense_strides;
+}
+
+bool ExternalBuffer::IsTensorLayout() const {
+  if (type != BufferDataType::kFloat32 || scale != 1.f || offset != 0.f) {
+    return false;
+  }
+  const SampleLayout layout = GetSampleLayout(*this);
+  const auto [channels, rows, cols] = layout.dims;
+  const auto [channel_stride, row_stride, col_stride] = layout.strides;
+  // 长度为1的维度不会被访问，其步长可以是任意值
+  const int64_t sample_size = int64_t(channels) * rows * cols;
+  return (rows == 1 || row_stride == 1) && (cols == 1 || col_stride == rows) &&
+         (channels == 1 || channel_stride == int64_t(rows) * cols) &&
+         (shape.front() == 1 || layout.batch_stride == sample_size);
+}
+
+std::vector<sftensor> WrapBuffer(const ExternalBuffer& buffer) {
+  CHECK(buffer.IsTensorLayout()) << "The external buffer does not have the tensor layout";
+  const SampleLayout layout = GetSampleLayout(buffer);
+  const auto [channels, rows, cols] = layout.dims;
+  std::vector<sftensor> tensors;
+  for (uint32_t b = 0; b < buffer.shape.front(); ++b) {
+    float* sample = static_cast<float*>(buffer.data) + b * layout.batch_stride;
+    tensors.push_back(std::make_shared<Tensor<float>>(sample, channels, rows, cols));
+  }
+  return tensors;
+}
+
+std::vector<sftensor> CreateBufferTensors(const ExternalBuffer& buffer) {
+  const SampleLayout layout = GetSampleLayout(buffer);
+  const auto [channels, rows, cols] = layout.dims;
+  std::vector<sftensor> tensors;
+  for (uint32_t b = 0; b < buffer.shape.front(); ++b) {
+    tensors.push_back(std::make_shared<Tensor<float>>(channels, rows, cols));
+  }
+  return tensors;
+}
+
+void ReadBuffer(const ExternalBuffer& buffer, uint32_t batch_index, Tensor<float>& tensor) {
+  const SampleLayout layout = GetSampleLayout(buffer);
+  CHECK_LT(batch_index, buffer.shape.front());
+  CheckSampleTensor(layout, tensor);
+  const int64_t sample_offset = batch_index * layout.batch_stride;
+  if (buffer.type == BufferDataType::kUInt8) {
+    const uint8_t* sample = static_cast<const uint8_t*>(buffer.data) + sample_offset;
+    ReadSample(sample, layout, buffer.scale, buffer.offset, tensor);
+  } else {
+    const float* sample = static_cast<const float*>(buffer.data) + sample_offset;
+    ReadSample(sample, layout, buffer.scale, buffer.offset, tensor);
+  }
+}
+
+void WriteBuffer(const Tensor<float>& tensor, uint32_t batch_index, const ExternalBuffer& buffer) {
+  const SampleLayout layout = GetSampleLayout(buffer);
+  CHECK_LT(batch_index, buffer.shape.front());
+  CheckSampleTensor(layout, tensor);
+  const int64_t sample_offset = batch_index * layout.batch_stride;
+  if (buffer.type == BufferDataType::kUInt8) {
+    uint8_t* sample = static_cast<uint8_t*>(buffer.data) + sample_offset;
+    WriteSample(tensor, layout, buffer.scale, buffer.offset, sample);
+  } else {
+    float* sample = static_cast<float*>(buffer.data) + sample_offset;
+    WriteSample(tensor, layout, buffer.scale, buffer.offset, sample);
+  }
+}
+}  // namespace kuiper_infer
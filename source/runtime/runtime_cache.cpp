@@ -0,0 +1,250 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-9.
+
+#include "runtime/runtime_cache.hpp"
+#include <glog/logging.h>
+#include <cstring>
+#include "data/tensor_util.hpp"
+
+namespace kuiper_infer {
+
+namespace {
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t RotateLeft(uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t Round(uint64_t acc, uint64_t input) {
+  acc += input * kPrime2;
+  acc = RotateLeft(acc, 31);
+  return acc * kPrime1;
+}
+
+inline uint64_t MergeRound(uint64_t acc, uint64_t value) {
+  acc ^= Round(0, value);
+  return acc * kPrime1 + kPrime4;
+}
+
+inline uint64_t Read64(const uint8_t* ptr) {
+  uint64_t value;
+  std::memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+uint64_t HashBytes(const uint8_t* ptr, size_t length, uint64_t seed) {
+  const uint8_t* end = ptr + length;
+  uint64_t hash;
+  if (length >= 32) {
+    // 四条相互独立的累加链，便于指令级并行
+    uint64_t v1 = seed + kPrime1 + kPrime2;
+    uint64_t v2 = seed + kPrime2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - kPrime1;
+    const uint8_t* limit = end - 32;
+    do {
+      v1 = Round(v1, Read64(ptr));
+      v2 = Round(v2, Read64(ptr + 8));
+      v3 = Round(v3, Read64(ptr + 16));
+      v4 = Round(v4, Read64(ptr + 24));
+      ptr += 32;
+    } while (ptr <= limit);
+    hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+    hash = MergeRound(hash, v1);
+    hash = MergeRound(hash, v2);
+    hash = MergeRound(hash, v3);
+    hash = MergeRound(hash, v4);
+  } else {
+    hash = seed + kPrime5;
+  }
+  hash += uint64_t(length);
+
+  for (; ptr + 8 <= end; ptr += 8) {
+    hash ^= Round(0, Read64(ptr));
+    hash = RotateLeft(hash, 27) * kPrime1 + kPrime4;
+  }
+  if (ptr + 4 <= end) {
+    uint32_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    hash ^= uint64_t(value) * kPrime1;
+    hash = RotateLeft(hash, 23) * kPrime2 + kPrime3;
+    ptr += 4;
+  }
+  for (; ptr < end; ++ptr) {
+    hash ^= (*ptr) * kPrime5;
+    hash = RotateLeft(hash, 11) * kPrime1;
+  }
+
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  hash ^= hash >> 29;
+  hash *= kPrime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+}  // namespace
+
+RuntimeResultCache::RuntimeResultCache(uint32_t capacity) : capacity_(capacity) {
+  CHECK_GT(capacity, 0) << "The capacity of the result cache is zero";
+}
+
+uint64_t RuntimeResultCache::HashTensors(const std::vector<sftensor>& tensors) {
+  uint64_t hash = tensors.size();
+  for (const sftensor& tensor : tensors) {
+    CHECK(tensor != nullptr && !tensor->empty()) << "The tensor to hash is empty";
+    // 形状参与哈希，避免数据相同但形状不同的输入发生碰撞
+    const uint32_t shapes[3] = {tensor->channels(), tensor->rows(), tensor->cols()};
+    hash = HashBytes(reinterpret_cast<const uint8_t*>(shapes), sizeof(shapes), hash);
+    hash = HashBytes(reinterpret_cast<const uint8_t*>(tensor->raw_ptr()),
+                     tensor->size() * sizeof(float), hash);
+  }
+  return hash;
+}
+
+// 逐字节比较两组张量，哈希相同时用来排除碰撞
+static bool SameTensors(const std::vector<sftensor>& lhs, const std::vector<sftensor>& rhs) {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  for (uint32_t i = 0; i < lhs.size(); ++i) {
+    const sftensor& lhs_tensor = lhs.at(i);
+    const sftensor& rhs_tensor = rhs.at(i);
+    if (lhs_tensor->shapes() != rhs_tensor->shapes() ||
+        std::memcmp(lhs_tensor->raw_ptr(), rhs_tensor->raw_ptr(),
+                    lhs_tensor->size() * sizeof(float)) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RuntimeResultCache::Lookup(const RuntimeCacheKey& key, std::vector<sftensor>& outputs) {
+  return LookupEntry(key, nullptr, outputs);
+}
+
+bool RuntimeResultCache::LookupEntry(const RuntimeCacheKey& key,
+                                     const std::vector<sftensor>* inputs,
+                                     std::vector<sftensor>& outputs) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto entry_iter = entries_map_.find(key);
+  if (entry_iter == entries_map_.end() ||
+      (inputs != nullptr && !SameTensors(*inputs, entry_iter->second->inputs))) {
+    metrics_.misses += 1;
+    return false;
+  }
+  metrics_.hits += 1;
+  entries_.splice(entries_.begin(), entries_, entry_iter->second);
+  outputs = entry_iter->second->outputs;
+  return true;
+}
+
+void RuntimeResultCache::Insert(const RuntimeCacheKey& key,
+                                const std::vector<sftensor>& outputs) {
+  std::vector<sftensor> cached_outputs;
+  for (const sftensor& output : outputs) {
+    CHECK(output != nullptr) << "The output tensor to cache is empty";
+    cached_outputs.push_back(TensorClone(output));
+  }
+  InsertCloned(key, {}, std::move(cached_outputs));
+}
+
+void RuntimeResultCache::InsertCloned(const RuntimeCacheKey& key,
+                                      std::vector<sftensor> cached_inputs,
+                                      std::vector<sftensor> cached_outputs) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto entry_iter = entries_map_.find(key);
+  if (entry_iter != entries_map_.end()) {
+    entry_iter->second->inputs = std::move(cached_inputs);
+    entry_iter->second->outputs = std::move(cached_outputs);
+    entries_.splice(entries_.begin(), entries_, entry_iter->second);
+    return;
+  }
+
+  entries_.push_front({key, std::move(cached_inputs), std::move(cached_outputs)});
+  entries_map_.insert({key, entries_.begin()});
+  if (entries_.size() > capacity_) {
+    entries_map_.erase(entries_.back().key);
+    entries_.pop_back();
+    metrics_.evictions += 1;
+  }
+}
+
+std::vector<sftensor> RuntimeResultCache::Forward(RuntimeGraph& graph,
+                                                  const std::string& model_name,
+                                                  const std::string& input_name,
+                                                  const std::vector<sftensor>& inputs,
+                                                  const std::string& output_name) {
+  const RuntimeCacheKey key{model_name, input_name, output_name, HashTensors(inputs)};
+  std::vector<sftensor> outputs;
+  if (LookupEntry(key, &inputs, outputs)) {
+    return outputs;
+  }
+
+  {
+    // 同一个图的输入输出空间是共享的，未命中的推理逐个执行，命中不需要等待
+    std::lock_guard<std::mutex> graph_lock(GraphMutex(graph));
+    graph.set_inputs(input_name, inputs);
+    graph.Forward(false);
+    // 图的输出空间会被下一次推理复用，缓存中保存的是拷贝
+    for (const sftensor& output : graph.get_outputs(output_name)) {
+      outputs.push_back(TensorClone(output));
+    }
+  }
+  std::vector<sftensor> cached_inputs;
+  for (const sftensor& input : inputs) {
+    cached_inputs.push_back(TensorClone(input));
+  }
+  InsertCloned(key, std::move(cached_inputs), outputs);
+  return outputs;
+}
+
+std::mutex& RuntimeResultCache::GraphMutex(const RuntimeGraph& graph) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<std::mutex>& graph_mutex = graph_mutexes_[&graph];
+  if (graph_mutex == nullptr) {
+    graph_mutex = std::make_unique<std::mutex>();
+  }
+  return *graph_mutex;
+}
+
+void RuntimeResultCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  entries_map_.clear();
+}
+
+uint32_t RuntimeResultCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+RuntimeCacheMetrics RuntimeResultCache::metrics() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return metrics_;
+}
+
+}  // namespace kuiper_infer
@@ -0,0 +1,351 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-13.
+
+#include "runtime/runtime_ipc.hpp"
+#ifdef __linux__
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <new>
+#include <utility>
+
+namespace kuiper_infer {
+
+namespace {
+constexpr uint32_t kIpcMagic = 0x4b504950;  // "KPIP"
+constexpr size_t kIpcAlignment = 64;
+
+size_t AlignSize(size_t size) { return (size + kIpcAlignment - 1) / kIpcAlignment * kIpcAlignment; }
+
+size_t SampleSize(const uint32_t* shapes) {
+  return size_t(shapes[0]) * shapes[1] * shapes[2] * sizeof(float);
+}
+
+uint8_t* SlotBase(RuntimeIpcHeader* header, uint32_t slot_index) {
+  return reinterpret_cast<uint8_t*>(header) + AlignSize(sizeof(RuntimeIpcHeader)) +
+         header->slot_stride * slot_index;
+}
+
+RuntimeIpcSlot* SlotAt(RuntimeIpcHeader* header, uint32_t slot_index) {
+  return reinterpret_cast<RuntimeIpcSlot*>(SlotBase(header, slot_index));
+}
+
+// 输入和输出张量紧跟在槽位之后，读写时不需要序列化和拷贝
+sftensor SlotTensor(RuntimeIpcHeader* header, uint32_t slot_index, bool is_input) {
+  uint8_t* ptr = SlotBase(header, slot_index) + AlignSize(sizeof(RuntimeIpcSlot));
+  const uint32_t* shapes = header->input_shapes;
+  if (!is_input) {
+    ptr += AlignSize(SampleSize(header->input_shapes));
+    shapes = header->output_shapes;
+  }
+  return std::make_shared<Tensor<float>>(reinterpret_cast<float*>(ptr), shapes[0], shapes[1],
+                                         shapes[2]);
+}
+
+constexpr std::chrono::milliseconds kLivenessInterval(100);
+
+void FutexWait(std::atomic<uint32_t>* word, uint32_t expected,
+               const timespec* timeout = nullptr) {
+  // 共享内存跨进程使用，不能使用FUTEX_PRIVATE_FLAG
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, timeout, nullptr,
+          0);
+}
+
+bool ServerAlive(const RuntimeIpcHeader* header) {
+  if (header->stopped.load(std::memory_order_acquire)) {
+    return false;
+  }
+  return kill(pid_t(header->server_pid), 0) == 0 || errno != ESRCH;
+}
+
+void FutexWake(std::atomic<uint32_t>* word, int count) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+}
+}  // namespace
+
+RuntimeIpcServer::RuntimeIpcServer(std::string shm_name, std::shared_ptr<RuntimeGraph> graph,
+                                   std::string input_name, std::string output_name,
+                                   uint32_t batch_size, const std::vector<uint32_t>& input_shapes,
+                                   const std::vector<uint32_t>& output_shapes,
+                                   uint32_t slot_count, bool reclaim)
+    : shm_name_(std::move(shm_name)),
+      graph_(std::move(graph)),
+      input_name_(std::move(input_name)),
+      output_name_(std::move(output_name)),
+      batch_size_(batch_size) {
+  CHECK(graph_ != nullptr) << "The graph of the ipc server is empty";
+  CHECK_GT(batch_size, 0);
+  CHECK_GT(slot_count, 0);
+  CHECK_EQ(input_shapes.size(), 3) << "The input shape should be channels, rows and cols";
+  CHECK_EQ(output_shapes.size(), 3) << "The output shape should be channels, rows and cols";
+
+  RuntimeIpcHeader header_info;
+  std::copy(input_shapes.begin(), input_shapes.end(), header_info.input_shapes);
+  std::copy(output_shapes.begin(), output_shapes.end(), header_info.output_shapes);
+  const uint64_t slot_stride = AlignSize(sizeof(RuntimeIpcSlot)) +
+                               AlignSize(SampleSize(header_info.input_shapes)) +
+                               AlignSize(SampleSize(header_info.output_shapes));
+  shm_size_ = AlignSize(sizeof(RuntimeIpcHeader)) + slot_stride * slot_count;
+
+  // 删除同名的共享内存会断开正在运行的服务端的客户端，只在显式要求时回收
+  if (reclaim) {
+    shm_unlink(shm_name_.c_str());
+  }
+  const int fd = shm_open(shm_name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  CHECK(fd >= 0 || errno != EEXIST)
+      << "The shared memory " << shm_name_
+      << " already exists, another server may be running. Reclaim it only if that server "
+         "has crashed";
+  CHECK_GE(fd, 0) << "Can not create the shared memory: " << shm_name_;
+  CHECK_EQ(ftruncate(fd, off_t(shm_size_)), 0) << "Can not resize the shared memory";
+  shm_ptr_ = mmap(nullptr, shm_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  CHECK(shm_ptr_ != MAP_FAILED) << "Can not map the shared memory: " << shm_name_;
+
+  header_ = new (shm_ptr_) RuntimeIpcHeader();
+  header_->slot_count = slot_count;
+  std::copy(input_shapes.begin(), input_shapes.end(), header_->input_shapes);
+  std::copy(output_shapes.begin(), output_shapes.end(), header_->output_shapes);
+  header_->slot_stride = slot_stride;
+  header_->server_pid = int32_t(getpid());
+  for (uint32_t i = 0; i < slot_count; ++i) {
+    new (SlotBase(header_, i)) RuntimeIpcSlot();
+    slot_inputs_.push_back(SlotTensor(header_, i, true));
+    slot_outputs_.push_back(SlotTensor(header_, i, false));
+  }
+  for (uint32_t i = 0; i < batch_size; ++i) {
+    sftensor padding_input =
+        std::make_shared<Tensor<float>>(input_shapes[0], input_shapes[1], input_shapes[2]);
+    padding_input->Fill(0.f);
+    padding_inputs_.push_back(padding_input);
+    padding_outputs_.push_back(
+        std::make_shared<Tensor<float>>(output_shapes[0], output_shapes[1], output_shapes[2]));
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->magic = kIpcMagic;
+}
+
+RuntimeIpcServer::~RuntimeIpcServer() {
+  if (shm_ptr_ != nullptr && shm_ptr_ != MAP_FAILED) {
+    munmap(shm_ptr_, shm_size_);
+    shm_unlink(shm_name_.c_str());
+  }
+}
+
+void RuntimeIpcServer::Run() {
+  std::vector<sftensor> inputs(batch_size_);
+  std::vector<sftensor> outputs(batch_size_);
+  while (!header_->stopped.load(std::memory_order_acquire)) {
+    // 先读取提交计数再收集请求，收集之后提交的请求会让等待立即返回
+    const uint32_t submitted = header_->submitted.load(std::memory_order_acquire);
+    const std::vector<uint32_t> batch = GatherBatch();
+    if (batch.empty()) {
+      FutexWait(&header_->submitted, submitted);
+      continue;
+    }
+
+    // 不满一个批次时使用服务端的张量补齐
+    for (uint32_t i = 0; i < batch_size_; ++i) {
+      if (i < batch.size()) {
+        inputs.at(i) = slot_inputs_.at(batch.at(i));
+        outputs.at(i) = slot_outputs_.at(batch.at(i));
+      } else {
+        inputs.at(i) = padding_inputs_.at(i);
+        outputs.at(i) = padding_outputs_.at(i);
+      }
+    }
+    graph_->set_inputs(input_name_, inputs);
+    graph_->set_outputs(output_name_, outputs);
+    graph_->Forward(false);
+
+    for (const uint32_t slot_index : batch) {
+      RuntimeIpcSlot* slot = SlotAt(header_, slot_index);
+      slot->status = int32_t(StatusCode::kSuccess);
+      // 客户端已经放弃等待时，槽位直接归还到环中
+      uint32_t state = RuntimeIpcSlot::kSlotProcessing;
+      if (!slot->state.compare_exchange_strong(state, RuntimeIpcSlot::kSlotDone,
+                                               std::memory_order_acq_rel)) {
+        slot->state.store(RuntimeIpcSlot::kSlotFree, std::memory_order_release);
+      }
+      FutexWake(&slot->state, INT_MAX);
+    }
+    batch_count_ += 1;
+  }
+
+  // 唤醒仍在等待的客户端
+  for (uint32_t i = 0; i < header_->slot_count; ++i) {
+    RuntimeIpcSlot* slot = SlotAt(header_, i);
+    uint32_t state = RuntimeIpcSlot::kSlotSubmitted;
+    if (slot->state.compare_exchange_strong(state, RuntimeIpcSlot::kSlotDone)) {
+      slot->status = int32_t(StatusCode::kUnknownCode);
+      FutexWake(&slot->state, INT_MAX);
+    }
+  }
+}
+
+void RuntimeIpcServer::Stop() {
+  header_->stopped.store(1, std::memory_order_release);
+  header_->submitted.fetch_add(1, std::memory_order_acq_rel);
+  FutexWake(&header_->submitted, INT_MAX);
+}
+
+uint64_t RuntimeIpcServer::batch_count() const { return batch_count_.load(); }
+
+std::vector<uint32_t> RuntimeIpcServer::GatherBatch() {
+  std::vector<uint32_t> batch;
+  const uint32_t slot_count = header_->slot_count;
+  for (uint32_t i = 0; i < slot_count && batch.size() < batch_size_; ++i) {
+    const uint32_t slot_index = (cursor_ + i) % slot_count;
+    RuntimeIpcSlot* slot = SlotAt(header_, slot_index);
+    uint32_t state = RuntimeIpcSlot::kSlotSubmitted;
+    if (slot->state.compare_exchange_strong(state, RuntimeIpcSlot::kSlotProcessing,
+                                            std::memory_order_acquire)) {
+      batch.push_back(slot_index);
+    }
+  }
+  // 从上一个批次结束的位置继续扫描，保证各个客户端之间的公平
+  if (!batch.empty()) {
+    cursor_ = (batch.back() + 1) % slot_count;
+  }
+  return batch;
+}
+
+RuntimeIpcClient::RuntimeIpcClient(const std::string& shm_name) {
+  const int fd = shm_open(shm_name.c_str(), O_RDWR, 0600);
+  CHECK_GE(fd, 0) << "Can not open the shared memory: " << shm_name;
+  struct stat shm_stat {};
+  CHECK_EQ(fstat(fd, &shm_stat), 0);
+  shm_size_ = shm_stat.st_size;
+  shm_ptr_ = mmap(nullptr, shm_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  CHECK(shm_ptr_ != MAP_FAILED) << "Can not map the shared memory: " << shm_name;
+
+  header_ = reinterpret_cast<RuntimeIpcHeader*>(shm_ptr_);
+  CHECK_EQ(header_->magic, kIpcMagic) << "The shared memory is not created by a server";
+  std::atomic_thread_fence(std::memory_order_acquire);
+  for (uint32_t i = 0; i < header_->slot_count; ++i) {
+    slot_inputs_.push_back(SlotTensor(header_, i, true));
+    slot_outputs_.push_back(SlotTensor(header_, i, false));
+  }
+}
+
+RuntimeIpcClient::~RuntimeIpcClient() {
+  if (shm_ptr_ != nullptr && shm_ptr_ != MAP_FAILED) {
+    munmap(shm_ptr_, shm_size_);
+  }
+}
+
+uint32_t RuntimeIpcClient::Acquire() {
+  const uint32_t slot_count = header_->slot_count;
+  while (true) {
+    CHECK(!header_->stopped.load(std::memory_order_acquire)) << "The ipc server has stopped";
+    const uint32_t start = acquire_cursor_.fetch_add(1);
+    for (uint32_t i = 0; i < slot_count; ++i) {
+      const uint32_t slot_index = (start + i) % slot_count;
+      uint32_t state = RuntimeIpcSlot::kSlotFree;
+      if (SlotAt(header_, slot_index)
+              ->state.compare_exchange_strong(state, RuntimeIpcSlot::kSlotAcquired)) {
+        return slot_index;
+      }
+    }
+    sched_yield();
+  }
+}
+
+sftensor RuntimeIpcClient::input(uint32_t slot_index) const {
+  return slot_inputs_.at(slot_index);
+}
+
+sftensor RuntimeIpcClient::output(uint32_t slot_index) const {
+  return slot_outputs_.at(slot_index);
+}
+
+StatusCode RuntimeIpcClient::Submit(uint32_t slot_index, std::chrono::milliseconds timeout) {
+  using namespace std::chrono;
+  RuntimeIpcSlot* slot = SlotAt(header_, slot_index);
+  CHECK_EQ(slot->state.load(), RuntimeIpcSlot::kSlotAcquired)
+      << "The slot " << slot_index << " is not acquired";
+  if (!ServerAlive(header_)) {
+    return StatusCode::kInferServerUnavailable;
+  }
+  slot->state.store(RuntimeIpcSlot::kSlotSubmitted, std::memory_order_release);
+  header_->submitted.fetch_add(1, std::memory_order_acq_rel);
+  FutexWake(&header_->submitted, 1);
+
+  // 分段等待，每一段结束时检查服务端是否仍然存活
+  const steady_clock::time_point deadline = steady_clock::now() + timeout;
+  uint32_t state = slot->state.load(std::memory_order_acquire);
+  while (state != RuntimeIpcSlot::kSlotDone) {
+    const steady_clock::time_point now = steady_clock::now();
+    StatusCode wait_status = StatusCode::kSuccess;
+    if (now >= deadline) {
+      wait_status = StatusCode::kInferTimeout;
+    } else if (!ServerAlive(header_)) {
+      wait_status = StatusCode::kInferServerUnavailable;
+    }
+    if (wait_status != StatusCode::kSuccess) {
+      // 尚未被服务端取走的请求撤回，正在执行的请求交给服务端回收
+      state = RuntimeIpcSlot::kSlotSubmitted;
+      if (slot->state.compare_exchange_strong(state, RuntimeIpcSlot::kSlotAcquired,
+                                              std::memory_order_acq_rel)) {
+        return wait_status;
+      }
+      state = RuntimeIpcSlot::kSlotProcessing;
+      if (slot->state.compare_exchange_strong(state, RuntimeIpcSlot::kSlotAbandoned,
+                                              std::memory_order_acq_rel)) {
+        return wait_status;
+      }
+      continue;
+    }
+
+    const nanoseconds wait_time =
+        std::min<nanoseconds>(deadline - now, duration_cast<nanoseconds>(kLivenessInterval));
+    timespec wait_timespec{};
+    wait_timespec.tv_sec = time_t(wait_time.count() / 1000000000);
+    wait_timespec.tv_nsec = long(wait_time.count() % 1000000000);
+    FutexWait(&slot->state, state, &wait_timespec);
+    state = slot->state.load(std::memory_order_acquire);
+  }
+  return StatusCode(slot->status);
+}
+
+void RuntimeIpcClient::Release(uint32_t slot_index) {
+  RuntimeIpcSlot* slot = SlotAt(header_, slot_index);
+  // 被放弃的槽位仍由服务端持有，执行完成后由服务端归还
+  if (slot->state.load(std::memory_order_acquire) == RuntimeIpcSlot::kSlotAbandoned) {
+    return;
+  }
+  slot->state.store(RuntimeIpcSlot::kSlotFree, std::memory_order_release);
+}
+
+}  // namespace kuiper_infer
+#endif  // __linux__
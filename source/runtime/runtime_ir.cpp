@@ -20,16 +20,59 @@
 // SOFTWARE.
 
 #include "runtime/runtime_ir.hpp"
+#include <omp.h>
+#include <algorithm>
+#include <array>
 #include <deque>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <utility>
 #include <vector>
+#include "data/tensor_util.hpp"
 #include "layer/abstract/layer_factory.hpp"
+#include "layer/abstract/layer_workspace.hpp"
 #include "runtime/runtime_ir.hpp"
 #include "utils/time/time_logging.hpp"
 
 namespace kuiper_infer {
+/**
+ * 张量的形状是否与pnnx操作数的形状一致，操作数的形状包含批次维度，
+ * 对应关系与RuntimeOperatorUtils::InitOperatorOutput中创建输出空间时相同
+ */
+static bool TensorMatchesOperand(const sftensor& tensor,
+                                 const std::vector<int32_t>& operand_shapes) {
+  if (tensor == nullptr || tensor->empty() || operand_shapes.size() < 2 ||
+      operand_shapes.size() > 4) {
+    return false;
+  }
+  std::array<int32_t, 3> shapes{1, 1, 1};
+  std::copy(operand_shapes.begin() + 1, operand_shapes.end(),
+            shapes.end() - (operand_shapes.size() - 1));
+  return int32_t(tensor->channels()) == shapes.at(0) && int32_t(tensor->rows()) == shapes.at(1) &&
+         int32_t(tensor->cols()) == shapes.at(2);
+}
+
+// 删除指定名称的外部缓冲区绑定
+static void RemoveBinding(std::vector<BufferBinding>& bindings, const std::string& name) {
+  bindings.erase(std::remove_if(bindings.begin(), bindings.end(),
+                                [&name](const BufferBinding& binding) {
+                                  return binding.name == name;
+                                }),
+                 bindings.end());
+}
+
+// 外部缓冲区的形状需要与操作数的形状完全一致，包括批次维度
+static void CheckBufferShape(const ExternalBuffer& buffer,
+                             const std::vector<int32_t>& operand_shapes,
+                             const std::string& name) {
+  CHECK(std::equal(buffer.shape.begin(), buffer.shape.end(), operand_shapes.begin(),
+                   operand_shapes.end(),
+                   [](uint32_t dim, int32_t operand_dim) { return int32_t(dim) == operand_dim; }))
+      << "The shape of the external buffer does not match the operand " << name;
+}
+
 RuntimeGraph::RuntimeGraph(std::string param_path, std::string bin_path)
     : param_path_(std::move(param_path)), bin_path_(std::move(bin_path)) {}
 
@@ -115,6 +158,10 @@ void RuntimeGraph::Build() {
   RuntimeOperatorUtils<float>::InitOperatorInput(operators_);
   RuntimeOperatorUtils<float>::InitOperatorOutput(graph_->ops, operators_);
 
+  // 构建静态执行计划，并一次性校验其中的形状
+  BuildExecutionPlan();
+  ValidateExecutionPlan();
+
   graph_state_ = GraphState::Complete;
   if (graph_ != nullptr) {
     graph_.reset();
@@ -128,52 +175,465 @@ void RuntimeGraph::Forward(bool debug) {
     LOG(FATAL) << "Graph need be build!"
                << ", current state is " << int32_t(graph_state_);
   }
+  LOG_IF(FATAL, !plan_inputs_bound_) << "The inputs of the graph have not been set yet!";
 
   if (debug) {
     utils::LayerTimeStatesSingleton::LayerTimeStatesCollectorInit();
   }
 
-  auto forward_layer = [&](const std::shared_ptr<Layer<float>>& layer, const std::string& op_name,
-                           const std::string& op_type) {
+  // 调用方的缓冲区直接转换到第一层读取的输入张量中
+  for (const BufferBinding& binding : input_bindings_) {
+#pragma omp parallel for
+    for (uint32_t i = 0; i < binding.tensors.size(); ++i) {
+      ReadBuffer(binding.buffer, i, *binding.tensors[i]);
+    }
+  }
+
+  for (uint32_t step_index = 0; step_index < execution_plan_.size(); ++step_index) {
+    const RuntimeExecutionStep& step = execution_plan_.at(step_index);
     StatusCode status;
-    if (debug) {
-      utils::LayerTimeLogging layer_time_logging(op_name, op_type);
+    if (debug && !step.skipped) {
+      utils::LayerTimeLogging layer_time_logging(step.op->name, step.op->type);
+      status = ForwardStep(step_index);
+    } else {
+      status = ForwardStep(step_index);
     }
-      status = layer->Forward();
-      return status;
-  };
+    CHECK(status == StatusCode::kSuccess)
+        << step.layer->layer_name() << " layer forward failed, error code: " << int32_t(status);
+  }
+
+  for (const BufferBinding& binding : output_bindings_) {
+#pragma omp parallel for
+    for (uint32_t i = 0; i < binding.tensors.size(); ++i) {
+      WriteBuffer(*binding.tensors[i], i, binding.buffer);
+    }
+  }
+
+  if (debug) {
+    utils::LayerTimeLogging::SummaryLogging();
+  }
+}
+
+StatusCode RuntimeGraph::ForwardStep(uint32_t step_index) {
+  CHECK(graph_state_ == GraphState::Complete) << "Graph need be build!";
+  CHECK_LT(step_index, execution_plan_.size());
+  RuntimeExecutionStep& step = execution_plan_.at(step_index);
+  if (step.skipped) {
+    return StatusCode::kSuccess;
+  }
+  const uint32_t thread_budget = uint32_t(omp_get_max_threads());
+  if (thread_budget != thread_budget_) {
+    PlanExecutionParallelism(thread_budget);
+  }
+  // 绑定了视图的层直接在视图上计算，不复制共享指针
+  const StatusCode status = step.input_views.empty()
+                                ? step.layer->Forward(step.inputs, *step.outputs)
+                                : step.layer->ForwardViews(step.input_views, step.output_views);
+  // 带完整检查的第一次执行通过后，之后的执行跳过层内的逐次检查
+  if (status == StatusCode::kSuccess && !step.validated) {
+    step.validated = true;
+    step.layer->set_checked(!fast_path_);
+  }
+  return status;
+}
+
+void RuntimeGraph::set_fast_path(bool fast_path) {
+  fast_path_ = fast_path;
+  for (RuntimeExecutionStep& step : execution_plan_) {
+    if (step.validated) {
+      step.layer->set_checked(!fast_path_);
+    }
+  }
+}
+
+bool RuntimeGraph::fast_path() const { return fast_path_; }
+
+void RuntimeGraph::set_dynamic_quantization(bool dynamic_quantization) {
+  CHECK(graph_state_ != GraphState::Complete)
+      << "Dynamic quantization must be set before the graph is built";
+  dynamic_quantization_ = dynamic_quantization;
+}
+
+bool RuntimeGraph::dynamic_quantization() const { return dynamic_quantization_; }
+
+void RuntimeGraph::PlanExecutionParallelism(uint32_t thread_budget) {
+  bool nested = false;
+  for (RuntimeExecutionStep& step : execution_plan_) {
+    const ParallelPlan parallel_plan = PlanParallelism(step.cost, thread_budget);
+    nested = nested || (parallel_plan.batch_threads > 1 && parallel_plan.intra_threads > 1);
+    step.layer->set_parallel_plan(parallel_plan);
+  }
+  // 样本间和样本内同时并行时需要允许嵌套的并行区域
+  if (nested && omp_get_max_active_levels() < 2) {
+    omp_set_max_active_levels(2);
+  }
+  thread_budget_ = thread_budget;
+}
+
+std::string RuntimeGraph::Summary() const {
+  CHECK(graph_state_ == GraphState::Complete) << "Graph need be build!";
+  const uint32_t thread_budget = thread_budget_ ? thread_budget_ : omp_get_max_threads();
+  std::ostringstream summary;
+  summary << std::left << std::setw(6) << "step" << std::setw(32) << "name" << std::setw(20)
+          << "type" << std::right << std::setw(12) << "MFLOPs" << std::setw(12) << "params"
+          << std::setw(12) << "weight MB" << std::setw(12) << "input MB" << std::setw(12)
+          << "output MB" << std::setw(10) << "threads" << "\n";
+  summary << std::fixed << std::setprecision(2);
+  for (uint32_t i = 0; i < execution_plan_.size(); ++i) {
+    const RuntimeExecutionStep& step = execution_plan_.at(i);
+    const ParallelPlan& parallel_plan = thread_budget_ ? step.layer->parallel_plan()
+                                                       : PlanParallelism(step.cost, thread_budget);
+    std::vector<const RuntimeOperator*> step_ops{step.op};
+    step_ops.insert(step_ops.end(), step.fused_ops.begin(), step.fused_ops.end());
+    for (const RuntimeOperator* op : step_ops) {
+      const OperatorCost cost = EstimateOperatorCost(*op);
+      std::string threads = ParallelPlanToString(parallel_plan);
+      if (step.skipped) {
+        threads = "skipped";
+      } else if (op != step.op) {
+        threads = "fused";
+      }
+      summary << std::left << std::setw(6) << i << std::setw(32) << op->name << std::setw(20)
+              << op->type << std::right << std::setw(12) << cost.flops / 1e6 << std::setw(12)
+              << uint64_t(cost.parameters) << std::setw(12) << cost.weight_bytes / 1e6
+              << std::setw(12) << cost.input_bytes / 1e6 << std::setw(12)
+              << cost.output_bytes / 1e6 << std::setw(10) << threads << "\n";
+    }
+  }
+
+  const LayerCost total_cost = TotalCost();
+  summary << std::setprecision(0) << "{\"operators\": " << operators_.size()
+          << ", \"steps\": " << execution_plan_.size() << ", \"threads\": " << thread_budget
+          << ", \"flops\": " << total_cost.flops << ", \"parameters\": " << total_cost.parameters
+          << ", \"weight_bytes\": " << total_cost.weight_bytes
+          << ", \"input_bytes\": " << total_cost.input_bytes
+          << ", \"output_bytes\": " << total_cost.output_bytes << "}\n";
+  return summary.str();
+}
+
+LayerCost RuntimeGraph::TotalCost() const {
+  CHECK(graph_state_ == GraphState::Complete) << "Graph need be build!";
+  LayerCost total_cost;
+  for (const RuntimeExecutionStep& step : execution_plan_) {
+    if (!step.skipped) {
+      total_cost += step.cost;
+    }
+  }
+  return total_cost;
+}
 
+void RuntimeGraph::ValidateExecutionPlan() {
+  for (const RuntimeExecutionStep& step : execution_plan_) {
+    CHECK(step.op != nullptr && step.layer != nullptr) << "The execution plan has an empty step";
+    const RuntimeOperator* output_op = step.fused_ops.empty() ? step.op : step.fused_ops.back();
+    const auto& output_operand = output_op->output_operands;
+    CHECK(output_operand != nullptr && step.outputs != nullptr)
+        << "The output operand of the op " << output_op->name << " is empty";
+
+    const std::vector<int32_t>& output_shapes = output_operand->shapes;
+    CHECK(!output_shapes.empty() && output_shapes.front() == int32_t(step.outputs->size()))
+        << "The batch size of the op " << output_op->name << " is mismatched";
+    for (const sftensor& output : *step.outputs) {
+      CHECK(TensorMatchesOperand(output, output_shapes))
+          << "The output tensor of the op " << output_op->name
+          << " does not match the shape of its operand";
+    }
+
+    for (const auto& input_operand : step.input_operands) {
+      CHECK(input_operand != nullptr && !input_operand->shapes.empty())
+          << "The input operand of the op " << step.op->name << " is empty";
+      CHECK_EQ(input_operand->shapes.front(), output_shapes.front())
+          << "The batch size of the input operand " << input_operand->name << " of the op "
+          << step.op->name << " is mismatched";
+      for (const sftensor& input : input_operand->datas) {
+        CHECK(input == nullptr || input->empty() ||
+              TensorMatchesOperand(input, input_operand->shapes))
+            << "The input tensor " << input_operand->name << " of the op " << step.op->name
+            << " does not match the shape of its operand";
+      }
+    }
+  }
+  ResetValidation();
+}
+
+void RuntimeGraph::ResetValidation() {
+  for (RuntimeExecutionStep& step : execution_plan_) {
+    step.validated = false;
+    step.layer->set_checked(true);
+  }
+}
+
+uint32_t RuntimeGraph::plan_size() const { return execution_plan_.size(); }
+
+const std::vector<RuntimeExecutionStep>& RuntimeGraph::execution_plan() const {
+  return execution_plan_;
+}
+
+void RuntimeGraph::BuildExecutionPlan() {
+  execution_plan_.clear();
   for (const auto& current_op : operators_) {
-    current_op->has_forward = false;
     CHECK_GT(current_op->forward_index, 0);
-
     if (is_input_op(current_op->name) || is_output_op(current_op->name)) {
-      current_op->has_forward = true;
       continue;
     }
 
     CHECK(current_op->layer != nullptr)
         << "The layer corresponding to the op " << current_op->name
         << " is empty, indicating that it may not have been created.";
+    CHECK(current_op->output_operands != nullptr && !current_op->output_operands->datas.empty())
+        << "The output operand of the op " << current_op->name << " is empty";
 
-    std::shared_ptr<Layer<float>> layer = current_op->layer;
-    StatusCode status = forward_layer(layer, current_op->name, current_op->type);
-    CHECK(status == StatusCode::kSuccess)
-        << layer->layer_name() << " layer forward failed, error code: " << int32_t(status);
-
-    current_op->has_forward = true;
+    // 输出空间在构建时就与后继节点的输入空间相互绑定
     PropagateLayerOutputs(current_op, current_op->output_operands->datas);
   }
 
-  if (debug) {
-    utils::LayerTimeLogging::SummaryLogging();
+  // 被融合的算子不再单独执行
+  std::set<RuntimeOperator*> fused_ops;
+  for (const auto& current_op : operators_) {
+    if (current_op->type != "pnnx.Expression" || fused_ops.count(current_op.get())) {
+      continue;
+    }
+    RuntimeExecutionStep step;
+    if (FuseResidualAdd(current_op, fused_ops, step)) {
+      execution_plan_.push_back(std::move(step));
+    }
   }
 
+  // 融合后的卷积在残差相加的位置执行，此时残差分支已经计算完毕
+  std::vector<RuntimeExecutionStep> fused_steps = std::move(execution_plan_);
+  execution_plan_.clear();
+  auto fused_step_iter = fused_steps.begin();
+  for (const auto& current_op : operators_) {
+    if (is_input_op(current_op->name) || is_output_op(current_op->name)) {
+      continue;
+    }
+    if (fused_ops.count(current_op.get())) {
+      if (fused_step_iter != fused_steps.end() &&
+          current_op->type == "pnnx.Expression") {
+        execution_plan_.push_back(std::move(*fused_step_iter));
+        ++fused_step_iter;
+      }
+      continue;
+    }
+
+    RuntimeExecutionStep step;
+    step.op = current_op.get();
+    step.layer = current_op->layer.get();
+    step.input_operands = current_op->input_operands_seq;
+    step.outputs = &current_op->output_operands->datas;
+    execution_plan_.push_back(std::move(step));
+  }
+
+  // 估计每一步的计算量，执行时据此在样本间和样本内分配线程
+  for (RuntimeExecutionStep& step : execution_plan_) {
+    // 量化后的权重改变了层的访存量和工作区大小，需在估计之前完成
+    if (dynamic_quantization_) {
+      step.layer->QuantizeWeights();
+    }
+    step.cost = EstimateOperatorCost(*step.op);
+    for (const RuntimeOperator* fused_op : step.fused_ops) {
+      const OperatorCost fused_cost = EstimateOperatorCost(*fused_op);
+      step.cost += fused_cost;
+    }
+    ReserveWorkspace(*step.op);
+  }
+  thread_budget_ = 0;
+  MarkRequiredOperators();
+  plan_inputs_bound_ = BindExecutionInputs();
+}
+
+void RuntimeGraph::ReserveWorkspace(const RuntimeOperator& op) {
+  if (op.layer == nullptr || op.output_operands == nullptr) {
+    return;
+  }
+  std::vector<std::vector<int32_t>> input_shapes;
+  for (const auto& input_operand : op.input_operands_seq) {
+    if (input_operand != nullptr) {
+      input_shapes.push_back(input_operand->shapes);
+    }
+  }
+  // 所有层共用每个线程的工作区，按最大的需求预留
+  LayerWorkspace::Reserve(op.layer->WorkspaceSize(input_shapes, op.output_operands->shapes));
+}
+
+void RuntimeGraph::MarkRequiredOperators() {
+  std::map<std::string, RuntimeOperator*> operators_map;
   for (const auto& op : operators_) {
-    LOG_IF(FATAL, !op->has_forward) << "The operator: " << op->name << " has not been forward yet!";
+    op->is_skipped = !requested_outputs_.empty();
+    operators_map.insert({op->name, op.get()});
+  }
+
+  std::queue<RuntimeOperator*> required_ops;
+  for (const std::string& output_name : requested_outputs_) {
+    const auto op_iter = operators_map.find(output_name);
+    CHECK(op_iter != operators_map.end()) << "Can not find the operand: " << output_name;
+    CHECK(!is_input_op(output_name)) << "The graph input can not be requested: " << output_name;
+    required_ops.push(op_iter->second);
+  }
+
+  // 从被请求的操作数出发，反向标记所有的生产者节点
+  while (!required_ops.empty()) {
+    RuntimeOperator* current_op = required_ops.front();
+    required_ops.pop();
+    if (!current_op->is_skipped) {
+      continue;
+    }
+    current_op->is_skipped = false;
+    for (const auto& [producer_name, input_operand] : current_op->input_operands) {
+      const auto op_iter = operators_map.find(producer_name);
+      if (op_iter != operators_map.end()) {
+        required_ops.push(op_iter->second);
+      }
+    }
+  }
+
+  for (RuntimeExecutionStep& step : execution_plan_) {
+    step.skipped = step.op->is_skipped;
+    for (RuntimeOperator* fused_op : step.fused_ops) {
+      step.skipped = step.skipped && fused_op->is_skipped;
+    }
+    if (step.skipped) {
+      continue;
+    }
+
+    // 融合后的中间结果不会写入自己的输出空间
+    step.op->is_skipped = false;
+    for (RuntimeOperator* fused_op : step.fused_ops) {
+      fused_op->is_skipped = false;
+    }
+    if (!step.fused_ops.empty()) {
+      for (const std::string& output_name : requested_outputs_) {
+        bool is_fused_output = output_name == step.op->name;
+        for (uint32_t i = 0; i + 1 < step.fused_ops.size(); ++i) {
+          is_fused_output = is_fused_output || output_name == step.fused_ops.at(i)->name;
+        }
+        LOG_IF(FATAL, is_fused_output)
+            << "The operand " << output_name
+            << " is fused away, request it before building the graph";
+      }
+    }
   }
 }
 
+bool RuntimeGraph::FuseResidualAdd(const std::shared_ptr<RuntimeOperator>& expression_op,
+                                   std::set<RuntimeOperator*>& fused_ops,
+                                   RuntimeExecutionStep& step) {
+  const auto& params = expression_op->params;
+  const auto expr_iter = params.find("expr");
+  if (expr_iter == params.end()) {
+    return false;
+  }
+  const auto expr = std::dynamic_pointer_cast<RuntimeParameterString>(expr_iter->second);
+  if (expr == nullptr || expr->value != "add(@0,@1)") {
+    return false;
+  }
+
+  const auto& input_operands = expression_op->input_operands_seq;
+  if (input_operands.size() != 2 || expression_op->input_operands.size() != 2 ||
+      input_operands.at(0)->shapes != input_operands.at(1)->shapes) {
+    return false;
+  }
+
+  const auto is_requested = [this](const std::string& op_name) {
+    return std::find(requested_outputs_.begin(), requested_outputs_.end(), op_name) !=
+           requested_outputs_.end();
+  };
+
+  for (uint32_t i = 0; i < input_operands.size(); ++i) {
+    const auto& conv_operand = input_operands.at(i);
+    const auto& residual_operand = input_operands.at(1 - i);
+
+    std::shared_ptr<RuntimeOperator> conv_op;
+    for (const auto& op : operators_) {
+      if (op->name == conv_operand->name) {
+        conv_op = op;
+        break;
+      }
+    }
+    // 卷积的输出只能被残差相加使用
+    if (conv_op == nullptr || fused_ops.count(conv_op.get()) || is_requested(conv_op->name) ||
+        (conv_op->type != "nn.Conv2d" && conv_op->type != "nn.ConvTranspose2d" &&
+         conv_op->type != "kuiper.DepthwisePointwise") ||
+        conv_op->output_operators.size() != 1 || conv_op->layer == nullptr) {
+      continue;
+    }
+
+    std::shared_ptr<RuntimeOperator> last_op = expression_op;
+    std::shared_ptr<RuntimeOperator> activation_op;
+    if (expression_op->output_operators.size() == 1 && !is_requested(expression_op->name)) {
+      const auto& next_op = expression_op->output_operators.begin()->second;
+      if (next_op->input_operands_seq.size() == 1 && !is_output_op(next_op->name) &&
+          next_op->output_operands != nullptr) {
+        activation_op = next_op;
+      }
+    }
+
+    if (activation_op != nullptr && conv_op->layer->FuseResidualAdd(activation_op->type)) {
+      last_op = activation_op;
+    } else if (!conv_op->layer->FuseResidualAdd("")) {
+      continue;
+    }
+
+    fused_ops.insert(conv_op.get());
+    fused_ops.insert(expression_op.get());
+    fused_ops.insert(last_op.get());
+
+    step.op = conv_op.get();
+    step.layer = conv_op->layer.get();
+    step.fused_ops.push_back(expression_op.get());
+    if (last_op != expression_op) {
+      step.fused_ops.push_back(last_op.get());
+    }
+    step.input_operands = conv_op->input_operands_seq;
+    step.input_operands.push_back(residual_operand);
+    step.outputs = &last_op->output_operands->datas;
+    return true;
+  }
+  return false;
+}
+
+bool RuntimeGraph::BindExecutionInputs() {
+  bool inputs_bound = true;
+  for (RuntimeExecutionStep& step : execution_plan_) {
+    step.inputs.clear();
+    for (const auto& input_operand : step.input_operands) {
+      CHECK(input_operand != nullptr)
+          << "The input operand of the op " << step.op->name << " is empty";
+      for (const sftensor& input_data : input_operand->datas) {
+        if (!step.skipped && (input_data == nullptr || input_data->empty())) {
+          inputs_bound = false;
+        }
+        step.inputs.push_back(input_data);
+      }
+    }
+    if (!step.skipped && step.inputs.empty()) {
+      LOG(ERROR) << step.op->name << " Layer input data is empty";
+      inputs_bound = false;
+    }
+    BindExecutionViews(step);
+  }
+  return inputs_bound;
+}
+
+void RuntimeGraph::BindExecutionViews(RuntimeExecutionStep& step) {
+  step.input_views.clear();
+  step.output_views.clear();
+  if (step.layer == nullptr || !step.layer->supports_views() || step.outputs == nullptr) {
+    return;
+  }
+  // 输入输出都已申请时才绑定视图，否则仍由共享指针的接口申请输出
+  std::vector<TensorView> input_views = MakeTensorViews(step.inputs);
+  std::vector<TensorView> output_views = MakeTensorViews(*step.outputs);
+  const auto is_empty = [](const TensorView& view) { return view.empty(); };
+  if (input_views.empty() || output_views.empty() ||
+      std::any_of(input_views.begin(), input_views.end(), is_empty) ||
+      std::any_of(output_views.begin(), output_views.end(), is_empty)) {
+    return;
+  }
+  step.input_views = std::move(input_views);
+  step.output_views = std::move(output_views);
+}
+
 std::shared_ptr<Layer<float>> RuntimeGraph::CreateLayer(
     const std::shared_ptr<RuntimeOperator>& op) {
   LOG_IF(FATAL, !op) << "Operator is empty!";
@@ -343,7 +803,7 @@ void RuntimeGraph::PropagateLayerOutputs(const std::shared_ptr<RuntimeOperator>&
       for (uint32_t i = 0; i < next_input_datas.size(); ++i) {
         const sftensor& layer_output_data = layer_output_datas.at(i);
         if (next_input_datas.at(i) != nullptr) {
-          CHECK(next_input_datas.at(i)->shapes() == layer_output_data->shapes());
+          CHECK(TensorShapeIsSame(next_input_datas.at(i), layer_output_data));
         }
         next_input_datas.at(i) = layer_output_data;
       }
@@ -438,7 +898,106 @@ void RuntimeGraph::set_inputs(const std::string& input_name, const std::vector<s
     }
   }
   CHECK(input_op != nullptr) << "Can not find the input operator: " << input_name;
+  RemoveBinding(input_bindings_, input_name);
+
+  // 输入与模型声明的形状不一致时，各层重新带着完整检查执行
+  const auto& input_operand = input_op->output_operands;
+  bool shapes_matched = input_operand != nullptr && !input_operand->shapes.empty() &&
+                        input_operand->shapes.front() == int32_t(inputs.size());
+  for (const sftensor& input : inputs) {
+    shapes_matched = shapes_matched && TensorMatchesOperand(input, input_operand->shapes);
+  }
+  if (!shapes_matched) {
+    ResetValidation();
+  }
   PropagateLayerOutputs(input_op, inputs);
+  plan_inputs_bound_ = BindExecutionInputs();
+}
+
+void RuntimeGraph::set_outputs(const std::string& output_name,
+                               const std::vector<sftensor>& outputs) {
+  CHECK(this->graph_state_ == GraphState::Complete);
+  std::shared_ptr<RuntimeOperator> output_op;
+  for (auto op : this->output_ops_) {
+    if (op->name == output_name) {
+      output_op = op;
+      break;
+    }
+  }
+  CHECK(output_op != nullptr) << "Can not find the output operator: " << output_name;
+  CHECK_EQ(output_op->input_operands_seq.size(), 1)
+      << "The output operator " << output_name << " has more than one input operand";
+  RemoveBinding(output_bindings_, output_name);
+
+  const std::string& producer_name = output_op->input_operands_seq.front()->name;
+  std::shared_ptr<RuntimeOperator> producer_op;
+  for (const auto& op : this->operators_) {
+    if (op->name == producer_name) {
+      producer_op = op;
+      break;
+    }
+  }
+  CHECK(producer_op != nullptr && !is_input_op(producer_name))
+      << "Can not find the producer of the output: " << output_name;
+
+  std::vector<sftensor>& output_datas = producer_op->output_operands->datas;
+  CHECK_EQ(output_datas.size(), outputs.size())
+      << "The batch size of the output " << output_name << " is mismatched";
+  for (uint32_t i = 0; i < outputs.size(); ++i) {
+    const sftensor& output = outputs.at(i);
+    CHECK(output != nullptr && output->shapes() == output_datas.at(i)->shapes())
+        << "The shape of the output tensor " << i << " is mismatched";
+    output_datas.at(i) = output;
+  }
+  // 执行计划中的输出指向同一个数组，只需要更新后继节点的输入
+  PropagateLayerOutputs(producer_op, output_datas);
+  plan_inputs_bound_ = BindExecutionInputs();
+}
+
+void RuntimeGraph::bind_input(const std::string& input_name, const ExternalBuffer& buffer) {
+  CHECK(this->graph_state_ == GraphState::Complete);
+  const auto input_iter =
+      std::find_if(input_ops_.begin(), input_ops_.end(),
+                   [&input_name](const auto& op) { return op->name == input_name; });
+  CHECK(input_iter != input_ops_.end()) << "Can not find the input operator: " << input_name;
+  CheckBufferShape(buffer, (*input_iter)->output_operands->shapes, input_name);
+
+  if (buffer.IsTensorLayout()) {
+    set_inputs(input_name, WrapBuffer(buffer));
+    return;
+  }
+  BufferBinding binding{input_name, buffer, CreateBufferTensors(buffer)};
+  set_inputs(input_name, binding.tensors);
+  input_bindings_.push_back(std::move(binding));
+}
+
+void RuntimeGraph::bind_output(const std::string& output_name, const ExternalBuffer& buffer) {
+  CHECK(this->graph_state_ == GraphState::Complete);
+  const auto output_iter =
+      std::find_if(output_ops_.begin(), output_ops_.end(),
+                   [&output_name](const auto& op) { return op->name == output_name; });
+  CHECK(output_iter != output_ops_.end()) << "Can not find the output operator: " << output_name;
+  const auto& output_operands = (*output_iter)->input_operands_seq;
+  CHECK(!output_operands.empty() && output_operands.front() != nullptr)
+      << "The output operator " << output_name << " has no input operand";
+  CheckBufferShape(buffer, output_operands.front()->shapes, output_name);
+
+  if (buffer.IsTensorLayout()) {
+    set_outputs(output_name, WrapBuffer(buffer));
+    return;
+  }
+  // 输出先写入引擎自己的张量，Forward结束时再转换到调用方的缓冲区
+  BufferBinding binding{output_name, buffer, CreateBufferTensors(buffer)};
+  set_outputs(output_name, binding.tensors);
+  output_bindings_.push_back(std::move(binding));
+}
+
+void RuntimeGraph::set_requested_outputs(const std::vector<std::string>& output_names) {
+  requested_outputs_ = output_names;
+  if (graph_state_ == GraphState::Complete) {
+    MarkRequiredOperators();
+    plan_inputs_bound_ = BindExecutionInputs();
+  }
 }
 
 std::vector<sftensor> RuntimeGraph::get_outputs(const std::string& output_name) const {
@@ -450,12 +1009,40 @@ std::vector<sftensor> RuntimeGraph::get_outputs(const std::string& output_name)
     }
   }
 
-  CHECK(output_op != nullptr) << "Can not find the output operator: " << output_name;
   std::vector<sftensor> outputs;
-  for (const auto& input_operand : output_op->input_operands_seq) {
-    std::copy(input_operand->datas.begin(), input_operand->datas.end(),
-              std::back_inserter(outputs));
+  if (output_op != nullptr) {
+    CHECK(!output_op->is_skipped) << "The output is not requested: " << output_name;
+    for (const auto& input_operand : output_op->input_operands_seq) {
+      std::copy(input_operand->datas.begin(), input_operand->datas.end(),
+                std::back_inserter(outputs));
+    }
+    return outputs;
+  }
+
+  // 读取中间节点的输出
+  for (const auto& op : this->operators_) {
+    if (op->name == output_name && !is_input_op(op->name)) {
+      output_op = op;
+      break;
+    }
+  }
+  CHECK(output_op != nullptr) << "Can not find the output operator: " << output_name;
+  CHECK(!output_op->is_skipped) << "The output is not requested: " << output_name;
+  // 融合步骤只写入最后一个算子的输出，其余算子的输出空间不会被更新
+  for (const RuntimeExecutionStep& step : execution_plan_) {
+    if (step.fused_ops.empty()) {
+      continue;
+    }
+    bool is_fused_output = step.op == output_op.get();
+    for (uint32_t i = 0; i + 1 < step.fused_ops.size(); ++i) {
+      is_fused_output = is_fused_output || step.fused_ops.at(i) == output_op.get();
+    }
+    CHECK(!is_fused_output) << "The operand " << output_name
+                            << " is fused away, request it before building the graph";
   }
+  CHECK(output_op->output_operands != nullptr)
+      << "The output operand of the op " << output_name << " is empty";
+  outputs = output_op->output_operands->datas;
   return outputs;
 }
 
@@ -0,0 +1,267 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-20.
+
+#include "runtime/runtime_numa.hpp"
+#include <glog/logging.h>
+#include <omp.h>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <utility>
+#include "data/tensor_util.hpp"
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace kuiper_infer {
+
+namespace {
+constexpr uint32_t kMaxNumaNodes = 64;
+constexpr int kMemoryPolicyPreferred = 1;  // MPOL_PREFERRED
+
+// 离开作用域时减少节点的待处理请求数，任务抛出异常时也会执行
+class PendingGuard {
+ public:
+  explicit PendingGuard(std::atomic<uint32_t>& pending) : pending_(pending) { pending_ += 1; }
+  ~PendingGuard() { pending_ -= 1; }
+  PendingGuard(const PendingGuard&) = delete;
+  PendingGuard& operator=(const PendingGuard&) = delete;
+
+ private:
+  std::atomic<uint32_t>& pending_;
+};
+}  // namespace
+
+std::vector<uint32_t> NumaTopology::ParseCpuList(const std::string& cpu_list) {
+  std::vector<uint32_t> cpus;
+  std::stringstream cpu_stream(cpu_list);
+  std::string cpu_range;
+  while (std::getline(cpu_stream, cpu_range, ',')) {
+    if (cpu_range.empty() || cpu_range == "\n") {
+      continue;
+    }
+    const size_t dash_pos = cpu_range.find('-');
+    const uint32_t first = std::stoul(cpu_range.substr(0, dash_pos));
+    const uint32_t last =
+        dash_pos == std::string::npos ? first : std::stoul(cpu_range.substr(dash_pos + 1));
+    CHECK_LE(first, last) << "Invalid cpu range: " << cpu_range;
+    for (uint32_t cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+NumaTopology NumaTopology::SingleNode() {
+  NumaTopology topology;
+  topology.node_ids.push_back(0);
+  std::vector<uint32_t> cpus;
+  const uint32_t cpu_count = std::max(1u, std::thread::hardware_concurrency());
+  for (uint32_t cpu = 0; cpu < cpu_count; ++cpu) {
+    cpus.push_back(cpu);
+  }
+  topology.node_cpus.push_back(cpus);
+  return topology;
+}
+
+NumaTopology NumaTopology::Detect(const std::string& node_root) {
+  NumaTopology topology;
+  for (uint32_t node_id = 0; node_id < kMaxNumaNodes; ++node_id) {
+    std::ifstream cpu_list_file(node_root + "/node" + std::to_string(node_id) + "/cpulist");
+    if (!cpu_list_file.is_open()) {
+      continue;
+    }
+    std::string cpu_list;
+    std::getline(cpu_list_file, cpu_list);
+    std::vector<uint32_t> cpus = ParseCpuList(cpu_list);
+    // 没有cpu的节点(例如只有内存的节点)不参与计算
+    if (!cpus.empty()) {
+      topology.node_ids.push_back(node_id);
+      topology.node_cpus.push_back(std::move(cpus));
+    }
+  }
+  if (topology.node_count() == 0) {
+    LOG(INFO) << "Can not detect the numa topology, fall back to a single node";
+    return SingleNode();
+  }
+  return topology;
+}
+
+bool PinThreadToNode(const NumaTopology& topology, uint32_t node_index) {
+  CHECK_LT(node_index, topology.node_count());
+#ifdef __linux__
+  const std::vector<uint32_t>& cpus = topology.node_cpus.at(node_index);
+  if (cpus.empty()) {
+    return false;
+  }
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (const uint32_t cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpu_set);
+    }
+  }
+  return sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+#else
+  return false;
+#endif
+}
+
+bool PreferNodeMemory(const NumaTopology& topology, uint32_t node_index) {
+  CHECK_LT(node_index, topology.node_count());
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+  const uint32_t node_id = topology.node_ids.at(node_index);
+  const uint32_t bits_per_mask = sizeof(unsigned long) * 8;
+  unsigned long node_mask[kMaxNumaNodes / (sizeof(unsigned long) * 8) + 1] = {0};
+  node_mask[node_id / bits_per_mask] |= 1ul << (node_id % bits_per_mask);
+  return syscall(SYS_set_mempolicy, kMemoryPolicyPreferred, node_mask, kMaxNumaNodes + 1) == 0;
+#else
+  return false;
+#endif
+}
+
+RuntimeNumaGraph::RuntimeNumaGraph(std::string param_path, std::string bin_path,
+                                   NumaTopology topology)
+    : param_path_(std::move(param_path)),
+      bin_path_(std::move(bin_path)),
+      topology_(std::move(topology)) {
+  CHECK_GT(topology_.node_count(), 0) << "The numa topology is empty";
+  CHECK_EQ(topology_.node_ids.size(), topology_.node_cpus.size());
+  for (uint32_t i = 0; i < topology_.node_count(); ++i) {
+    workers_.push_back(std::make_unique<NodeWorker>());
+  }
+  for (uint32_t i = 0; i < topology_.node_count(); ++i) {
+    workers_.at(i)->thread = std::thread(&RuntimeNumaGraph::WorkerLoop, this, i);
+  }
+}
+
+RuntimeNumaGraph::~RuntimeNumaGraph() {
+  for (const auto& worker : workers_) {
+    {
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      worker->stop = true;
+    }
+    worker->condition.notify_all();
+  }
+  for (const auto& worker : workers_) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+void RuntimeNumaGraph::WorkerLoop(uint32_t node_index) {
+  // 单节点时不需要绑定，保持系统默认的调度和内存策略
+  if (topology_.node_count() > 1) {
+    LOG_IF(WARNING, !PinThreadToNode(topology_, node_index))
+        << "Can not pin the worker to the numa node " << topology_.node_ids.at(node_index);
+    LOG_IF(WARNING, !PreferNodeMemory(topology_, node_index))
+        << "Can not prefer the memory of the numa node " << topology_.node_ids.at(node_index);
+    omp_set_num_threads(int(topology_.node_cpus.at(node_index).size()));
+  }
+
+  NodeWorker& worker = *workers_.at(node_index);
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(worker.mutex);
+      worker.condition.wait(lock, [&worker]() { return worker.stop || !worker.tasks.empty(); });
+      if (worker.tasks.empty()) {
+        break;
+      }
+      task = std::move(worker.tasks.front());
+      worker.tasks.pop_front();
+    }
+    task();
+  }
+}
+
+void RuntimeNumaGraph::RunOnNode(uint32_t node_index, std::function<void()> task) {
+  CHECK_LT(node_index, workers_.size());
+  NodeWorker& worker = *workers_.at(node_index);
+  std::packaged_task<void()> packaged_task(std::move(task));
+  std::future<void> task_future = packaged_task.get_future();
+  PendingGuard pending_guard(worker.pending);
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.emplace_back([&packaged_task]() { packaged_task(); });
+  }
+  worker.condition.notify_one();
+  task_future.get();
+}
+
+void RuntimeNumaGraph::Build() {
+  std::vector<std::thread> build_threads;
+  for (uint32_t i = 0; i < workers_.size(); ++i) {
+    // 在节点的工作线程上构建，权重和激活空间由该节点首次访问并分配在本地内存
+    build_threads.emplace_back([this, i]() {
+      RunOnNode(i, [this, i]() {
+        auto graph = std::make_shared<RuntimeGraph>(param_path_, bin_path_);
+        graph->Build();
+        workers_.at(i)->graph = graph;
+      });
+    });
+  }
+  for (std::thread& build_thread : build_threads) {
+    build_thread.join();
+  }
+}
+
+std::vector<sftensor> RuntimeNumaGraph::Forward(uint32_t node_index, const std::string& input_name,
+                                                const std::vector<sftensor>& inputs,
+                                                const std::string& output_name) {
+  std::vector<sftensor> outputs;
+  RunOnNode(node_index, [&]() {
+    RuntimeGraph& graph = replica(node_index);
+    graph.set_inputs(input_name, inputs);
+    graph.Forward(false);
+    for (const sftensor& output : graph.get_outputs(output_name)) {
+      outputs.push_back(TensorClone(output));
+    }
+  });
+  return outputs;
+}
+
+std::vector<sftensor> RuntimeNumaGraph::Forward(const std::string& input_name,
+                                                const std::vector<sftensor>& inputs,
+                                                const std::string& output_name) {
+  uint32_t node_index = 0;
+  for (uint32_t i = 1; i < workers_.size(); ++i) {
+    if (workers_.at(i)->pending < workers_.at(node_index)->pending) {
+      node_index = i;
+    }
+  }
+  return Forward(node_index, input_name, inputs, output_name);
+}
+
+const NumaTopology& RuntimeNumaGraph::topology() const { return topology_; }
+
+RuntimeGraph& RuntimeNumaGraph::replica(uint32_t node_index) {
+  CHECK_LT(node_index, workers_.size());
+  CHECK(workers_.at(node_index)->graph != nullptr) << "The numa graph need be build!";
+  return *workers_.at(node_index)->graph;
+}
+
+}  // namespace kuiper_infer
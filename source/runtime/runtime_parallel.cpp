@@ -0,0 +1,128 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-29.
+
+#include "runtime/runtime_parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+namespace kuiper_infer {
+
+namespace {
+/// 每个线程至少分到的计算量和访存量，再少则创建线程的开销超过收益
+constexpr double kFlopsPerThread = 256. * 1024.;
+constexpr double kBytesPerThread = 64. * 1024.;
+
+double ShapeElements(const std::vector<int32_t>& shapes) {
+  if (shapes.empty()) {
+    return 0.;
+  }
+  return std::accumulate(shapes.begin(), shapes.end(), 1., std::multiplies<double>());
+}
+
+double WeightElements(const RuntimeOperator& op, std::vector<int32_t>* weight_shape) {
+  const auto weight_iter = op.attribute.find("weight");
+  if (weight_iter == op.attribute.end() || weight_iter->second == nullptr) {
+    return 0.;
+  }
+  if (weight_shape != nullptr) {
+    *weight_shape = weight_iter->second->shape;
+  }
+  const auto bias_iter = op.attribute.find("bias");
+  double bias_elements = 0.;
+  if (bias_iter != op.attribute.end() && bias_iter->second != nullptr) {
+    bias_elements = ShapeElements(bias_iter->second->shape);
+  }
+  return ShapeElements(weight_iter->second->shape) + bias_elements;
+}
+}  // namespace
+
+OperatorCost EstimateOperatorCost(const RuntimeOperator& op) {
+  OperatorCost cost;
+  std::vector<std::vector<int32_t>> input_shapes;
+  double input_elements = 0.;
+  for (const auto& input_operand : op.input_operands_seq) {
+    if (input_operand != nullptr) {
+      input_shapes.push_back(input_operand->shapes);
+      input_elements += ShapeElements(input_operand->shapes);
+    }
+  }
+
+  std::vector<int32_t> output_shapes;
+  if (op.output_operands != nullptr && !op.output_operands->shapes.empty()) {
+    output_shapes = op.output_operands->shapes;
+    cost.batch_size = uint32_t(std::max(output_shapes.front(), 1));
+    // 卷积类算子在样本内按输出通道切分，全连接层按输出特征切分，其余算子不限制
+    if (output_shapes.size() == 4) {
+      cost.channels = uint32_t(std::max(output_shapes.at(1), 1));
+    } else if (op.type == "nn.Linear") {
+      cost.channels = uint32_t(std::max(output_shapes.back(), 1));
+    }
+  }
+  const double output_elements = ShapeElements(output_shapes);
+
+  if (op.layer != nullptr) {
+    static_cast<LayerCost&>(cost) = op.layer->Cost(input_shapes, output_shapes);
+    return cost;
+  }
+
+  std::vector<int32_t> weight_shape;
+  cost.parameters = WeightElements(op, &weight_shape);
+  if (weight_shape.size() >= 2 && weight_shape.front() > 0) {
+    // 每个输出(反卷积为每个输入)元素与一个卷积核或权重行做乘加
+    const double kernel_elements = ShapeElements(weight_shape) / weight_shape.front();
+    if (op.type == "nn.ConvTranspose2d") {
+      cost.flops = 2. * input_elements * kernel_elements;
+    } else {
+      cost.flops = 2. * output_elements * kernel_elements;
+    }
+  } else {
+    cost.flops = std::max(input_elements, output_elements);
+  }
+  cost.weight_bytes = cost.parameters * sizeof(float);
+  cost.input_bytes = input_elements * sizeof(float);
+  cost.output_bytes = output_elements * sizeof(float);
+  return cost;
+}
+
+ParallelPlan PlanParallelism(const OperatorCost& cost, uint32_t thread_budget) {
+  thread_budget = std::max(thread_budget, 1u);
+  const double work_threads =
+      std::max(cost.flops / kFlopsPerThread, cost.bytes() / kBytesPerThread);
+  const uint32_t useful_threads =
+      uint32_t(std::clamp(std::floor(work_threads), 1., double(thread_budget)));
+
+  ParallelPlan parallel_plan;
+  parallel_plan.batch_threads = std::min(std::max(cost.batch_size, 1u), useful_threads);
+  const uint32_t max_intra_threads = cost.channels > 0 ? cost.channels : useful_threads;
+  parallel_plan.intra_threads =
+      std::clamp(useful_threads / parallel_plan.batch_threads, 1u, max_intra_threads);
+  return parallel_plan;
+}
+
+std::string ParallelPlanToString(const ParallelPlan& parallel_plan) {
+  return std::to_string(parallel_plan.batch_threads) + "x" +
+         std::to_string(parallel_plan.intra_threads);
+}
+}  // namespace kuiper_infer
@@ -0,0 +1,245 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-6.
+
+#include "runtime/runtime_scheduler.hpp"
+#include <glog/logging.h>
+#include <omp.h>
+#include <utility>
+#include "data/tensor_util.hpp"
+
+namespace kuiper_infer {
+
+RuntimeScheduler::RuntimeScheduler(uint32_t worker_count, uint32_t threads_per_worker)
+    : threads_per_worker_(threads_per_worker) {
+  CHECK_GT(worker_count, 0) << "The scheduler needs at least one worker";
+  CHECK_GT(threads_per_worker, 0) << "The worker needs at least one thread";
+  for (uint32_t i = 0; i < worker_count; ++i) {
+    workers_.emplace_back(&RuntimeScheduler::WorkerLoop, this);
+  }
+}
+
+RuntimeScheduler::~RuntimeScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  condition_.notify_all();
+  for (std::thread& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+void RuntimeScheduler::RegisterModel(const std::string& model_name,
+                                     std::shared_ptr<RuntimeGraph> graph) {
+  CHECK(graph != nullptr) << "The graph of the model " << model_name << " is empty";
+  CHECK_GT(graph->plan_size(), 0) << "The graph of the model " << model_name
+                                  << " need be build!";
+  std::lock_guard<std::mutex> lock(mutex_);
+  CHECK(models_.find(model_name) == models_.end())
+      << "The model " << model_name << " has been registered";
+  auto model = std::make_unique<Model>();
+  model->name = model_name;
+  model->graph = std::move(graph);
+  models_.insert({model_name, std::move(model)});
+}
+
+std::future<RuntimeRequestResult> RuntimeScheduler::Submit(
+    const std::string& model_name, const std::string& input_name, std::vector<sftensor> inputs,
+    const std::string& output_name, int32_t priority, Clock::time_point deadline) {
+  auto request = std::make_unique<Request>();
+  request->input_name = input_name;
+  request->output_name = output_name;
+  request->inputs = std::move(inputs);
+  request->priority = priority;
+  request->deadline = deadline;
+  request->submit_time = Clock::now();
+  std::future<RuntimeRequestResult> future = request->promise.get_future();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CHECK(!stop_) << "The scheduler has been stopped";
+    const auto model_iter = models_.find(model_name);
+    CHECK(model_iter != models_.end()) << "Can not find the model: " << model_name;
+    request->sequence = sequence_++;
+    Model* model = model_iter->second.get();
+    model->pending.push_back(std::move(request));
+    model->metrics.queued += 1;
+  }
+  condition_.notify_one();
+  return future;
+}
+
+RuntimeModelMetrics RuntimeScheduler::metrics(const std::string& model_name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto model_iter = models_.find(model_name);
+  CHECK(model_iter != models_.end()) << "Can not find the model: " << model_name;
+  const Model* model = model_iter->second.get();
+  RuntimeModelMetrics metrics = model->metrics;
+  if (metrics.completed > 0) {
+    metrics.avg_queue_time = model->total_queue_time / double(metrics.completed);
+    metrics.avg_latency = model->total_latency / double(metrics.completed);
+  }
+  return metrics;
+}
+
+void RuntimeScheduler::set_step_observer(StepObserver observer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  step_observer_ =
+      observer ? std::make_shared<const StepObserver>(std::move(observer)) : nullptr;
+}
+
+bool RuntimeScheduler::HasPrecedence(const Request& lhs, const Request& rhs) {
+  if (lhs.priority != rhs.priority) {
+    return lhs.priority > rhs.priority;
+  }
+  if (lhs.deadline != rhs.deadline) {
+    return lhs.deadline < rhs.deadline;
+  }
+  return lhs.sequence < rhs.sequence;
+}
+
+RuntimeScheduler::Model* RuntimeScheduler::PickModel() {
+  Model* picked_model = nullptr;
+  const Request* picked_request = nullptr;
+  for (auto& [model_name, model] : models_) {
+    if (model->busy) {
+      continue;
+    }
+    // 正在执行的请求占用了模型的张量，只能等它结束后再开始新的请求
+    const Request* request = model->current.get();
+    if (request == nullptr) {
+      for (const auto& pending_request : model->pending) {
+        if (request == nullptr || HasPrecedence(*pending_request, *request)) {
+          request = pending_request.get();
+        }
+      }
+    }
+    if (request != nullptr &&
+        (picked_request == nullptr || HasPrecedence(*request, *picked_request))) {
+      picked_model = model.get();
+      picked_request = request;
+    }
+  }
+  return picked_model;
+}
+
+void RuntimeScheduler::WorkerLoop() {
+  omp_set_num_threads(int(threads_per_worker_));
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    Model* model = nullptr;
+    condition_.wait(lock, [this, &model]() {
+      model = PickModel();
+      if (model != nullptr || !stop_) {
+        return model != nullptr;
+      }
+      for (const auto& [model_name, registered_model] : models_) {
+        if (registered_model->busy) {
+          return false;
+        }
+      }
+      return true;
+    });
+    if (model == nullptr) {
+      break;
+    }
+    RunStep(model, lock);
+  }
+}
+
+void RuntimeScheduler::RunStep(Model* model, std::unique_lock<std::mutex>& lock) {
+  model->busy = true;
+  if (model->current == nullptr) {
+    auto best_iter = model->pending.begin();
+    for (auto iter = model->pending.begin(); iter != model->pending.end(); ++iter) {
+      if (HasPrecedence(**iter, **best_iter)) {
+        best_iter = iter;
+      }
+    }
+    model->current = std::move(*best_iter);
+    model->pending.erase(best_iter);
+    model->next_step = 0;
+    model->metrics.queued -= 1;
+
+    if (Clock::now() > model->current->deadline) {
+      model->metrics.expired += 1;
+      RuntimeRequestResult result;
+      result.status = StatusCode::kInferDeadlineExceeded;
+      FinishRequest(model, std::move(result));
+      model->busy = false;
+      condition_.notify_all();
+      return;
+    }
+  }
+
+  Request* request = model->current.get();
+  const uint32_t step_index = model->next_step;
+  const bool is_last_step = step_index + 1 == model->graph->plan_size();
+  const std::shared_ptr<const StepObserver> step_observer = step_observer_;
+  lock.unlock();
+
+  RuntimeGraph* graph = model->graph.get();
+  if (step_index == 0) {
+    request->start_time = Clock::now();
+    graph->set_inputs(request->input_name, request->inputs);
+  }
+  RuntimeRequestResult result;
+  result.status = graph->ForwardStep(step_index);
+  const bool finished = is_last_step || result.status != StatusCode::kSuccess;
+  if (finished && result.status == StatusCode::kSuccess) {
+    // 输出张量会被下一个请求复用，需要拷贝一份
+    for (const sftensor& output : graph->get_outputs(request->output_name)) {
+      result.outputs.push_back(TensorClone(output));
+    }
+  }
+  if (step_observer) {
+    (*step_observer)(model->name, step_index);
+  }
+
+  lock.lock();
+  model->next_step += 1;
+  if (finished) {
+    using namespace std::chrono;
+    const Clock::time_point finish_time = Clock::now();
+    model->metrics.completed += 1;
+    model->total_queue_time +=
+        duration_cast<duration<double, std::milli>>(request->start_time - request->submit_time)
+            .count();
+    model->total_latency +=
+        duration_cast<duration<double, std::milli>>(finish_time - request->submit_time).count();
+    FinishRequest(model, std::move(result));
+  }
+  model->busy = false;
+  condition_.notify_all();
+}
+
+void RuntimeScheduler::FinishRequest(Model* model, RuntimeRequestResult result) {
+  CHECK(model->current != nullptr);
+  model->current->promise.set_value(std::move(result));
+  model->current.reset();
+  model->next_step = 0;
+}
+
+}  // namespace kuiper_infer
@@ -0,0 +1,178 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-28.
+// __GLIBC__由libc的头文件定义，判断之前先包含一个标准头文件
+#include <cstddef>
+#if defined(__linux__) && defined(__GLIBC__)
+#include <dlfcn.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include "runtime/runtime_ir.hpp"
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+}
+
+namespace {
+std::atomic<bool> g_count_allocations{false};
+std::atomic<uint64_t> g_allocation_count{0};
+
+// OpenMP运行时在进入嵌套并行区域时会为线程组申请内存，这部分不属于推理框架，不计入统计
+bool IsOpenMPRuntime(void* caller) {
+  Dl_info info;
+  if (dladdr(caller, &info) == 0 || info.dli_fname == nullptr) {
+    return false;
+  }
+  return std::strstr(info.dli_fname, "libgomp") != nullptr;
+}
+
+// 对齐值必须是2的幂，posix_memalign还要求是指针大小的整数倍
+bool IsValidAlignment(size_t alignment) {
+  return alignment != 0 && (alignment & (alignment - 1)) == 0;
+}
+
+void RecordAllocation(void* caller) {
+  if (g_count_allocations.load(std::memory_order_relaxed) && !IsOpenMPRuntime(caller)) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+uint64_t CountForwardAllocations(kuiper_infer::RuntimeGraph& graph) {
+  g_allocation_count = 0;
+  g_count_allocations = true;
+  graph.Forward(false);
+  g_count_allocations = false;
+  return g_allocation_count;
+}
+}  // namespace
+
+// 替换malloc系列函数，operator new以及armadillo的内存申请最终都会经过这里，
+// 替换对整个程序生效，所以本文件单独编译成test_alloc_free
+extern "C" {
+void* malloc(size_t size) {
+  RecordAllocation(__builtin_return_address(0));
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  RecordAllocation(__builtin_return_address(0));
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  RecordAllocation(__builtin_return_address(0));
+  return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+  RecordAllocation(__builtin_return_address(0));
+  if (!IsValidAlignment(alignment) || alignment % sizeof(void*) != 0) {
+    return EINVAL;
+  }
+  void* mem = __libc_memalign(alignment, size);
+  if (mem == nullptr) {
+    return ENOMEM;
+  }
+  *ptr = mem;
+  return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  RecordAllocation(__builtin_return_address(0));
+  if (!IsValidAlignment(alignment)) {
+    errno = EINVAL;
+    return nullptr;
+  }
+  return __libc_memalign(alignment, size);
+}
+}
+
+using namespace kuiper_infer;
+
+static void SetBatchInputs(RuntimeGraph& graph, uint32_t batch_size, uint32_t channels,
+                           uint32_t rows, uint32_t cols) {
+  std::vector<sftensor> inputs;
+  for (uint32_t i = 0; i < batch_size; ++i) {
+    sftensor input = std::make_shared<Tensor<float>>(channels, rows, cols);
+    input->RandN();
+    inputs.push_back(input);
+  }
+  graph.set_inputs("pnnx_input_0", inputs);
+}
+
+TEST(test_alloc_free, aligned_alloc_alignment) {
+  void* ptr = nullptr;
+  ASSERT_EQ(posix_memalign(&ptr, 3 * sizeof(void*), 64), EINVAL);
+  ASSERT_EQ(posix_memalign(&ptr, sizeof(void*) / 2, 64), EINVAL);
+  ASSERT_EQ(posix_memalign(&ptr, 64, 100), 0);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % 64, 0);
+  free(ptr);
+
+  errno = 0;
+  ASSERT_EQ(aligned_alloc(48, 96), nullptr);
+  ASSERT_EQ(errno, EINVAL);
+  ptr = aligned_alloc(32, 96);
+  ASSERT_NE(ptr, nullptr);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % 32, 0);
+  free(ptr);
+}
+
+TEST(test_alloc_free, forward_resnet18) {
+  RuntimeGraph graph("tmp/resnet/resnet18_batch1.param", "tmp/resnet/resnet18_batch1.pnnx.bin");
+  graph.Build();
+  SetBatchInputs(graph, 1, 3, 224, 224);
+  // 第一次推理负责申请各层的工作空间，之后的推理不再申请内存
+  graph.Forward(false);
+  ASSERT_EQ(CountForwardAllocations(graph), 0);
+}
+
+TEST(test_alloc_free, forward_mobilenet) {
+  RuntimeGraph graph("tmp/mobilenet/mobile.pnnx.param", "tmp/mobilenet/mobile.pnnx.bin");
+  graph.Build();
+  SetBatchInputs(graph, 1, 3, 32, 32);
+  graph.Forward(false);
+  ASSERT_EQ(CountForwardAllocations(graph), 0);
+}
+
+TEST(test_alloc_free, forward_yolov5n_small) {
+  RuntimeGraph graph("tmp/yolo/demo/yolov5n_small.pnnx.param",
+                     "tmp/yolo/demo/yolov5n_small.pnnx.bin");
+  graph.Build();
+  SetBatchInputs(graph, 4, 3, 320, 320);
+  graph.Forward(false);
+  ASSERT_EQ(CountForwardAllocations(graph), 0);
+}
+
+TEST(test_alloc_free, forward_unet_deconv) {
+  RuntimeGraph graph("tmp/unet/demo_deconv.pnnx.param", "tmp/unet/demo_deconv.pnnx.bin");
+  graph.Build();
+  SetBatchInputs(graph, 1, 13, 13, 31);
+  graph.Forward(false);
+  ASSERT_EQ(CountForwardAllocations(graph), 0);
+}
+#endif
@@ -0,0 +1,150 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-3.
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include "data/npy.hpp"
+#include "runtime/pnnx/ir.h"
+#include "runtime/runtime_ir.hpp"
+
+static std::vector<float> RandomValues(uint32_t size, uint32_t seed) {
+  std::mt19937 engine(seed);
+  std::uniform_real_distribution<float> distribution(-0.5f, 0.5f);
+  std::vector<float> values(size);
+  for (float& value : values) {
+    value = distribution(engine);
+  }
+  return values;
+}
+
+static pnnx::Operator* FindOperator(pnnx::Graph& graph, const std::string& name) {
+  for (pnnx::Operator* op : graph.ops) {
+    if (op->name == name) {
+      return op;
+    }
+  }
+  return nullptr;
+}
+
+// 每个用例在自己的临时目录中生成、编译和运行模型，结束时删除
+class TestAotModel : public testing::Test {
+ protected:
+  void SetUp() override {
+    std::string pattern = (std::filesystem::temp_directory_path() / "kuiper_aot_XXXXXX").string();
+    ASSERT_NE(mkdtemp(pattern.data()), nullptr) << pattern;
+    dir_ = pattern;
+  }
+
+  void TearDown() override {
+    if (!dir_.empty()) {
+      std::error_code error;
+      std::filesystem::remove_all(dir_, error);
+    }
+  }
+
+  std::string Path(const std::string& name) const { return (dir_ / name).string(); }
+
+  std::filesystem::path dir_;
+};
+
+TEST_F(TestAotModel, compile_generated_model) {
+  using namespace kuiper_infer;
+  // bn没有特化的内核，通过层工厂创建，其余算子都调用特化的内核
+  const std::string param =
+      "7767517\n"
+      "13 12\n"
+      "pnnx.Input pnnx_input_0 0 1 0 #0=(1,3,12,12)f32\n"
+      "nn.Conv2d conv 1 1 0 1 activation=nn.ReLU bias=True dilation=(1,1) groups=1 "
+      "in_channels=3 kernel_size=(3,3) out_channels=8 padding=(1,1) padding_mode=zeros "
+      "stride=(1,1) #1=(1,8,12,12)f32\n"
+      "nn.MaxPool2d pool 1 1 1 2 ceil_mode=False dilation=(1,1) kernel_size=(2,2) "
+      "padding=(0,0) return_indices=False stride=(2,2) #2=(1,8,6,6)f32\n"
+      "nn.Conv2d dw 1 1 2 3 bias=True dilation=(1,1) groups=8 in_channels=8 kernel_size=(3,3) "
+      "out_channels=8 padding=(1,1) padding_mode=zeros stride=(1,1) #3=(1,8,6,6)f32\n"
+      "nn.BatchNorm2d bn 1 1 3 4 affine=True eps=1.000000e-05 num_features=8 "
+      "#4=(1,8,6,6)f32\n"
+      "pnnx.Expression add 2 1 2 4 5 expr=add(@0,@1) #5=(1,8,6,6)f32\n"
+      "nn.ReLU6 relu6 1 1 5 6 #6=(1,8,6,6)f32\n"
+      "nn.Conv2d down 1 1 6 7 bias=False dilation=(1,1) groups=2 in_channels=8 "
+      "kernel_size=(3,3) out_channels=12 padding=(1,1) padding_mode=zeros stride=(2,2) "
+      "#7=(1,12,3,3)f32\n"
+      "nn.Hardswish hardswish 1 1 7 8 #8=(1,12,3,3)f32\n"
+      "nn.AdaptiveAvgPool2d avgpool 1 1 8 9 output_size=(1,1) #9=(1,12,1,1)f32\n"
+      "torch.flatten flatten 1 1 9 10 end_dim=-1 start_dim=1 #10=(1,12)f32\n"
+      "nn.Linear linear 1 1 10 11 bias=True in_features=12 out_features=10 #11=(1,10)f32\n"
+      "pnnx.Output pnnx_output_0 1 0 11\n";
+  pnnx::Graph graph;
+  ASSERT_EQ(graph.parse(param), 0);
+  FindOperator(graph, "conv")->attrs["weight"] =
+      pnnx::Attribute({8, 3, 3, 3}, RandomValues(8 * 3 * 9, 1));
+  FindOperator(graph, "conv")->attrs["bias"] = pnnx::Attribute({8}, RandomValues(8, 2));
+  FindOperator(graph, "dw")->attrs["weight"] =
+      pnnx::Attribute({8, 1, 3, 3}, RandomValues(8 * 9, 3));
+  FindOperator(graph, "dw")->attrs["bias"] = pnnx::Attribute({8}, RandomValues(8, 4));
+  pnnx::Operator* bn = FindOperator(graph, "bn");
+  bn->attrs["running_mean"] = pnnx::Attribute({8}, RandomValues(8, 5));
+  bn->attrs["running_var"] = pnnx::Attribute({8}, std::vector<float>(8, 1.5f));
+  bn->attrs["weight"] = pnnx::Attribute({8}, RandomValues(8, 6));
+  bn->attrs["bias"] = pnnx::Attribute({8}, RandomValues(8, 7));
+  FindOperator(graph, "down")->attrs["weight"] =
+      pnnx::Attribute({12, 4, 3, 3}, RandomValues(12 * 4 * 9, 8));
+  FindOperator(graph, "linear")->attrs["weight"] =
+      pnnx::Attribute({10, 12}, RandomValues(10 * 12, 9));
+  FindOperator(graph, "linear")->attrs["bias"] = pnnx::Attribute({10}, RandomValues(10, 10));
+
+  const std::string param_path = Path("model.pnnx.param");
+  const std::string bin_path = Path("model.pnnx.bin");
+  const std::string cpp_path = Path("model.cpp");
+  const std::string exe_path = Path("model");
+  ASSERT_EQ(graph.save(param_path, bin_path), 0);
+  ASSERT_EQ(graph.cpp(cpp_path, bin_path), 0);
+
+  const std::string compile = std::string(KUIPER_AOT_COMPILER) + " -DKUIPER_AOT_MAIN " +
+                              cpp_path + " -o " + exe_path + " " + KUIPER_AOT_LIBS;
+  ASSERT_EQ(std::system(compile.c_str()), 0) << compile;
+
+  const std::string input_path = Path("input.npy");
+  const std::string output_path = Path("output.npy");
+  sftensor input = std::make_shared<Tensor<float>>(3, 12, 12);
+  input->RandN();
+  ASSERT_TRUE(NpyDataLoader::Save(input_path, *input));
+  const std::string run = exe_path + " " + bin_path + " 1 " + input_path + " " + output_path;
+  ASSERT_EQ(std::system(run.c_str()), 0) << run;
+
+  RuntimeGraph runtime_graph(param_path, bin_path);
+  runtime_graph.Build();
+  runtime_graph.set_inputs("pnnx_input_0", {input});
+  runtime_graph.Forward(false);
+  const std::vector<sftensor> expected = runtime_graph.get_outputs("pnnx_output_0");
+  ASSERT_EQ(expected.size(), 1);
+
+  const NpyArray output = NpyDataLoader::Load(output_path);
+  ASSERT_FALSE(output.empty());
+  const sftensor output_tensor = output.ToTensor();
+  ASSERT_EQ(output_tensor->size(), expected.front()->size());
+  for (uint32_t i = 0; i < output_tensor->size(); ++i) {
+    ASSERT_NEAR(output_tensor->index(i), expected.front()->index(i), 1e-4f) << i;
+  }
+}
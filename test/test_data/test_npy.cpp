@@ -0,0 +1,209 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-9.
+#include <gtest/gtest.h>
+#include <fstream>
+#include "data/npy.hpp"
+
+// 按numpy的格式手工写出一个npy文件
+static void WriteNpy(const std::string& file_path, const std::string& header, const void* data,
+                     size_t size) {
+  std::string npy("\x93NUMPY\x01\x00", 8);
+  const uint16_t header_size = uint16_t(header.size());
+  npy.append(reinterpret_cast<const char*>(&header_size), sizeof(header_size));
+  npy += header;
+  npy.append(static_cast<const char*>(data), size);
+  std::ofstream out(file_path, std::ios::binary);
+  out.write(npy.data(), std::streamsize(npy.size()));
+}
+
+TEST(test_npy, load_c_order) {
+  using namespace kuiper_infer;
+  const std::vector<float> data{0.f, 1.f, 2.f, 3.f, 4.f, 5.f};
+  WriteNpy("/tmp/kuiper_test_c_order.npy",
+           "{'descr': '<f4', 'fortran_order': False, 'shape': (2, 3), }\n", data.data(),
+           data.size() * sizeof(float));
+  const NpyArray array = NpyDataLoader::Load("/tmp/kuiper_test_c_order.npy");
+  ASSERT_FALSE(array.empty());
+  ASSERT_EQ(array.dtype(), RuntimeDataType::kTypeFloat32);
+  ASSERT_EQ(array.shape(), std::vector<uint32_t>({2, 3}));
+  ASSERT_EQ(array.size(), 6);
+  ASSERT_FALSE(array.is_tensor_layout());
+
+  const TensorView view = array.view();
+  ASSERT_EQ(view.channels(), 1);
+  ASSERT_EQ(view.rows(), 2);
+  ASSERT_EQ(view.cols(), 3);
+  for (uint32_t r = 0; r < 2; ++r) {
+    for (uint32_t c = 0; c < 3; ++c) {
+      ASSERT_EQ(view.at<const float>(0, r, c), data.at(r * 3 + c));
+    }
+  }
+}
+
+TEST(test_npy, load_fortran_order) {
+  using namespace kuiper_infer;
+  const std::vector<int32_t> data{0, 3, 1, 4, 2, 5};
+  WriteNpy("/tmp/kuiper_test_f_order.npy",
+           "{'descr': '<i4', 'fortran_order': True, 'shape': (2, 3), }\n", data.data(),
+           data.size() * sizeof(int32_t));
+  const NpyArray array = NpyDataLoader::Load("/tmp/kuiper_test_f_order.npy");
+  ASSERT_FALSE(array.empty());
+  ASSERT_EQ(array.dtype(), RuntimeDataType::kTypeInt32);
+  ASSERT_TRUE(array.fortran_order());
+
+  const TensorView view = array.view();
+  for (uint32_t r = 0; r < 2; ++r) {
+    for (uint32_t c = 0; c < 3; ++c) {
+      ASSERT_EQ(view.at<const int32_t>(0, r, c), int32_t(r * 3 + c));
+    }
+  }
+}
+
+TEST(test_npy, load_invalid) {
+  using namespace kuiper_infer;
+  const std::vector<float> data{0.f, 1.f};
+  WriteNpy("/tmp/kuiper_test_truncated.npy",
+           "{'descr': '<f4', 'fortran_order': False, 'shape': (2, 3), }\n", data.data(),
+           data.size() * sizeof(float));
+  ASSERT_TRUE(NpyDataLoader::Load("/tmp/kuiper_test_truncated.npy").empty());
+  WriteNpy("/tmp/kuiper_test_float64.npy",
+           "{'descr': '<f8', 'fortran_order': False, 'shape': (1,), }\n", data.data(),
+           data.size() * sizeof(float));
+  ASSERT_TRUE(NpyDataLoader::Load("/tmp/kuiper_test_float64.npy").empty());
+  ASSERT_TRUE(NpyDataLoader::Load("/tmp/kuiper_test_missing.npy").empty());
+
+  // 损坏的头部和字节数溢出的形状返回空数组，不抛出异常
+  const std::vector<std::string> headers{
+      "{'descr': '<f4', 'fortran_order': False, 'shape': (2, x), }\n",
+      "{'descr': '<f4', 'fortran_order': False, 'shape': (2, -1), }\n",
+      "{'descr': '<f4', 'fortran_order': False, 'shape': (2, 99999999999), }\n",
+      "{'descr': '<f4', 'fortran_order': False, 'shape': (2,, 3), }\n",
+      "{'descr': '<f4', 'fortran_order': False, 'shape': (2, 3\n",
+      "{'descr': '<f4, 'fortran_order': False, 'shape': (2, 3), }\n",
+      "{'descr': '<f4', 'fortran_order': Maybe, 'shape': (2, 3), }\n",
+      "{'descr': '<f4', 'fortran_order': False, 'shape': ",
+      "{'descr': '<f4', 'fortran_order': False, "
+      "'shape': (4294967295, 4294967295, 4294967295), }\n",
+  };
+  for (const std::string& header : headers) {
+    WriteNpy("/tmp/kuiper_test_bad_header.npy", header, data.data(), data.size() * sizeof(float));
+    ASSERT_TRUE(NpyDataLoader::Load("/tmp/kuiper_test_bad_header.npy").empty()) << header;
+  }
+}
+
+TEST(test_npy, tensor_layout) {
+  using namespace kuiper_infer;
+  const std::vector<float> data{0.f, 1.f, 2.f, 3.f};
+  WriteNpy("/tmp/kuiper_test_vector.npy",
+           "{'descr': '<f4', 'fortran_order': False, 'shape': (4,), }    \n", data.data(),
+           data.size() * sizeof(float));
+  const NpyArray array = NpyDataLoader::Load("/tmp/kuiper_test_vector.npy");
+  ASSERT_TRUE(array.is_tensor_layout());
+  const std::shared_ptr<Tensor<float>> tensor = array.ToTensor();
+  ASSERT_EQ(tensor->raw_shapes(), std::vector<uint32_t>({4}));
+  ASSERT_EQ(tensor->raw_ptr(), array.view().data<const float>());
+  for (uint32_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(tensor->index(i), data.at(i));
+  }
+}
+
+TEST(test_npy, save_load) {
+  using namespace kuiper_infer;
+  Tensor<float> tensor(3, 4, 5);
+  tensor.RandN();
+  ASSERT_TRUE(NpyDataLoader::Save("/tmp/kuiper_test_save.npy", tensor));
+
+  const NpyArray array = NpyDataLoader::Load("/tmp/kuiper_test_save.npy");
+  ASSERT_EQ(array.shape(), std::vector<uint32_t>({3, 4, 5}));
+  const std::shared_ptr<Tensor<float>> loaded = array.ToTensor();
+  ASSERT_EQ(loaded->shapes(), tensor.shapes());
+  for (uint32_t c = 0; c < 3; ++c) {
+    for (uint32_t r = 0; r < 4; ++r) {
+      for (uint32_t col = 0; col < 5; ++col) {
+        ASSERT_EQ(loaded->at(c, r, col), tensor.at(c, r, col));
+        ASSERT_EQ(array.view().at<const float>(c, r, col), tensor.at(c, r, col));
+      }
+    }
+  }
+}
+
+TEST(test_npy, save_load_archive) {
+  using namespace kuiper_infer;
+  std::map<std::string, std::shared_ptr<Tensor<float>>> tensors;
+  tensors["input"] = std::make_shared<Tensor<float>>(2, 3, 3);
+  tensors["output"] = std::make_shared<Tensor<float>>(1, 1, 10);
+  tensors["input"]->RandN();
+  tensors["output"]->RandN();
+  ASSERT_TRUE(NpyDataLoader::SaveArchive("/tmp/kuiper_test_archive.npz", tensors));
+
+  const std::map<std::string, NpyArray> arrays =
+      NpyDataLoader::LoadArchive("/tmp/kuiper_test_archive.npz");
+  ASSERT_EQ(arrays.size(), 2);
+  for (const auto& [name, tensor] : tensors) {
+    ASSERT_EQ(arrays.count(name), 1);
+    const std::shared_ptr<Tensor<float>> loaded = arrays.at(name).ToTensor();
+    ASSERT_EQ(loaded->raw_shapes(), tensor->raw_shapes());
+    for (uint32_t i = 0; i < tensor->size(); ++i) {
+      ASSERT_EQ(loaded->index(i), tensor->index(i));
+    }
+  }
+}
+
+TEST(test_npy, batch_iterator) {
+  using namespace kuiper_infer;
+  const uint32_t samples = 5;
+  std::vector<float> data(samples * 2 * 3 * 4);
+  for (uint32_t i = 0; i < data.size(); ++i) {
+    data.at(i) = float(i);
+  }
+  WriteNpy("/tmp/kuiper_test_dataset.npy",
+           "{'descr': '<f4', 'fortran_order': False, 'shape': (5, 2, 3, 4), }\n", data.data(),
+           data.size() * sizeof(float));
+  const NpyArray dataset = NpyDataLoader::Load("/tmp/kuiper_test_dataset.npy");
+  ASSERT_EQ(dataset.samples(), samples);
+
+  NpyBatchIterator iterator(dataset, 2);
+  std::vector<std::shared_ptr<Tensor<float>>> batch;
+  std::vector<uint32_t> batch_sizes;
+  uint32_t sample = 0;
+  while (iterator.Next(batch)) {
+    batch_sizes.push_back(batch.size());
+    for (const auto& tensor : batch) {
+      ASSERT_EQ(tensor->shapes(), std::vector<uint32_t>({2, 3, 4}));
+      const float* sample_data = data.data() + sample * 24;
+      for (uint32_t c = 0; c < 2; ++c) {
+        for (uint32_t r = 0; r < 3; ++r) {
+          for (uint32_t col = 0; col < 4; ++col) {
+            ASSERT_EQ(tensor->at(c, r, col), sample_data[c * 12 + r * 4 + col]);
+          }
+        }
+      }
+      sample += 1;
+    }
+  }
+  ASSERT_EQ(batch_sizes, std::vector<uint32_t>({2, 2, 1}));
+
+  iterator.Reset();
+  ASSERT_TRUE(iterator.Next(batch));
+  ASSERT_EQ(batch.size(), 2);
+}
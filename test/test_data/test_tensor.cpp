@@ -210,6 +210,75 @@ TEST(test_tensor, transform2) {
   }
 }
 
+TEST(test_tensor, map) {
+  using namespace kuiper_infer;
+
+  // 超过并行阈值的张量
+  Tensor<float> f3(4, 129, 131);
+  for (uint32_t i = 0; i < f3.size(); ++i) {
+    f3.index(i) = float(i % 7) - 3.f;
+  }
+  const float slope = 0.5f;
+  f3.Map([slope](float value) { return value > 0.f ? value : value * slope; });
+  for (uint32_t i = 0; i < f3.size(); ++i) {
+    const float value = float(i % 7) - 3.f;
+    ASSERT_EQ(f3.index(i), value > 0.f ? value : value * slope);
+  }
+}
+
+TEST(test_tensor, zip) {
+  using namespace kuiper_infer;
+
+  Tensor<float> f1(3, 5, 7);
+  Tensor<float> f2(3, 5, 7);
+  for (uint32_t i = 0; i < f1.size(); ++i) {
+    f1.index(i) = float(i);
+    f2.index(i) = float(i % 4);
+  }
+  f1.Zip(f2, [](float x, float y) { return x * y + 1.f; });
+  for (uint32_t i = 0; i < f1.size(); ++i) {
+    ASSERT_EQ(f1.index(i), float(i) * float(i % 4) + 1.f);
+  }
+}
+
+TEST(test_tensor, reduce) {
+  using namespace kuiper_infer;
+
+  Tensor<int32_t> f1(5, 97, 101);
+  int64_t expected_sum = 0;
+  int32_t expected_max = 0;
+  for (uint32_t i = 0; i < f1.size(); ++i) {
+    f1.index(i) = int32_t(i * 13 % 1009);
+    expected_sum += f1.index(i);
+    expected_max = std::max(expected_max, f1.index(i));
+  }
+  ASSERT_EQ(f1.Reduce(0, [](int32_t x, int32_t y) { return x + y; }), expected_sum);
+  ASSERT_EQ(f1.Reduce(std::numeric_limits<int32_t>::lowest(),
+                      [](int32_t x, int32_t y) { return std::max(x, y); }),
+            expected_max);
+
+  Tensor<float> f2(3, 3, 3);
+  f2.Fill(2.f);
+  ASSERT_EQ(f2.Reduce(0.f, [](float x, float y) { return x + y; }), 54.f);
+}
+
+#ifdef __AVX2__
+TEST(test_tensor, map_simd) {
+  using namespace kuiper_infer;
+
+  Tensor<float> f3(3, 5, 7);
+  for (uint32_t i = 0; i < f3.size(); ++i) {
+    f3.index(i) = float(i) - 50.f;
+  }
+  // 105个元素，最后一组只有一个有效值
+  const __m256 zero = _mm256_setzero_ps();
+  f3.MapSimd([zero](__m256 x) { return _mm256_max_ps(x, zero); });
+  for (uint32_t i = 0; i < f3.size(); ++i) {
+    ASSERT_EQ(f3.index(i), std::max(float(i) - 50.f, 0.f));
+  }
+}
+#endif
+
 TEST(test_tensor, clone) {
   using namespace kuiper_infer;
 
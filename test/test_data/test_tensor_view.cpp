@@ -0,0 +1,86 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-8.
+#include <gtest/gtest.h>
+#include "data/tensor_view.hpp"
+
+TEST(test_tensor_view, dense) {
+  using namespace kuiper_infer;
+  Tensor<float> tensor(2, 3, 4);
+  for (uint32_t i = 0; i < tensor.size(); ++i) {
+    tensor.index(i) = float(i);
+  }
+  const TensorView view(tensor);
+  ASSERT_EQ(view.dtype(), RuntimeDataType::kTypeFloat32);
+  ASSERT_EQ(view.channels(), 2);
+  ASSERT_EQ(view.rows(), 3);
+  ASSERT_EQ(view.cols(), 4);
+  ASSERT_EQ(view.size(), tensor.size());
+  ASSERT_TRUE(view.is_contiguous());
+  ASSERT_EQ(view.data<float>(), tensor.raw_ptr());
+  for (uint32_t c = 0; c < 2; ++c) {
+    for (uint32_t r = 0; r < 3; ++r) {
+      for (uint32_t col = 0; col < 4; ++col) {
+        ASSERT_EQ(view.at<float>(c, r, col), tensor.at(c, r, col));
+      }
+    }
+  }
+
+  // 视图与张量共享内存
+  view.at<float>(1, 2, 3) = -1.f;
+  ASSERT_EQ(tensor.at(1, 2, 3), -1.f);
+  const TensorView channel = view.channel(1);
+  ASSERT_EQ(channel.channels(), 1);
+  ASSERT_EQ(channel.at<float>(0, 2, 3), -1.f);
+}
+
+TEST(test_tensor_view, strided) {
+  using namespace kuiper_infer;
+  // 行主序的缓冲区，每行的元素连续存放
+  std::vector<int32_t> values(3 * 4);
+  for (uint32_t i = 0; i < values.size(); ++i) {
+    values.at(i) = int32_t(i);
+  }
+  const TensorView view(values.data(), 1, 3, 4, 12, 4, 1);
+  ASSERT_EQ(view.dtype(), RuntimeDataType::kTypeInt32);
+  ASSERT_FALSE(view.is_contiguous());
+  for (uint32_t r = 0; r < 3; ++r) {
+    for (uint32_t col = 0; col < 4; ++col) {
+      ASSERT_EQ(view.at<int32_t>(0, r, col), int32_t(r * 4 + col));
+    }
+  }
+}
+
+TEST(test_tensor_view, span) {
+  using namespace kuiper_infer;
+  std::vector<sftensor> tensors = {std::make_shared<ftensor>(1, 2, 2), nullptr};
+  const std::vector<TensorView> views = MakeTensorViews(tensors);
+  ASSERT_EQ(views.size(), 2);
+  ASSERT_FALSE(views.at(0).empty());
+  ASSERT_TRUE(views.at(1).empty());
+
+  const Span<const TensorView> span(views);
+  ASSERT_EQ(span.size(), 2);
+  ASSERT_EQ(span.data(), views.data());
+  ASSERT_TRUE(span[0].same_shape(views.at(0)));
+  ASSERT_TRUE(Span<const TensorView>().empty());
+}
@@ -0,0 +1,169 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-6.
+#include <gtest/gtest.h>
+#include "../../source/layer/details/block_sparse.hpp"
+#include "../../source/layer/details/convolution.hpp"
+#include "../../source/layer/details/linear.hpp"
+
+using namespace kuiper_infer;
+
+// 按块剪枝，zero_percent%的1x8块置零
+static void PruneBlocks(float* values, uint32_t rows, uint32_t cols, uint32_t zero_percent) {
+  for (uint32_t r = 0; r < rows; ++r) {
+    for (uint32_t c = 0; c < cols; ++c) {
+      const uint32_t block = r * cols + c / sparse::kBlockCols;
+      if (block * 37 % 100 < zero_percent) {
+        values[r * cols + c] = 0.f;
+      }
+    }
+  }
+}
+
+TEST(test_layer, block_sparse_matrix) {
+  const uint32_t rows = 5;
+  const uint32_t cols = 29;
+  const uint32_t positions = 70;
+  const size_t col_stride = cols + 3;
+  std::vector<float> dense(rows * cols);
+  for (uint32_t i = 0; i < dense.size(); ++i) {
+    dense.at(i) = float(int(i * 7) % 13 - 6);
+  }
+  PruneBlocks(dense.data(), rows, cols, 60);
+  std::vector<const float*> row_ptrs;
+  for (uint32_t r = 0; r < rows; ++r) {
+    row_ptrs.push_back(dense.data() + r * cols);
+  }
+  ASSERT_GE(sparse::ZeroBlockRatio(row_ptrs, cols), 0.5f);
+
+  sparse::BlockSparseMatrix matrix(row_ptrs, cols);
+  ASSERT_LT(matrix.blocks(), rows * ((cols + 7) / 8));
+  ASSERT_LT(matrix.memory_bytes(), dense.size() * sizeof(float));
+
+  std::vector<float> input(col_stride * positions);
+  for (uint32_t i = 0; i < input.size(); ++i) {
+    input.at(i) = float(i % 11) * 0.5f;
+  }
+  std::vector<float> output(rows * positions);
+  matrix.Multiply(input.data(), col_stride, positions, output.data(), positions, 3);
+  for (uint32_t r = 0; r < rows; ++r) {
+    for (uint32_t n = 0; n < positions; ++n) {
+      float expected = 0.f;
+      for (uint32_t c = 0; c < cols; ++c) {
+        expected += dense.at(r * cols + c) * input.at(n * col_stride + c);
+      }
+      ASSERT_FLOAT_EQ(output.at(r * positions + n), expected);
+    }
+  }
+}
+
+TEST(test_layer, linear_block_sparse) {
+  const int32_t in_features = 67;
+  const int32_t out_features = 19;
+  const uint32_t feature_dims = 5;
+  std::vector<float> weights(in_features * out_features);
+  for (uint32_t i = 0; i < weights.size(); ++i) {
+    weights.at(i) = float(int(i * 5) % 9 - 4) * 0.25f;
+  }
+
+  LinearLayer dense_layer(in_features, out_features, true);
+  dense_layer.set_weights(weights);
+  ASSERT_FALSE(dense_layer.is_sparse());
+
+  PruneBlocks(weights.data(), out_features, in_features, 75);
+  LinearLayer sparse_layer(in_features, out_features, true);
+  sparse_layer.set_weights(weights);
+  ASSERT_TRUE(sparse_layer.is_sparse());
+
+  const std::vector<float> bias(out_features, 1.5f);
+  sparse_layer.set_bias(bias);
+  sftensor input = std::make_shared<ftensor>(1, feature_dims, in_features);
+  input->RandN();
+  std::vector<sftensor> inputs = {input};
+  std::vector<sftensor> outputs = {std::make_shared<ftensor>(1, feature_dims, out_features)};
+  ASSERT_EQ(sparse_layer.Forward(inputs, outputs), StatusCode::kSuccess);
+
+  // 权重按PyTorch的(out_features, in_features)行主序给出
+  for (uint32_t r = 0; r < feature_dims; ++r) {
+    for (int32_t o = 0; o < out_features; ++o) {
+      float expected = bias.at(o);
+      for (int32_t i = 0; i < in_features; ++i) {
+        expected += input->at(0, r, i) * weights.at(o * in_features + i);
+      }
+      ASSERT_NEAR(outputs.front()->at(0, r, o), expected, 1e-4f);
+    }
+  }
+}
+
+TEST(test_layer, conv_block_sparse) {
+  const uint32_t in_channels = 16;
+  const uint32_t kernel_count = 12;
+  const uint32_t input_h = 14;
+  const uint32_t input_w = 15;
+  for (uint32_t kernel : {1, 3}) {
+    // 四分之三的卷积核只保留前两个输入通道，im2col按通道展开，零块连续
+    std::vector<sftensor> weights;
+    for (uint32_t k = 0; k < kernel_count; ++k) {
+      sftensor weight = std::make_shared<ftensor>(in_channels, kernel, kernel);
+      weight->RandN();
+      const uint32_t kept_channels = k % 4 != 3 ? 2 : in_channels;
+      for (uint32_t ic = kept_channels; ic < in_channels; ++ic) {
+        weight->slice(ic).zeros();
+      }
+      weights.push_back(weight);
+    }
+
+    sftensor input = std::make_shared<ftensor>(in_channels, input_h, input_w);
+    input->RandN();
+    std::vector<sftensor> inputs = {input};
+    std::vector<sftensor> outputs(1);
+    const uint32_t padding = kernel / 2;
+    ConvolutionLayer conv_layer(kernel_count, in_channels, kernel, kernel, padding, padding, 1, 1,
+                                1, false);
+    conv_layer.set_weights(weights);
+    ASSERT_EQ(conv_layer.Forward(inputs, outputs), StatusCode::kSuccess);
+
+    // 直接按定义计算参考输出，输出尺寸与输入相同
+    const sftensor output = outputs.front();
+    ASSERT_EQ(output->channels(), kernel_count);
+    for (uint32_t k = 0; k < kernel_count; ++k) {
+      for (uint32_t r = 0; r < input_h; ++r) {
+        for (uint32_t c = 0; c < input_w; ++c) {
+          float expected = 0.f;
+          for (uint32_t ic = 0; ic < in_channels; ++ic) {
+            for (uint32_t kh = 0; kh < kernel; ++kh) {
+              for (uint32_t kw = 0; kw < kernel; ++kw) {
+                const int32_t ir = int32_t(r + kh) - int32_t(padding);
+                const int32_t icol = int32_t(c + kw) - int32_t(padding);
+                if (ir < 0 || icol < 0 || ir >= int32_t(input_h) || icol >= int32_t(input_w)) {
+                  continue;
+                }
+                expected += weights.at(k)->at(ic, kh, kw) * input->at(ic, ir, icol);
+              }
+            }
+          }
+          ASSERT_NEAR(output->at(k, r, c), expected, 1e-4f);
+        }
+      }
+    }
+  }
+}
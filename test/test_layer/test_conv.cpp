@@ -265,6 +265,56 @@ TEST(test_layer, convolution3x3x32_stride1x1_padding0) {
   }
 }
 
+TEST(test_layer, convolution3x3x32_fused_residual_relu) {
+  const uint32_t batch_size = 4;
+  std::vector<sftensor> inputs(batch_size);
+  std::vector<sftensor> residuals(batch_size);
+  std::vector<sftensor> outputs1(batch_size);
+  std::vector<sftensor> outputs2(batch_size);
+
+  const uint32_t in_channel = 32;
+  const uint32_t kernel_count = 8;
+  for (uint32_t i = 0; i < batch_size; ++i) {
+    inputs.at(i) = std::make_shared<ftensor>(in_channel, 8, 8);
+    inputs.at(i)->RandN();
+    residuals.at(i) = std::make_shared<ftensor>(kernel_count, 8, 8);
+    residuals.at(i)->RandN();
+  }
+  const uint32_t kernel_h = 3;
+  const uint32_t kernel_w = 3;
+  std::vector<sftensor> weights;
+  for (uint32_t i = 0; i < kernel_count; ++i) {
+    sftensor kernel = std::make_shared<ftensor>(in_channel, kernel_h, kernel_w);
+    kernel->RandN();
+    weights.push_back(kernel);
+  }
+
+  ConvolutionLayer conv_layer(kernel_count, in_channel, kernel_h, kernel_w, 1, 1, 1, 1, 1,
+                              false);
+  conv_layer.set_weights(weights);
+  conv_layer.Forward(inputs, outputs1);
+
+  ConvolutionLayer fused_layer(kernel_count, in_channel, kernel_h, kernel_w, 1, 1, 1, 1, 1,
+                               false);
+  fused_layer.set_weights(weights);
+  ASSERT_TRUE(fused_layer.FuseResidualAdd("nn.ReLU"));
+  ASSERT_FALSE(fused_layer.FuseResidualAdd("nn.Softmax"));
+
+  std::vector<sftensor> fused_inputs = inputs;
+  fused_inputs.insert(fused_inputs.end(), residuals.begin(), residuals.end());
+  ASSERT_EQ(fused_layer.Forward(fused_inputs, outputs2), StatusCode::kSuccess);
+
+  for (uint32_t i = 0; i < batch_size; ++i) {
+    ASSERT_EQ(outputs1.at(i)->size(), outputs2.at(i)->size());
+    const uint32_t output_size = outputs1.at(i)->size();
+    for (uint32_t j = 0; j < output_size; ++j) {
+      const float expected =
+          std::max(outputs1.at(i)->index(j) + residuals.at(i)->index(j), 0.f);
+      ASSERT_LE(std::abs(expected - outputs2.at(i)->index(j)), 1e-4);
+    }
+  }
+}
+
 TEST(test_layer, convolution1x1x3_stride1x1_padding0) {
   const uint32_t batch_size = 1;
   std::vector<sftensor> inputs(batch_size);
@@ -699,3 +749,273 @@ TEST(test_layer, conv_dilation2) {
         << i << " real: " << real_data.at(i) << " predict: " << outputs_values.at(i);
   }
 }
+
+TEST(test_layer, conv_cost) {
+  using namespace kuiper_infer;
+  ConvolutionLayer conv_layer(16, 8, 3, 3, 1, 1, 1, 1, 2, true);
+  const LayerCost cost = conv_layer.Cost({{2, 8, 32, 32}}, {2, 16, 32, 32});
+  const double output_elements = 2. * 16 * 32 * 32;
+  ASSERT_DOUBLE_EQ(cost.flops, 2. * output_elements * 4 * 3 * 3 + output_elements);
+  ASSERT_DOUBLE_EQ(cost.parameters, 16 * 4 * 3 * 3 + 16);
+  ASSERT_DOUBLE_EQ(cost.weight_bytes, cost.parameters * sizeof(float));
+  ASSERT_DOUBLE_EQ(cost.input_bytes, 2. * 8 * 32 * 32 * sizeof(float));
+  ASSERT_DOUBLE_EQ(cost.output_bytes, output_elements * sizeof(float));
+}
+
+TEST(test_layer, conv_im2col_specialized) {
+  using namespace kuiper_infer;
+  ASSERT_EQ(window::SelectIm2Col(3, 3, 1, 1, 2, 2), nullptr);
+  ASSERT_EQ(window::SelectIm2Col(3, 5, 1, 1, 1, 1), nullptr);
+
+  const uint32_t input_h = 11;
+  const uint32_t input_w = 9;
+  std::vector<float> input(input_h * input_w);
+  for (uint32_t i = 0; i < input.size(); ++i) {
+    input.at(i) = float(i) + 1.f;
+  }
+
+  for (uint32_t stride : {1, 2}) {
+    for (uint32_t padding : {0, 1, 2}) {
+      const uint32_t kernel = 3;
+      const window::Im2ColFunc im2col =
+          window::SelectIm2Col(kernel, kernel, stride, stride, 1, 1);
+      ASSERT_NE(im2col, nullptr);
+      const uint32_t output_h = (input_h + 2 * padding - kernel) / stride + 1;
+      const uint32_t output_w = (input_w + 2 * padding - kernel) / stride + 1;
+      const uint32_t row_len = kernel * kernel;
+      std::vector<float> matrix(row_len * output_h * output_w);
+      im2col(input.data(), input_h, input_w, padding, padding, output_h, output_w, row_len,
+             matrix.data());
+
+      // 和逐元素判断补边的实现比较
+      for (uint32_t w = 0; w < output_w; ++w) {
+        for (uint32_t r = 0; r < output_h; ++r) {
+          const float* col_ptr = matrix.data() + (w * output_h + r) * row_len;
+          for (uint32_t kw = 0; kw < kernel; ++kw) {
+            for (uint32_t kh = 0; kh < kernel; ++kh) {
+              const int32_t y = int32_t(r * stride + kh) - int32_t(padding);
+              const int32_t x = int32_t(w * stride + kw) - int32_t(padding);
+              float expected = 0.f;
+              if (y >= 0 && y < int32_t(input_h) && x >= 0 && x < int32_t(input_w)) {
+                expected = input.at(x * input_h + y);
+              }
+              ASSERT_EQ(col_ptr[kw * kernel + kh], expected);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(test_layer, conv_micro_kernel) {
+  using namespace kuiper_infer;
+  const uint32_t output_channels = 11;
+  const uint32_t reduce_size = 27;
+  const uint32_t cols = 30;
+  const size_t col_stride = reduce_size + 5;
+  ASSERT_TRUE(micro_kernel::UseConvMicroKernel(output_channels, reduce_size));
+  ASSERT_FALSE(micro_kernel::UseConvMicroKernel(16, reduce_size));
+
+  std::vector<std::vector<float>> weights(output_channels, std::vector<float>(reduce_size));
+  std::vector<const float*> kernels;
+  std::vector<float> bias(output_channels);
+  for (uint32_t k = 0; k < output_channels; ++k) {
+    for (uint32_t p = 0; p < reduce_size; ++p) {
+      weights.at(k).at(p) = float((k * 7 + p * 3) % 13) - 6.f;
+    }
+    kernels.push_back(weights.at(k).data());
+    bias.at(k) = float(k) * 0.5f;
+  }
+  std::vector<float> matrix(col_stride * cols);
+  std::vector<float> residual(output_channels * cols);
+  for (uint32_t i = 0; i < matrix.size(); ++i) {
+    matrix.at(i) = float(i % 17) * 0.25f;
+  }
+  for (uint32_t i = 0; i < residual.size(); ++i) {
+    residual.at(i) = float(i % 5);
+  }
+
+  micro_kernel::ConvMicroKernel kernel(reduce_size, kernels, bias);
+  ASSERT_EQ(kernel.code().full_panels, 1);
+  ASSERT_EQ(kernel.code().tail_rows, 3);
+  ASSERT_NE(kernel.code().tail_func, kernel.code().panel_func);
+
+  // 两个通道分块，更多的线程按输出位置切分，位置数不是寄存器分块的整数倍
+  for (uint32_t threads : {1, 2, 5, 16}) {
+    std::vector<float> output(output_channels * cols);
+    kernel.Run(matrix.data(), col_stride, cols, residual.data(), nullptr, output.data(),
+               threads);
+    for (uint32_t k = 0; k < output_channels; ++k) {
+      for (uint32_t c = 0; c < cols; ++c) {
+        float expected = bias.at(k) + residual.at(k * cols + c);
+        for (uint32_t p = 0; p < reduce_size; ++p) {
+          expected += weights.at(k).at(p) * matrix.at(c * col_stride + p);
+        }
+        ASSERT_FLOAT_EQ(output.at(k * cols + c), expected) << threads;
+      }
+    }
+  }
+
+  // 无偏置的实例，激活在写回时完成
+  micro_kernel::ConvMicroKernel kernel_no_bias(reduce_size, kernels, {});
+  ASSERT_NE(kernel_no_bias.code().panel_func, kernel.code().panel_func);
+  auto relu = [](const float* in_ptr, float* out_ptr, int64_t size) {
+    for (int64_t i = 0; i < size; ++i) {
+      out_ptr[i] = std::max(in_ptr[i], 0.f);
+    }
+  };
+  for (uint32_t threads : {1, 5}) {
+    std::vector<float> output(output_channels * cols);
+    kernel_no_bias.Run(matrix.data(), col_stride, cols, nullptr, relu, output.data(), threads);
+    for (uint32_t k = 0; k < output_channels; ++k) {
+      for (uint32_t c = 0; c < cols; ++c) {
+        float expected = 0.f;
+        for (uint32_t p = 0; p < reduce_size; ++p) {
+          expected += weights.at(k).at(p) * matrix.at(c * col_stride + p);
+        }
+        ASSERT_FLOAT_EQ(output.at(k * cols + c), std::max(expected, 0.f)) << threads;
+      }
+    }
+  }
+}
+
+TEST(test_layer, conv_grouped) {
+  using namespace kuiper_infer;
+  const uint32_t groups = 4;
+  const uint32_t in_channels = 8;
+  const uint32_t out_channels = 12;
+  const uint32_t channels_per_group = in_channels / groups;
+  const uint32_t kernel_count_group = out_channels / groups;
+  for (uint32_t kernel : {1, 3}) {
+    const uint32_t padding = kernel / 2;
+    std::vector<sftensor> weights(out_channels);
+    for (uint32_t k = 0; k < out_channels; ++k) {
+      weights.at(k) = std::make_shared<ftensor>(channels_per_group, kernel, kernel);
+      weights.at(k)->RandN();
+    }
+    sftensor input = std::make_shared<ftensor>(in_channels, 13, 11);
+    input->RandN();
+
+    ConvolutionLayer grouped_layer(out_channels, in_channels, kernel, kernel, padding, padding, 1,
+                                   1, groups, false);
+    grouped_layer.set_weights(weights);
+    std::vector<sftensor> inputs = {input};
+    std::vector<sftensor> outputs(1);
+    ASSERT_EQ(grouped_layer.Forward(inputs, outputs), StatusCode::kSuccess);
+
+    // 每个分组单独用普通卷积计算作为参考
+    for (uint32_t g = 0; g < groups; ++g) {
+      ConvolutionLayer group_layer(kernel_count_group, channels_per_group, kernel, kernel, padding,
+                                   padding, 1, 1, 1, false);
+      const auto group_weights = weights.begin() + g * kernel_count_group;
+      group_layer.set_weights(
+          std::vector<sftensor>(group_weights, group_weights + kernel_count_group));
+      sftensor group_input = std::make_shared<ftensor>(channels_per_group, 13, 11);
+      for (uint32_t ic = 0; ic < channels_per_group; ++ic) {
+        group_input->slice(ic) = input->slice(g * channels_per_group + ic);
+      }
+      std::vector<sftensor> group_inputs = {group_input};
+      std::vector<sftensor> group_outputs(1);
+      ASSERT_EQ(group_layer.Forward(group_inputs, group_outputs), StatusCode::kSuccess);
+      for (uint32_t k = 0; k < kernel_count_group; ++k) {
+        ASSERT_TRUE(arma::approx_equal(outputs.front()->slice(g * kernel_count_group + k),
+                                       group_outputs.front()->slice(k), "absdiff", 1e-4f));
+      }
+    }
+  }
+}
+
+TEST(test_layer, conv_fft) {
+  using namespace kuiper_infer;
+  ASSERT_GT(fft::SelectTransformSize(64, 64, 7, 7, 1, 1), 0);
+  ASSERT_EQ(fft::SelectTransformSize(64, 64, 3, 3, 1, 1), 0);
+  // 输入通道很少的7x7步长2的stem层仍然走im2col
+  ASSERT_EQ(fft::SelectTransformSize(3, 64, 7, 7, 2, 2), 0);
+
+  const uint32_t in_channels = 3;
+  const uint32_t out_channels = 2;
+  const uint32_t kernel_h = 7;
+  const uint32_t kernel_w = 5;
+  const uint32_t input_h = 23;
+  const uint32_t input_w = 19;
+  const uint32_t padding = 3;
+  std::vector<std::vector<float>> kernels(out_channels);
+  std::vector<const float*> kernel_ptrs;
+  for (uint32_t o = 0; o < out_channels; ++o) {
+    for (uint32_t i = 0; i < in_channels * kernel_h * kernel_w; ++i) {
+      kernels.at(o).push_back(float(int(i * 7 + o * 3) % 11 - 5) * 0.1f);
+    }
+    kernel_ptrs.push_back(kernels.at(o).data());
+  }
+  std::vector<float> input(in_channels * input_h * input_w);
+  for (uint32_t i = 0; i < input.size(); ++i) {
+    input.at(i) = float(int(i * 13) % 17 - 8) * 0.25f;
+  }
+
+  fft::FFTConvolution fft_conv(16, in_channels, out_channels, kernel_h, kernel_w, kernel_ptrs);
+  for (uint32_t stride : {1, 2}) {
+    const uint32_t output_h = (input_h + 2 * padding - kernel_h) / stride + 1;
+    const uint32_t output_w = (input_w + 2 * padding - kernel_w) / stride + 1;
+    std::vector<float> output(out_channels * output_h * output_w);
+    fft_conv.Forward(input.data(), input_h, input_w, padding, padding, stride, stride,
+                     output.data(), output_h, output_w, 2);
+
+    // 列主序的直接互相关作为参考
+    for (uint32_t o = 0; o < out_channels; ++o) {
+      for (uint32_t ox = 0; ox < output_w; ++ox) {
+        for (uint32_t oy = 0; oy < output_h; ++oy) {
+          float expected = 0.f;
+          for (uint32_t c = 0; c < in_channels; ++c) {
+            for (uint32_t kw = 0; kw < kernel_w; ++kw) {
+              for (uint32_t kh = 0; kh < kernel_h; ++kh) {
+                const int32_t y = int32_t(oy * stride + kh) - int32_t(padding);
+                const int32_t x = int32_t(ox * stride + kw) - int32_t(padding);
+                if (y >= 0 && y < int32_t(input_h) && x >= 0 && x < int32_t(input_w)) {
+                  expected += input.at((c * input_w + x) * input_h + y) *
+                              kernels.at(o).at((c * kernel_w + kw) * kernel_h + kh);
+                }
+              }
+            }
+          }
+          ASSERT_NEAR(output.at((o * output_w + ox) * output_h + oy), expected, 1e-3f);
+        }
+      }
+    }
+  }
+}
+
+TEST(test_layer, convolution7x7x32_fft) {
+  const uint32_t batch_size = 2;
+  std::vector<sftensor> inputs(batch_size);
+  std::vector<sftensor> outputs1(batch_size);
+  std::vector<sftensor> outputs2(batch_size);
+
+  const uint32_t in_channel = 32;
+  for (uint32_t i = 0; i < batch_size; ++i) {
+    inputs.at(i) = std::make_shared<ftensor>(in_channel, 40, 37);
+    inputs.at(i)->RandN();
+  }
+  const uint32_t kernel_h = 7;
+  const uint32_t kernel_w = 7;
+  const uint32_t kernel_count = 32;
+  ASSERT_GT(fft::SelectTransformSize(in_channel, kernel_count, kernel_h, kernel_w, 1, 1), 0);
+  std::vector<sftensor> weights;
+  for (uint32_t i = 0; i < kernel_count; ++i) {
+    sftensor kernel = std::make_shared<ftensor>(in_channel, kernel_h, kernel_w);
+    kernel->RandN();
+    weights.push_back(kernel);
+  }
+  Convolution(inputs, outputs1, 1, 1, weights);
+  ConvolutionLayer conv_layer(kernel_count, in_channel, kernel_h, kernel_w, 0, 0, 1, 1, 1, false);
+  conv_layer.set_weights(weights);
+  conv_layer.Forward(inputs, outputs2);
+  ASSERT_EQ(outputs1.size(), outputs2.size());
+  for (uint32_t i = 0; i < outputs1.size(); ++i) {
+    ASSERT_EQ(outputs1.at(i)->size(), outputs2.at(i)->size());
+    const uint32_t output_size = outputs1.at(i)->size();
+    for (uint32_t j = 0; j < output_size; ++j) {
+      ASSERT_LE(std::abs(outputs1.at(i)->index(j) - outputs2.at(i)->index(j)), 1e-3);
+    }
+  }
+}
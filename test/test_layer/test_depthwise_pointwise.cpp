@@ -0,0 +1,147 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-4.
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "../../source/layer/details/activation_sse.hpp"
+#include "../../source/layer/details/depthwise_pointwise.hpp"
+#include "data/tensor.hpp"
+
+using namespace kuiper_infer;
+
+static std::vector<float> RandomValues(uint32_t size, float scale) {
+  std::vector<float> values(size);
+  for (uint32_t i = 0; i < size; ++i) {
+    values.at(i) = scale * float(int(i * 37 % 17) - 8);
+  }
+  return values;
+}
+
+// 先做深度卷积再做逐点卷积的朴素实现
+static sftensor DepthwisePointwise(const sftensor& input, uint32_t out_channels, uint32_t kernel,
+                                   uint32_t padding, uint32_t stride,
+                                   const std::vector<float>& dw_weight,
+                                   const std::vector<float>& dw_bias,
+                                   const std::vector<float>& pw_weight,
+                                   const std::vector<float>& pw_bias, bool depthwise_relu) {
+  const uint32_t channels = input->channels();
+  const uint32_t output_h = (input->rows() + 2 * padding - kernel) / stride + 1;
+  const uint32_t output_w = (input->cols() + 2 * padding - kernel) / stride + 1;
+  Tensor<float> middle(channels, output_h, output_w);
+  for (uint32_t c = 0; c < channels; ++c) {
+    for (uint32_t r = 0; r < output_h; ++r) {
+      for (uint32_t col = 0; col < output_w; ++col) {
+        float sum = dw_bias.at(c);
+        for (uint32_t kh = 0; kh < kernel; ++kh) {
+          for (uint32_t kw = 0; kw < kernel; ++kw) {
+            const int32_t y = int32_t(r * stride + kh) - int32_t(padding);
+            const int32_t x = int32_t(col * stride + kw) - int32_t(padding);
+            if (y >= 0 && y < int32_t(input->rows()) && x >= 0 && x < int32_t(input->cols())) {
+              sum += input->at(c, y, x) * dw_weight.at((c * kernel + kh) * kernel + kw);
+            }
+          }
+        }
+        middle.at(c, r, col) = depthwise_relu ? std::max(sum, 0.f) : sum;
+      }
+    }
+  }
+
+  sftensor output = std::make_shared<Tensor<float>>(out_channels, output_h, output_w);
+  for (uint32_t o = 0; o < out_channels; ++o) {
+    for (uint32_t r = 0; r < output_h; ++r) {
+      for (uint32_t col = 0; col < output_w; ++col) {
+        float sum = pw_bias.at(o);
+        for (uint32_t c = 0; c < channels; ++c) {
+          sum += middle.at(c, r, col) * pw_weight.at(o * channels + c);
+        }
+        output->at(o, r, col) = sum;
+      }
+    }
+  }
+  return output;
+}
+
+TEST(test_layer, depthwise_pointwise) {
+  using namespace activation;
+  const uint32_t channels = 6;
+  const uint32_t out_channels = 5;
+  const std::vector<float> dw_weight = RandomValues(channels * 9, 0.125f);
+  const std::vector<float> dw_bias = RandomValues(channels, 0.5f);
+  const std::vector<float> pw_weight = RandomValues(out_channels * channels, 0.25f);
+  const std::vector<float> pw_bias = RandomValues(out_channels, 1.f);
+
+  for (uint32_t stride : {1, 2}) {
+    DepthwisePointwiseLayer layer(channels, out_channels, 3, 3, 1, 1, stride, stride);
+    layer.set_depthwise(dw_weight, dw_bias);
+    layer.set_pointwise(pw_weight, pw_bias);
+    layer.set_activations(ApplySSEActivationRaw(ActivationType::kActivationRelu), nullptr);
+
+    std::vector<sftensor> inputs;
+    std::vector<sftensor> outputs(2);
+    for (uint32_t i = 0; i < outputs.size(); ++i) {
+      sftensor input = std::make_shared<Tensor<float>>(channels, 67, 45);
+      input->RandN();
+      inputs.push_back(input);
+    }
+    ASSERT_EQ(layer.Forward(inputs, outputs), StatusCode::kSuccess);
+
+    for (uint32_t i = 0; i < outputs.size(); ++i) {
+      const sftensor expected = DepthwisePointwise(inputs.at(i), out_channels, 3, 1, stride,
+                                                   dw_weight, dw_bias, pw_weight, pw_bias, true);
+      ASSERT_EQ(outputs.at(i)->shapes(), expected->shapes());
+      for (uint32_t j = 0; j < expected->size(); ++j) {
+        ASSERT_NEAR(outputs.at(i)->index(j), expected->index(j), 1e-4f);
+      }
+    }
+  }
+}
+
+TEST(test_layer, depthwise_pointwise_residual) {
+  using namespace activation;
+  const uint32_t channels = 4;
+  const std::vector<float> dw_weight = RandomValues(channels * 9, 0.125f);
+  const std::vector<float> dw_bias = RandomValues(channels, 0.5f);
+  const std::vector<float> pw_weight = RandomValues(channels * channels, 0.25f);
+  const std::vector<float> pw_bias = RandomValues(channels, 1.f);
+
+  DepthwisePointwiseLayer layer(channels, channels, 3, 3, 1, 1, 1, 1);
+  layer.set_depthwise(dw_weight, dw_bias);
+  layer.set_pointwise(pw_weight, pw_bias);
+  ASSERT_FALSE(layer.FuseResidualAdd("nn.Softmax"));
+  ASSERT_TRUE(layer.FuseResidualAdd("nn.ReLU"));
+
+  sftensor input = std::make_shared<Tensor<float>>(channels, 19, 23);
+  sftensor residual = std::make_shared<Tensor<float>>(channels, 19, 23);
+  input->RandN();
+  residual->RandN();
+  std::vector<sftensor> inputs = {input, residual};
+  std::vector<sftensor> outputs(1);
+  ASSERT_EQ(layer.Forward(inputs, outputs), StatusCode::kSuccess);
+
+  // 残差相加在偏置之后、激活函数之前
+  const sftensor expected = DepthwisePointwise(input, channels, 3, 1, 1, dw_weight, dw_bias,
+                                               pw_weight, pw_bias, false);
+  for (uint32_t j = 0; j < expected->size(); ++j) {
+    const float value = std::max(expected->index(j) + residual->index(j), 0.f);
+    ASSERT_NEAR(outputs.front()->index(j), value, 1e-4f);
+  }
+}
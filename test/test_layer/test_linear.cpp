@@ -307,4 +307,14 @@ TEST(test_layer, forward_linear10) {
       ASSERT_EQ(is_same, true);
     }
   }
-}
\ No newline at end of file
+}
+
+TEST(test_layer, linear_cost) {
+  using namespace kuiper_infer;
+  LinearLayer linear_layer(512, 1000, true);
+  const LayerCost cost = linear_layer.Cost({{4, 512}}, {4, 1000});
+  ASSERT_DOUBLE_EQ(cost.flops, 2. * 4 * 1000 * 512 + 4 * 1000);
+  ASSERT_DOUBLE_EQ(cost.parameters, 512 * 1000 + 1000);
+  ASSERT_DOUBLE_EQ(cost.input_bytes, 4. * 512 * sizeof(float));
+  ASSERT_DOUBLE_EQ(cost.output_bytes, 4. * 1000 * sizeof(float));
+}
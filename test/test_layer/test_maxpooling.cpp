@@ -536,4 +536,55 @@ TEST(test_layer, forward_max_pooling_s77_k77) {
       ASSERT_TRUE(arma::approx_equal(output1->slice(c), output2->slice(c), "absdiff", 0.01f));
     }
   }
-}
\ No newline at end of file
+}
+
+TEST(test_layer, maxpooling_cost) {
+  using namespace kuiper_infer;
+  MaxPoolingLayer max_layer(1, 1, 3, 3, 2, 2);
+  const LayerCost cost = max_layer.Cost({{1, 64, 112, 112}}, {1, 64, 56, 56});
+  ASSERT_DOUBLE_EQ(cost.flops, 64. * 56 * 56 * 9);
+  ASSERT_DOUBLE_EQ(cost.parameters, 0.);
+  ASSERT_DOUBLE_EQ(cost.weight_bytes, 0.);
+}
+
+TEST(test_layer, maxpooling_specialized) {
+  using namespace kuiper_infer;
+  ASSERT_EQ(window::SelectMaxPooling(7, 7, 3, 3), nullptr);
+
+  const uint32_t input_h = 10;
+  const uint32_t input_w = 13;
+  std::vector<float> input(input_h * input_w);
+  for (uint32_t i = 0; i < input.size(); ++i) {
+    input.at(i) = float((i * 37) % 101) - 50.f;
+  }
+
+  const std::vector<std::pair<uint32_t, uint32_t>> geometries = {{2, 2}, {3, 1}, {3, 2}, {5, 1}};
+  for (const auto& [pooling, stride] : geometries) {
+    for (uint32_t padding = 0; padding <= pooling / 2; ++padding) {
+      const window::MaxPoolingFunc max_pooling =
+          window::SelectMaxPooling(pooling, pooling, stride, stride);
+      ASSERT_NE(max_pooling, nullptr);
+      const uint32_t output_h = (input_h + 2 * padding - pooling) / stride + 1;
+      const uint32_t output_w = (input_w + 2 * padding - pooling) / stride + 1;
+      std::vector<float> output(output_h * output_w);
+      max_pooling(input.data(), input_h, input_w, padding, padding, output_h, output_w,
+                  output.data());
+
+      for (uint32_t w = 0; w < output_w; ++w) {
+        for (uint32_t r = 0; r < output_h; ++r) {
+          float expected = std::numeric_limits<float>::lowest();
+          for (uint32_t kw = 0; kw < pooling; ++kw) {
+            for (uint32_t kh = 0; kh < pooling; ++kh) {
+              const int32_t y = int32_t(r * stride + kh) - int32_t(padding);
+              const int32_t x = int32_t(w * stride + kw) - int32_t(padding);
+              if (y >= 0 && y < int32_t(input_h) && x >= 0 && x < int32_t(input_w)) {
+                expected = std::max(expected, input.at(x * input_h + y));
+              }
+            }
+          }
+          ASSERT_EQ(output.at(w * output_h + r), expected);
+        }
+      }
+    }
+  }
+}
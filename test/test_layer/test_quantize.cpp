@@ -0,0 +1,143 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-7.
+#include <gtest/gtest.h>
+#include "../../source/layer/details/linear.hpp"
+#include "../../source/layer/details/quantize.hpp"
+
+using namespace kuiper_infer;
+
+TEST(test_layer, quantize_rows) {
+  const uint32_t rows = 3;
+  const uint32_t cols = 37;
+  std::vector<float> values(rows * cols);
+  for (uint32_t i = 0; i < values.size(); ++i) {
+    values.at(i) = float(int(i * 7) % 23 - 11) * 0.1f;
+  }
+  std::fill(values.begin() + cols, values.begin() + 2 * cols, 0.f);
+
+  const size_t padded_cols = quant::PaddedCols(cols);
+  ASSERT_EQ(padded_cols, 64);
+  std::vector<int8_t> quantized(rows * padded_cols, int8_t(1));
+  std::vector<float> scales(rows);
+  quant::QuantizeRows(values.data(), cols, 1, rows, cols, quantized.data(), scales.data(), 2);
+  ASSERT_EQ(scales.at(1), 0.f);
+  for (uint32_t r = 0; r < rows; ++r) {
+    for (uint32_t c = 0; c < padded_cols; ++c) {
+      const int8_t q = quantized.at(r * padded_cols + c);
+      if (c >= cols) {
+        ASSERT_EQ(q, 0);
+        continue;
+      }
+      ASSERT_LE(std::abs(int32_t(q)), quant::kInt8Max);
+      ASSERT_NEAR(float(q) * scales.at(r), values.at(r * cols + c), scales.at(r) * 0.5f + 1e-6f);
+    }
+  }
+}
+
+TEST(test_layer, quantized_matrix) {
+  const uint32_t rows = 9;
+  const uint32_t cols = 90;
+  const uint32_t positions = 130;
+  std::vector<float> weights(rows * cols);
+  for (uint32_t i = 0; i < weights.size(); ++i) {
+    weights.at(i) = float(int(i * 5) % 17 - 8) * 0.05f;
+  }
+  std::vector<const float*> row_ptrs;
+  for (uint32_t r = 0; r < rows; ++r) {
+    row_ptrs.push_back(weights.data() + r * cols);
+  }
+  quant::QuantizedMatrix matrix(row_ptrs, cols);
+  ASSERT_LT(matrix.memory_bytes() * 3, weights.size() * sizeof(float));
+
+  // 输入按列主序存放，每一行的元素间隔为行数
+  std::vector<float> input(positions * cols);
+  for (uint32_t i = 0; i < input.size(); ++i) {
+    input.at(i) = float(int(i * 3) % 19 - 9) * 0.2f;
+  }
+  const size_t padded_cols = quant::PaddedCols(cols);
+  std::vector<int8_t> input_quantized(positions * padded_cols);
+  std::vector<float> input_scales(positions);
+  quant::QuantizeRows(input.data(), 1, positions, positions, cols, input_quantized.data(),
+                      input_scales.data(), 4);
+  std::vector<float> output(rows * positions);
+  matrix.Multiply(input_quantized.data(), input_scales.data(), positions, output.data(),
+                  positions, 3);
+
+  for (uint32_t r = 0; r < rows; ++r) {
+    for (uint32_t n = 0; n < positions; ++n) {
+      float expected = 0.f;
+      float magnitude = 0.f;
+      for (uint32_t c = 0; c < cols; ++c) {
+        expected += weights.at(r * cols + c) * input.at(c * positions + n);
+        magnitude += std::abs(weights.at(r * cols + c) * input.at(c * positions + n));
+      }
+      ASSERT_NEAR(output.at(r * positions + n), expected, magnitude * 0.02f + 1e-5f);
+    }
+  }
+}
+
+TEST(test_layer, linear_dynamic_quantization) {
+  const int32_t in_features = 96;
+  const int32_t out_features = 40;
+  const uint32_t feature_dims = 7;
+  std::vector<float> weights(in_features * out_features);
+  for (uint32_t i = 0; i < weights.size(); ++i) {
+    weights.at(i) = float(int(i * 11) % 29 - 14) * 0.03f;
+  }
+  const std::vector<float> bias(out_features, 0.5f);
+
+  LinearLayer float_layer(in_features, out_features, true);
+  float_layer.set_weights(weights);
+  float_layer.set_bias(bias);
+  LinearLayer int8_layer(in_features, out_features, true);
+  int8_layer.set_weights(weights);
+  int8_layer.set_bias(bias);
+  ASSERT_FALSE(int8_layer.is_quantized());
+  ASSERT_TRUE(int8_layer.QuantizeWeights());
+  ASSERT_TRUE(int8_layer.is_quantized());
+
+  // 量化后的权重只有原来的四分之一左右
+  const std::vector<std::vector<int32_t>> input_shapes = {{1, 1, int32_t(feature_dims),
+                                                           in_features}};
+  const std::vector<int32_t> output_shape = {1, 1, int32_t(feature_dims), out_features};
+  ASSERT_LT(int8_layer.Cost(input_shapes, output_shape).weight_bytes * 3,
+            float_layer.Cost(input_shapes, output_shape).weight_bytes);
+  ASSERT_GT(int8_layer.WorkspaceSize(input_shapes, output_shape), 0);
+
+  sftensor input = std::make_shared<ftensor>(1, feature_dims, in_features);
+  input->RandN();
+  std::vector<sftensor> inputs = {input};
+  std::vector<sftensor> float_outputs = {std::make_shared<ftensor>(1, feature_dims, out_features)};
+  std::vector<sftensor> int8_outputs = {std::make_shared<ftensor>(1, feature_dims, out_features)};
+  ASSERT_EQ(float_layer.Forward(inputs, float_outputs), StatusCode::kSuccess);
+  ASSERT_EQ(int8_layer.Forward(inputs, int8_outputs), StatusCode::kSuccess);
+  for (uint32_t r = 0; r < feature_dims; ++r) {
+    for (int32_t o = 0; o < out_features; ++o) {
+      ASSERT_NEAR(int8_outputs.front()->at(0, r, o), float_outputs.front()->at(0, r, o), 0.1f);
+    }
+  }
+
+  // 重新设置权重后仍然使用量化的权重
+  int8_layer.set_weights(weights);
+  ASSERT_TRUE(int8_layer.is_quantized());
+}
@@ -187,4 +187,22 @@ TEST(test_layer, forward_relu6_2) {
       ASSERT_EQ(output_->index(j), input_->index(j));
     }
   }
-}
\ No newline at end of file
+}
+
+TEST(test_layer, forward_relu_views) {
+  using namespace kuiper_infer;
+  std::vector<float> input_data(2 * 5 * 7);
+  for (uint32_t i = 0; i < input_data.size(); ++i) {
+    input_data.at(i) = float(i) - 30.f;
+  }
+  std::vector<float> output_data(input_data.size(), -1.f);
+  const std::vector<TensorView> inputs = {TensorView(input_data.data(), 2, 5, 7)};
+  const std::vector<TensorView> outputs = {TensorView(output_data.data(), 2, 5, 7)};
+
+  ReluLayer relu_layer;
+  ASSERT_TRUE(relu_layer.supports_views());
+  ASSERT_EQ(relu_layer.ForwardViews(inputs, outputs), StatusCode::kSuccess);
+  for (uint32_t i = 0; i < input_data.size(); ++i) {
+    ASSERT_EQ(output_data.at(i), std::max(input_data.at(i), 0.f));
+  }
+}
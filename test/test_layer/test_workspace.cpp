@@ -0,0 +1,81 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-2-3.
+#include <gtest/gtest.h>
+#include <omp.h>
+#include <cstdint>
+#include <set>
+#include "../../source/layer/details/convolution.hpp"
+#include "layer/abstract/layer_workspace.hpp"
+
+TEST(test_layer, workspace_reserve) {
+  using namespace kuiper_infer;
+  const size_t reserved = LayerWorkspace::reserved_size();
+  LayerWorkspace::Reserve(reserved + 100);
+  ASSERT_EQ(LayerWorkspace::reserved_size(), reserved + 100);
+  // 更小的需求不会降低预留的大小
+  LayerWorkspace::Reserve(1);
+  ASSERT_EQ(LayerWorkspace::reserved_size(), reserved + 100);
+
+  float* buffer = LayerWorkspace::Acquire(10);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(buffer) % 64, 0);
+  // 预留范围内的请求复用同一块内存
+  ASSERT_EQ(LayerWorkspace::Acquire(reserved + 100), buffer);
+  ASSERT_EQ(LayerWorkspace::SliceSize(17), 32);
+}
+
+TEST(test_layer, workspace_per_thread) {
+  using namespace kuiper_infer;
+  std::set<float*> buffers;
+  int team_size = 0;
+#pragma omp parallel num_threads(4)
+  {
+    float* buffer = LayerWorkspace::Acquire(64);
+#pragma omp critical
+    {
+      buffers.insert(buffer);
+      team_size = omp_get_num_threads();
+    }
+  }
+  // 每个线程有自己的工作区
+  ASSERT_EQ(buffers.size(), size_t(team_size));
+}
+
+TEST(test_layer, conv_workspace_size) {
+  using namespace kuiper_infer;
+  ConvolutionLayer conv_layer(8, 4, 3, 3, 1, 1, 1, 1, 1, false);
+  std::vector<sftensor> weights;
+  for (uint32_t k = 0; k < 8; ++k) {
+    weights.push_back(std::make_shared<ftensor>(4, 3, 3));
+  }
+  conv_layer.set_weights(weights);
+  ASSERT_EQ(conv_layer.WorkspaceSize({{1, 4, 16, 16}}, {1, 8, 16, 16}), 4 * 3 * 3 * 16 * 16);
+
+  // 1x1卷积直接使用输入，不需要工作区
+  ConvolutionLayer conv1x1_layer(8, 4, 1, 1, 0, 0, 1, 1, 1, false);
+  std::vector<sftensor> weights1x1;
+  for (uint32_t k = 0; k < 8; ++k) {
+    weights1x1.push_back(std::make_shared<ftensor>(4, 1, 1));
+  }
+  conv1x1_layer.set_weights(weights1x1);
+  ASSERT_EQ(conv1x1_layer.WorkspaceSize({{1, 4, 16, 16}}, {1, 8, 16, 16}), 0);
+}
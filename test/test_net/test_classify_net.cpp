@@ -22,6 +22,7 @@
 // Created by fss on 22-11-22.
 #include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <algorithm>
 #include "data/load_data.hpp"
 #include "runtime/runtime_ir.hpp"
 
@@ -52,6 +53,75 @@ TEST(test_net, forward_resnet18) {
   }
 }
 
+TEST(test_net, forward_resnet18_features) {
+  using namespace kuiper_infer;
+  RuntimeGraph graph("tmp/resnet/resnet18_batch1.param", "tmp/resnet/resnet18_batch1.pnnx.bin");
+  // 请求中间节点的输出，保证不会被算子融合消去
+  graph.set_requested_outputs({"avgpool", "pnnx_output_0"});
+  graph.Build();
+
+  std::shared_ptr<Tensor<float>> input1 = std::make_shared<Tensor<float>>(3, 224, 224);
+  input1->Fill(2.);
+  std::vector<std::shared_ptr<Tensor<float>>> inputs;
+  inputs.push_back(input1);
+  graph.set_inputs("pnnx_input_0", inputs);
+  graph.Forward(false);
+
+  std::vector<std::shared_ptr<Tensor<float>>> features1 = graph.get_outputs("avgpool");
+  ASSERT_EQ(features1.size(), 1);
+  ASSERT_EQ(features1.front()->channels(), 512);
+  const std::vector<float> values1 = features1.front()->values();
+
+  // 只执行主干网络，分类头被跳过
+  graph.set_requested_outputs({"avgpool"});
+  uint32_t skipped_steps = 0;
+  for (const RuntimeExecutionStep& step : graph.execution_plan()) {
+    const bool is_head = step.op->type == "torch.flatten" || step.op->type == "nn.Linear";
+    ASSERT_EQ(step.skipped, is_head) << step.op->name;
+    if (step.skipped) {
+      skipped_steps += 1;
+      for (const auto& output : *step.outputs) {
+        output->Fill(-1.f);
+      }
+    }
+  }
+  ASSERT_EQ(skipped_steps, 2);
+
+  features1.front()->Fill(0.f);
+  graph.Forward(false);
+  std::vector<std::shared_ptr<Tensor<float>>> features2 = graph.get_outputs("avgpool");
+  ASSERT_EQ(features2.size(), 1);
+  ASSERT_EQ(features2.front()->values(), values1);
+  for (const RuntimeExecutionStep& step : graph.execution_plan()) {
+    if (!step.skipped) {
+      continue;
+    }
+    for (const auto& output : *step.outputs) {
+      for (float value : output->values()) {
+        ASSERT_EQ(value, -1.f);
+      }
+    }
+  }
+}
+
+TEST(test_net, forward_fused_output) {
+  using namespace kuiper_infer;
+  RuntimeGraph graph("tmp/resnet/resnet18_batch1.param", "tmp/resnet/resnet18_batch1.pnnx.bin");
+  graph.Build();
+  // 被融合消去的中间结果不能读取
+  for (const RuntimeExecutionStep& step : graph.execution_plan()) {
+    if (!step.fused_ops.empty()) {
+      ASSERT_DEATH(graph.get_outputs(step.op->name), "fused away");
+    }
+  }
+  const std::vector<RuntimeExecutionStep>& plan = graph.execution_plan();
+  const auto fused_step = std::find_if(plan.begin(), plan.end(), [](const auto& step) {
+    return !step.fused_ops.empty();
+  });
+  ASSERT_NE(fused_step, plan.end());
+  ASSERT_FALSE(graph.get_outputs(fused_step->fused_ops.back()->name).empty());
+}
+
 TEST(test_net, forward_group_conv) {
   using namespace kuiper_infer;
   RuntimeGraph graph("tmp/group_conv/group_conv.pnnx.param", "tmp/group_conv/group_conv.pnnx.bin");
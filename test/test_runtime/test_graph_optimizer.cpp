@@ -0,0 +1,249 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-27.
+#include <gtest/gtest.h>
+#include <cstring>
+#include <random>
+#include "runtime/graph_optimizer.hpp"
+#include "runtime/runtime_ir.hpp"
+
+using namespace kuiper_infer;
+
+static std::vector<float> AttributeValues(const pnnx::Attribute& attr) {
+  std::vector<float> values(attr.data.size() / sizeof(float));
+  std::memcpy(values.data(), attr.data.data(), attr.data.size());
+  return values;
+}
+
+static pnnx::Operator* FindOperator(pnnx::Graph& graph, const std::string& name) {
+  for (pnnx::Operator* op : graph.ops) {
+    if (op->name == name) {
+      return op;
+    }
+  }
+  return nullptr;
+}
+
+TEST(test_runtime, graph_optimizer_passes) {
+  const std::string param =
+      "7767517\n"
+      "7 6\n"
+      "pnnx.Input pnnx_input_0 0 1 0 #0=(1,1,4,4)f32\n"
+      "nn.Conv2d conv 1 1 0 1 bias=True dilation=(1,1) groups=1 in_channels=1 "
+      "kernel_size=(1,1) out_channels=2 padding=(0,0) padding_mode=zeros stride=(1,1) "
+      "#1=(1,2,4,4)f32\n"
+      "nn.BatchNorm2d bn 1 1 1 2 affine=True eps=0.0 num_features=2 #2=(1,2,4,4)f32\n"
+      "nn.ReLU relu 1 1 2 3 #3=(1,2,4,4)f32\n"
+      "nn.Dropout dropout 1 1 3 4 #4=(1,2,4,4)f32\n"
+      "nn.ReLU dead 1 1 4 5 #5=(1,2,4,4)f32\n"
+      "pnnx.Output pnnx_output_0 1 0 4";
+  pnnx::Graph graph;
+  ASSERT_EQ(graph.parse(param), 0);
+
+  pnnx::Operator* conv = FindOperator(graph, "conv");
+  pnnx::Operator* bn = FindOperator(graph, "bn");
+  ASSERT_NE(conv, nullptr);
+  ASSERT_NE(bn, nullptr);
+  conv->attrs["weight"] = pnnx::Attribute({2, 1, 1, 1}, {2.f, 3.f});
+  conv->attrs["bias"] = pnnx::Attribute({2}, {1.f, -1.f});
+  bn->attrs["running_mean"] = pnnx::Attribute({2}, {1.f, 2.f});
+  bn->attrs["running_var"] = pnnx::Attribute({2}, {4.f, 9.f});
+  bn->attrs["weight"] = pnnx::Attribute({2}, {1.f, 2.f});
+  bn->attrs["bias"] = pnnx::Attribute({2}, {0.5f, 0.f});
+
+  GraphOptimizer optimizer(graph);
+  const std::vector<GraphPassStats> pass_stats = optimizer.Optimize();
+  ASSERT_EQ(pass_stats.size(), 6);
+  ASSERT_EQ(pass_stats.at(0).pass_name, "eliminate_identity");
+  ASSERT_EQ(pass_stats.at(0).rewrites, 1);
+  ASSERT_EQ(pass_stats.at(2).pass_name, "fold_batch_norm");
+  ASSERT_EQ(pass_stats.at(2).rewrites, 1);
+  ASSERT_EQ(pass_stats.at(3).pass_name, "fuse_activation");
+  ASSERT_EQ(pass_stats.at(3).rewrites, 1);
+  ASSERT_EQ(pass_stats.at(4).pass_name, "fuse_depthwise_pointwise");
+  ASSERT_EQ(pass_stats.at(4).rewrites, 0);
+  ASSERT_EQ(pass_stats.at(5).pass_name, "eliminate_dead_code");
+  ASSERT_EQ(pass_stats.at(5).rewrites, 1);
+  ASSERT_EQ(pass_stats.back().ops_after, 3);
+
+  // 只剩下输入、卷积和输出，卷积直接连接到输出
+  ASSERT_EQ(graph.ops.size(), 3);
+  ASSERT_EQ(graph.operands.size(), 2);
+  ASSERT_EQ(conv->params.at("activation").s, "nn.ReLU");
+  ASSERT_EQ(conv->outputs.front()->consumers.size(), 1);
+  ASSERT_EQ(conv->outputs.front()->consumers.front()->type, "pnnx.Output");
+
+  // w' = w * gamma / sqrt(var), b' = (b - mean) * gamma / sqrt(var) + beta
+  const std::vector<float> weight = AttributeValues(conv->attrs.at("weight"));
+  const std::vector<float> bias = AttributeValues(conv->attrs.at("bias"));
+  ASSERT_FLOAT_EQ(weight.at(0), 1.f);
+  ASSERT_FLOAT_EQ(weight.at(1), 2.f);
+  ASSERT_FLOAT_EQ(bias.at(0), 0.5f);
+  ASSERT_FLOAT_EQ(bias.at(1), -2.f);
+}
+
+TEST(test_runtime, graph_optimizer_fold_shape) {
+  const std::string param =
+      "7767517\n"
+      "4 3\n"
+      "pnnx.Input pnnx_input_0 0 1 0 #0=(1,8,2,2)f32\n"
+      "torch.flatten flatten 1 1 0 1 end_dim=-1 start_dim=1 #1=(1,32)f32\n"
+      "Tensor.view view 1 1 1 2 shape=(1,4,8) #2=(1,4,8)f32\n"
+      "pnnx.Output pnnx_output_0 1 0 2";
+  pnnx::Graph graph;
+  ASSERT_EQ(graph.parse(param), 0);
+
+  GraphOptimizer optimizer(graph);
+  ASSERT_EQ(optimizer.FoldConstantShape(), 1);
+  ASSERT_EQ(graph.ops.size(), 3);
+  pnnx::Operator* view = FindOperator(graph, "view");
+  ASSERT_NE(view, nullptr);
+  ASSERT_EQ(view->type, "Tensor.view");
+  ASSERT_EQ(view->inputs.front()->name, "0");
+  ASSERT_EQ(view->params.at("shape").ai, std::vector<int>({1, 4, 8}));
+}
+
+TEST(test_runtime, graph_optimizer_fuse_depthwise_pointwise) {
+  const std::string param =
+      "7767517\n"
+      "5 4\n"
+      "pnnx.Input pnnx_input_0 0 1 0 #0=(1,2,4,4)f32\n"
+      "nn.Conv2d dw 1 1 0 1 bias=False dilation=(1,1) groups=2 in_channels=2 "
+      "kernel_size=(3,3) out_channels=2 padding=(1,1) padding_mode=zeros stride=(1,1) "
+      "#1=(1,2,4,4)f32\n"
+      "nn.ReLU6 relu6 1 1 1 2 #2=(1,2,4,4)f32\n"
+      "nn.Conv2d pw 1 1 2 3 bias=True dilation=(1,1) groups=1 in_channels=2 "
+      "kernel_size=(1,1) out_channels=3 padding=(0,0) padding_mode=zeros stride=(1,1) "
+      "#3=(1,3,4,4)f32\n"
+      "pnnx.Output pnnx_output_0 1 0 3";
+  pnnx::Graph graph;
+  ASSERT_EQ(graph.parse(param), 0);
+
+  pnnx::Operator* dw = FindOperator(graph, "dw");
+  pnnx::Operator* pw = FindOperator(graph, "pw");
+  ASSERT_NE(dw, nullptr);
+  ASSERT_NE(pw, nullptr);
+  dw->attrs["weight"] = pnnx::Attribute({2, 1, 3, 3}, std::vector<float>(18, 1.f));
+  pw->attrs["weight"] = pnnx::Attribute({3, 2, 1, 1}, {1.f, 2.f, 3.f, 4.f, 5.f, 6.f});
+  pw->attrs["bias"] = pnnx::Attribute({3}, {1.f, 2.f, 3.f});
+
+  GraphOptimizer optimizer(graph);
+  ASSERT_EQ(optimizer.FuseActivation(), 1);
+  ASSERT_EQ(optimizer.FuseDepthwisePointwise(), 1);
+
+  // 深度卷积改写为融合算子并直接连接到输出，中间结果不再是图中的操作数
+  ASSERT_EQ(graph.ops.size(), 3);
+  ASSERT_EQ(graph.operands.size(), 2);
+  ASSERT_EQ(dw->type, "kuiper.DepthwisePointwise");
+  ASSERT_EQ(dw->params.at("channels").i, 2);
+  ASSERT_EQ(dw->params.at("out_channels").i, 3);
+  ASSERT_EQ(dw->params.at("kernel_size").ai, std::vector<int>({3, 3}));
+  ASSERT_EQ(dw->params.at("dw_activation").s, "nn.ReLU6");
+  ASSERT_EQ(dw->params.count("activation"), 0);
+  ASSERT_EQ(dw->outputs.front()->consumers.front()->type, "pnnx.Output");
+
+  ASSERT_EQ(AttributeValues(dw->attrs.at("dw_bias")), std::vector<float>(2, 0.f));
+  ASSERT_EQ(dw->attrs.at("weight").shape, std::vector<int>({3, 2, 1, 1}));
+  ASSERT_EQ(AttributeValues(dw->attrs.at("bias")), std::vector<float>({1.f, 2.f, 3.f}));
+}
+
+static std::vector<float> RandomValues(uint32_t size, float low, float high, uint32_t seed) {
+  std::mt19937 engine(seed);
+  std::uniform_real_distribution<float> distribution(low, high);
+  std::vector<float> values(size);
+  for (float& value : values) {
+    value = distribution(engine);
+  }
+  return values;
+}
+
+static std::vector<sftensor> RunSavedGraph(const std::string& param_path,
+                                           const std::string& bin_path, const sftensor& input) {
+  RuntimeGraph graph(param_path, bin_path);
+  graph.Build();
+  graph.set_inputs("pnnx_input_0", {input});
+  graph.Forward(false);
+  return graph.get_outputs("pnnx_output_0");
+}
+
+TEST(test_runtime, graph_optimizer_round_trip) {
+  const std::string param =
+      "7767517\n"
+      "8 7\n"
+      "pnnx.Input pnnx_input_0 0 1 0 #0=(1,4,9,9)f32\n"
+      "nn.Conv2d conv 1 1 0 1 bias=True dilation=(1,1) groups=1 in_channels=4 "
+      "kernel_size=(3,3) out_channels=8 padding=(1,1) padding_mode=zeros stride=(1,1) "
+      "#1=(1,8,9,9)f32\n"
+      "nn.BatchNorm2d bn 1 1 1 2 affine=True eps=1.000000e-05 num_features=8 "
+      "#2=(1,8,9,9)f32\n"
+      "nn.ReLU relu 1 1 2 3 #3=(1,8,9,9)f32\n"
+      "nn.Conv2d dw 1 1 3 4 bias=True dilation=(1,1) groups=8 in_channels=8 "
+      "kernel_size=(3,3) out_channels=8 padding=(1,1) padding_mode=zeros stride=(1,1) "
+      "#4=(1,8,9,9)f32\n"
+      "nn.ReLU6 relu6 1 1 4 5 #5=(1,8,9,9)f32\n"
+      "nn.Conv2d pw 1 1 5 6 bias=True dilation=(1,1) groups=1 in_channels=8 "
+      "kernel_size=(1,1) out_channels=6 padding=(0,0) padding_mode=zeros stride=(1,1) "
+      "#6=(1,6,9,9)f32\n"
+      "pnnx.Output pnnx_output_0 1 0 6";
+  pnnx::Graph graph;
+  ASSERT_EQ(graph.parse(param), 0);
+  FindOperator(graph, "conv")->attrs["weight"] =
+      pnnx::Attribute({8, 4, 3, 3}, RandomValues(8 * 4 * 9, -0.5f, 0.5f, 1));
+  FindOperator(graph, "conv")->attrs["bias"] =
+      pnnx::Attribute({8}, RandomValues(8, -0.5f, 0.5f, 2));
+  pnnx::Operator* bn = FindOperator(graph, "bn");
+  bn->attrs["running_mean"] = pnnx::Attribute({8}, RandomValues(8, -0.5f, 0.5f, 3));
+  bn->attrs["running_var"] = pnnx::Attribute({8}, RandomValues(8, 0.5f, 2.f, 4));
+  bn->attrs["weight"] = pnnx::Attribute({8}, RandomValues(8, 0.5f, 1.5f, 5));
+  bn->attrs["bias"] = pnnx::Attribute({8}, RandomValues(8, -0.5f, 0.5f, 6));
+  FindOperator(graph, "dw")->attrs["weight"] =
+      pnnx::Attribute({8, 1, 3, 3}, RandomValues(8 * 9, -1.f, 1.f, 7));
+  FindOperator(graph, "dw")->attrs["bias"] = pnnx::Attribute({8}, RandomValues(8, 0.f, 1.f, 8));
+  FindOperator(graph, "pw")->attrs["weight"] =
+      pnnx::Attribute({6, 8, 1, 1}, RandomValues(6 * 8, -0.5f, 0.5f, 9));
+  FindOperator(graph, "pw")->attrs["bias"] =
+      pnnx::Attribute({6}, RandomValues(6, -0.5f, 0.5f, 10));
+  ASSERT_EQ(graph.save("/tmp/kuiper_test_opt_origin.pnnx.param",
+                       "/tmp/kuiper_test_opt_origin.pnnx.bin"),
+            0);
+
+  // 与kuiper_opt相同，优化后保存再由运行时重新加载
+  GraphOptimizer optimizer(graph);
+  optimizer.Optimize();
+  ASSERT_EQ(graph.ops.size(), 4);
+  ASSERT_EQ(FindOperator(graph, "conv")->params.at("activation").s, "nn.ReLU");
+  ASSERT_EQ(FindOperator(graph, "dw")->type, "kuiper.DepthwisePointwise");
+  ASSERT_EQ(graph.save("/tmp/kuiper_test_opt.pnnx.param", "/tmp/kuiper_test_opt.pnnx.bin"), 0);
+
+  sftensor input = std::make_shared<Tensor<float>>(4, 9, 9);
+  input->RandN();
+  const std::vector<sftensor> expected = RunSavedGraph(
+      "/tmp/kuiper_test_opt_origin.pnnx.param", "/tmp/kuiper_test_opt_origin.pnnx.bin", input);
+  const std::vector<sftensor> outputs =
+      RunSavedGraph("/tmp/kuiper_test_opt.pnnx.param", "/tmp/kuiper_test_opt.pnnx.bin", input);
+  ASSERT_EQ(outputs.size(), 1);
+  ASSERT_EQ(expected.size(), 1);
+  ASSERT_EQ(outputs.front()->shapes(), expected.front()->shapes());
+  for (uint32_t i = 0; i < expected.front()->size(); ++i) {
+    ASSERT_NEAR(outputs.front()->index(i), expected.front()->index(i), 1e-4f) << i;
+  }
+}
@@ -0,0 +1,74 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-31.
+#include <gtest/gtest.h>
+#include <fstream>
+#include <iterator>
+#include "runtime/pnnx/ir.h"
+#include "runtime/runtime_aot.hpp"
+
+TEST(test_runtime_aot, arena_tensors) {
+  using namespace kuiper_infer;
+  AotArena arena(256);
+  const std::vector<sftensor> tensors = arena.Tensors(16, {2, 3, 4, 5});
+  ASSERT_EQ(tensors.size(), 2);
+  ASSERT_EQ(tensors.at(1)->raw_ptr(), tensors.at(0)->raw_ptr() + 60);
+  ASSERT_EQ(tensors.at(0)->channels(), 3);
+  ASSERT_EQ(tensors.at(0)->rows(), 4);
+  ASSERT_EQ(tensors.at(0)->cols(), 5);
+
+  // 二维的操作数放在列上
+  const std::vector<sftensor> features = arena.Tensors(0, {1, 16});
+  ASSERT_EQ(features.at(0)->raw_ptr() + 16, tensors.at(0)->raw_ptr());
+  ASSERT_EQ(features.at(0)->cols(), 16);
+
+  const std::vector<sftensor> inputs = AotConcat({features, tensors});
+  ASSERT_EQ(inputs.size(), 3);
+  ASSERT_EQ(inputs.at(2), tensors.at(1));
+}
+
+TEST(test_runtime_aot, generate_cpp) {
+  pnnx::Graph graph;
+  const std::string param =
+      "7767517\n"
+      "5 4\n"
+      "pnnx.Input in0 0 1 0 #0=(1,3,8,8)f32\n"
+      "nn.ReLU relu1 1 1 0 1 #0=(1,3,8,8)f32 #1=(1,3,8,8)f32\n"
+      "nn.ReLU relu2 1 1 1 2 #1=(1,3,8,8)f32 #2=(1,3,8,8)f32\n"
+      "pnnx.Expression add 2 1 1 2 3 expr=add(@0,@1) #3=(1,3,8,8)f32\n"
+      "pnnx.Output out0 1 0 3\n";
+  ASSERT_EQ(graph.parse(param), 0);
+  const std::string cpp_path = "tmp/aot_relu_add.cpp";
+  ASSERT_EQ(graph.cpp(cpp_path, "tmp/aot_relu_add.pnnx.bin"), 0);
+
+  std::ifstream cpp_file(cpp_path);
+  const std::string code((std::istreambuf_iterator<char>(cpp_file)),
+                         std::istreambuf_iterator<char>());
+  // relu2的输出复用了输入的内存，三个操作数同时存活
+  ASSERT_NE(code.find("kArenaSize = 576;"), std::string::npos);
+  ASSERT_NE(code.find("operand_2_ = arena_.Tensors(0, {1, 3, 8, 8});"), std::string::npos);
+  // 形状作为模板参数，直接调用特化的内核而不经过层工厂
+  ASSERT_NE(code.find("aot::Activate<192, aot::Activation::kRelu>(arena + 192, arena + 0);"),
+            std::string::npos);
+  ASSERT_NE(code.find("aot::Add<192>(arena + 192, arena + 0, arena + 384);"), std::string::npos);
+  ASSERT_EQ(code.find("CreateLayer"), std::string::npos);
+}
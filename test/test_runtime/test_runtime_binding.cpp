@@ -0,0 +1,107 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-30.
+#include <gtest/gtest.h>
+#include "runtime/runtime_binding.hpp"
+
+TEST(test_runtime_binding, tensor_layout) {
+  using namespace kuiper_infer;
+  std::vector<float> data(2 * 3 * 4 * 5);
+  ExternalBuffer row_major = ExternalBuffer::RowMajor(data.data(), {2, 3, 4, 5});
+  ASSERT_EQ(row_major.element_strides(), (std::vector<int64_t>{60, 20, 5, 1}));
+  ASSERT_FALSE(row_major.IsTensorLayout());
+
+  ExternalBuffer column_major = row_major;
+  column_major.strides = {60, 20, 1, 4};
+  ASSERT_TRUE(column_major.IsTensorLayout());
+
+  // 一维的特征向量在两种布局下相同
+  ExternalBuffer features = ExternalBuffer::RowMajor(data.data(), {4, 30});
+  ASSERT_TRUE(features.IsTensorLayout());
+
+  std::vector<uint8_t> pixels(2 * 3 * 4 * 5);
+  ASSERT_FALSE(ExternalBuffer::RowMajor(pixels.data(), {2, 3, 4, 5}).IsTensorLayout());
+}
+
+TEST(test_runtime_binding, wrap_without_copy) {
+  using namespace kuiper_infer;
+  std::vector<float> data(2 * 3 * 4 * 5);
+  ExternalBuffer buffer = ExternalBuffer::RowMajor(data.data(), {2, 3, 4, 5});
+  buffer.strides = {60, 20, 1, 4};
+  const std::vector<sftensor> tensors = WrapBuffer(buffer);
+  ASSERT_EQ(tensors.size(), 2);
+  ASSERT_EQ(tensors.at(1)->raw_ptr(), data.data() + 60);
+  ASSERT_EQ(tensors.at(1)->channels(), 3);
+  ASSERT_EQ(tensors.at(1)->rows(), 4);
+  ASSERT_EQ(tensors.at(1)->cols(), 5);
+}
+
+TEST(test_runtime_binding, read_row_major_float) {
+  using namespace kuiper_infer;
+  std::vector<float> data(2 * 3 * 4 * 5);
+  for (uint32_t i = 0; i < data.size(); ++i) {
+    data.at(i) = float(i);
+  }
+  const ExternalBuffer buffer = ExternalBuffer::RowMajor(data.data(), {2, 3, 4, 5});
+  std::vector<sftensor> tensors = CreateBufferTensors(buffer);
+  ReadBuffer(buffer, 1, *tensors.at(1));
+  for (uint32_t c = 0; c < 3; ++c) {
+    for (uint32_t h = 0; h < 4; ++h) {
+      for (uint32_t w = 0; w < 5; ++w) {
+        ASSERT_EQ(tensors.at(1)->at(c, h, w), data.at(60 + c * 20 + h * 5 + w));
+      }
+    }
+  }
+}
+
+TEST(test_runtime_binding, read_uint8_scaled) {
+  using namespace kuiper_infer;
+  std::vector<uint8_t> pixels(1 * 3 * 2 * 2);
+  for (uint32_t i = 0; i < pixels.size(); ++i) {
+    pixels.at(i) = uint8_t(i * 20);
+  }
+  const ExternalBuffer buffer =
+      ExternalBuffer::RowMajor(pixels.data(), {1, 3, 2, 2}, 1.f / 255.f, -0.5f);
+  Tensor<float> tensor(3, 2, 2);
+  ReadBuffer(buffer, 0, tensor);
+  for (uint32_t c = 0; c < 3; ++c) {
+    for (uint32_t h = 0; h < 2; ++h) {
+      for (uint32_t w = 0; w < 2; ++w) {
+        const float pixel = pixels.at(c * 4 + h * 2 + w);
+        ASSERT_FLOAT_EQ(tensor.at(c, h, w), pixel / 255.f - 0.5f);
+      }
+    }
+  }
+}
+
+TEST(test_runtime_binding, write_uint8_saturated) {
+  using namespace kuiper_infer;
+  Tensor<float> tensor(1, 2, 2);
+  tensor.at(0, 0, 0) = -3.f;
+  tensor.at(0, 0, 1) = 1.4f;
+  tensor.at(0, 1, 0) = 254.6f;
+  tensor.at(0, 1, 1) = 300.f;
+  std::vector<uint8_t> pixels(4);
+  const ExternalBuffer buffer = ExternalBuffer::RowMajor(pixels.data(), {1, 1, 2, 2});
+  WriteBuffer(tensor, 0, buffer);
+  ASSERT_EQ(pixels, (std::vector<uint8_t>{0, 1, 255, 255}));
+}
@@ -0,0 +1,198 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-9.
+#include <gtest/gtest.h>
+#include <thread>
+#include "data/tensor_util.hpp"
+#include "runtime/runtime_cache.hpp"
+#include "runtime/runtime_ir.hpp"
+
+using namespace kuiper_infer;
+
+TEST(test_runtime, cache_hash_tensors) {
+  sftensor tensor1 = std::make_shared<Tensor<float>>(3, 17, 13);
+  tensor1->RandN();
+  sftensor tensor2 = TensorClone(tensor1);
+  ASSERT_EQ(RuntimeResultCache::HashTensors({tensor1}),
+            RuntimeResultCache::HashTensors({tensor2}));
+
+  tensor2->index(tensor2->size() - 1) += 1.f;
+  ASSERT_NE(RuntimeResultCache::HashTensors({tensor1}),
+            RuntimeResultCache::HashTensors({tensor2}));
+
+  // 数据相同但形状不同
+  sftensor tensor3 = TensorClone(tensor1);
+  tensor3->Reshape({3, 13, 17});
+  ASSERT_NE(RuntimeResultCache::HashTensors({tensor1}),
+            RuntimeResultCache::HashTensors({tensor3}));
+}
+
+TEST(test_runtime, cache_lru) {
+  RuntimeResultCache cache(2);
+  sftensor output = std::make_shared<Tensor<float>>(1, 2, 2);
+  output->Fill(1.f);
+  const auto key = [](const std::string& model_name, uint64_t input_hash) {
+    return RuntimeCacheKey{model_name, "pnnx_input_0", "pnnx_output_0", input_hash};
+  };
+  cache.Insert(key("model", 1), {output});
+  cache.Insert(key("model", 2), {output});
+
+  std::vector<sftensor> outputs;
+  ASSERT_TRUE(cache.Lookup(key("model", 1), outputs));
+  ASSERT_EQ(outputs.size(), 1);
+  ASSERT_NE(outputs.front(), output);
+  ASSERT_EQ(outputs.front()->values(), output->values());
+
+  // 键值2最久未被使用，插入键值3时被淘汰
+  cache.Insert(key("model", 3), {output});
+  ASSERT_EQ(cache.size(), 2);
+  ASSERT_FALSE(cache.Lookup(key("model", 2), outputs));
+  ASSERT_TRUE(cache.Lookup(key("model", 1), outputs));
+  ASSERT_TRUE(cache.Lookup(key("model", 3), outputs));
+  ASSERT_FALSE(cache.Lookup(key("other_model", 3), outputs));
+
+  const RuntimeCacheMetrics metrics = cache.metrics();
+  ASSERT_EQ(metrics.hits, 3);
+  ASSERT_EQ(metrics.misses, 2);
+  ASSERT_EQ(metrics.evictions, 1);
+  ASSERT_FLOAT_EQ(metrics.hit_rate(), 0.6);
+}
+
+TEST(test_runtime, cache_forward) {
+  RuntimeGraph graph("tmp/add/resnet_add.pnnx.param", "tmp/add/resnet_add.pnnx.bin");
+  graph.Build();
+  RuntimeResultCache cache(4);
+
+  std::vector<sftensor> inputs;
+  for (int i = 0; i < 4; ++i) {
+    sftensor input = std::make_shared<Tensor<float>>(1, 4, 4);
+    input->Fill(1.f);
+    inputs.push_back(input);
+  }
+  std::vector<sftensor> outputs1 =
+      cache.Forward(graph, "resnet_add", "pnnx_input_0", inputs, "pnnx_output_0");
+  std::vector<sftensor> outputs2 =
+      cache.Forward(graph, "resnet_add", "pnnx_input_0", inputs, "pnnx_output_0");
+  ASSERT_EQ(outputs1.size(), 4);
+  ASSERT_EQ(outputs1, outputs2);
+  ASSERT_EQ(cache.metrics().hits, 1);
+  ASSERT_EQ(cache.metrics().misses, 1);
+
+  inputs.front()->Fill(2.f);
+  std::vector<sftensor> outputs3 =
+      cache.Forward(graph, "resnet_add", "pnnx_input_0", inputs, "pnnx_output_0");
+  ASSERT_NE(outputs3.front()->values(), outputs1.front()->values());
+  ASSERT_EQ(cache.metrics().misses, 2);
+}
+
+TEST(test_runtime, cache_forward_outputs) {
+  RuntimeGraph graph("tmp/add/resnet_add.pnnx.param", "tmp/add/resnet_add.pnnx.bin");
+  graph.Build();
+  RuntimeResultCache cache(4);
+
+  // 同一个输入请求两个不同的输出，不能返回另一个输出的缓存
+  std::string intermediate_name;
+  for (const RuntimeExecutionStep& step : graph.execution_plan()) {
+    if (step.fused_ops.empty()) {
+      intermediate_name = step.op->name;
+      break;
+    }
+  }
+  ASSERT_FALSE(intermediate_name.empty());
+
+  sftensor input = std::make_shared<Tensor<float>>(1, 4, 4);
+  input->Fill(1.f);
+  std::vector<sftensor> outputs1 =
+      cache.Forward(graph, "resnet_add", "pnnx_input_0", {input}, "pnnx_output_0");
+  std::vector<sftensor> outputs2 =
+      cache.Forward(graph, "resnet_add", "pnnx_input_0", {input}, intermediate_name);
+  ASSERT_EQ(cache.metrics().misses, 2);
+  ASSERT_EQ(cache.metrics().hits, 0);
+  std::vector<sftensor> expected2 = graph.get_outputs(intermediate_name);
+  ASSERT_EQ(outputs2.size(), expected2.size());
+  for (uint32_t i = 0; i < expected2.size(); ++i) {
+    ASSERT_EQ(outputs2.at(i)->values(), expected2.at(i)->values());
+  }
+
+  std::vector<sftensor> outputs3 =
+      cache.Forward(graph, "resnet_add", "pnnx_input_0", {input}, "pnnx_output_0");
+  ASSERT_EQ(outputs3, outputs1);
+  ASSERT_EQ(cache.metrics().hits, 1);
+}
+
+TEST(test_runtime, cache_forward_collision) {
+  RuntimeGraph graph("tmp/add/resnet_add.pnnx.param", "tmp/add/resnet_add.pnnx.bin");
+  graph.Build();
+  RuntimeResultCache cache(4);
+
+  sftensor input = std::make_shared<Tensor<float>>(1, 4, 4);
+  input->Fill(1.f);
+  // 模拟哈希碰撞，键值相同但输入不同的条目不能命中
+  sftensor stale_output = std::make_shared<Tensor<float>>(1, 1, 1);
+  stale_output->Fill(-1.f);
+  const RuntimeCacheKey key{"resnet_add", "pnnx_input_0", "pnnx_output_0",
+                            RuntimeResultCache::HashTensors({input})};
+  cache.Insert(key, {stale_output});
+
+  std::vector<sftensor> outputs =
+      cache.Forward(graph, "resnet_add", "pnnx_input_0", {input}, "pnnx_output_0");
+  ASSERT_EQ(cache.metrics().misses, 1);
+  ASSERT_EQ(outputs.size(), graph.get_outputs("pnnx_output_0").size());
+  ASSERT_EQ(outputs.front()->values(), graph.get_outputs("pnnx_output_0").front()->values());
+}
+
+TEST(test_runtime, cache_forward_concurrent) {
+  RuntimeGraph graph("tmp/add/resnet_add.pnnx.param", "tmp/add/resnet_add.pnnx.bin");
+  graph.Build();
+  RuntimeResultCache cache(16);
+
+  // 不同输入的未命中同时到达，在同一个图上逐个执行，每个结果对应自己的输入
+  const int requests = 8;
+  std::vector<std::vector<sftensor>> expected(requests);
+  for (int i = 0; i < requests; ++i) {
+    sftensor input = std::make_shared<Tensor<float>>(1, 4, 4);
+    input->Fill(float(i));
+    graph.set_inputs("pnnx_input_0", {input});
+    graph.Forward(false);
+    for (const sftensor& output : graph.get_outputs("pnnx_output_0")) {
+      expected.at(i).push_back(TensorClone(output));
+    }
+  }
+
+  std::vector<std::vector<sftensor>> outputs(requests);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < requests; ++i) {
+    threads.emplace_back([&, i]() {
+      sftensor input = std::make_shared<Tensor<float>>(1, 4, 4);
+      input->Fill(float(i));
+      outputs.at(i) = cache.Forward(graph, "resnet_add", "pnnx_input_0", {input}, "pnnx_output_0");
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(cache.metrics().misses, requests);
+  for (int i = 0; i < requests; ++i) {
+    ASSERT_EQ(outputs.at(i).size(), expected.at(i).size());
+    ASSERT_EQ(outputs.at(i).front()->values(), expected.at(i).front()->values()) << i;
+  }
+}
@@ -0,0 +1,124 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-13.
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <thread>
+#include "runtime/runtime_ipc.hpp"
+
+using namespace kuiper_infer;
+
+TEST(test_runtime, ipc_server_client) {
+  const std::string param_path = "tmp/add/resnet_add.pnnx.param";
+  const std::string bin_path = "tmp/add/resnet_add.pnnx.bin";
+  const uint32_t batch_size = 4;
+
+  RuntimeGraph graph(param_path, bin_path);
+  graph.Build();
+  std::vector<sftensor> inputs;
+  for (uint32_t i = 0; i < batch_size; ++i) {
+    sftensor input = std::make_shared<Tensor<float>>(1, 4, 4);
+    input->Fill(float(i));
+    inputs.push_back(input);
+  }
+  graph.set_inputs("pnnx_input_0", inputs);
+  graph.Forward(false);
+  const std::vector<sftensor> expected = graph.get_outputs("pnnx_output_0");
+  const sftensor& expected_output = expected.front();
+
+  auto server_graph = std::make_shared<RuntimeGraph>(param_path, bin_path);
+  server_graph->Build();
+  RuntimeIpcServer server("/kuiper_test_ipc", server_graph, "pnnx_input_0", "pnnx_output_0",
+                          batch_size, {1, 4, 4},
+                          {expected_output->channels(), expected_output->rows(),
+                           expected_output->cols()},
+                          8);
+  std::thread server_thread([&server]() { server.Run(); });
+
+  std::vector<std::thread> client_threads;
+  for (uint32_t c = 0; c < 3; ++c) {
+    client_threads.emplace_back([&expected, batch_size]() {
+      RuntimeIpcClient client("/kuiper_test_ipc");
+      for (uint32_t i = 0; i < 16; ++i) {
+        const uint32_t sample = i % batch_size;
+        const uint32_t slot = client.Acquire();
+        // 直接在共享内存中写入输入，读取输出
+        client.input(slot)->Fill(float(sample));
+        ASSERT_EQ(client.Submit(slot), StatusCode::kSuccess);
+        ASSERT_EQ(client.output(slot)->values(), expected.at(sample)->values());
+        client.Release(slot);
+      }
+    });
+  }
+  for (std::thread& client_thread : client_threads) {
+    client_thread.join();
+  }
+
+  server.Stop();
+  server_thread.join();
+  ASSERT_GT(server.batch_count(), 0);
+  ASSERT_LE(server.batch_count(), 48);
+}
+
+TEST(test_runtime, ipc_server_exclusive) {
+  auto graph = std::make_shared<RuntimeGraph>("tmp/add/resnet_add.pnnx.param",
+                                              "tmp/add/resnet_add.pnnx.bin");
+  graph->Build();
+  // 模拟崩溃的服务端留下的共享内存
+  shm_unlink("/kuiper_test_ipc_exclusive");
+  const int fd = shm_open("/kuiper_test_ipc_exclusive", O_CREAT | O_EXCL | O_RDWR, 0600);
+  ASSERT_GE(fd, 0);
+  close(fd);
+
+  ASSERT_DEATH(RuntimeIpcServer("/kuiper_test_ipc_exclusive", graph, "pnnx_input_0",
+                                "pnnx_output_0", 1, {1, 4, 4}, {1, 4, 4}, 2),
+               "already exists");
+  RuntimeIpcServer server("/kuiper_test_ipc_exclusive", graph, "pnnx_input_0", "pnnx_output_0",
+                          1, {1, 4, 4}, {1, 4, 4}, 2, true);
+  RuntimeIpcClient client("/kuiper_test_ipc_exclusive");
+  // 服务端仍在运行时不能被第二个服务端替换
+  ASSERT_DEATH(RuntimeIpcServer("/kuiper_test_ipc_exclusive", graph, "pnnx_input_0",
+                                "pnnx_output_0", 1, {1, 4, 4}, {1, 4, 4}, 2),
+               "already exists");
+}
+
+TEST(test_runtime, ipc_client_timeout) {
+  auto graph = std::make_shared<RuntimeGraph>("tmp/add/resnet_add.pnnx.param",
+                                              "tmp/add/resnet_add.pnnx.bin");
+  graph->Build();
+  RuntimeIpcServer server("/kuiper_test_ipc_timeout", graph, "pnnx_input_0", "pnnx_output_0", 1,
+                          {1, 4, 4}, {1, 4, 4}, 2, true);
+  RuntimeIpcClient client("/kuiper_test_ipc_timeout");
+
+  // 服务端没有运行，请求超时后被撤回，槽位可以再次提交
+  const uint32_t slot = client.Acquire();
+  ASSERT_EQ(client.Submit(slot, std::chrono::milliseconds(50)), StatusCode::kInferTimeout);
+  ASSERT_EQ(client.Submit(slot, std::chrono::milliseconds(10)), StatusCode::kInferTimeout);
+
+  // 服务端停止后请求立即失败
+  server.Stop();
+  ASSERT_EQ(client.Submit(slot, std::chrono::milliseconds(1000)),
+            StatusCode::kInferServerUnavailable);
+  client.Release(slot);
+}
@@ -605,3 +605,34 @@ TEST(test_runtime, op_is_output) {
   ASSERT_EQ(graph.is_output_op("pnnx_output_0"), true);
   ASSERT_EQ(graph.is_output_op("random_str"), false);
 }
+
+TEST(test_runtime, graph_forward_plan) {
+  using namespace kuiper_infer;
+  RuntimeGraph graph("tmp/add/resnet_add.pnnx.param", "tmp/add/resnet_add.pnnx.bin");
+  graph.Build();
+
+  const int batch_size = 4;
+  std::vector<std::shared_ptr<Tensor<float>>> inputs;
+  for (int i = 0; i < batch_size; ++i) {
+    std::shared_ptr<Tensor<float>> input = std::make_shared<Tensor<float>>(1, 4, 4);
+    input->Fill(1.);
+    inputs.push_back(input);
+  }
+  graph.set_inputs("pnnx_input_0", inputs);
+  graph.Forward(false);
+  std::vector<std::shared_ptr<Tensor<float>>> outputs1 = graph.get_outputs("pnnx_output_0");
+  ASSERT_EQ(outputs1.size(), batch_size);
+  std::vector<std::vector<float>> values1;
+  for (const auto& output : outputs1) {
+    values1.push_back(output->values());
+  }
+
+  graph.Forward(false);
+  std::vector<std::shared_ptr<Tensor<float>>> outputs2 = graph.get_outputs("pnnx_output_0");
+  ASSERT_EQ(outputs2.size(), batch_size);
+  for (int i = 0; i < batch_size; ++i) {
+    // 执行计划在构建时绑定输出空间，多次推理复用同一个输出张量
+    ASSERT_EQ(outputs1.at(i), outputs2.at(i));
+    ASSERT_EQ(outputs2.at(i)->values(), values1.at(i));
+  }
+}
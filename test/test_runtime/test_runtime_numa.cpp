@@ -0,0 +1,90 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-20.
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <fstream>
+#include "runtime/runtime_numa.hpp"
+
+using namespace kuiper_infer;
+
+TEST(test_runtime, numa_parse_cpu_list) {
+  ASSERT_EQ(NumaTopology::ParseCpuList("0-3,8,10-11\n"),
+            std::vector<uint32_t>({0, 1, 2, 3, 8, 10, 11}));
+  ASSERT_EQ(NumaTopology::ParseCpuList("5"), std::vector<uint32_t>({5}));
+  ASSERT_TRUE(NumaTopology::ParseCpuList("").empty());
+}
+
+TEST(test_runtime, numa_detect_topology) {
+  // 构造一个两节点的sysfs目录，节点2只有内存没有cpu
+  const std::string node_root = "/tmp/kuiper_test_numa";
+  mkdir(node_root.c_str(), 0755);
+  const std::vector<std::string> cpu_lists = {"0-1", "2-3", ""};
+  for (uint32_t i = 0; i < cpu_lists.size(); ++i) {
+    const std::string node_dir = node_root + "/node" + std::to_string(i);
+    mkdir(node_dir.c_str(), 0755);
+    std::ofstream cpu_list_file(node_dir + "/cpulist");
+    cpu_list_file << cpu_lists.at(i) << "\n";
+  }
+
+  const NumaTopology topology = NumaTopology::Detect(node_root);
+  ASSERT_EQ(topology.node_count(), 2);
+  ASSERT_EQ(topology.node_ids, std::vector<uint32_t>({0, 1}));
+  ASSERT_EQ(topology.node_cpus.at(1), std::vector<uint32_t>({2, 3}));
+
+  const NumaTopology fallback = NumaTopology::Detect("/tmp/kuiper_test_numa_missing");
+  ASSERT_EQ(fallback.node_count(), 1);
+  ASSERT_FALSE(fallback.node_cpus.front().empty());
+}
+
+TEST(test_runtime, numa_graph_forward) {
+  const std::string param_path = "tmp/add/resnet_add.pnnx.param";
+  const std::string bin_path = "tmp/add/resnet_add.pnnx.bin";
+  RuntimeGraph graph(param_path, bin_path);
+  graph.Build();
+
+  std::vector<sftensor> inputs;
+  for (int i = 0; i < 4; ++i) {
+    sftensor input = std::make_shared<Tensor<float>>(1, 4, 4);
+    input->Fill(1.f);
+    inputs.push_back(input);
+  }
+  graph.set_inputs("pnnx_input_0", inputs);
+  graph.Forward(false);
+  const std::vector<sftensor> expected = graph.get_outputs("pnnx_output_0");
+
+  // 注入两个节点的拓扑，在单节点的机器上也能运行
+  NumaTopology topology;
+  topology.node_ids = {0, 1};
+  topology.node_cpus = {{0}, {0}};
+  RuntimeNumaGraph numa_graph(param_path, bin_path, topology);
+  numa_graph.Build();
+  for (uint32_t node = 0; node < topology.node_count(); ++node) {
+    const std::vector<sftensor> outputs =
+        numa_graph.Forward(node, "pnnx_input_0", inputs, "pnnx_output_0");
+    ASSERT_EQ(outputs.size(), expected.size());
+    for (uint32_t i = 0; i < outputs.size(); ++i) {
+      ASSERT_EQ(outputs.at(i)->values(), expected.at(i)->values());
+    }
+  }
+  ASSERT_NE(&numa_graph.replica(0), &numa_graph.replica(1));
+}
@@ -0,0 +1,111 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-29.
+#include <gtest/gtest.h>
+#include "runtime/runtime_parallel.hpp"
+
+static std::shared_ptr<kuiper_infer::RuntimeOperator> MakeConvOperator(int32_t batch) {
+  using namespace kuiper_infer;
+  auto op = std::make_shared<RuntimeOperator>();
+  op->type = "nn.Conv2d";
+  op->input_operands_seq.push_back(std::make_shared<RuntimeOperand>(
+      "input", std::vector<int32_t>{batch, 64, 56, 56}, std::vector<sftensor>{},
+      RuntimeDataType::kTypeFloat32));
+  op->output_operands = std::make_shared<RuntimeOperand>(
+      "output", std::vector<int32_t>{batch, 64, 56, 56}, std::vector<sftensor>{},
+      RuntimeDataType::kTypeFloat32);
+  op->attribute.insert({"weight", std::make_shared<RuntimeAttribute>(
+                                      std::vector<int32_t>{64, 64, 3, 3},
+                                      RuntimeDataType::kTypeFloat32, std::vector<char>{})});
+  return op;
+}
+
+TEST(test_runtime_parallel, conv_cost) {
+  using namespace kuiper_infer;
+  const OperatorCost cost = EstimateOperatorCost(*MakeConvOperator(2));
+  ASSERT_EQ(cost.batch_size, 2);
+  ASSERT_EQ(cost.channels, 64);
+  ASSERT_DOUBLE_EQ(cost.flops, 2. * 2 * 64 * 56 * 56 * 64 * 3 * 3);
+  ASSERT_DOUBLE_EQ(cost.bytes(), (2. * 2 * 64 * 56 * 56 + 64 * 64 * 3 * 3) * sizeof(float));
+}
+
+TEST(test_runtime_parallel, single_sample_splits_inside) {
+  using namespace kuiper_infer;
+  const ParallelPlan plan = PlanParallelism(EstimateOperatorCost(*MakeConvOperator(1)), 8);
+  ASSERT_EQ(plan.batch_threads, 1);
+  ASSERT_EQ(plan.intra_threads, 8);
+}
+
+TEST(test_runtime_parallel, batch_fills_budget) {
+  using namespace kuiper_infer;
+  const ParallelPlan plan = PlanParallelism(EstimateOperatorCost(*MakeConvOperator(8)), 8);
+  ASSERT_EQ(plan.batch_threads, 8);
+  ASSERT_EQ(plan.intra_threads, 1);
+
+  const ParallelPlan plan2 = PlanParallelism(EstimateOperatorCost(*MakeConvOperator(2)), 8);
+  ASSERT_EQ(plan2.batch_threads, 2);
+  ASSERT_EQ(plan2.intra_threads, 4);
+}
+
+TEST(test_runtime_parallel, small_operator_single_thread) {
+  using namespace kuiper_infer;
+  OperatorCost cost;
+  cost.flops = 1024;
+  cost.input_bytes = 4096;
+  cost.batch_size = 8;
+  cost.channels = 16;
+  const ParallelPlan plan = PlanParallelism(cost, 16);
+  ASSERT_EQ(plan.batch_threads, 1);
+  ASSERT_EQ(plan.intra_threads, 1);
+}
+
+TEST(test_runtime_parallel, linear_splits_features) {
+  using namespace kuiper_infer;
+  // 二维输出的全连接层按输出特征切分，单个样本也能使用多个线程
+  auto op = std::make_shared<RuntimeOperator>();
+  op->type = "nn.Linear";
+  op->input_operands_seq.push_back(std::make_shared<RuntimeOperand>(
+      "input", std::vector<int32_t>{1, 2048}, std::vector<sftensor>{},
+      RuntimeDataType::kTypeFloat32));
+  op->output_operands = std::make_shared<RuntimeOperand>(
+      "output", std::vector<int32_t>{1, 1000}, std::vector<sftensor>{},
+      RuntimeDataType::kTypeFloat32);
+  op->attribute.insert({"weight", std::make_shared<RuntimeAttribute>(
+                                      std::vector<int32_t>{1000, 2048},
+                                      RuntimeDataType::kTypeFloat32, std::vector<char>{})});
+  const OperatorCost cost = EstimateOperatorCost(*op);
+  ASSERT_EQ(cost.channels, 1000);
+
+  const ParallelPlan plan = PlanParallelism(cost, 8);
+  ASSERT_EQ(plan.batch_threads, 1);
+  ASSERT_EQ(plan.intra_threads, 8);
+}
+
+TEST(test_runtime_parallel, unbounded_split) {
+  using namespace kuiper_infer;
+  // 没有通道维的算子不按通道数限制线程
+  OperatorCost cost;
+  cost.flops = 64. * 1024 * 1024;
+  const ParallelPlan plan = PlanParallelism(cost, 4);
+  ASSERT_EQ(plan.batch_threads, 1);
+  ASSERT_EQ(plan.intra_threads, 4);
+}
@@ -0,0 +1,139 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-6.
+#include <gtest/gtest.h>
+#include "runtime/runtime_ir.hpp"
+#include "runtime/runtime_scheduler.hpp"
+
+using namespace kuiper_infer;
+
+static std::vector<sftensor> SchedulerInputs(uint32_t batch_size, float value) {
+  std::vector<sftensor> inputs;
+  for (uint32_t i = 0; i < batch_size; ++i) {
+    sftensor input = std::make_shared<Tensor<float>>(1, 4, 4);
+    input->Fill(value);
+    inputs.push_back(input);
+  }
+  return inputs;
+}
+
+TEST(test_runtime, scheduler_multi_model) {
+  const std::string param_path = "tmp/add/resnet_add.pnnx.param";
+  const std::string bin_path = "tmp/add/resnet_add.pnnx.bin";
+  RuntimeGraph graph(param_path, bin_path);
+  graph.Build();
+  graph.set_inputs("pnnx_input_0", SchedulerInputs(4, 1.f));
+  graph.Forward(false);
+  std::vector<sftensor> expected = graph.get_outputs("pnnx_output_0");
+
+  auto graph1 = std::make_shared<RuntimeGraph>(param_path, bin_path);
+  auto graph2 = std::make_shared<RuntimeGraph>(param_path, bin_path);
+  graph1->Build();
+  graph2->Build();
+
+  RuntimeScheduler scheduler(2);
+  scheduler.RegisterModel("model1", graph1);
+  scheduler.RegisterModel("model2", graph2);
+
+  std::vector<std::future<RuntimeRequestResult>> results;
+  for (int i = 0; i < 8; ++i) {
+    const std::string model_name = i % 2 ? "model1" : "model2";
+    results.push_back(scheduler.Submit(model_name, "pnnx_input_0", SchedulerInputs(4, 1.f),
+                                       "pnnx_output_0", i % 3));
+  }
+
+  for (auto& result_future : results) {
+    RuntimeRequestResult result = result_future.get();
+    ASSERT_EQ(result.status, StatusCode::kSuccess);
+    ASSERT_EQ(result.outputs.size(), expected.size());
+    for (uint32_t i = 0; i < expected.size(); ++i) {
+      ASSERT_EQ(result.outputs.at(i)->values(), expected.at(i)->values());
+    }
+  }
+
+  const RuntimeModelMetrics metrics1 = scheduler.metrics("model1");
+  const RuntimeModelMetrics metrics2 = scheduler.metrics("model2");
+  ASSERT_EQ(metrics1.completed, 4);
+  ASSERT_EQ(metrics2.completed, 4);
+  ASSERT_EQ(metrics1.queued, 0);
+  ASSERT_GE(metrics1.avg_latency, metrics1.avg_queue_time);
+}
+
+TEST(test_runtime, scheduler_deadline) {
+  auto graph = std::make_shared<RuntimeGraph>("tmp/add/resnet_add.pnnx.param",
+                                              "tmp/add/resnet_add.pnnx.bin");
+  graph->Build();
+
+  RuntimeScheduler scheduler(1);
+  scheduler.RegisterModel("model", graph);
+  const auto deadline = RuntimeScheduler::Clock::now() - std::chrono::milliseconds(1);
+  RuntimeRequestResult result = scheduler
+                                    .Submit("model", "pnnx_input_0", SchedulerInputs(1, 1.f),
+                                            "pnnx_output_0", 0, deadline)
+                                    .get();
+  ASSERT_EQ(result.status, StatusCode::kInferDeadlineExceeded);
+  ASSERT_TRUE(result.outputs.empty());
+  ASSERT_EQ(scheduler.metrics("model").expired, 1);
+  ASSERT_EQ(scheduler.metrics("model").completed, 0);
+}
+
+TEST(test_runtime, scheduler_preemption) {
+  auto batch_graph = std::make_shared<RuntimeGraph>("tmp/resnet/resnet18_batch1.param",
+                                                    "tmp/resnet/resnet18_batch1.pnnx.bin");
+  auto online_graph = std::make_shared<RuntimeGraph>("tmp/add/resnet_add.pnnx.param",
+                                                     "tmp/add/resnet_add.pnnx.bin");
+  batch_graph->Build();
+  online_graph->Build();
+  ASSERT_GT(batch_graph->plan_size(), 1);
+
+  RuntimeScheduler scheduler(1);
+  scheduler.RegisterModel("batch", batch_graph);
+  scheduler.RegisterModel("online", online_graph);
+
+  // 低优先级请求执行完第一层后提交高优先级请求，高优先级请求应在下一个层边界抢占
+  std::vector<std::pair<std::string, uint32_t>> executed_steps;
+  std::future<RuntimeRequestResult> online_result;
+  scheduler.set_step_observer([&](const std::string& model_name, uint32_t step_index) {
+    executed_steps.emplace_back(model_name, step_index);
+    if (model_name == "batch" && step_index == 0) {
+      online_result = scheduler.Submit("online", "pnnx_input_0", SchedulerInputs(1, 1.f),
+                                       "pnnx_output_0", 10);
+    }
+  });
+
+  sftensor batch_input = std::make_shared<Tensor<float>>(3, 224, 224);
+  batch_input->Fill(1.f);
+  std::future<RuntimeRequestResult> batch_result =
+      scheduler.Submit("batch", "pnnx_input_0", {batch_input}, "pnnx_output_0", 0);
+  ASSERT_EQ(batch_result.get().status, StatusCode::kSuccess);
+  ASSERT_EQ(online_result.get().status, StatusCode::kSuccess);
+
+  const uint32_t online_steps = online_graph->plan_size();
+  ASSERT_EQ(executed_steps.size(), batch_graph->plan_size() + online_steps);
+  ASSERT_EQ(executed_steps.front(), std::make_pair(std::string("batch"), 0u));
+  for (uint32_t i = 0; i < online_steps; ++i) {
+    ASSERT_EQ(executed_steps.at(i + 1), std::make_pair(std::string("online"), i));
+  }
+  for (uint32_t i = online_steps + 1; i < executed_steps.size(); ++i) {
+    ASSERT_EQ(executed_steps.at(i), std::make_pair(std::string("batch"), i - online_steps));
+  }
+}
@@ -0,0 +1,49 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-31.
+#include <cstdio>
+#include <string>
+#include "runtime/pnnx/ir.h"
+
+int main(int argc, char* argv[]) {
+  if (argc != 4) {
+    fprintf(stderr, "Usage: %s [in.pnnx.param] [in.pnnx.bin] [out.cpp]\n", argv[0]);
+    return -1;
+  }
+  const std::string in_param_path = argv[1];
+  const std::string in_bin_path = argv[2];
+  const std::string out_cpp_path = argv[3];
+
+  pnnx::Graph graph;
+  if (graph.load(in_param_path, in_bin_path) != 0) {
+    fprintf(stderr, "Load model %s failed\n", in_param_path.c_str());
+    return -1;
+  }
+
+  if (graph.cpp(out_cpp_path, in_bin_path) != 0) {
+    fprintf(stderr, "Generate code for model %s failed\n", in_param_path.c_str());
+    return -1;
+  }
+  fprintf(stdout, "Generated code is saved to %s, build it with -DKUIPER_AOT_MAIN to get a "
+          "standalone executable\n", out_cpp_path.c_str());
+  return 0;
+}
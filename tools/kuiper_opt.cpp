@@ -0,0 +1,62 @@
+// MIT License
+// Copyright (c) 2022 - 傅莘莘
+// Source URL: https://github.com/zjhellofss/KuiperInfer
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Created by fss on 24-1-27.
+#include <cstdio>
+#include <string>
+#include "runtime/graph_optimizer.hpp"
+#include "runtime/pnnx/ir.h"
+
+int main(int argc, char* argv[]) {
+  if (argc != 5) {
+    fprintf(stderr, "Usage: %s [in.pnnx.param] [in.pnnx.bin] [out.pnnx.param] [out.pnnx.bin]\n",
+            argv[0]);
+    return -1;
+  }
+  const std::string in_param_path = argv[1];
+  const std::string in_bin_path = argv[2];
+  const std::string out_param_path = argv[3];
+  const std::string out_bin_path = argv[4];
+
+  pnnx::Graph graph;
+  if (graph.load(in_param_path, in_bin_path) != 0) {
+    fprintf(stderr, "Load model %s failed\n", in_param_path.c_str());
+    return -1;
+  }
+
+  kuiper_infer::GraphOptimizer optimizer(graph);
+  const auto pass_stats = optimizer.Optimize();
+
+  fprintf(stdout, "%-24s %10s %10s %10s %12s\n", "pass", "rewrites", "ops_before", "ops_after",
+          "time(ms)");
+  for (const auto& stats : pass_stats) {
+    fprintf(stdout, "%-24s %10u %10u %10u %12.3f\n", stats.pass_name.c_str(), stats.rewrites,
+            stats.ops_before, stats.ops_after, stats.elapsed_time);
+  }
+
+  if (graph.save(out_param_path, out_bin_path) != 0) {
+    fprintf(stderr, "Save model %s failed\n", out_param_path.c_str());
+    return -1;
+  }
+  fprintf(stdout, "Optimized model is saved to %s and %s\n", out_param_path.c_str(),
+          out_bin_path.c_str());
+  return 0;
+}